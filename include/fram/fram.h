@@ -1,9 +1,12 @@
 #pragma once
 
+#include "fram/fram_chip.h"
 #include "fram/fram_hal.h"
 #include "fram/fram_dev.h"
+#include "fram/fram_io.h"
 #include "fram/fram_partition.h"
 #include "fram/fram_ring.h"
+#include "fram/fram_stage.h"
 #include "fram/fram_vslot.h"
 #include "fram/fram_kvs.h"
 #include "fram/fram_superblock.h"
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Supported SPI FRAM parts, identified from the RDID response.
+
+// Optional opcodes/modes (fram_chip_t.flags)
+#define FRAM_CHIP_FSTRD (1U << 0) // FAST_READ 0x0B (one dummy byte)
+#define FRAM_CHIP_DPI   (1U << 1) // dual SPI
+#define FRAM_CHIP_QPI   (1U << 2) // quad SPI
+
+// Longest RDID response in the table (6 continuation codes + 3 bytes)
+#define FRAM_CHIP_RDID_LEN 9
+
+typedef struct {
+    const char *name;
+    uint8_t manuf_id;     // JEDEC manufacturer, after any 0x7F continuation codes
+    uint8_t device_id;    // density/family byte (the following byte is a revision)
+    uint32_t size_bytes;
+    uint8_t addr_bytes;   // 2 or 3
+    uint32_t max_freq_hz; // plain SPI READ/WRITE
+    uint32_t flags;       // FRAM_CHIP_*
+} fram_chip_t;
+
+// Look up the part answering with this RDID response. Leading and trailing
+// 0x7F continuation codes around the manufacturer byte are skipped, which
+// covers both the Cypress (7F..7F C2 dd rr) and Fujitsu (04 7F dd rr) layouts.
+// ESP_ERR_NOT_FOUND for unknown parts, ESP_ERR_INVALID_SIZE if truncated.
+esp_err_t fram_chip_identify(const uint8_t *rdid, size_t len, const fram_chip_t **chip);
+
+size_t fram_chip_count(void);
+const fram_chip_t *fram_chip_get(size_t index);
@@ -3,10 +3,76 @@
 #include "fram/fram_hal.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "freertos/timers.h"
+#include "sdkconfig.h"
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
+typedef void (*fram_dev_notify_fn)(void *arg);
+
+#if CONFIG_FRAM_DEV_STATS
+// Latency histogram: bucket 0 counts calls under 1 us, bucket i (i >= 1)
+// calls of [2^(i-1), 2^i) us; the last bucket also takes everything longer.
+#define FRAM_DEV_HIST_BUCKETS 16
+
+// Extended counters (CONFIG_FRAM_DEV_STATS). Updated with relaxed atomics, so
+// a snapshot is consistent per field, not across fields.
+typedef struct {
+    uint64_t bytes_read;
+    uint64_t bytes_written;
+    uint32_t read_hist[FRAM_DEV_HIST_BUCKETS];  // read, readv, read_copy
+    uint32_t write_hist[FRAM_DEV_HIST_BUCKETS]; // write, writev, fill
+    uint64_t lock_wait_us;                      // total time waiting for the lock
+    uint32_t lock_wait_max_us;
+    uint32_t lock_hold_max_us;
+} fram_dev_xstats_t;
+#endif
+
+#if CONFIG_FRAM_DEV_CACHE_LINES
+#define FRAM_DEV_CACHE_LINES CONFIG_FRAM_DEV_CACHE_LINES
+#define FRAM_DEV_CACHE_LINE_SIZE CONFIG_FRAM_DEV_CACHE_LINE_SIZE
+#define FRAM_DEV_CACHE_PINS 4
+
+#if (FRAM_DEV_CACHE_LINE_SIZE & (FRAM_DEV_CACHE_LINE_SIZE - 1)) != 0
+#error "CONFIG_FRAM_DEV_CACHE_LINE_SIZE must be a power of two"
+#endif
+
+// One aligned FRAM_DEV_CACHE_LINE_SIZE block of the device
+typedef struct {
+    uint32_t tag; // device offset of data[0]
+    bool valid;
+    bool ref;     // CLOCK reference bit
+    bool pinned;  // inside a pinned range: never evicted
+    uint8_t data[FRAM_DEV_CACHE_LINE_SIZE];
+} fram_dev_cache_line_t;
+
+typedef struct {
+    uint32_t offset;
+    uint32_t len; // 0 = free
+} fram_dev_cache_pin_t;
+#endif
+
+#if CONFIG_FRAM_DEV_COMBINE_SIZE
+#define FRAM_DEV_COMBINE_SIZE CONFIG_FRAM_DEV_COMBINE_SIZE
+
+// One staged write range; ranges never overlap each other
+typedef struct {
+    uint32_t offset;
+    uint16_t at;  // position in stage_buf
+    uint16_t len;
+} fram_dev_stage_t;
+#endif
+
+// Per-task latency budgets for preemptible transfers
+#define FRAM_DEV_BUDGET_TASKS 4
+
+typedef struct {
+    TaskHandle_t task; // NULL = free
+    uint32_t budget_us;
+} fram_dev_budget_t;
+
 typedef struct {
     fram_hal_t *hal;
     SemaphoreHandle_t mutex;
@@ -20,12 +86,85 @@ typedef struct {
 
     uint32_t error_threshold;
     uint32_t mutex_timeout_ms;
+
+    uint8_t *shadow;            // RAM copy of the whole array, or NULL
+    bool shadow_valid;          // false after an unrecoverable write error
+    uint32_t shadow_verify_pos; // next offset for fram_dev_shadow_verify()
+    uint32_t shadow_skipped;    // write bytes dropped as already on the device
+    uint32_t shadow_mismatches; // verify chunks that differed from the device
+
+    uint32_t cache_hits;
+    uint32_t cache_misses;
+#if CONFIG_FRAM_DEV_CACHE_LINES
+    bool cache_enabled;
+    fram_dev_cache_line_t cache[FRAM_DEV_CACHE_LINES];
+    fram_dev_cache_pin_t cache_pins[FRAM_DEV_CACHE_PINS];
+    uint32_t cache_hand;         // CLOCK hand
+    uint32_t cache_pinned_lines; // upper bound, overlapping pins count twice
+#endif
+
+    uint32_t combined_writes; // writes absorbed into a staged range
+    uint32_t combine_flushes;
+#if CONFIG_FRAM_DEV_COMBINE_SIZE
+    uint8_t stage_buf[FRAM_DEV_COMBINE_SIZE];
+    fram_dev_stage_t stage[FRAM_VEC_MAX];
+    size_t stage_count;
+    uint16_t stage_used;        // bytes of stage_buf in use
+    TimerHandle_t stage_timer;  // NULL: combining off for this device
+    StaticTimer_t stage_timer_buf;
+    bool stage_due;             // timeout passed, the next call flushes
+    fram_dev_notify_fn stage_notify;
+    void *stage_notify_arg;
+#endif
+
+    TaskHandle_t lock_owner; // task holding mutex, NULL when free
+    uint32_t lock_depth;     // nested fram_dev calls/scopes of lock_owner
+
+    // Preemptible transfers (fram_dev_config_t.preempt_chunk)
+    uint32_t preempt_chunk;
+    uint32_t preempt_budget_us;
+    fram_dev_budget_t budgets[FRAM_DEV_BUDGET_TASKS];
+    bool preemptible;          // the owner's current transfer may yield
+    UBaseType_t lock_prio;     // owner's priority when it took the mutex
+    uint32_t hi_waiters;       // tasks above lock_prio waiting for the mutex
+    int64_t hi_deadline_us;    // earliest budget deadline among them
+    int64_t chunk_at_us;       // last yield check by the owner
+    uint32_t preempt_yields;
+
+#if CONFIG_FRAM_DEV_STATS
+    fram_dev_xstats_t xstats;
+    int64_t locked_at_us; // lock owner only
+    int64_t op_start_us;  // lock owner only: start of the outermost lock
+#endif
 } fram_dev_t;
 
 typedef struct {
     fram_hal_t *hal;
     uint32_t error_threshold;  // default: CONFIG_FRAM_DEFAULT_ERROR_THRESHOLD
     uint32_t mutex_timeout_ms; // default: CONFIG_FRAM_DEFAULT_MUTEX_TIMEOUT_MS
+    // Optional RAM shadow, at least size_bytes long (internal RAM or PSRAM).
+    // Loaded at init; reads are then served from it and writes go through
+    // to the device, minus leading/trailing bytes it already holds.
+    uint8_t *shadow;
+    size_t shadow_len;
+    // Serve short reads from the write-through line cache
+    // (CONFIG_FRAM_DEV_CACHE_LINES; ignored when that is 0 or with a shadow).
+    // Only for devices that nothing else writes behind fram_dev's back.
+    bool cache;
+    // Stage small writes and send them as one writev on fram_dev_barrier(),
+    // when CONFIG_FRAM_DEV_COMBINE_SIZE bytes are staged, or on the first call
+    // CONFIG_FRAM_DEV_COMBINE_TIMEOUT_MS after the first one (see
+    // fram_dev_set_flush_notify(); ignored when that is 0). Staged writes
+    // reach the device in no particular order.
+    bool combine;
+    // Split read, write and fill transfers into pieces of at most this many
+    // bytes (0 = off) and, between pieces, hand the device to a waiting task
+    // of higher priority once its latency budget would run out. Such a
+    // transfer is not atomic towards other tasks, and fails with
+    // ESP_ERR_NOT_FINISHED, partly done, if it cannot get the device back
+    // within mutex_timeout_ms. Ignored with a shadow.
+    uint32_t preempt_chunk;
+    uint32_t preempt_budget_us; // default: CONFIG_FRAM_DEFAULT_PREEMPT_BUDGET_US
 } fram_dev_config_t;
 
 esp_err_t fram_dev_init(fram_dev_t *dev, const fram_dev_config_t *cfg);
@@ -34,6 +173,53 @@ esp_err_t fram_dev_deinit(fram_dev_t *dev);
 esp_err_t fram_dev_read(fram_dev_t *dev, uint32_t offset, void *buf, size_t len);
 esp_err_t fram_dev_write(fram_dev_t *dev, uint32_t offset, const void *buf, size_t len);
 
+// Hold the device (and the SPI bus, where the HAL supports it) across several
+// calls. fram_dev/fram_pm calls made by the same task inside the scope skip
+// the mutex, and other tasks' I/O cannot interleave. Scopes nest; every
+// successful begin needs one end. Keep scopes short: other tasks wait up to
+// mutex_timeout_ms.
+esp_err_t fram_dev_begin(fram_dev_t *dev);
+esp_err_t fram_dev_end(fram_dev_t *dev);
+// Write out staged writes (see fram_dev_config_t.combine). Everything
+// written before the barrier is on the device before anything written
+// after it. writev, fill and the async, copy and shadow calls also flush
+// first. ESP_OK at once when nothing is staged.
+esp_err_t fram_dev_barrier(fram_dev_t *dev);
+// Staged writes that outlived CONFIG_FRAM_DEV_COMBINE_TIMEOUT_MS are flushed
+// by the next call on the device; the timer never touches the bus itself.
+// `notify(arg)` (NULL = none) is then called from the timer service task so
+// an idle device can be flushed too: it must not block, and should get some
+// task to call fram_dev_barrier(). fram_io_init() registers its worker.
+esp_err_t fram_dev_set_flush_notify(fram_dev_t *dev, fram_dev_notify_fn notify, void *arg);
+// Latency budget of the calling task for preemptible devices: how long it
+// is willing to wait for a lower-priority task's transfer, give or take one
+// piece. 0 restores the device default. ESP_ERR_NO_MEM when
+// FRAM_DEV_BUDGET_TASKS tasks already have their own.
+esp_err_t fram_dev_set_latency_budget(fram_dev_t *dev, uint32_t budget_us);
+// True if the calling task holds the device (inside a scope or a call).
+bool fram_dev_in_scope(const fram_dev_t *dev);
+
+// Scatter-gather: up to FRAM_VEC_MAX segments, in order, under one lock.
+// HALs with readv/writev send contiguous segments as one transaction; others
+// get one chunked transfer per segment. A failed segment stops the vector.
+esp_err_t fram_dev_readv(fram_dev_t *dev, const fram_rvec_t *vec, size_t count);
+esp_err_t fram_dev_writev(fram_dev_t *dev, const fram_wvec_t *vec, size_t count);
+
+// Set `len` bytes to `value` (0xFF = erased). HALs with a fill op stream it
+// without a source buffer; others get chunked writes from a fixed pattern.
+esp_err_t fram_dev_fill(fram_dev_t *dev, uint32_t offset, uint8_t value, size_t len);
+
+// Queue a transfer and return without waiting. `done` runs (with the device
+// lock held) when the op is retired by fram_dev_async_wait() or by a later
+// access to the device; `buf` must stay valid until then. HALs without async
+// support complete the op synchronously: `done` runs before the call
+// returns, and the call returns the same result.
+esp_err_t fram_dev_read_async(fram_dev_t *dev, uint32_t offset, void *buf, size_t len,
+                              fram_hal_done_fn done, void *arg);
+esp_err_t fram_dev_write_async(fram_dev_t *dev, uint32_t offset, const void *buf, size_t len,
+                               fram_hal_done_fn done, void *arg);
+esp_err_t fram_dev_async_wait(fram_dev_t *dev, uint32_t timeout_ms);
+
 esp_err_t fram_dev_read_u8(fram_dev_t *dev, uint32_t offset, uint8_t *val);
 esp_err_t fram_dev_read_u16(fram_dev_t *dev, uint32_t offset, uint16_t *val);
 esp_err_t fram_dev_read_u32(fram_dev_t *dev, uint32_t offset, uint32_t *val);
@@ -43,15 +229,52 @@ esp_err_t fram_dev_write_u16(fram_dev_t *dev, uint32_t offset, uint16_t val);
 esp_err_t fram_dev_write_u32(fram_dev_t *dev, uint32_t offset, uint32_t val);
 esp_err_t fram_dev_write_u64(fram_dev_t *dev, uint32_t offset, uint64_t val);
 
+// Redundant HALs (e.g. the mirror HAL): number of stored copies (1 for plain
+// devices), read one specific copy, and rewrite the other copies of a range
+// from good_copy. ESP_ERR_NOT_SUPPORTED if the HAL keeps a single copy; the
+// mirror HAL refuses (ESP_ERR_INVALID_STATE) a good_copy it knows is stale.
+uint32_t fram_dev_get_copies(const fram_dev_t *dev);
+esp_err_t fram_dev_read_copy(fram_dev_t *dev, uint32_t copy, uint32_t offset, void *buf, size_t len);
+esp_err_t fram_dev_repair(fram_dev_t *dev, uint32_t good_copy, uint32_t offset, size_t len);
+
+// Shadow mode. sync reloads the whole shadow from the device (and re-enables
+// it after a failed write that could not be re-read). verify compares the
+// next `len` bytes, continuing where the previous call stopped, fixes the
+// shadow from the device and returns ESP_ERR_INVALID_CRC if anything
+// differed; call it periodically to bound how long a silent corruption of
+// either side can persist.
+esp_err_t fram_dev_shadow_sync(fram_dev_t *dev);
+esp_err_t fram_dev_shadow_verify(fram_dev_t *dev, size_t len);
+
+// Read cache (CONFIG_FRAM_DEV_CACHE_LINES). pin loads the lines covering a
+// range and keeps them resident until the matching unpin; up to
+// FRAM_DEV_CACHE_PINS ranges, and at least one line stays evictable
+// (ESP_ERR_NO_MEM otherwise). invalidate drops every line, e.g. after the
+// device was written behind fram_dev's back. ESP_ERR_NOT_SUPPORTED when the
+// cache is compiled out, ESP_ERR_INVALID_STATE if the device does not use it.
+esp_err_t fram_dev_cache_pin(fram_dev_t *dev, uint32_t offset, size_t len);
+esp_err_t fram_dev_cache_unpin(fram_dev_t *dev, uint32_t offset, size_t len);
+esp_err_t fram_dev_cache_invalidate(fram_dev_t *dev);
+
 bool fram_dev_is_healthy(const fram_dev_t *dev);
 uint32_t fram_dev_get_size(const fram_dev_t *dev);
 
 typedef struct {
-    uint32_t read_count;
+    uint32_t read_count; // device reads, plus calls served from the shadow or cache
     uint32_t write_count;
     uint32_t error_count;
     uint32_t size_bytes;
     bool healthy;
+    uint32_t shadow_skipped;
+    uint32_t shadow_mismatches;
+    uint32_t cache_hits;   // cache lines a read found resident
+    uint32_t cache_misses; // cache lines a read had to load
+    uint32_t combined_writes; // writes merged into an already staged range
+    uint32_t combine_flushes;
+    uint32_t preempt_yields; // times a transfer handed the device over
+#if CONFIG_FRAM_DEV_STATS
+    fram_dev_xstats_t x;
+#endif
 } fram_dev_stats_t;
 
 void fram_dev_get_stats(const fram_dev_t *dev, fram_dev_stats_t *stats);
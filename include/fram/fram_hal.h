@@ -1,12 +1,20 @@
 #pragma once
 
 #include "esp_err.h"
+#include "fram/fram_chip.h"
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
 typedef struct fram_hal fram_hal_t;
 
+// HAL capabilities (fram_hal_t.caps)
+// read/write accept any in-range length and stream it as one transfer
+// (one CS window on SPI); fram_dev then skips max_transfer chunking.
+#define FRAM_HAL_CAP_CONTINUOUS (1U << 0)
+
+#define FRAM_HAL_WAIT_FOREVER UINT32_MAX
+
 // HAL operations
 typedef esp_err_t (*fram_hal_init_fn)(fram_hal_t *hal);
 typedef esp_err_t (*fram_hal_deinit_fn)(fram_hal_t *hal);
@@ -14,6 +22,62 @@ typedef esp_err_t (*fram_hal_read_fn)(fram_hal_t *hal, uint32_t addr, void *buf,
 typedef esp_err_t (*fram_hal_write_fn)(fram_hal_t *hal, uint32_t addr, const void *buf, size_t len);
 typedef esp_err_t (*fram_hal_probe_fn)(fram_hal_t *hal);
 
+// Asynchronous ops (optional, NULL if unsupported). Submission returns as soon
+// as the transfer is queued; `done` runs in task context from `wait` (or from
+// a later submission/sync op that has to retire it), in submission order. The
+// buffer must stay valid until then. If submission fails, `done` is not called.
+// An op the HAL completes inline instead (e.g. a buffer it cannot queue) runs
+// `done` before returning and returns the same result.
+typedef void (*fram_hal_done_fn)(fram_hal_t *hal, esp_err_t err, void *arg);
+typedef esp_err_t (*fram_hal_read_async_fn)(fram_hal_t *hal, uint32_t addr, void *buf, size_t len,
+                                            fram_hal_done_fn done, void *arg);
+typedef esp_err_t (*fram_hal_write_async_fn)(fram_hal_t *hal, uint32_t addr, const void *buf, size_t len,
+                                             fram_hal_done_fn done, void *arg);
+// Retire all queued ops, running their callbacks. ESP_ERR_TIMEOUT if some
+// are still in flight after timeout_ms (FRAM_HAL_WAIT_FOREVER: no limit).
+typedef esp_err_t (*fram_hal_wait_fn)(fram_hal_t *hal, uint32_t timeout_ms);
+
+// Bus ownership for the duration of one fram_dev call (optional).
+typedef esp_err_t (*fram_hal_acquire_fn)(fram_hal_t *hal);
+typedef void (*fram_hal_release_fn)(fram_hal_t *hal);
+
+// Redundant HALs (fram_hal_t.copies > 1, optional): read one specific stored
+// copy, and schedule rewriting the other copies of a range from good_copy
+// (e.g. after that copy passed a CRC check the served data failed).
+typedef esp_err_t (*fram_hal_read_copy_fn)(fram_hal_t *hal, uint32_t copy, uint32_t addr,
+                                           void *buf, size_t len);
+typedef esp_err_t (*fram_hal_repair_fn)(fram_hal_t *hal, uint32_t good_copy, uint32_t addr, size_t len);
+
+// Scatter-gather segments. `offset` is relative to the layer the vector is
+// passed to (device address for HAL and fram_dev, partition offset for pm).
+#define FRAM_VEC_MAX 8
+
+typedef struct {
+    uint32_t offset;
+    const void *buf;
+    size_t len;
+} fram_wvec_t;
+
+typedef struct {
+    uint32_t offset;
+    void *buf;
+    size_t len;
+} fram_rvec_t;
+
+// Vectored ops (optional). Segments are transferred in order, the first
+// failure stops the vector, and runs of contiguous segments go out as one
+// transaction (one WREN + WRITE on SPI). Any segment length is accepted.
+// count <= FRAM_VEC_MAX.
+typedef esp_err_t (*fram_hal_writev_fn)(fram_hal_t *hal, const fram_wvec_t *vec, size_t count);
+typedef esp_err_t (*fram_hal_readv_fn)(fram_hal_t *hal, const fram_rvec_t *vec, size_t count);
+
+// Write `len` copies of `value` from addr (optional); streamed as one WRITE.
+typedef esp_err_t (*fram_hal_fill_fn)(fram_hal_t *hal, uint32_t addr, uint8_t value, size_t len);
+
+// fram_hal_t.buses: HALs with a bit in common share a bus, so one holding
+// it (acquire) keeps the other from transferring.
+#define FRAM_HAL_BUS_SPI(host) (1U << (host))
+
 struct fram_hal {
     fram_hal_init_fn   init;
     fram_hal_deinit_fn deinit;
@@ -21,16 +85,96 @@ struct fram_hal {
     fram_hal_write_fn  write;
     fram_hal_probe_fn  probe;
 
+    fram_hal_read_async_fn  read_async;
+    fram_hal_write_async_fn write_async;
+    fram_hal_wait_fn        wait;
+
+    fram_hal_acquire_fn acquire;
+    fram_hal_release_fn release;
+
+    fram_hal_read_copy_fn read_copy;
+    fram_hal_repair_fn    repair;
+
+    fram_hal_readv_fn  readv;
+    fram_hal_writev_fn writev;
+    fram_hal_fill_fn   fill;
+
     uint32_t size_bytes;   // Total capacity
     uint32_t max_transfer; // Max data bytes per transaction
+    uint32_t caps;         // FRAM_HAL_CAP_* flags
+    const fram_chip_t *chip; // identified part, NULL if not probed/unknown
+    uint32_t copies;       // stored copies of each byte (read_copy), 0/1 = plain
+    uint32_t buses;        // FRAM_HAL_BUS_* bits of the buses it transfers on, 0 = none shared
 
     void *ctx;
 };
 
-// SPI HAL (FM25V02A)
+// SPI clock calibration building blocks. They need no driver, so they are
+// built on every target and can be exercised without a bus.
+#define FRAM_HAL_SPI_CALIB_RECORD_LEN 16
+
+// Persisted result, CRC-protected
+typedef struct {
+    uint32_t magic;
+    uint32_t freq_hz;
+    uint32_t input_delay_ns;
+    uint32_t crc32;
+} fram_hal_spi_calib_record_t;
+
+// Longest run of passing delays in one sweep; zero-initialise, then add each
+// delay in increasing order.
+typedef struct {
+    uint32_t run;
+    uint32_t best_run;
+    uint32_t best_end; // last delay of the longest run
+} fram_hal_spi_calib_window_t;
+
+void fram_hal_spi_calib_window_add(fram_hal_spi_calib_window_t *win, uint32_t delay_ns, bool pass);
+// Centre of the longest run, if it has `margin_steps` passing steps on either
+// side of the centre; false otherwise.
+bool fram_hal_spi_calib_window_pick(const fram_hal_spi_calib_window_t *win, uint32_t step_ns,
+                                    uint32_t margin_steps, uint32_t *delay_ns);
+void fram_hal_spi_calib_record_make(fram_hal_spi_calib_record_t *rec, uint32_t freq_hz, uint32_t input_delay_ns);
+// Magic and CRC match and the clock is nonzero and within max_hz
+bool fram_hal_spi_calib_record_valid(const fram_hal_spi_calib_record_t *rec, uint32_t max_hz);
+
+// SPI HAL (FM25V/CY15B and MB85RS SPI FRAM, see fram_chip.h)
 #if CONFIG_FRAM_HAL_SPI_ENABLED
 #include "driver/spi_master.h"
 
+// Clock calibration: candidate clocks are tried fastest first and, at each,
+// a sweep of MISO input delays. A setting passes when RDID matches and a
+// scratch region reads back correctly, first unchanged and then after
+// `passes` pattern writes. The first clock whose passing delays form a run of
+// at least 1 + 2 * margin_steps wins, with the delay at the centre of the
+// run. The margin applies to the delay axis only: the chosen clock is the
+// fastest that qualifies, with no step back; list slower candidates in
+// freqs_hz to leave headroom on the clock as well. The configured clock is
+// the fallback and is never undercut.
+#define FRAM_HAL_SPI_CALIB_LEN        64 // scratch bytes
+
+typedef struct {
+    uint32_t scratch_addr;   // FRAM_HAL_SPI_CALIB_LEN bytes, restored afterwards
+    const uint32_t *freqs_hz; // candidates, fastest first; NULL = src_hz / n up to the chip's rating
+    uint32_t src_hz;         // clock the default candidates divide; 0 = the SPI default source's
+                             // frequency from the clock tree
+    size_t freq_count;
+    uint32_t delay_max_ns;   // input delays 0..max are tried; default 50
+    uint32_t delay_step_ns;  // default 5
+    uint32_t passes;         // pattern write/read-backs per setting; default 4
+    uint32_t margin_steps;   // passing delay steps needed each side (delay only); default 1
+    bool persist;            // reuse/store the result at record_addr
+    uint32_t record_addr;    // FRAM_HAL_SPI_CALIB_RECORD_LEN bytes, outside the scratch
+} fram_hal_spi_calib_config_t;
+
+typedef struct {
+    uint32_t freq_hz;
+    uint32_t input_delay_ns;
+    uint32_t tested;     // settings tried
+    uint32_t passed;     // settings that passed
+    bool from_record;    // stored setting re-verified, no sweep
+} fram_hal_spi_calib_result_t;
+
 typedef struct {
     spi_host_device_t host;
     int cs_pin;
@@ -40,22 +184,190 @@ typedef struct {
     int spi_mode;           // 0 or 3
     uint32_t freq_hz;
     uint32_t size_bytes;    // 0 = auto-detect via RDID
-    size_t max_transfer;    // max data bytes per transaction
+    size_t max_transfer;    // max data bytes per transaction (DMA, not stack bound)
     uint32_t powerup_delay_ms;
     bool init_bus;          // initialize SPI bus
     bool deinit_bus;        // free SPI bus on deinit
+    uint32_t queue_size;    // async queue depth, 0 = CONFIG_FRAM_SPI_QUEUE_SIZE (max)
+    uint32_t polling_threshold; // poll transfers of <= N bytes, 0 = Kconfig default
+    const fram_hal_spi_calib_config_t *calibrate; // calibrate once created, NULL = off
 } fram_hal_spi_config_t;
 
+typedef struct {
+    spi_transaction_ext_t trans;
+    fram_hal_done_fn done; // set on the last descriptor of an op
+    void *arg;
+} fram_hal_spi_async_t;
+
+// Keep the ctx in DMA-capable internal RAM (a static is fine): buffers the
+// SPI DMA cannot reach directly are staged through `bounce`.
 typedef struct {
     spi_host_device_t host;
-    spi_device_handle_t dev;
+    spi_device_handle_t dev;    // NULL if a clock change lost the handle: unusable
     bool bus_inited;
     bool deinit_bus;
+    bool bus_held;              // acquired via hal->acquire
+    int cs_pin;
+    int spi_mode;
+    uint32_t freq_hz;
+    uint32_t input_delay_ns;
+    uint32_t addr_bits;         // 16 or 24, from the identified part
+    uint32_t polling_threshold;
+    uint8_t bounce[(CONFIG_FRAM_SPI_BOUNCE_SIZE + 3) & ~3] __attribute__((aligned(4)));
+
+    // In-flight async descriptors (FIFO, same order as the driver queue)
+    fram_hal_spi_async_t async[CONFIG_FRAM_SPI_QUEUE_SIZE];
+    uint32_t queue_depth;
+    uint32_t async_head;
+    uint32_t async_count;
+
+    fram_hal_spi_calib_result_t calib; // last calibration
 } fram_hal_spi_ctx_t;
 
 esp_err_t fram_hal_spi_create(fram_hal_t *hal,
                               fram_hal_spi_ctx_t *ctx,
                               const fram_hal_spi_config_t *cfg);
+
+// Re-register the device with a new clock and MISO input delay. No transfer
+// may be in progress (not from inside a fram_dev call).
+esp_err_t fram_hal_spi_set_clock(fram_hal_t *hal, uint32_t freq_hz, uint32_t input_delay_ns);
+
+// Find and apply the fastest stable clock (see above). Call before
+// fram_dev_init(). The scratch is restored, but a reset mid-sweep leaves a
+// test pattern there, so reserve it (and the record) for calibration. With
+// `persist` a valid stored record is re-verified and reused instead of
+// sweeping, and a new result is stored. *result (may be NULL) and ctx->calib
+// receive the outcome. ESP_OK also when only the configured clock passes.
+esp_err_t fram_hal_spi_calibrate(fram_hal_t *hal, const fram_hal_spi_calib_config_t *cfg,
+                                 fram_hal_spi_calib_result_t *result);
+#endif
+
+// Stripe HAL: several child HALs presented as one device
+#if CONFIG_FRAM_HAL_STRIPE_ENABLED
+
+typedef enum {
+    FRAM_HAL_STRIPE_MODE_STRIPE = 0, // stripe_size bytes per child, round robin
+    FRAM_HAL_STRIPE_MODE_CONCAT,     // children back to back (capacity only)
+} fram_hal_stripe_mode_t;
+
+// Children that share a bus (e.g. two SPI devices on one host) are not
+// acquired for a fram_dev call: holding the bus for one would block transfers
+// to the other. Their WREN + WRITE pairs can then interleave with other
+// devices on that bus; children on buses of their own are held as usual.
+typedef struct {
+    fram_hal_t *const *children; // created (not yet initialized) child HALs
+    size_t child_count;
+    fram_hal_stripe_mode_t mode;
+    uint32_t stripe_size;        // 0 = CONFIG_FRAM_HAL_STRIPE_DEFAULT_SIZE
+} fram_hal_stripe_config_t;
+
+typedef struct {
+    fram_hal_t *children[CONFIG_FRAM_HAL_STRIPE_MAX_CHILDREN];
+    size_t child_count;
+    fram_hal_stripe_mode_t mode;
+    uint32_t stripe_size;
+    uint32_t child_size; // bytes used on each child (stripe mode)
+    uint32_t acquired;   // bitmask of children holding their bus
+    esp_err_t async_err; // first error reported by a child completion
+} fram_hal_stripe_ctx_t;
+
+esp_err_t fram_hal_stripe_create(fram_hal_t *hal,
+                                 fram_hal_stripe_ctx_t *ctx,
+                                 const fram_hal_stripe_config_t *cfg);
+#endif
+
+// Mirror HAL: every write goes to two child HALs, reads are balanced
+#if CONFIG_FRAM_HAL_MIRROR_ENABLED
+
+#define FRAM_HAL_MIRROR_CHILDREN 2
+#define FRAM_HAL_MIRROR_CHUNK    64 // repair copy granularity (ctx scratch)
+
+typedef enum {
+    FRAM_HAL_MIRROR_READ_ALTERNATE = 0, // whole reads alternate between children
+    FRAM_HAL_MIRROR_READ_SPLIT,         // large reads split across both (async)
+} fram_hal_mirror_read_t;
+
+// Bus holding follows the stripe rule: children on one shared bus are not
+// acquired. Writes (and SPLIT reads) are queued on both children at once,
+// which only overlaps on the wire when they sit on separate buses; on one
+// SPI host the driver runs the two copies back to back.
+typedef struct {
+    fram_hal_t *children[FRAM_HAL_MIRROR_CHILDREN]; // created, not yet initialized
+    fram_hal_mirror_read_t read_policy;
+    uint32_t split_min;       // SPLIT: reads >= this are split, 0 = CONFIG_FRAM_HAL_MIRROR_SPLIT_MIN
+    uint32_t repair_budget;   // bytes repaired per op, 0 = CONFIG_FRAM_HAL_MIRROR_REPAIR_BUDGET
+    uint32_t error_threshold; // per child, 0 = CONFIG_FRAM_DEFAULT_ERROR_THRESHOLD
+} fram_hal_mirror_config_t;
+
+// Per-child accounting, same rules as fram_dev_t
+typedef struct {
+    uint32_t read_count;
+    uint32_t write_count;
+    uint32_t error_count;
+    uint32_t consecutive_errors;
+    bool healthy;             // false: reads avoid this child
+    uint32_t repaired_bytes;
+} fram_hal_mirror_child_t;
+
+typedef struct {
+    uint32_t addr;
+    uint32_t len;
+    uint8_t child;            // stale child, rewritten from the other one
+} fram_hal_mirror_range_t;
+
+typedef struct {
+    fram_hal_t *children[FRAM_HAL_MIRROR_CHILDREN];
+    fram_hal_mirror_child_t child[FRAM_HAL_MIRROR_CHILDREN];
+    fram_hal_mirror_read_t read_policy;
+    uint32_t split_min;
+    uint32_t repair_budget;
+    uint32_t error_threshold;
+    uint32_t next_read;
+    uint32_t acquired;        // bitmask of children holding their bus
+
+    // Pending repairs; reads avoid a child inside its stale ranges and fail
+    // with ESP_ERR_INVALID_STATE where both children are stale. A range is
+    // only copied while its source is healthy and not stale itself.
+    fram_hal_mirror_range_t repair[CONFIG_FRAM_HAL_MIRROR_REPAIR_SLOTS];
+    uint32_t repair_count;
+    esp_err_t async_err[FRAM_HAL_MIRROR_CHILDREN];
+    uint8_t scratch[FRAM_HAL_MIRROR_CHUNK];
+} fram_hal_mirror_ctx_t;
+
+esp_err_t fram_hal_mirror_create(fram_hal_t *hal,
+                                 fram_hal_mirror_ctx_t *ctx,
+                                 const fram_hal_mirror_config_t *cfg);
+esp_err_t fram_hal_mirror_get_child_stats(const fram_hal_t *hal, size_t child,
+                                          fram_hal_mirror_child_t *stats);
+// Bytes still queued for repair on either child
+uint32_t fram_hal_mirror_repair_pending(const fram_hal_t *hal);
+#endif
+
+// File HAL (linux target): device contents live in an mmap'd image file
+#if CONFIG_FRAM_HAL_FILE_ENABLED
+
+typedef struct {
+    const char *path;    // image file, created if missing; must outlive the HAL
+    size_t size_bytes;   // 0 = CONFIG_FRAM_HAL_FILE_DEFAULT_SIZE
+    bool truncate;       // start from a blank (0xFF) image
+    bool sync_on_write;  // msync() after every write
+} fram_hal_file_config_t;
+
+typedef struct {
+    const char *path;
+    size_t size_bytes;
+    bool truncate;
+    bool sync_on_write;
+    int fd;
+    uint8_t *map;
+    bool created;        // last init created or extended the image
+} fram_hal_file_ctx_t;
+
+esp_err_t fram_hal_file_create(fram_hal_t *hal,
+                               fram_hal_file_ctx_t *ctx,
+                               const fram_hal_file_config_t *cfg);
+// Flush the mapping to the image file
+esp_err_t fram_hal_file_sync(fram_hal_t *hal);
 #endif
 
 // Mock HAL (tests)
@@ -65,17 +377,56 @@ typedef struct {
     uint8_t *buffer;     // backing store
     size_t buffer_len;   // size of backing buffer
     size_t size_bytes;   // usable size (<= buffer_len)
+    size_t max_transfer; // 0 = size_bytes
+    bool continuous;     // advertise FRAM_HAL_CAP_CONTINUOUS
+    const uint8_t *rdid; // emulated RDID response for probe, NULL = none
+    size_t rdid_len;
+    // Bus timing model (sim_time_ns). Every transaction costs cs_overhead_ns
+    // plus opcode, address and data bytes on the wire; a write adds a WREN
+    // transaction. Without FRAM_HAL_CAP_CONTINUOUS, each max_transfer bytes
+    // of one call is a separate command.
+    uint32_t byte_ns;    // wire time per byte, 0 = derived from clock_hz
+    uint32_t clock_hz;   // SPI clock, used when byte_ns is 0 (0 = no wire time)
+    uint32_t cs_overhead_ns; // per transaction: CS setup/hold, driver setup
+    uint8_t addr_bytes;  // 0 = identified part's, else 2
+    bool realtime;       // also busy-wait the modelled time in every call
 } fram_hal_mock_config_t;
 
+#define FRAM_HAL_MOCK_ASYNC_DEPTH 8
+
+typedef struct {
+    uint32_t addr;
+    void *rx;
+    const void *tx;
+    size_t len;
+    fram_hal_done_fn done;
+    void *arg;
+} fram_hal_mock_async_t;
+
 typedef struct {
     uint8_t *buffer;
     size_t size_bytes;
     uint32_t op_count;
+    uint32_t txn_count;  // bus transactions an SPI part would see (WREN counts)
+    uint32_t wren_count;
+    uint64_t wire_bytes; // opcode + address + data bytes clocked
+    uint64_t sim_time_ns; // simulated bus time spent
+    uint32_t byte_ns;
+    uint32_t cs_overhead_ns;
+    uint8_t addr_bytes;
+    bool realtime;
     uint32_t fail_after;
     bool fail_enabled;
     uint32_t inject_offset;
     size_t inject_len;
     bool inject_enabled;
+    const uint8_t *rdid;
+    size_t rdid_len;
+
+    // Queued async ops, performed on wait (or when the queue fills up)
+    fram_hal_mock_async_t async[FRAM_HAL_MOCK_ASYNC_DEPTH];
+    uint32_t async_head;
+    uint32_t async_count;
 } fram_hal_mock_ctx_t;
 
 esp_err_t fram_hal_mock_create(fram_hal_t *hal,
@@ -85,4 +436,5 @@ uint8_t *fram_hal_mock_get_buffer(fram_hal_t *hal);
 void fram_hal_mock_fill(fram_hal_t *hal, uint8_t value);
 void fram_hal_mock_set_fail_after(fram_hal_t *hal, uint32_t operations);
 void fram_hal_mock_inject_error(fram_hal_t *hal, uint32_t offset, size_t len);
+void fram_hal_mock_reset_counters(fram_hal_t *hal);
 #endif
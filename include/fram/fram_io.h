@@ -0,0 +1,124 @@
+#pragma once
+
+#include "fram/fram_dev.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "sdkconfig.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#if CONFIG_FRAM_IO_ENABLED
+
+// I/O worker (CONFIG_FRAM_IO_ENABLED): one task per device that owns all
+// transfers submitted through it. Requests wait in a fixed table of
+// CONFIG_FRAM_IO_QUEUE_DEPTH slots and run highest priority first, then
+// earliest deadline, then in submission order. Requests whose ranges overlap
+// (and at least one of which writes) always run in submission order.
+// Contiguous queued writes are merged into one fram_dev_writev(); if that
+// fails, each of them is retried alone so every request gets its own result.
+
+#define FRAM_IO_QUEUE_DEPTH CONFIG_FRAM_IO_QUEUE_DEPTH
+
+typedef void (*fram_io_done_fn)(esp_err_t err, void *arg);
+
+// Per-request options; NULL means priority 0, no deadline, blocking.
+// Completion: with `done` set the call returns once the request is queued
+// and `done` runs on the worker task; with `notify` set the worker stores
+// the result in *result (if not NULL) and calls xTaskNotifyGive(notify).
+// Otherwise the call blocks and returns the result. Buffers must stay valid
+// until completion.
+typedef struct {
+    uint8_t priority;    // higher runs first
+    int64_t deadline_us; // esp_timer_get_time() value; 0 = none
+    fram_io_done_fn done;
+    void *arg;
+    TaskHandle_t notify;
+    esp_err_t *result;
+} fram_io_opts_t;
+
+typedef enum {
+    FRAM_IO_SLOT_FREE = 0,
+    FRAM_IO_SLOT_QUEUED,
+    FRAM_IO_SLOT_RUNNING,
+    FRAM_IO_SLOT_DONE, // blocking submitter has not collected the result yet
+} fram_io_slot_state_t;
+
+typedef enum {
+    FRAM_IO_OP_READ,
+    FRAM_IO_OP_WRITE, // writev, `count` segments
+    FRAM_IO_OP_FILL,
+} fram_io_op_t;
+
+typedef struct {
+    fram_io_op_t op;
+    fram_io_opts_t opts;
+    uint32_t offset; // read/fill
+    size_t len;      // read/fill
+    void *rbuf;      // read
+    uint8_t value;   // fill
+    fram_wvec_t vec[FRAM_VEC_MAX];
+    size_t count;
+} fram_io_req_t;
+
+typedef struct {
+    fram_io_slot_state_t state;
+    fram_io_req_t req;
+    uint32_t seq;
+    esp_err_t err;
+    bool wait; // blocking submitter
+    SemaphoreHandle_t done_sem;
+    StaticSemaphore_t done_buf;
+} fram_io_slot_t;
+
+typedef struct fram_io {
+    fram_dev_t *dev;
+    bool merge;
+    volatile bool stop;
+    volatile bool flush; // combine timeout passed: run fram_dev_barrier()
+
+    fram_io_slot_t slots[FRAM_IO_QUEUE_DEPTH];
+    uint32_t next_seq;
+    SemaphoreHandle_t lock; // slot table
+    StaticSemaphore_t lock_buf;
+    SemaphoreHandle_t free; // counts free slots
+    StaticSemaphore_t free_buf;
+    SemaphoreHandle_t pending; // wakes the worker
+    StaticSemaphore_t pending_buf;
+    SemaphoreHandle_t stopped;
+    StaticSemaphore_t stopped_buf;
+    uint32_t submit_timeout_ms;
+
+    TaskHandle_t task;
+    StaticTask_t task_buf;
+    StackType_t stack[CONFIG_FRAM_IO_TASK_STACK / sizeof(StackType_t)];
+
+    uint32_t completed; // requests finished by the worker
+    uint32_t merged;    // requests that rode along in another's writev
+} fram_io_t;
+
+typedef struct {
+    fram_dev_t *dev;
+    uint32_t task_priority;     // default: CONFIG_FRAM_IO_TASK_PRIORITY
+    uint32_t submit_timeout_ms; // wait for a free slot; default: dev mutex_timeout_ms
+    bool no_merge;              // run every write request on its own
+} fram_io_config_t;
+
+// Starts the worker (pinned to CONFIG_FRAM_IO_TASK_CORE). With write
+// combining on, the worker also flushes staged writes once
+// CONFIG_FRAM_DEV_COMBINE_TIMEOUT_MS passes (fram_dev_set_flush_notify()).
+// deinit runs the requests still queued, then stops it.
+esp_err_t fram_io_init(fram_io_t *io, const fram_io_config_t *cfg);
+esp_err_t fram_io_deinit(fram_io_t *io);
+
+// Same arguments and checks as the fram_dev calls. Called from the worker
+// itself (e.g. a `done` callback) or from a task inside a fram_dev scope on
+// the device, the request runs inline instead of being queued.
+// ESP_ERR_TIMEOUT if no slot frees up within submit_timeout_ms.
+esp_err_t fram_io_read(fram_io_t *io, uint32_t offset, void *buf, size_t len, const fram_io_opts_t *opts);
+esp_err_t fram_io_write(fram_io_t *io, uint32_t offset, const void *buf, size_t len, const fram_io_opts_t *opts);
+esp_err_t fram_io_writev(fram_io_t *io, const fram_wvec_t *vec, size_t count, const fram_io_opts_t *opts);
+esp_err_t fram_io_fill(fram_io_t *io, uint32_t offset, uint8_t value, size_t len, const fram_io_opts_t *opts);
+
+#endif // CONFIG_FRAM_IO_ENABLED
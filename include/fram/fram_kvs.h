@@ -33,6 +33,8 @@ esp_err_t fram_kvs_deinit(fram_kvs_t *kvs);
 esp_err_t fram_kvs_get(fram_kvs_t *kvs, const char *key, void *buf, size_t *len);
 esp_err_t fram_kvs_set(fram_kvs_t *kvs, const char *key, const void *buf, size_t len);
 esp_err_t fram_kvs_delete(fram_kvs_t *kvs, const char *key);
+// Drop every key. Erases the whole partition.
+esp_err_t fram_kvs_clear(fram_kvs_t *kvs);
 bool fram_kvs_exists(fram_kvs_t *kvs, const char *key);
 esp_err_t fram_kvs_get_len(fram_kvs_t *kvs, const char *key, size_t *len);
 
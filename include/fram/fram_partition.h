@@ -1,6 +1,7 @@
 #pragma once
 
 #include "fram/fram_dev.h"
+#include "fram/fram_io.h"
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
@@ -18,11 +19,31 @@ typedef struct {
     uint32_t flags;
 } fram_partition_t;
 
+#if CONFIG_FRAM_DEV_STATS
+// Per-partition counters (CONFIG_FRAM_DEV_STATS). Time is measured around the
+// fram_dev call, so it includes waiting for the device lock.
+typedef struct {
+    uint32_t read_ops;
+    uint32_t write_ops;
+    uint64_t bytes_read;
+    uint64_t bytes_written;
+    uint64_t busy_us;
+    uint32_t max_us;
+} fram_part_stats_t;
+#endif
+
 typedef struct {
     fram_dev_t *dev;
     fram_partition_t partitions[FRAM_PART_MAX];
     size_t partition_count;
     bool initialized;
+#if CONFIG_FRAM_DEV_STATS
+    fram_part_stats_t stats[FRAM_PART_MAX];
+#endif
+#if CONFIG_FRAM_IO_ENABLED
+    fram_io_t *io; // writes go through this worker when set
+    uint8_t io_priority;
+#endif
 } fram_pm_t;
 
 esp_err_t fram_pm_init(fram_pm_t *pm, fram_dev_t *dev,
@@ -33,11 +54,58 @@ const fram_partition_t *fram_pm_find(const fram_pm_t *pm, const char *name);
 const fram_partition_t *fram_pm_get(const fram_pm_t *pm, size_t index);
 size_t fram_pm_count(const fram_pm_t *pm);
 
+// fram_dev_begin()/fram_dev_end() on the partition manager's device.
+esp_err_t fram_pm_begin(fram_pm_t *pm);
+esp_err_t fram_pm_end(fram_pm_t *pm);
+
+#if CONFIG_FRAM_IO_ENABLED
+// Run fram_pm_write/writev/fill (and so every primitive write path) as
+// blocking requests on `io`, which must serve pm's device, at `priority`.
+// NULL detaches. Writes made inside a device scope still run inline: that
+// covers ring and vslot recovery at init and any fram_pm_begin() held by the
+// caller. Appends, batches, clears, vslot saves and KVS writes are queued.
+esp_err_t fram_pm_set_io(fram_pm_t *pm, fram_io_t *io, uint8_t priority);
+#endif
+
 esp_err_t fram_pm_read(fram_pm_t *pm, const fram_partition_t *part,
                        uint32_t offset, void *buf, size_t len);
 esp_err_t fram_pm_write(fram_pm_t *pm, const fram_partition_t *part,
                         uint32_t offset, const void *buf, size_t len);
 
+// Vectored forms of fram_pm_read()/fram_pm_write(); offsets are partition
+// relative. See fram_dev_writev().
+esp_err_t fram_pm_readv(fram_pm_t *pm, const fram_partition_t *part,
+                        const fram_rvec_t *vec, size_t count);
+esp_err_t fram_pm_writev(fram_pm_t *pm, const fram_partition_t *part,
+                         const fram_wvec_t *vec, size_t count);
+
+// Set a range to `value` in one streamed write where the HAL supports it.
+// fram_pm_erase() fills the whole partition with 0xFF.
+esp_err_t fram_pm_fill(fram_pm_t *pm, const fram_partition_t *part,
+                       uint32_t offset, uint8_t value, size_t len);
 esp_err_t fram_pm_erase(fram_pm_t *pm, const fram_partition_t *part);
 
+#if CONFIG_FRAM_DEV_STATS
+esp_err_t fram_pm_get_stats(const fram_pm_t *pm, const fram_partition_t *part, fram_part_stats_t *stats);
+void fram_pm_reset_stats(fram_pm_t *pm);
+#endif
+
+// Redundant devices (fram_dev_get_copies() > 1). FRAM_PM_COPY_ANY reads like
+// fram_pm_read(), so validation code can take the copy as a parameter.
+#define FRAM_PM_COPY_ANY UINT32_MAX
+
+esp_err_t fram_pm_read_copy(fram_pm_t *pm, const fram_partition_t *part, uint32_t copy,
+                            uint32_t offset, void *buf, size_t len);
+
+// Validates the record at `offset` as stored in one copy, reading only via
+// fram_pm_read_copy(..., copy, ...); sets *len to the record size on success.
+typedef esp_err_t (*fram_pm_check_fn)(void *arg, uint32_t copy, size_t *len);
+
+// Called when a record failed validation: runs `check` against each copy and
+// has the other copies rewritten from the first one that passes.
+// ESP_ERR_NOT_SUPPORTED on single-copy devices, ESP_ERR_INVALID_CRC if no copy
+// validates.
+esp_err_t fram_pm_recover(fram_pm_t *pm, const fram_partition_t *part, uint32_t offset,
+                          fram_pm_check_fn check, void *arg);
+
 bool fram_pm_is_valid_range(const fram_partition_t *part, uint32_t offset, size_t len);
@@ -1,8 +1,10 @@
 #pragma once
 
 #include "fram/fram_partition.h"
+#include "fram/fram_vslot.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
+#include "sdkconfig.h"
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
@@ -16,6 +18,23 @@ typedef struct {
     uint32_t crc32;
 } __attribute__((packed)) fram_ring_header_t;
 
+// Packed rings: record header, then `len` payload bytes, then the commit
+// byte. The CRC covers header and payload and is seeded with the ring magic,
+// which is not stored.
+typedef struct {
+    uint32_t seq;
+    uint64_t ts_us;
+    uint16_t len;
+    uint32_t crc32;
+} __attribute__((packed)) fram_ring_packed_header_t;
+
+#define FRAM_RING_PACKED_OVERHEAD (sizeof(fram_ring_packed_header_t) + 1)
+
+// Timestamp source for appended records. The time queries below assume it
+// never goes backwards over the life of the ring; esp_timer_get_time(), the
+// default, restarts at every boot.
+typedef uint64_t (*fram_ring_clock_fn)(void);
+
 typedef struct {
     fram_pm_t *pm;
     const fram_partition_t *part;
@@ -24,6 +43,20 @@ typedef struct {
     uint32_t max_payload;
     uint32_t capacity;
     uint32_t magic;
+    bool logical_clear;
+    fram_ring_clock_fn clock;
+    uint32_t base;          // slot 0 offset; the head hint lives below it
+    uint32_t hint_interval; // 0 = no head hint
+
+    // Packed mode: records back to back in [base, base + data_size), with
+    // byte positions relative to base
+    bool packed;
+    uint32_t data_size;
+    uint32_t head_off;
+    uint32_t tail_off;
+    uint32_t newest_off;
+    uint32_t used;
+    uint8_t anchor_copy;
 
     uint32_t head_slot;
     uint32_t tail_slot;
@@ -40,6 +73,17 @@ typedef struct {
     const char *partition_name;
     uint32_t max_payload;
     uint32_t magic;
+    bool logical_clear; // clear() zeroes live commit bytes instead of erasing
+    // Persist the newest slot and seq every `hint_interval` appends (0 = off).
+    // init() then checks the hint and binary-searches the head and tail
+    // instead of validating every slot. Reserves 32 bytes at the start of the
+    // partition, so it changes the layout; clamped to half the capacity.
+    uint32_t hint_interval;
+    // Variable-length records laid out back to back, wrapping at the end of
+    // the partition; appends evict whole oldest records. hint_interval is
+    // ignored: the partition starts with a tail anchor instead.
+    bool packed;
+    fram_ring_clock_fn clock; // NULL = esp_timer_get_time()
 } fram_ring_config_t;
 
 esp_err_t fram_ring_init(fram_ring_t *ring, const fram_ring_config_t *cfg);
@@ -47,6 +91,20 @@ esp_err_t fram_ring_deinit(fram_ring_t *ring);
 
 esp_err_t fram_ring_append(fram_ring_t *ring, const void *payload, size_t len);
 
+typedef struct {
+    const void *payload;
+    size_t len;
+} fram_ring_rec_t;
+
+// Append `count` records under one lock with one timestamp. Records are
+// staged into as few contiguous writes as possible and published oldest
+// first, so a reset during the call recovers a prefix of the batch. On
+// error the ring is unchanged in RAM, except that a fixed ring drops the
+// old records whose slots the batch was about to reuse; the prefix may
+// still be there after a reset. ESP_ERR_INVALID_SIZE if the batch would
+// evict its own records.
+esp_err_t fram_ring_append_batch(fram_ring_t *ring, const fram_ring_rec_t *recs, size_t count);
+
 esp_err_t fram_ring_peek_oldest(fram_ring_t *ring, void *payload, size_t *len,
                                 uint32_t *seq, uint64_t *ts_us);
 esp_err_t fram_ring_peek_newest(fram_ring_t *ring, void *payload, size_t *len,
@@ -58,8 +116,73 @@ typedef esp_err_t (*fram_ring_iter_fn)(uint32_t seq, uint64_t ts_us,
                                        const void *payload, size_t len, void *ctx);
 esp_err_t fram_ring_iterate(fram_ring_t *ring, fram_ring_iter_fn cb, void *ctx);
 
+// Random access. Fixed slots address a seq directly and binary-search
+// timestamps, reading one header per step; packed rings walk the header
+// chain from the tail (headers only, no payloads). ESP_ERR_NOT_FOUND when
+// `seq` is not in the ring.
+esp_err_t fram_ring_read_seq(fram_ring_t *ring, uint32_t seq, void *payload, size_t *len, uint64_t *ts_us);
+// First record stamped at or after `ts_us`; ESP_ERR_NOT_FOUND if none is.
+esp_err_t fram_ring_seek_time(fram_ring_t *ring, uint64_t ts_us, uint32_t *seq);
+// Records with from_seq <= seq < to_seq (UINT32_MAX: up to the newest).
+// Bounds compare modulo 2^32, like cursor seqs, so they must lie within 2^31
+// of the ring's records.
+esp_err_t fram_ring_iterate_range(fram_ring_t *ring, uint32_t from_seq, uint32_t to_seq,
+                                  fram_ring_iter_fn cb, void *ctx);
+// Records with from_ts <= ts_us < to_ts.
+esp_err_t fram_ring_iterate_time(fram_ring_t *ring, uint64_t from_ts, uint64_t to_ts,
+                                 fram_ring_iter_fn cb, void *ctx);
+
+// Consumer cursors: named read positions for one ring, persisted as a table
+// in a caller-provided vslot (max_payload >= sizeof(recs)). Each consumer
+// reads at its own pace and acks what it has handled; after a reset it
+// resumes at the first unacked record. A consumer that falls more than the
+// ring's length behind loses the overwritten records: lag() reports them and
+// read_next() carries on from the oldest record. An erasing clear() restarts
+// sequence numbers, so delete the cursors along with it.
+#define FRAM_RING_CURSOR_NAME_LEN 12
+
+typedef struct {
+    char name[FRAM_RING_CURSOR_NAME_LEN]; // empty = free entry
+    uint32_t seq;                         // first unacked seq
+} __attribute__((packed)) fram_ring_cursor_rec_t;
+
+typedef struct {
+    fram_ring_t *ring;
+    fram_vslot_t *vs;
+    fram_ring_cursor_rec_t recs[CONFIG_FRAM_RING_MAX_CURSORS];
+} fram_ring_cursor_store_t;
+
+typedef struct {
+    fram_ring_cursor_store_t *store;
+    uint32_t index;
+    uint32_t next_seq; // next record read_next() returns
+    uint32_t next_pos; // its byte position in a packed ring, if pos_valid
+    bool pos_valid;
+} fram_ring_cursor_t;
+
+esp_err_t fram_ring_cursor_store_init(fram_ring_cursor_store_t *store, fram_ring_t *ring, fram_vslot_t *vs);
+// Opens the named cursor, creating it at the oldest record if it does not
+// exist. ESP_ERR_NO_MEM when all CONFIG_FRAM_RING_MAX_CURSORS are taken.
+esp_err_t fram_ring_cursor_open(fram_ring_cursor_store_t *store, const char *name, fram_ring_cursor_t *cur);
+esp_err_t fram_ring_cursor_delete(fram_ring_cursor_store_t *store, const char *name);
+
+// ESP_ERR_NOT_FOUND once the cursor has caught up with the head.
+esp_err_t fram_ring_read_next(fram_ring_cursor_t *cur, void *payload, size_t *len,
+                              uint32_t *seq, uint64_t *ts_us);
+// Acknowledges every record up to and including `seq` with one vslot save;
+// acking per batch rather than per record keeps the writes down.
+esp_err_t fram_ring_ack(fram_ring_cursor_t *cur, uint32_t seq);
+// Moves the read position back to the first unacked record, e.g. after a
+// failed upload.
+esp_err_t fram_ring_cursor_rewind(fram_ring_cursor_t *cur);
+// `pending`: records in the ring not yet acked. `lost`: unacked records
+// already overwritten or cleared.
+esp_err_t fram_ring_cursor_lag(fram_ring_cursor_t *cur, uint32_t *pending, uint32_t *lost);
+
 esp_err_t fram_ring_clear(fram_ring_t *ring);
 uint32_t fram_ring_count(const fram_ring_t *ring);
+// Packed rings: the number of max_payload records that always fit. Full
+// means the next max_payload append would evict.
 uint32_t fram_ring_capacity(const fram_ring_t *ring);
 bool fram_ring_is_full(const fram_ring_t *ring);
 bool fram_ring_is_empty(const fram_ring_t *ring);
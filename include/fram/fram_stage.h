@@ -0,0 +1,101 @@
+#pragma once
+
+#include "fram/fram_ring.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "sdkconfig.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#if CONFIG_FRAM_STAGE_ENABLED
+
+// RAM staging ring (CONFIG_FRAM_STAGE_ENABLED) in front of a fram_ring_t.
+// Producers on any core or in an ISR reserve space with one compare-and-swap,
+// copy their record and publish it with one atomic store; no lock is taken
+// and nothing touches the bus. A drain call or task moves committed records
+// into the ring in reservation order. When the buffer is full new records
+// are dropped and counted. A record not yet committed holds back the ones
+// reserved after it, so keep reserve-to-commit windows short.
+
+#define FRAM_STAGE_SIZE CONFIG_FRAM_STAGE_SIZE
+
+#if (FRAM_STAGE_SIZE & (FRAM_STAGE_SIZE - 1)) != 0
+#error "CONFIG_FRAM_STAGE_SIZE must be a power of two"
+#endif
+
+typedef struct {
+    uint32_t pushed;        // records committed
+    uint32_t dropped;       // records refused because the buffer was full
+    uint32_t dropped_bytes; // payload bytes of those
+    uint32_t drained;       // records appended to the ring
+    uint32_t drain_errors;  // failed appends (the record stays staged)
+    uint32_t high_water;    // most bytes staged at once, headers included
+} fram_stage_stats_t;
+
+typedef struct {
+    fram_ring_t *ring;
+    uint32_t max_record; // largest payload accepted
+
+    // Positions count bytes since init and wrap at 2^32; the buffer index is
+    // pos % FRAM_STAGE_SIZE. head: next reservation, tail: next record to
+    // drain. Free-running so that head - tail is the fill level.
+    uint32_t head;
+    uint32_t tail;
+    uint8_t buf[FRAM_STAGE_SIZE] __attribute__((aligned(4)));
+
+    fram_stage_stats_t stats;
+
+    SemaphoreHandle_t drain_lock; // one drainer at a time
+    StaticSemaphore_t drain_lock_buf;
+
+    // Drain task, if started
+    uint32_t wake_bytes; // fill level at which producers wake the task
+    uint32_t period_ms;
+    uint32_t wake_pending;
+    volatile bool stop;
+    SemaphoreHandle_t wake;
+    StaticSemaphore_t wake_buf;
+    SemaphoreHandle_t stopped;
+    StaticSemaphore_t stopped_buf;
+    TaskHandle_t task;
+    StaticTask_t task_buf;
+    StackType_t stack[CONFIG_FRAM_STAGE_TASK_STACK / sizeof(StackType_t)];
+} fram_stage_t;
+
+typedef struct {
+    fram_ring_t *ring;        // initialised ring the records go to
+    bool start_task;          // run a drain task; otherwise call fram_stage_drain()
+    uint32_t task_priority;   // default: CONFIG_FRAM_STAGE_TASK_PRIORITY
+    uint32_t wake_bytes;      // default: half the buffer
+    uint32_t drain_period_ms; // drain at least this often; default 100
+} fram_stage_config_t;
+
+// deinit stops the task after a final drain; records that still cannot be
+// appended are lost.
+esp_err_t fram_stage_init(fram_stage_t *stage, const fram_stage_config_t *cfg);
+esp_err_t fram_stage_deinit(fram_stage_t *stage);
+
+// Producers; safe from ISRs and any task, never block. Records may be up to
+// the ring's max_payload and at most a quarter of the buffer.
+// ESP_ERR_NO_MEM (and a drop counted) when the buffer is full.
+esp_err_t fram_stage_push(fram_stage_t *stage, const void *payload, size_t len);
+// Two-step form for producers that build the record in place: reserve `len`
+// bytes, fill *buf, then commit exactly that buffer. Every reservation must
+// be committed.
+esp_err_t fram_stage_reserve(fram_stage_t *stage, size_t len, void **buf);
+esp_err_t fram_stage_commit(fram_stage_t *stage, void *buf);
+
+// Append up to `max` committed records (0 = all) to the ring, in
+// fram_ring_append_batch() calls of up to 16 records. Task context only.
+// *drained (may be NULL) receives the count. Stops at the first failed batch
+// and returns its error; that batch stays staged.
+esp_err_t fram_stage_drain(fram_stage_t *stage, size_t max, size_t *drained);
+
+// Bytes currently staged, headers and padding included
+uint32_t fram_stage_used(const fram_stage_t *stage);
+void fram_stage_get_stats(const fram_stage_t *stage, fram_stage_stats_t *stats);
+void fram_stage_reset_stats(fram_stage_t *stage);
+
+#endif // CONFIG_FRAM_STAGE_ENABLED
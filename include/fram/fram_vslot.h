@@ -23,6 +23,7 @@ typedef struct {
     uint32_t max_payload;
     uint32_t slot_size;
     uint32_t magic;
+    bool logical_clear;
 
     uint32_t active_slot;
     uint32_t active_version;
@@ -38,6 +39,7 @@ typedef struct {
     uint32_t max_payload;
     uint32_t slot_count; // 2 or 3
     uint32_t magic;
+    bool logical_clear; // clear() zeroes the commit bytes instead of erasing
 } fram_vslot_config_t;
 
 esp_err_t fram_vslot_init(fram_vslot_t *vs, const fram_vslot_config_t *cfg);
@@ -0,0 +1,67 @@
+#include "fram/fram_chip.h"
+
+#define FRAM_CHIP_CONT_CODE 0x7F
+
+#define FRAM_MANUF_CYPRESS 0xC2 // Ramtron/Cypress/Infineon (bank 7)
+#define FRAM_MANUF_FUJITSU 0x04
+
+#define KB(x) ((x) * 1024U)
+#define MHZ(x) ((x) * 1000000U)
+
+// Device byte: Cypress encodes family (bits 7..5) and density (bits 4..0);
+// Fujitsu a vendor field and density. The revision byte after it is ignored.
+// Parts without RDID (e.g. MB85RS256B) cannot be probed and are not listed.
+static const fram_chip_t s_chips[] = {
+    { "FM25V01A",   FRAM_MANUF_CYPRESS, 0x21, KB(16),   2, MHZ(40), FRAM_CHIP_FSTRD },
+    { "FM25V02A",   FRAM_MANUF_CYPRESS, 0x22, KB(32),   2, MHZ(40), FRAM_CHIP_FSTRD },
+    { "FM25V05",    FRAM_MANUF_CYPRESS, 0x23, KB(64),   2, MHZ(40), FRAM_CHIP_FSTRD },
+    { "FM25V10",    FRAM_MANUF_CYPRESS, 0x24, KB(128),  3, MHZ(40), FRAM_CHIP_FSTRD },
+    { "FM25V20A",   FRAM_MANUF_CYPRESS, 0x25, KB(256),  3, MHZ(40), FRAM_CHIP_FSTRD },
+    { "CY15B104Q",  FRAM_MANUF_CYPRESS, 0x26, KB(512),  3, MHZ(40), FRAM_CHIP_FSTRD },
+    { "MB85RS64V",  FRAM_MANUF_FUJITSU, 0x03, KB(8),    2, MHZ(20), 0 },
+    { "MB85RS512T", FRAM_MANUF_FUJITSU, 0x26, KB(64),   2, MHZ(30), FRAM_CHIP_FSTRD },
+    { "MB85RS1MT",  FRAM_MANUF_FUJITSU, 0x27, KB(128),  3, MHZ(30), FRAM_CHIP_FSTRD },
+    { "MB85RS2MT",  FRAM_MANUF_FUJITSU, 0x48, KB(256),  3, MHZ(40), FRAM_CHIP_FSTRD },
+    { "MB85RS4MT",  FRAM_MANUF_FUJITSU, 0x49, KB(512),  3, MHZ(40), FRAM_CHIP_FSTRD },
+};
+
+esp_err_t fram_chip_identify(const uint8_t *rdid, size_t len, const fram_chip_t **chip) {
+    if (rdid == NULL || chip == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    size_t i = 0;
+    while (i < len && rdid[i] == FRAM_CHIP_CONT_CODE) {
+        i++;
+    }
+    if (i >= len) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    uint8_t manuf = rdid[i++];
+    while (i < len && rdid[i] == FRAM_CHIP_CONT_CODE) {
+        i++;
+    }
+    if (i >= len) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    uint8_t device = rdid[i];
+
+    for (size_t n = 0; n < sizeof(s_chips) / sizeof(s_chips[0]); n++) {
+        if (s_chips[n].manuf_id == manuf && s_chips[n].device_id == device) {
+            *chip = &s_chips[n];
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+size_t fram_chip_count(void) {
+    return sizeof(s_chips) / sizeof(s_chips[0]);
+}
+
+const fram_chip_t *fram_chip_get(size_t index) {
+    if (index >= fram_chip_count()) {
+        return NULL;
+    }
+    return &s_chips[index];
+}
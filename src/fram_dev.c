@@ -1,25 +1,187 @@
 #include "fram/fram_dev.h"
 
 #include "esp_check.h"
+#include "esp_timer.h"
 #include "sdkconfig.h"
 #include <string.h>
 
 #define TAG "fram_dev"
 
+// Source for fill on HALs without a fill op; 0xFF (erase) is the common case
+// and comes from flash, other values from a small stack pattern.
+#define FRAM_DEV_FILL_STACK 64
+#define FRAM_DEV_VERIFY_CHUNK 64
+// Longest a preempted transfer waits for the waiter to take the device
+#define FRAM_DEV_HANDOFF_US 100
+static const uint8_t s_fill_ff[256] = {
+    [0 ... 255] = 0xFF,
+};
+
+#if CONFIG_FRAM_DEV_STATS
+// Stats are written with the device lock held; the atomics keep lock-free
+// snapshots from seeing torn 64-bit values.
+#define FRAM_DEV_STAT_ADD(field, n) __atomic_fetch_add(&(field), (n), __ATOMIC_RELAXED)
+#define FRAM_DEV_STAT_GET(field) __atomic_load_n(&(field), __ATOMIC_RELAXED)
+#define FRAM_DEV_STAT_CLEAR(field) __atomic_store_n(&(field), 0, __ATOMIC_RELAXED)
+
+static void fram_dev_stat_max(uint32_t *field, int64_t val) {
+    uint32_t v = val > UINT32_MAX ? UINT32_MAX : (uint32_t)val;
+    uint32_t cur = __atomic_load_n(field, __ATOMIC_RELAXED);
+    while (v > cur && !__atomic_compare_exchange_n(field, &cur, v, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+static uint32_t fram_dev_hist_bucket(int64_t us) {
+    if (us <= 0) {
+        return 0;
+    }
+    if (us >= (1LL << (FRAM_DEV_HIST_BUCKETS - 1))) {
+        return FRAM_DEV_HIST_BUCKETS - 1;
+    }
+    return 32 - (uint32_t)__builtin_clz((uint32_t)us);
+}
+
+static void fram_dev_stat_bytes(fram_dev_t *dev, bool write, size_t bytes) {
+    if (write) {
+        FRAM_DEV_STAT_ADD(dev->xstats.bytes_written, (uint64_t)bytes);
+    } else {
+        FRAM_DEV_STAT_ADD(dev->xstats.bytes_read, (uint64_t)bytes);
+    }
+}
+
+// One synchronous call, from before the lock wait to now; lock held.
+static void fram_dev_stat_op(fram_dev_t *dev, bool write, size_t bytes) {
+    uint32_t *hist = write ? dev->xstats.write_hist : dev->xstats.read_hist;
+    FRAM_DEV_STAT_ADD(hist[fram_dev_hist_bucket(esp_timer_get_time() - dev->op_start_us)], 1);
+    fram_dev_stat_bytes(dev, write, bytes);
+}
+#else
+#define fram_dev_stat_bytes(dev, write, bytes) ((void)(bytes))
+#define fram_dev_stat_op(dev, write, bytes) ((void)(bytes))
+#endif
+
+// Preemptible devices: a waiter with a higher priority than the owner
+// registers its budget deadline, which the owner checks between pieces.
+static uint32_t fram_dev_budget_of(const fram_dev_t *dev, TaskHandle_t task) {
+    for (size_t i = 0; i < FRAM_DEV_BUDGET_TASKS; i++) {
+        if (dev->budgets[i].task == task) {
+            return dev->budgets[i].budget_us;
+        }
+    }
+    return dev->preempt_budget_us;
+}
+
+static bool fram_dev_wait_register(fram_dev_t *dev, TaskHandle_t self) {
+    if (dev->lock_owner == NULL || uxTaskPriorityGet(NULL) <= dev->lock_prio) {
+        return false;
+    }
+    int64_t deadline = esp_timer_get_time() + fram_dev_budget_of(dev, self);
+    int64_t cur = __atomic_load_n(&dev->hi_deadline_us, __ATOMIC_RELAXED);
+    while (deadline < cur && !__atomic_compare_exchange_n(&dev->hi_deadline_us, &cur, deadline, true,
+                                                          __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+    }
+    __atomic_fetch_add(&dev->hi_waiters, 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+static void fram_dev_wait_unregister(fram_dev_t *dev) {
+    if (__atomic_sub_fetch(&dev->hi_waiters, 1, __ATOMIC_ACQ_REL) == 0) {
+        __atomic_store_n(&dev->hi_deadline_us, INT64_MAX, __ATOMIC_RELEASE);
+    }
+}
+
+// The device lock is re-entrant for its owner: inside fram_dev_begin() /
+// fram_dev_end() (or a nested call) the owner only bumps lock_depth, with no
+// semaphore round-trip.
 static esp_err_t fram_dev_lock(fram_dev_t *dev) {
     if (dev == NULL || dev->mutex == NULL) {
         return ESP_ERR_INVALID_STATE;
     }
-    if (xSemaphoreTake(dev->mutex, pdMS_TO_TICKS(dev->mutex_timeout_ms)) != pdTRUE) {
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    if (dev->lock_owner == self) {
+        // op_start_us stays at the outermost lock, so a nested call does not
+        // cut short the latency of the op or scope around it
+        dev->lock_depth++;
+        return ESP_OK;
+    }
+#if CONFIG_FRAM_DEV_STATS
+    int64_t start = esp_timer_get_time();
+#endif
+    bool hi = dev->preempt_chunk != 0 && fram_dev_wait_register(dev, self);
+    BaseType_t taken = xSemaphoreTake(dev->mutex, pdMS_TO_TICKS(dev->mutex_timeout_ms));
+    if (hi) {
+        fram_dev_wait_unregister(dev);
+    }
+    if (taken != pdTRUE) {
         return ESP_ERR_TIMEOUT;
     }
+    dev->lock_owner = self;
+    dev->lock_depth = 1;
+    if (dev->preempt_chunk != 0) {
+        dev->lock_prio = uxTaskPriorityGet(NULL);
+        dev->chunk_at_us = esp_timer_get_time();
+    }
+#if CONFIG_FRAM_DEV_STATS
+    int64_t now = esp_timer_get_time();
+    FRAM_DEV_STAT_ADD(dev->xstats.lock_wait_us, (uint64_t)(now - start));
+    fram_dev_stat_max(&dev->xstats.lock_wait_max_us, now - start);
+    dev->op_start_us = start;
+    dev->locked_at_us = now;
+#endif
     return ESP_OK;
 }
 
 static void fram_dev_unlock(fram_dev_t *dev) {
-    if (dev && dev->mutex) {
-        xSemaphoreGive(dev->mutex);
+    if (dev == NULL || dev->mutex == NULL || dev->lock_depth == 0 ||
+        dev->lock_owner != xTaskGetCurrentTaskHandle()) {
+        return;
+    }
+    if (--dev->lock_depth > 0) {
+        return;
+    }
+#if CONFIG_FRAM_DEV_STATS
+    fram_dev_stat_max(&dev->xstats.lock_hold_max_us, esp_timer_get_time() - dev->locked_at_us);
+#endif
+    dev->lock_owner = NULL;
+    xSemaphoreGive(dev->mutex);
+}
+
+static esp_err_t fram_dev_stage_flush(fram_dev_t *dev);
+
+// Device lock plus, for HALs that support it, exclusive use of the bus until
+// fram_dev_unlock_bus(). Used by the synchronous paths only: async ops stay
+// queued past the call that submitted them. Nested calls reuse the bus held
+// by the outermost one.
+static esp_err_t fram_dev_lock_bus(fram_dev_t *dev) {
+    esp_err_t err = fram_dev_lock(dev);
+    if (err != ESP_OK || dev->lock_depth > 1) {
+        return err;
+    }
+    if (dev->hal->acquire) {
+        err = dev->hal->acquire(dev->hal);
+        if (err != ESP_OK) {
+            fram_dev_unlock(dev);
+            return err;
+        }
+    }
+#if CONFIG_FRAM_DEV_COMBINE_SIZE
+    // The combine timer only marks staged writes due; the next call flushes
+    if (__atomic_load_n(&dev->stage_due, __ATOMIC_ACQUIRE) && fram_dev_stage_flush(dev) != ESP_OK) {
+        ESP_LOGW(TAG, "timed flush of staged writes failed");
+    }
+#endif
+    return ESP_OK;
+}
+
+static void fram_dev_unlock_bus(fram_dev_t *dev) {
+    // Not the owner: a preemptible transfer failed to take the device back
+    if (dev->lock_owner != xTaskGetCurrentTaskHandle()) {
+        return;
     }
+    if (dev->hal->release && dev->lock_depth == 1) {
+        dev->hal->release(dev->hal);
+    }
+    fram_dev_unlock(dev);
 }
 
 static void fram_dev_record_error(fram_dev_t *dev) {
@@ -34,6 +196,64 @@ static void fram_dev_record_success(fram_dev_t *dev) {
     dev->consecutive_errors = 0;
 }
 
+// Bytes handed to the HAL per call. HALs that stream a whole range in one
+// transfer (one CS window) get it unsplit.
+static uint32_t fram_dev_max_chunk(const fram_dev_t *dev) {
+    uint32_t chunk = dev->hal->max_transfer;
+    if ((dev->hal->caps & FRAM_HAL_CAP_CONTINUOUS) || chunk == 0) {
+        chunk = dev->hal->size_bytes;
+    }
+    if (dev->preemptible && dev->preempt_chunk < chunk) {
+        chunk = dev->preempt_chunk;
+    }
+    return chunk;
+}
+
+// Between two pieces of a preemptible transfer: if a higher-priority task
+// waits and its budget would run out during the next piece, release the
+// device, let the waiter take it, then queue up again. The waiter runs at
+// its own priority, and while it waits this task inherits it as usual.
+// ESP_ERR_NOT_FINISHED if the device cannot be taken back: the caller no
+// longer owns it and must return without touching `dev`.
+static esp_err_t fram_dev_preempt_point(fram_dev_t *dev) {
+    if (!dev->preemptible || dev->lock_depth != 1) {
+        return ESP_OK;
+    }
+    int64_t now = esp_timer_get_time();
+    int64_t piece = now - dev->chunk_at_us;
+    dev->chunk_at_us = now;
+    if (__atomic_load_n(&dev->hi_waiters, __ATOMIC_ACQUIRE) == 0 ||
+        now + piece < __atomic_load_n(&dev->hi_deadline_us, __ATOMIC_ACQUIRE)) {
+        return ESP_OK;
+    }
+
+    dev->preempt_yields++;
+#if CONFIG_FRAM_DEV_STATS
+    int64_t op_start = dev->op_start_us;
+#endif
+    // The next owner's transfers decide for themselves
+    dev->preemptible = false;
+    fram_dev_unlock_bus(dev);
+    // Giving the mutex only readies the waiter; on another core it may not
+    // have run yet, and taking the mutex straight back would starve it
+    int64_t until = esp_timer_get_time() + FRAM_DEV_HANDOFF_US;
+    while (__atomic_load_n(&dev->hi_waiters, __ATOMIC_ACQUIRE) > 0 && esp_timer_get_time() < until) {
+        taskYIELD();
+    }
+    if (fram_dev_lock_bus(dev) != ESP_OK) {
+        return ESP_ERR_NOT_FINISHED;
+    }
+    dev->preemptible = true;
+#if CONFIG_FRAM_DEV_STATS
+    dev->op_start_us = op_start;
+#endif
+    return ESP_OK;
+}
+
+#if CONFIG_FRAM_DEV_COMBINE_SIZE
+static void fram_dev_stage_timer(TimerHandle_t timer);
+#endif
+
 esp_err_t fram_dev_init(fram_dev_t *dev, const fram_dev_config_t *cfg) {
     if (dev == NULL || cfg == NULL || cfg->hal == NULL) {
         return ESP_ERR_INVALID_ARG;
@@ -61,6 +281,31 @@ esp_err_t fram_dev_init(fram_dev_t *dev, const fram_dev_config_t *cfg) {
         return ESP_ERR_INVALID_STATE;
     }
 
+    if (cfg->shadow) {
+        if (cfg->shadow_len < dev->hal->size_bytes) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+        dev->shadow = cfg->shadow;
+        ESP_RETURN_ON_ERROR(fram_dev_shadow_sync(dev), TAG, "shadow load failed");
+    }
+#if CONFIG_FRAM_DEV_CACHE_LINES
+    dev->cache_enabled = cfg->cache && dev->shadow == NULL;
+#endif
+    if (dev->shadow == NULL) {
+        dev->preempt_chunk = cfg->preempt_chunk;
+    }
+    dev->preempt_budget_us = cfg->preempt_budget_us ? cfg->preempt_budget_us : CONFIG_FRAM_DEFAULT_PREEMPT_BUDGET_US;
+    dev->hi_deadline_us = INT64_MAX;
+#if CONFIG_FRAM_DEV_COMBINE_SIZE
+    if (cfg->combine && dev->shadow == NULL) {
+        dev->stage_timer = xTimerCreateStatic("fram_dev", pdMS_TO_TICKS(CONFIG_FRAM_DEV_COMBINE_TIMEOUT_MS), pdFALSE,
+                                              dev, fram_dev_stage_timer, &dev->stage_timer_buf);
+        if (dev->stage_timer == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+#endif
+
     return ESP_OK;
 }
 
@@ -68,6 +313,18 @@ esp_err_t fram_dev_deinit(fram_dev_t *dev) {
     if (dev == NULL || dev->hal == NULL) {
         return ESP_ERR_INVALID_ARG;
     }
+#if CONFIG_FRAM_DEV_COMBINE_SIZE
+    if (dev->stage_timer != NULL) {
+        if (fram_dev_lock_bus(dev) == ESP_OK) {
+            if (fram_dev_stage_flush(dev) != ESP_OK) {
+                ESP_LOGW(TAG, "staged writes lost at deinit");
+            }
+            fram_dev_unlock_bus(dev);
+        }
+        xTimerDelete(dev->stage_timer, portMAX_DELAY);
+        dev->stage_timer = NULL;
+    }
+#endif
     if (dev->hal->deinit) {
         dev->hal->deinit(dev->hal);
     }
@@ -75,28 +332,18 @@ esp_err_t fram_dev_deinit(fram_dev_t *dev) {
     return ESP_OK;
 }
 
-esp_err_t fram_dev_read(fram_dev_t *dev, uint32_t offset, void *buf, size_t len) {
-    if (dev == NULL || dev->hal == NULL || buf == NULL) {
-        return ESP_ERR_INVALID_ARG;
-    }
-    if (len == 0) {
-        return ESP_OK;
-    }
+static bool fram_dev_range_ok(const fram_dev_t *dev, uint32_t offset, size_t len) {
     uint32_t size_bytes = dev->hal->size_bytes;
-    if (size_bytes == 0 || offset > size_bytes || len > size_bytes || offset > size_bytes - len) {
-        return ESP_ERR_INVALID_SIZE;
-    }
-
-    esp_err_t err = fram_dev_lock(dev);
-    if (err != ESP_OK) {
-        fram_dev_record_error(dev);
-        return err;
-    }
+    return size_bytes != 0 && offset <= size_bytes && len <= size_bytes && offset <= size_bytes - len;
+}
 
+// Chunked transfers; the caller holds the bus (fram_dev_lock_bus).
+static esp_err_t fram_dev_read_locked(fram_dev_t *dev, uint32_t offset, void *buf, size_t len) {
+    esp_err_t err = ESP_OK;
     size_t remaining = len;
     uint8_t *out = (uint8_t *)buf;
     uint32_t addr = offset;
-    uint32_t max_transfer = dev->hal->max_transfer ? dev->hal->max_transfer : size_bytes;
+    uint32_t max_transfer = fram_dev_max_chunk(dev);
 
     while (remaining > 0) {
         size_t chunk = remaining > max_transfer ? max_transfer : remaining;
@@ -110,114 +357,1361 @@ esp_err_t fram_dev_read(fram_dev_t *dev, uint32_t offset, void *buf, size_t len)
         out += chunk;
         addr += chunk;
         remaining -= chunk;
+        if (remaining > 0 && (err = fram_dev_preempt_point(dev)) != ESP_OK) {
+            break;
+        }
     }
-
-    fram_dev_unlock(dev);
     return err;
 }
 
-esp_err_t fram_dev_write(fram_dev_t *dev, uint32_t offset, const void *buf, size_t len) {
-    if (dev == NULL || dev->hal == NULL || buf == NULL) {
-        return ESP_ERR_INVALID_ARG;
+#if CONFIG_FRAM_DEV_CACHE_LINES
+static uint32_t fram_dev_cache_tag(uint32_t offset) {
+    return offset & ~(uint32_t)(FRAM_DEV_CACHE_LINE_SIZE - 1);
+}
+
+static bool fram_dev_cache_overlaps(uint32_t tag, uint32_t offset, size_t len) {
+    return tag < offset + len && offset < tag + FRAM_DEV_CACHE_LINE_SIZE;
+}
+
+static bool fram_dev_cache_in_pin(const fram_dev_t *dev, uint32_t tag) {
+    for (size_t i = 0; i < FRAM_DEV_CACHE_PINS; i++) {
+        const fram_dev_cache_pin_t *pin = &dev->cache_pins[i];
+        if (pin->len > 0 && fram_dev_cache_overlaps(tag, pin->offset, pin->len)) {
+            return true;
+        }
     }
-    if (len == 0) {
-        return ESP_OK;
+    return false;
+}
+
+static fram_dev_cache_line_t *fram_dev_cache_find(fram_dev_t *dev, uint32_t tag) {
+    for (size_t i = 0; i < FRAM_DEV_CACHE_LINES; i++) {
+        if (dev->cache[i].valid && dev->cache[i].tag == tag) {
+            return &dev->cache[i];
+        }
     }
-    uint32_t size_bytes = dev->hal->size_bytes;
-    if (size_bytes == 0 || offset > size_bytes || len > size_bytes || offset > size_bytes - len) {
-        return ESP_ERR_INVALID_SIZE;
+    return NULL;
+}
+
+// CLOCK: an empty line if there is one, otherwise the first unpinned line
+// whose reference bit is clear, clearing bits on the way. Two sweeps always
+// find one because pinning leaves at least one line evictable.
+static fram_dev_cache_line_t *fram_dev_cache_victim(fram_dev_t *dev) {
+    for (size_t i = 0; i < FRAM_DEV_CACHE_LINES; i++) {
+        if (!dev->cache[i].valid) {
+            return &dev->cache[i];
+        }
+    }
+    for (size_t n = 0; n < 2 * FRAM_DEV_CACHE_LINES; n++) {
+        fram_dev_cache_line_t *line = &dev->cache[dev->cache_hand];
+        dev->cache_hand = (dev->cache_hand + 1) % FRAM_DEV_CACHE_LINES;
+        if (line->pinned) {
+            continue;
+        }
+        if (line->ref) {
+            line->ref = false;
+            continue;
+        }
+        return line;
     }
+    return NULL;
+}
 
-    esp_err_t err = fram_dev_lock(dev);
+// Caller holds the bus.
+static esp_err_t fram_dev_cache_get(fram_dev_t *dev, uint32_t tag, fram_dev_cache_line_t **out) {
+    fram_dev_cache_line_t *line = fram_dev_cache_find(dev, tag);
+    if (line) {
+        dev->cache_hits++;
+        line->ref = true;
+        *out = line;
+        return ESP_OK;
+    }
+
+    dev->cache_misses++;
+    line = fram_dev_cache_victim(dev);
+    if (line == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    uint32_t len = dev->hal->size_bytes - tag;
+    if (len > FRAM_DEV_CACHE_LINE_SIZE) {
+        len = FRAM_DEV_CACHE_LINE_SIZE;
+    }
+    line->valid = false;
+    esp_err_t err = fram_dev_read_locked(dev, tag, line->data, len);
     if (err != ESP_OK) {
-        fram_dev_record_error(dev);
         return err;
     }
+    line->tag = tag;
+    line->valid = true;
+    line->ref = true;
+    line->pinned = fram_dev_cache_in_pin(dev, tag);
+    *out = line;
+    return ESP_OK;
+}
+
+// A read of at most one line, so it spans one or two lines.
+static esp_err_t fram_dev_cache_read(fram_dev_t *dev, uint32_t offset, void *buf, size_t len) {
+    uint8_t *out = (uint8_t *)buf;
+    while (len > 0) {
+        fram_dev_cache_line_t *line;
+        uint32_t tag = fram_dev_cache_tag(offset);
+        esp_err_t err = fram_dev_cache_get(dev, tag, &line);
+        if (err != ESP_OK) {
+            return err;
+        }
+        size_t at = offset - tag;
+        size_t n = FRAM_DEV_CACHE_LINE_SIZE - at;
+        if (n > len) {
+            n = len;
+        }
+        memcpy(out, line->data + at, n);
+        out += n;
+        offset += (uint32_t)n;
+        len -= n;
+    }
+    return ESP_OK;
+}
+
+// Write-through: bring resident lines overlapping a written range up to
+// date. `buf` NULL means the range was filled with `value`.
+static void fram_dev_cache_store(fram_dev_t *dev, uint32_t offset, const void *buf, uint8_t value, size_t len) {
+    for (size_t i = 0; i < FRAM_DEV_CACHE_LINES; i++) {
+        fram_dev_cache_line_t *line = &dev->cache[i];
+        if (!line->valid || !fram_dev_cache_overlaps(line->tag, offset, len)) {
+            continue;
+        }
+        uint32_t start = offset > line->tag ? offset : line->tag;
+        uint32_t end = offset + (uint32_t)len;
+        if (end > line->tag + FRAM_DEV_CACHE_LINE_SIZE) {
+            end = line->tag + FRAM_DEV_CACHE_LINE_SIZE;
+        }
+        if (buf) {
+            memcpy(line->data + (start - line->tag), (const uint8_t *)buf + (start - offset), end - start);
+        } else {
+            memset(line->data + (start - line->tag), value, end - start);
+        }
+    }
+}
+
+// Drop lines overlapping a range whose device content is unknown.
+static void fram_dev_cache_drop(fram_dev_t *dev, uint32_t offset, size_t len) {
+    for (size_t i = 0; i < FRAM_DEV_CACHE_LINES; i++) {
+        if (dev->cache[i].valid && fram_dev_cache_overlaps(dev->cache[i].tag, offset, len)) {
+            dev->cache[i].valid = false;
+        }
+    }
+}
+
+static bool fram_dev_cacheable(const fram_dev_t *dev, size_t len) {
+    return dev->cache_enabled && len <= FRAM_DEV_CACHE_LINE_SIZE;
+}
+#else
+static esp_err_t fram_dev_cache_read(fram_dev_t *dev, uint32_t offset, void *buf, size_t len) {
+    return fram_dev_read_locked(dev, offset, buf, len);
+}
+
+static void fram_dev_cache_store(fram_dev_t *dev, uint32_t offset, const void *buf, uint8_t value, size_t len) {
+    (void)dev;
+    (void)offset;
+    (void)buf;
+    (void)value;
+    (void)len;
+}
+
+static void fram_dev_cache_drop(fram_dev_t *dev, uint32_t offset, size_t len) {
+    (void)dev;
+    (void)offset;
+    (void)len;
+}
+
+static bool fram_dev_cacheable(const fram_dev_t *dev, size_t len) {
+    (void)dev;
+    (void)len;
+    return false;
+}
+#endif // CONFIG_FRAM_DEV_CACHE_LINES
+
+// Cached reads count once per call, like reads served from the shadow;
+// line loads count as device reads on their own.
+static esp_err_t fram_dev_cache_readv(fram_dev_t *dev, const fram_rvec_t *vec, size_t count) {
+    esp_err_t err = ESP_OK;
+    for (size_t i = 0; i < count && err == ESP_OK; i++) {
+        err = fram_dev_cache_read(dev, vec[i].offset, vec[i].buf, vec[i].len);
+    }
+    if (err == ESP_OK) {
+        dev->read_count++;
+    }
+    return err;
+}
 
+static esp_err_t fram_dev_write_locked(fram_dev_t *dev, uint32_t offset, const void *buf, size_t len) {
+    esp_err_t err = ESP_OK;
     size_t remaining = len;
     const uint8_t *in = (const uint8_t *)buf;
     uint32_t addr = offset;
-    uint32_t max_transfer = dev->hal->max_transfer ? dev->hal->max_transfer : size_bytes;
+    uint32_t max_transfer = fram_dev_max_chunk(dev);
 
     while (remaining > 0) {
         size_t chunk = remaining > max_transfer ? max_transfer : remaining;
         err = dev->hal->write(dev->hal, addr, in, chunk);
         if (err != ESP_OK) {
+            fram_dev_cache_drop(dev, addr, chunk);
             fram_dev_record_error(dev);
             break;
         }
+        fram_dev_cache_store(dev, addr, in, 0, chunk);
         dev->write_count++;
         fram_dev_record_success(dev);
         in += chunk;
         addr += chunk;
         remaining -= chunk;
+        if (remaining > 0 && (err = fram_dev_preempt_point(dev)) != ESP_OK) {
+            break;
+        }
     }
-
-    fram_dev_unlock(dev);
     return err;
 }
 
-esp_err_t fram_dev_read_u8(fram_dev_t *dev, uint32_t offset, uint8_t *val) {
-    return fram_dev_read(dev, offset, val, sizeof(*val));
+static bool fram_dev_shadowed(const fram_dev_t *dev) {
+    return dev->shadow != NULL && dev->shadow_valid;
 }
 
-esp_err_t fram_dev_read_u16(fram_dev_t *dev, uint32_t offset, uint16_t *val) {
-    return fram_dev_read(dev, offset, val, sizeof(*val));
+// Leading / trailing bytes of a write that the shadow already holds.
+static size_t fram_dev_shadow_head(const fram_dev_t *dev, uint32_t offset, const uint8_t *in, size_t len) {
+    const uint8_t *old = dev->shadow + offset;
+    size_t n = 0;
+    while (n < len && in[n] == old[n]) {
+        n++;
+    }
+    return n;
 }
 
-esp_err_t fram_dev_read_u32(fram_dev_t *dev, uint32_t offset, uint32_t *val) {
-    return fram_dev_read(dev, offset, val, sizeof(*val));
+static size_t fram_dev_shadow_tail(const fram_dev_t *dev, uint32_t offset, const uint8_t *in, size_t len) {
+    const uint8_t *old = dev->shadow + offset;
+    size_t n = 0;
+    while (n < len && in[len - 1 - n] == old[len - 1 - n]) {
+        n++;
+    }
+    return n;
 }
 
-esp_err_t fram_dev_read_u64(fram_dev_t *dev, uint32_t offset, uint64_t *val) {
-    return fram_dev_read(dev, offset, val, sizeof(*val));
+// Narrow a write to the bytes that differ from the shadow. False if the
+// device already holds all of them.
+static bool fram_dev_shadow_trim(fram_dev_t *dev, uint32_t *offset, const uint8_t **buf, size_t *len) {
+    size_t head = fram_dev_shadow_head(dev, *offset, *buf, *len);
+    size_t tail = head < *len ? fram_dev_shadow_tail(dev, *offset + (uint32_t)head, *buf + head, *len - head) : 0;
+    dev->shadow_skipped += (uint32_t)(head + tail);
+    if (head == *len) {
+        return false;
+    }
+    *offset += (uint32_t)head;
+    *buf += head;
+    *len -= head + tail;
+    return true;
 }
 
-esp_err_t fram_dev_write_u8(fram_dev_t *dev, uint32_t offset, uint8_t val) {
-    return fram_dev_write(dev, offset, &val, sizeof(val));
+// fram_dev_shadow_trim() for a fill with `value`.
+static bool fram_dev_shadow_trim_fill(fram_dev_t *dev, uint32_t *offset, uint8_t value, size_t *len) {
+    const uint8_t *old = dev->shadow + *offset;
+    size_t first = 0;
+    size_t last = *len;
+    while (first < last && old[first] == value) {
+        first++;
+    }
+    while (last > first && old[last - 1] == value) {
+        last--;
+    }
+    dev->shadow_skipped += (uint32_t)(*len - (last - first));
+    if (first == last) {
+        return false;
+    }
+    *offset += (uint32_t)first;
+    *len = last - first;
+    return true;
 }
 
-esp_err_t fram_dev_write_u16(fram_dev_t *dev, uint32_t offset, uint16_t val) {
-    return fram_dev_write(dev, offset, &val, sizeof(val));
+// After a failed write the device content of the range is unknown: re-read
+// it, or stop serving reads from the shadow until fram_dev_shadow_sync().
+static void fram_dev_shadow_reload(fram_dev_t *dev, uint32_t offset, size_t len) {
+    if (fram_dev_read_locked(dev, offset, dev->shadow + offset, len) != ESP_OK) {
+        dev->shadow_valid = false;
+        ESP_LOGW(TAG, "shadow disabled: 0x%x+%u unreadable after a failed write",
+                 (unsigned)offset, (unsigned)len);
+    }
 }
 
-esp_err_t fram_dev_write_u32(fram_dev_t *dev, uint32_t offset, uint32_t val) {
-    return fram_dev_write(dev, offset, &val, sizeof(val));
+// Write the segments in order, bypassing staging. Caller holds the bus.
+static esp_err_t fram_dev_writev_locked(fram_dev_t *dev, const fram_wvec_t *vec, size_t count) {
+    esp_err_t err = ESP_OK;
+    // Shadowed: drop the bytes at either end of each contiguous run that the
+    // device already holds. Segments inside a run stay whole so the run is
+    // still one transaction. The shadow is updated run by run so a later run
+    // (e.g. a commit byte set after being cleared) compares against it.
+    fram_wvec_t trimmed[FRAM_VEC_MAX];
+    bool shadowed = fram_dev_shadowed(dev);
+    if (shadowed) {
+        size_t n = 0;
+        size_t end;
+        for (size_t i = 0; i < count; i = end) {
+            end = i + 1;
+            while (end < count && vec[end].offset == vec[end - 1].offset + vec[end - 1].len) {
+                end++;
+            }
+            size_t lo = i;
+            size_t hi = end;
+            while (lo < hi && fram_dev_shadow_head(dev, vec[lo].offset, vec[lo].buf, vec[lo].len) == vec[lo].len) {
+                dev->shadow_skipped += (uint32_t)vec[lo++].len;
+            }
+            while (hi > lo &&
+                   fram_dev_shadow_tail(dev, vec[hi - 1].offset, vec[hi - 1].buf, vec[hi - 1].len) == vec[hi - 1].len) {
+                dev->shadow_skipped += (uint32_t)vec[--hi].len;
+            }
+            if (lo == hi) {
+                continue;
+            }
+            size_t first = n;
+            for (size_t k = lo; k < hi; k++) {
+                trimmed[n++] = vec[k];
+            }
+            fram_wvec_t *head = &trimmed[first];
+            size_t skip = fram_dev_shadow_head(dev, head->offset, head->buf, head->len);
+            head->offset += (uint32_t)skip;
+            head->buf = (const uint8_t *)head->buf + skip;
+            head->len -= skip;
+            fram_wvec_t *tail = &trimmed[n - 1];
+            size_t cut = fram_dev_shadow_tail(dev, tail->offset, tail->buf, tail->len);
+            tail->len -= cut;
+            dev->shadow_skipped += (uint32_t)(skip + cut);
+            for (size_t k = first; k < n; k++) {
+                memcpy(dev->shadow + trimmed[k].offset, trimmed[k].buf, trimmed[k].len);
+            }
+        }
+        vec = trimmed;
+        count = n;
+    }
+
+    if (count == 0) {
+        // Nothing to send
+    } else if (dev->hal->writev) {
+        err = dev->hal->writev(dev->hal, vec, count);
+        for (size_t i = 0; i < count; i++) {
+            if (err == ESP_OK) {
+                fram_dev_cache_store(dev, vec[i].offset, vec[i].buf, 0, vec[i].len);
+            } else {
+                fram_dev_cache_drop(dev, vec[i].offset, vec[i].len);
+            }
+        }
+        if (err != ESP_OK) {
+            fram_dev_record_error(dev);
+        } else {
+            dev->write_count++;
+            fram_dev_record_success(dev);
+        }
+    } else {
+        for (size_t i = 0; i < count && err == ESP_OK; i++) {
+            err = fram_dev_write_locked(dev, vec[i].offset, vec[i].buf, vec[i].len);
+        }
+    }
+    if (shadowed && err != ESP_OK) {
+        for (size_t i = 0; i < count; i++) {
+            fram_dev_shadow_reload(dev, vec[i].offset, vec[i].len);
+        }
+    }
+    return err;
 }
 
-esp_err_t fram_dev_write_u64(fram_dev_t *dev, uint32_t offset, uint64_t val) {
-    return fram_dev_write(dev, offset, &val, sizeof(val));
+#if CONFIG_FRAM_DEV_COMBINE_SIZE
+static bool fram_dev_stage_overlaps(const fram_dev_stage_t *st, uint32_t offset, size_t len) {
+    return st->offset < offset + len && offset < st->offset + st->len;
 }
 
-bool fram_dev_is_healthy(const fram_dev_t *dev) {
-    return dev ? dev->healthy : false;
+// Writes the staged ranges in address order, so ranges that ended up back
+// to back go out as one transaction. Caller holds the bus.
+static esp_err_t fram_dev_stage_flush(fram_dev_t *dev) {
+    __atomic_store_n(&dev->stage_due, false, __ATOMIC_RELEASE);
+    if (dev->stage_count == 0) {
+        return ESP_OK;
+    }
+    fram_wvec_t vec[FRAM_VEC_MAX];
+    size_t count = dev->stage_count;
+    for (size_t i = 0; i < count; i++) {
+        const fram_dev_stage_t *st = &dev->stage[i];
+        fram_wvec_t seg = { .offset = st->offset, .buf = dev->stage_buf + st->at, .len = st->len };
+        size_t k = i;
+        while (k > 0 && vec[k - 1].offset > seg.offset) {
+            vec[k] = vec[k - 1];
+            k--;
+        }
+        vec[k] = seg;
+    }
+    // Staged state must not change under the flush, so it never yields
+    bool preemptible = dev->preemptible;
+    dev->preemptible = false;
+    esp_err_t err = fram_dev_writev_locked(dev, vec, count);
+    dev->preemptible = preemptible;
+    // On failure the device content of the ranges is unknown either way;
+    // the error goes to whoever triggered the flush
+    dev->stage_count = 0;
+    dev->stage_used = 0;
+    dev->combine_flushes++;
+    xTimerStop(dev->stage_timer, 0);
+    return err;
 }
 
-uint32_t fram_dev_get_size(const fram_dev_t *dev) {
-    if (dev == NULL || dev->hal == NULL) {
-        return 0;
+// Stage a write. Ranges stay disjoint: a write inside a staged range
+// overwrites it in place, one touching the newest range extends it, and
+// one partly overlapping an older range flushes first. Between barriers
+// staged writes may reach the device in any order.
+static esp_err_t fram_dev_stage_write(fram_dev_t *dev, uint32_t offset, const void *buf, size_t len) {
+    esp_err_t err;
+    if (len > FRAM_DEV_COMBINE_SIZE) {
+        err = fram_dev_stage_flush(dev);
+        return err == ESP_OK ? fram_dev_write_locked(dev, offset, buf, len) : err;
     }
-    return dev->hal->size_bytes;
+
+    size_t last = dev->stage_count;
+    for (size_t i = 0; i + 1 < dev->stage_count; i++) {
+        fram_dev_stage_t *st = &dev->stage[i];
+        if (!fram_dev_stage_overlaps(st, offset, len)) {
+            continue;
+        }
+        if (offset >= st->offset && offset + len <= st->offset + st->len) {
+            memcpy(dev->stage_buf + st->at + (offset - st->offset), buf, len);
+            dev->combined_writes++;
+            return ESP_OK;
+        }
+        err = fram_dev_stage_flush(dev);
+        if (err != ESP_OK) {
+            return err;
+        }
+        break;
+    }
+
+    if (dev->stage_count > 0) {
+        last = dev->stage_count - 1;
+        fram_dev_stage_t *st = &dev->stage[last];
+        uint32_t st_end = st->offset + st->len;
+        if (offset <= st_end && st->offset <= offset + len) {
+            uint32_t lo = offset < st->offset ? offset : st->offset;
+            uint32_t hi = offset + (uint32_t)len > st_end ? offset + (uint32_t)len : st_end;
+            if (st->at + (hi - lo) <= FRAM_DEV_COMBINE_SIZE) {
+                if (lo < st->offset) {
+                    memmove(dev->stage_buf + st->at + (st->offset - lo), dev->stage_buf + st->at, st->len);
+                }
+                st->offset = lo;
+                st->len = (uint16_t)(hi - lo);
+                memcpy(dev->stage_buf + st->at + (offset - lo), buf, len);
+                dev->stage_used = st->at + st->len;
+                dev->combined_writes++;
+                return dev->stage_used == FRAM_DEV_COMBINE_SIZE ? fram_dev_stage_flush(dev) : ESP_OK;
+            }
+        }
+    }
+
+    if (dev->stage_count == FRAM_VEC_MAX || dev->stage_used + len > FRAM_DEV_COMBINE_SIZE) {
+        err = fram_dev_stage_flush(dev);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+    fram_dev_stage_t *st = &dev->stage[dev->stage_count++];
+    st->offset = offset;
+    st->at = dev->stage_used;
+    st->len = (uint16_t)len;
+    memcpy(dev->stage_buf + st->at, buf, len);
+    dev->stage_used += (uint16_t)len;
+    if (dev->stage_count == 1) {
+        xTimerStart(dev->stage_timer, 0);
+    }
+    return dev->stage_used == FRAM_DEV_COMBINE_SIZE ? fram_dev_stage_flush(dev) : ESP_OK;
 }
 
-void fram_dev_get_stats(const fram_dev_t *dev, fram_dev_stats_t *stats) {
-    if (dev == NULL || stats == NULL) {
-        return;
+// Reads see staged data
+static void fram_dev_stage_overlay(const fram_dev_t *dev, uint32_t offset, void *buf, size_t len) {
+    for (size_t i = 0; i < dev->stage_count; i++) {
+        const fram_dev_stage_t *st = &dev->stage[i];
+        if (!fram_dev_stage_overlaps(st, offset, len)) {
+            continue;
+        }
+        uint32_t start = offset > st->offset ? offset : st->offset;
+        uint32_t end = offset + (uint32_t)len;
+        if (end > st->offset + st->len) {
+            end = st->offset + st->len;
+        }
+        memcpy((uint8_t *)buf + (start - offset), dev->stage_buf + st->at + (start - st->offset), end - start);
     }
-    stats->read_count = dev->read_count;
-    stats->write_count = dev->write_count;
-    stats->error_count = dev->error_count;
-    stats->size_bytes = dev->hal ? dev->hal->size_bytes : 0;
-    stats->healthy = dev->healthy;
 }
 
-void fram_dev_reset_stats(fram_dev_t *dev) {
-    if (dev == NULL) {
-        return;
+// Timer service task: taking the device or the bus could block every
+// software timer, so only mark the staged writes due and wake the task
+// registered to flush them, if any.
+static void fram_dev_stage_timer(TimerHandle_t timer) {
+    fram_dev_t *dev = (fram_dev_t *)pvTimerGetTimerID(timer);
+    __atomic_store_n(&dev->stage_due, true, __ATOMIC_RELEASE);
+    fram_dev_notify_fn notify = dev->stage_notify;
+    if (notify) {
+        notify(dev->stage_notify_arg);
     }
-    dev->read_count = 0;
-    dev->write_count = 0;
-    dev->error_count = 0;
-    dev->consecutive_errors = 0;
-    dev->healthy = true;
+}
+
+static bool fram_dev_combining(const fram_dev_t *dev) {
+    return dev->stage_timer != NULL;
+}
+#else
+static esp_err_t fram_dev_stage_flush(fram_dev_t *dev) {
+    (void)dev;
+    return ESP_OK;
+}
+
+static esp_err_t fram_dev_stage_write(fram_dev_t *dev, uint32_t offset, const void *buf, size_t len) {
+    return fram_dev_write_locked(dev, offset, buf, len);
+}
+
+static void fram_dev_stage_overlay(const fram_dev_t *dev, uint32_t offset, void *buf, size_t len) {
+    (void)dev;
+    (void)offset;
+    (void)buf;
+    (void)len;
+}
+
+static bool fram_dev_combining(const fram_dev_t *dev) {
+    (void)dev;
+    return false;
+}
+#endif // CONFIG_FRAM_DEV_COMBINE_SIZE
+
+// Serve reads from the shadow without touching the bus. ESP_ERR_NOT_FOUND if
+// there is no valid shadow and the caller has to read the device.
+static esp_err_t fram_dev_shadow_readv(fram_dev_t *dev, const fram_rvec_t *vec, size_t count, size_t total) {
+    if (dev->shadow == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    esp_err_t err = fram_dev_lock(dev);
+    if (err != ESP_OK) {
+        fram_dev_record_error(dev);
+        return err;
+    }
+    if (!fram_dev_shadowed(dev)) {
+        fram_dev_unlock(dev);
+        return ESP_ERR_NOT_FOUND;
+    }
+    for (size_t i = 0; i < count; i++) {
+        memcpy(vec[i].buf, dev->shadow + vec[i].offset, vec[i].len);
+    }
+    dev->read_count++;
+    fram_dev_stat_op(dev, false, total);
+    fram_dev_unlock(dev);
+    return ESP_OK;
+}
+
+static esp_err_t fram_dev_write_shadowed(fram_dev_t *dev, uint32_t offset, const void *buf, size_t len) {
+    const uint8_t *in = (const uint8_t *)buf;
+    if (!fram_dev_shadow_trim(dev, &offset, &in, &len)) {
+        return ESP_OK;
+    }
+    esp_err_t err = fram_dev_write_locked(dev, offset, in, len);
+    if (err == ESP_OK) {
+        memcpy(dev->shadow + offset, in, len);
+    } else {
+        fram_dev_shadow_reload(dev, offset, len);
+    }
+    return err;
+}
+
+esp_err_t fram_dev_read(fram_dev_t *dev, uint32_t offset, void *buf, size_t len) {
+    if (dev == NULL || dev->hal == NULL || buf == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (len == 0) {
+        return ESP_OK;
+    }
+    if (!fram_dev_range_ok(dev, offset, len)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    const fram_rvec_t seg = { .offset = offset, .buf = buf, .len = len };
+    esp_err_t err = fram_dev_shadow_readv(dev, &seg, 1, len);
+    if (err != ESP_ERR_NOT_FOUND) {
+        return err;
+    }
+
+    err = fram_dev_lock_bus(dev);
+    if (err != ESP_OK) {
+        fram_dev_record_error(dev);
+        return err;
+    }
+    if (fram_dev_cacheable(dev, len)) {
+        err = fram_dev_cache_readv(dev, &seg, 1);
+    } else {
+        dev->preemptible = dev->preempt_chunk != 0;
+        err = fram_dev_read_locked(dev, offset, buf, len);
+        if (err == ESP_ERR_NOT_FINISHED) {
+            return err; // device lost while yielding
+        }
+        dev->preemptible = false;
+    }
+    if (err == ESP_OK) {
+        fram_dev_stage_overlay(dev, offset, buf, len);
+    }
+    fram_dev_stat_op(dev, false, err == ESP_OK ? len : 0);
+    fram_dev_unlock_bus(dev);
+    return err;
+}
+
+esp_err_t fram_dev_write(fram_dev_t *dev, uint32_t offset, const void *buf, size_t len) {
+    if (dev == NULL || dev->hal == NULL || buf == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (len == 0) {
+        return ESP_OK;
+    }
+    if (!fram_dev_range_ok(dev, offset, len)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    esp_err_t err = fram_dev_lock_bus(dev);
+    if (err != ESP_OK) {
+        fram_dev_record_error(dev);
+        return err;
+    }
+    if (fram_dev_shadowed(dev)) {
+        err = fram_dev_write_shadowed(dev, offset, buf, len);
+    } else {
+        dev->preemptible = dev->preempt_chunk != 0;
+        if (fram_dev_combining(dev)) {
+            err = fram_dev_stage_write(dev, offset, buf, len);
+        } else {
+            err = fram_dev_write_locked(dev, offset, buf, len);
+        }
+        if (err == ESP_ERR_NOT_FINISHED) {
+            return err; // device lost while yielding
+        }
+        dev->preemptible = false;
+    }
+    fram_dev_stat_op(dev, true, err == ESP_OK ? len : 0);
+    fram_dev_unlock_bus(dev);
+    return err;
+}
+
+esp_err_t fram_dev_begin(fram_dev_t *dev) {
+    if (dev == NULL || dev->hal == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    esp_err_t err = fram_dev_lock_bus(dev);
+    if (err != ESP_OK) {
+        fram_dev_record_error(dev);
+    }
+    return err;
+}
+
+esp_err_t fram_dev_end(fram_dev_t *dev) {
+    if (dev == NULL || dev->hal == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (dev->lock_depth == 0 || dev->lock_owner != xTaskGetCurrentTaskHandle()) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    fram_dev_unlock_bus(dev);
+    return ESP_OK;
+}
+
+esp_err_t fram_dev_barrier(fram_dev_t *dev) {
+    if (dev == NULL || dev->hal == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!fram_dev_combining(dev)) {
+        return ESP_OK;
+    }
+    esp_err_t err = fram_dev_lock_bus(dev);
+    if (err != ESP_OK) {
+        fram_dev_record_error(dev);
+        return err;
+    }
+    err = fram_dev_stage_flush(dev);
+    fram_dev_unlock_bus(dev);
+    return err;
+}
+
+esp_err_t fram_dev_set_flush_notify(fram_dev_t *dev, fram_dev_notify_fn notify, void *arg) {
+    if (dev == NULL || dev->hal == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+#if CONFIG_FRAM_DEV_COMBINE_SIZE
+    esp_err_t err = fram_dev_lock(dev);
+    if (err != ESP_OK) {
+        return err;
+    }
+    dev->stage_notify = notify;
+    dev->stage_notify_arg = arg;
+    fram_dev_unlock(dev);
+#else
+    (void)notify;
+    (void)arg;
+#endif
+    return ESP_OK;
+}
+
+esp_err_t fram_dev_set_latency_budget(fram_dev_t *dev, uint32_t budget_us) {
+    if (dev == NULL || dev->hal == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    esp_err_t err = fram_dev_lock(dev);
+    if (err != ESP_OK) {
+        return err;
+    }
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    fram_dev_budget_t *slot = NULL;
+    for (size_t i = 0; i < FRAM_DEV_BUDGET_TASKS; i++) {
+        if (dev->budgets[i].task == self) {
+            slot = &dev->budgets[i];
+            break;
+        }
+        if (slot == NULL && dev->budgets[i].task == NULL) {
+            slot = &dev->budgets[i];
+        }
+    }
+    if (budget_us == 0) {
+        if (slot != NULL && slot->task == self) {
+            slot->task = NULL;
+        }
+    } else if (slot == NULL) {
+        err = ESP_ERR_NO_MEM;
+    } else {
+        slot->task = self;
+        slot->budget_us = budget_us;
+    }
+    fram_dev_unlock(dev);
+    return err;
+}
+
+bool fram_dev_in_scope(const fram_dev_t *dev) {
+    return dev != NULL && dev->lock_depth > 0 && dev->lock_owner == xTaskGetCurrentTaskHandle();
+}
+
+esp_err_t fram_dev_readv(fram_dev_t *dev, const fram_rvec_t *vec, size_t count) {
+    if (dev == NULL || dev->hal == NULL || (vec == NULL && count > 0)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (count > FRAM_VEC_MAX) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    size_t total = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (vec[i].buf == NULL && vec[i].len > 0) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        if (!fram_dev_range_ok(dev, vec[i].offset, vec[i].len)) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+        total += vec[i].len;
+    }
+    if (count == 0) {
+        return ESP_OK;
+    }
+
+    esp_err_t err = fram_dev_shadow_readv(dev, vec, count, total);
+    if (err != ESP_ERR_NOT_FOUND) {
+        return err;
+    }
+
+    // Through the cache only if every segment fits in it
+    bool cached = true;
+    for (size_t i = 0; i < count; i++) {
+        cached = cached && fram_dev_cacheable(dev, vec[i].len);
+    }
+
+    err = fram_dev_lock_bus(dev);
+    if (err != ESP_OK) {
+        fram_dev_record_error(dev);
+        return err;
+    }
+    if (cached) {
+        err = fram_dev_cache_readv(dev, vec, count);
+    } else if (dev->hal->readv) {
+        err = dev->hal->readv(dev->hal, vec, count);
+        if (err != ESP_OK) {
+            fram_dev_record_error(dev);
+        } else {
+            dev->read_count++;
+            fram_dev_record_success(dev);
+        }
+    } else {
+        for (size_t i = 0; i < count && err == ESP_OK; i++) {
+            err = fram_dev_read_locked(dev, vec[i].offset, vec[i].buf, vec[i].len);
+        }
+    }
+    for (size_t i = 0; i < count && err == ESP_OK; i++) {
+        fram_dev_stage_overlay(dev, vec[i].offset, vec[i].buf, vec[i].len);
+    }
+    fram_dev_stat_op(dev, false, err == ESP_OK ? total : 0);
+    fram_dev_unlock_bus(dev);
+    return err;
+}
+
+esp_err_t fram_dev_writev(fram_dev_t *dev, const fram_wvec_t *vec, size_t count) {
+    if (dev == NULL || dev->hal == NULL || (vec == NULL && count > 0)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (count > FRAM_VEC_MAX) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    size_t total = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (vec[i].buf == NULL && vec[i].len > 0) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        if (!fram_dev_range_ok(dev, vec[i].offset, vec[i].len)) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+        total += vec[i].len;
+    }
+    if (count == 0) {
+        return ESP_OK;
+    }
+
+    esp_err_t err = fram_dev_lock_bus(dev);
+    if (err != ESP_OK) {
+        fram_dev_record_error(dev);
+        return err;
+    }
+
+    // A writev keeps its segment order, so staged writes go first
+    err = fram_dev_stage_flush(dev);
+    if (err == ESP_OK) {
+        err = fram_dev_writev_locked(dev, vec, count);
+    }
+    fram_dev_stat_op(dev, true, err == ESP_OK ? total : 0);
+    fram_dev_unlock_bus(dev);
+    return err;
+}
+
+esp_err_t fram_dev_fill(fram_dev_t *dev, uint32_t offset, uint8_t value, size_t len) {
+    if (dev == NULL || dev->hal == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (len == 0) {
+        return ESP_OK;
+    }
+    if (!fram_dev_range_ok(dev, offset, len)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    esp_err_t err = fram_dev_lock_bus(dev);
+    if (err != ESP_OK) {
+        fram_dev_record_error(dev);
+        return err;
+    }
+
+    uint32_t start = offset;
+    size_t n = len;
+    bool shadowed = fram_dev_shadowed(dev);
+    if (shadowed && !fram_dev_shadow_trim_fill(dev, &start, value, &n)) {
+        n = 0;
+    }
+
+    err = fram_dev_stage_flush(dev);
+    dev->preemptible = !shadowed && dev->preempt_chunk != 0;
+    if (err != ESP_OK || n == 0) {
+        // Staged writes failed, or already filled
+    } else if (dev->hal->fill) {
+        size_t piece = dev->preemptible ? dev->preempt_chunk : n;
+        size_t done = 0;
+        while (done < n) {
+            size_t chunk = n - done < piece ? n - done : piece;
+            uint32_t addr = start + (uint32_t)done;
+            err = dev->hal->fill(dev->hal, addr, value, chunk);
+            if (err != ESP_OK) {
+                fram_dev_cache_drop(dev, addr, chunk);
+                fram_dev_record_error(dev);
+                break;
+            }
+            fram_dev_cache_store(dev, addr, NULL, value, chunk);
+            dev->write_count++;
+            fram_dev_record_success(dev);
+            done += chunk;
+            if (done < n && (err = fram_dev_preempt_point(dev)) != ESP_OK) {
+                break;
+            }
+        }
+    } else {
+        uint8_t pattern[FRAM_DEV_FILL_STACK];
+        const uint8_t *src = s_fill_ff;
+        size_t src_len = sizeof(s_fill_ff);
+        if (value != 0xFF) {
+            memset(pattern, value, sizeof(pattern));
+            src = pattern;
+            src_len = sizeof(pattern);
+        }
+        size_t done = 0;
+        while (done < n && err == ESP_OK) {
+            size_t chunk = n - done < src_len ? n - done : src_len;
+            err = fram_dev_write_locked(dev, start + (uint32_t)done, src, chunk);
+            done += chunk;
+            if (err == ESP_OK && done < n) {
+                err = fram_dev_preempt_point(dev);
+            }
+        }
+    }
+    if (err == ESP_ERR_NOT_FINISHED) {
+        return err; // device lost while yielding
+    }
+    dev->preemptible = false;
+    if (shadowed && n > 0) {
+        if (err == ESP_OK) {
+            memset(dev->shadow + start, value, n);
+        } else {
+            fram_dev_shadow_reload(dev, start, n);
+        }
+    }
+    fram_dev_stat_op(dev, true, err == ESP_OK ? len : 0);
+    fram_dev_unlock_bus(dev);
+    return err;
+}
+
+esp_err_t fram_dev_read_async(fram_dev_t *dev, uint32_t offset, void *buf, size_t len,
+                              fram_hal_done_fn done, void *arg) {
+    if (dev == NULL || dev->hal == NULL || buf == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    uint32_t size_bytes = dev->hal->size_bytes;
+    if (size_bytes == 0 || offset > size_bytes || len > size_bytes || offset > size_bytes - len) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (dev->hal->read_async == NULL || dev->shadow) {
+        esp_err_t err = fram_dev_read(dev, offset, buf, len);
+        if (done) {
+            done(dev->hal, err, arg);
+        }
+        return err;
+    }
+
+    esp_err_t err = fram_dev_lock(dev);
+    if (err != ESP_OK) {
+        fram_dev_record_error(dev);
+        return err;
+    }
+    err = fram_dev_stage_flush(dev);
+    if (err == ESP_OK) {
+        err = dev->hal->read_async(dev->hal, offset, buf, len, done, arg);
+    }
+    if (err != ESP_OK) {
+        fram_dev_record_error(dev);
+    } else {
+        dev->read_count++;
+        fram_dev_stat_bytes(dev, false, len);
+    }
+    fram_dev_unlock(dev);
+    return err;
+}
+
+esp_err_t fram_dev_write_async(fram_dev_t *dev, uint32_t offset, const void *buf, size_t len,
+                               fram_hal_done_fn done, void *arg) {
+    if (dev == NULL || dev->hal == NULL || buf == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    uint32_t size_bytes = dev->hal->size_bytes;
+    if (size_bytes == 0 || offset > size_bytes || len > size_bytes || offset > size_bytes - len) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (dev->hal->write_async == NULL || dev->shadow) {
+        esp_err_t err = fram_dev_write(dev, offset, buf, len);
+        if (done) {
+            done(dev->hal, err, arg);
+        }
+        return err;
+    }
+
+    esp_err_t err = fram_dev_lock(dev);
+    if (err != ESP_OK) {
+        fram_dev_record_error(dev);
+        return err;
+    }
+    // Reads are ordered behind the queued write, so a line reloaded after
+    // this sees the new data
+    fram_dev_cache_drop(dev, offset, len);
+    err = fram_dev_stage_flush(dev);
+    if (err == ESP_OK) {
+        err = dev->hal->write_async(dev->hal, offset, buf, len, done, arg);
+    }
+    if (err != ESP_OK) {
+        fram_dev_record_error(dev);
+    } else {
+        dev->write_count++;
+        fram_dev_stat_bytes(dev, true, len);
+    }
+    fram_dev_unlock(dev);
+    return err;
+}
+
+esp_err_t fram_dev_async_wait(fram_dev_t *dev, uint32_t timeout_ms) {
+    if (dev == NULL || dev->hal == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (dev->hal->wait == NULL) {
+        return ESP_OK;
+    }
+
+    esp_err_t err = fram_dev_lock(dev);
+    if (err != ESP_OK) {
+        return err;
+    }
+    err = dev->hal->wait(dev->hal, timeout_ms);
+    if (err != ESP_OK && err != ESP_ERR_TIMEOUT) {
+        fram_dev_record_error(dev);
+    }
+    fram_dev_unlock(dev);
+    return err;
+}
+
+uint32_t fram_dev_get_copies(const fram_dev_t *dev) {
+    if (dev == NULL || dev->hal == NULL || dev->hal->read_copy == NULL || dev->hal->copies == 0) {
+        return 1;
+    }
+    return dev->hal->copies;
+}
+
+esp_err_t fram_dev_read_copy(fram_dev_t *dev, uint32_t copy, uint32_t offset, void *buf, size_t len) {
+    if (dev == NULL || dev->hal == NULL || buf == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (dev->hal->read_copy == NULL) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    uint32_t size_bytes = dev->hal->size_bytes;
+    if (size_bytes == 0 || offset > size_bytes || len > size_bytes || offset > size_bytes - len) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    esp_err_t err = fram_dev_lock_bus(dev);
+    if (err != ESP_OK) {
+        fram_dev_record_error(dev);
+        return err;
+    }
+    err = fram_dev_stage_flush(dev);
+    if (err == ESP_OK) {
+        err = dev->hal->read_copy(dev->hal, copy, offset, buf, len);
+        if (err != ESP_OK) {
+            fram_dev_record_error(dev);
+        } else {
+            dev->read_count++;
+            fram_dev_record_success(dev);
+        }
+    }
+    fram_dev_stat_op(dev, false, err == ESP_OK ? len : 0);
+    fram_dev_unlock_bus(dev);
+    return err;
+}
+
+esp_err_t fram_dev_repair(fram_dev_t *dev, uint32_t good_copy, uint32_t offset, size_t len) {
+    if (dev == NULL || dev->hal == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (dev->hal->repair == NULL) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    uint32_t size_bytes = dev->hal->size_bytes;
+    if (size_bytes == 0 || offset > size_bytes || len > size_bytes || offset > size_bytes - len) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    esp_err_t err = fram_dev_lock_bus(dev);
+    if (err != ESP_OK) {
+        return err;
+    }
+    err = fram_dev_stage_flush(dev);
+    if (err == ESP_OK) {
+        err = dev->hal->repair(dev->hal, good_copy, offset, len);
+        if (err != ESP_OK) {
+            fram_dev_record_error(dev);
+        } else {
+            fram_dev_record_success(dev);
+        }
+    }
+    fram_dev_cache_drop(dev, offset, len);
+    if (err == ESP_OK && fram_dev_shadowed(dev)) {
+        fram_dev_shadow_reload(dev, offset, len);
+    }
+    fram_dev_unlock_bus(dev);
+    return err;
+}
+
+esp_err_t fram_dev_shadow_sync(fram_dev_t *dev) {
+    if (dev == NULL || dev->hal == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (dev->shadow == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    esp_err_t err = fram_dev_lock_bus(dev);
+    if (err != ESP_OK) {
+        return err;
+    }
+    dev->shadow_valid = false;
+    err = fram_dev_read_locked(dev, 0, dev->shadow, dev->hal->size_bytes);
+    if (err == ESP_OK) {
+        dev->shadow_valid = true;
+        dev->shadow_verify_pos = 0;
+    }
+    fram_dev_unlock_bus(dev);
+    return err;
+}
+
+esp_err_t fram_dev_shadow_verify(fram_dev_t *dev, size_t len) {
+    if (dev == NULL || dev->hal == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (dev->shadow == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    esp_err_t err = fram_dev_lock_bus(dev);
+    if (err != ESP_OK) {
+        return err;
+    }
+    if (!dev->shadow_valid) {
+        fram_dev_unlock_bus(dev);
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    uint8_t buf[FRAM_DEV_VERIFY_CHUNK];
+    uint32_t size_bytes = dev->hal->size_bytes;
+    bool mismatch = false;
+    if (len > size_bytes) {
+        len = size_bytes;
+    }
+    while (len > 0 && err == ESP_OK) {
+        uint32_t pos = dev->shadow_verify_pos;
+        size_t chunk = len < sizeof(buf) ? len : sizeof(buf);
+        if (chunk > size_bytes - pos) {
+            chunk = size_bytes - pos;
+        }
+        err = fram_dev_read_locked(dev, pos, buf, chunk);
+        if (err != ESP_OK) {
+            break;
+        }
+        if (memcmp(buf, dev->shadow + pos, chunk) != 0) {
+            // The device is what survives a reset: make the shadow match it
+            memcpy(dev->shadow + pos, buf, chunk);
+            dev->shadow_mismatches++;
+            mismatch = true;
+        }
+        dev->shadow_verify_pos = (pos + (uint32_t)chunk) % size_bytes;
+        len -= chunk;
+    }
+    fram_dev_unlock_bus(dev);
+    if (err != ESP_OK) {
+        return err;
+    }
+    return mismatch ? ESP_ERR_INVALID_CRC : ESP_OK;
+}
+
+esp_err_t fram_dev_cache_pin(fram_dev_t *dev, uint32_t offset, size_t len) {
+    if (dev == NULL || dev->hal == NULL || len == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+#if CONFIG_FRAM_DEV_CACHE_LINES
+    if (!dev->cache_enabled) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (!fram_dev_range_ok(dev, offset, len)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    esp_err_t err = fram_dev_lock_bus(dev);
+    if (err != ESP_OK) {
+        return err;
+    }
+    fram_dev_cache_pin_t *pin = NULL;
+    for (size_t i = 0; i < FRAM_DEV_CACHE_PINS && pin == NULL; i++) {
+        if (dev->cache_pins[i].len == 0) {
+            pin = &dev->cache_pins[i];
+        }
+    }
+    uint32_t first = fram_dev_cache_tag(offset);
+    uint32_t last = fram_dev_cache_tag(offset + (uint32_t)len - 1);
+    uint32_t lines = (last - first) / FRAM_DEV_CACHE_LINE_SIZE + 1;
+    if (pin == NULL || dev->cache_pinned_lines + lines >= FRAM_DEV_CACHE_LINES) {
+        fram_dev_unlock_bus(dev);
+        return ESP_ERR_NO_MEM;
+    }
+    pin->offset = offset;
+    pin->len = (uint32_t)len;
+    dev->cache_pinned_lines += lines;
+
+    for (uint32_t tag = first; tag <= last && err == ESP_OK; tag += FRAM_DEV_CACHE_LINE_SIZE) {
+        fram_dev_cache_line_t *line;
+        err = fram_dev_cache_get(dev, tag, &line);
+        if (err == ESP_OK) {
+            line->pinned = true;
+        }
+    }
+    fram_dev_unlock_bus(dev);
+    // A line that failed to load is pinned when a later read loads it
+    return err;
+#else
+    (void)offset;
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+esp_err_t fram_dev_cache_unpin(fram_dev_t *dev, uint32_t offset, size_t len) {
+    if (dev == NULL || dev->hal == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+#if CONFIG_FRAM_DEV_CACHE_LINES
+    if (!dev->cache_enabled) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    esp_err_t err = fram_dev_lock(dev);
+    if (err != ESP_OK) {
+        return err;
+    }
+    err = ESP_ERR_NOT_FOUND;
+    for (size_t i = 0; i < FRAM_DEV_CACHE_PINS; i++) {
+        fram_dev_cache_pin_t *pin = &dev->cache_pins[i];
+        if (pin->len > 0 && pin->offset == offset && pin->len == len) {
+            uint32_t first = fram_dev_cache_tag(offset);
+            uint32_t last = fram_dev_cache_tag(offset + (uint32_t)len - 1);
+            dev->cache_pinned_lines -= (last - first) / FRAM_DEV_CACHE_LINE_SIZE + 1;
+            pin->len = 0;
+            err = ESP_OK;
+            break;
+        }
+    }
+    if (err == ESP_OK) {
+        for (size_t i = 0; i < FRAM_DEV_CACHE_LINES; i++) {
+            fram_dev_cache_line_t *line = &dev->cache[i];
+            line->pinned = line->valid && fram_dev_cache_in_pin(dev, line->tag);
+        }
+    }
+    fram_dev_unlock(dev);
+    return err;
+#else
+    (void)offset;
+    (void)len;
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+esp_err_t fram_dev_cache_invalidate(fram_dev_t *dev) {
+    if (dev == NULL || dev->hal == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+#if CONFIG_FRAM_DEV_CACHE_LINES
+    if (!dev->cache_enabled) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    esp_err_t err = fram_dev_lock(dev);
+    if (err != ESP_OK) {
+        return err;
+    }
+    fram_dev_cache_drop(dev, 0, dev->hal->size_bytes);
+    fram_dev_unlock(dev);
+    return ESP_OK;
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+esp_err_t fram_dev_read_u8(fram_dev_t *dev, uint32_t offset, uint8_t *val) {
+    return fram_dev_read(dev, offset, val, sizeof(*val));
+}
+
+esp_err_t fram_dev_read_u16(fram_dev_t *dev, uint32_t offset, uint16_t *val) {
+    return fram_dev_read(dev, offset, val, sizeof(*val));
+}
+
+esp_err_t fram_dev_read_u32(fram_dev_t *dev, uint32_t offset, uint32_t *val) {
+    return fram_dev_read(dev, offset, val, sizeof(*val));
+}
+
+esp_err_t fram_dev_read_u64(fram_dev_t *dev, uint32_t offset, uint64_t *val) {
+    return fram_dev_read(dev, offset, val, sizeof(*val));
+}
+
+esp_err_t fram_dev_write_u8(fram_dev_t *dev, uint32_t offset, uint8_t val) {
+    return fram_dev_write(dev, offset, &val, sizeof(val));
+}
+
+esp_err_t fram_dev_write_u16(fram_dev_t *dev, uint32_t offset, uint16_t val) {
+    return fram_dev_write(dev, offset, &val, sizeof(val));
+}
+
+esp_err_t fram_dev_write_u32(fram_dev_t *dev, uint32_t offset, uint32_t val) {
+    return fram_dev_write(dev, offset, &val, sizeof(val));
+}
+
+esp_err_t fram_dev_write_u64(fram_dev_t *dev, uint32_t offset, uint64_t val) {
+    return fram_dev_write(dev, offset, &val, sizeof(val));
+}
+
+bool fram_dev_is_healthy(const fram_dev_t *dev) {
+    return dev ? dev->healthy : false;
+}
+
+uint32_t fram_dev_get_size(const fram_dev_t *dev) {
+    if (dev == NULL || dev->hal == NULL) {
+        return 0;
+    }
+    return dev->hal->size_bytes;
+}
+
+void fram_dev_get_stats(const fram_dev_t *dev, fram_dev_stats_t *stats) {
+    if (dev == NULL || stats == NULL) {
+        return;
+    }
+    stats->read_count = dev->read_count;
+    stats->write_count = dev->write_count;
+    stats->error_count = dev->error_count;
+    stats->size_bytes = dev->hal ? dev->hal->size_bytes : 0;
+    stats->healthy = dev->healthy;
+    stats->shadow_skipped = dev->shadow_skipped;
+    stats->shadow_mismatches = dev->shadow_mismatches;
+    stats->cache_hits = dev->cache_hits;
+    stats->cache_misses = dev->cache_misses;
+    stats->combined_writes = dev->combined_writes;
+    stats->combine_flushes = dev->combine_flushes;
+    stats->preempt_yields = dev->preempt_yields;
+#if CONFIG_FRAM_DEV_STATS
+    const fram_dev_xstats_t *x = &dev->xstats;
+    stats->x.bytes_read = FRAM_DEV_STAT_GET(x->bytes_read);
+    stats->x.bytes_written = FRAM_DEV_STAT_GET(x->bytes_written);
+    for (size_t i = 0; i < FRAM_DEV_HIST_BUCKETS; i++) {
+        stats->x.read_hist[i] = FRAM_DEV_STAT_GET(x->read_hist[i]);
+        stats->x.write_hist[i] = FRAM_DEV_STAT_GET(x->write_hist[i]);
+    }
+    stats->x.lock_wait_us = FRAM_DEV_STAT_GET(x->lock_wait_us);
+    stats->x.lock_wait_max_us = FRAM_DEV_STAT_GET(x->lock_wait_max_us);
+    stats->x.lock_hold_max_us = FRAM_DEV_STAT_GET(x->lock_hold_max_us);
+#endif
+}
+
+void fram_dev_reset_stats(fram_dev_t *dev) {
+    if (dev == NULL) {
+        return;
+    }
+    dev->read_count = 0;
+    dev->write_count = 0;
+    dev->error_count = 0;
+    dev->consecutive_errors = 0;
+    dev->healthy = true;
+    dev->shadow_skipped = 0;
+    dev->shadow_mismatches = 0;
+    dev->cache_hits = 0;
+    dev->cache_misses = 0;
+    dev->combined_writes = 0;
+    dev->combine_flushes = 0;
+    dev->preempt_yields = 0;
+#if CONFIG_FRAM_DEV_STATS
+    fram_dev_xstats_t *x = &dev->xstats;
+    FRAM_DEV_STAT_CLEAR(x->bytes_read);
+    FRAM_DEV_STAT_CLEAR(x->bytes_written);
+    for (size_t i = 0; i < FRAM_DEV_HIST_BUCKETS; i++) {
+        FRAM_DEV_STAT_CLEAR(x->read_hist[i]);
+        FRAM_DEV_STAT_CLEAR(x->write_hist[i]);
+    }
+    FRAM_DEV_STAT_CLEAR(x->lock_wait_us);
+    FRAM_DEV_STAT_CLEAR(x->lock_wait_max_us);
+    FRAM_DEV_STAT_CLEAR(x->lock_hold_max_us);
+#endif
 }
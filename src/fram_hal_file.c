@@ -0,0 +1,188 @@
+#include "fram/fram_hal.h"
+
+#if CONFIG_FRAM_HAL_FILE_ENABLED
+
+#include "esp_check.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define TAG "fram_hal_file"
+
+static esp_err_t fram_hal_file_deinit(fram_hal_t *hal) {
+    if (hal == NULL || hal->ctx == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    fram_hal_file_ctx_t *ctx = (fram_hal_file_ctx_t *)hal->ctx;
+    esp_err_t err = ESP_OK;
+    if (ctx->map != NULL) {
+        if (msync(ctx->map, ctx->size_bytes, MS_SYNC) != 0) {
+            err = ESP_FAIL;
+        }
+        munmap(ctx->map, ctx->size_bytes);
+        ctx->map = NULL;
+    }
+    if (ctx->fd >= 0) {
+        close(ctx->fd);
+        ctx->fd = -1;
+    }
+    return err;
+}
+
+static esp_err_t fram_hal_file_init(fram_hal_t *hal) {
+    if (hal == NULL || hal->ctx == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    fram_hal_file_ctx_t *ctx = (fram_hal_file_ctx_t *)hal->ctx;
+    if (ctx->map != NULL) {
+        return ESP_OK;
+    }
+
+    int flags = O_RDWR | O_CREAT | (ctx->truncate ? O_TRUNC : 0);
+    ctx->fd = open(ctx->path, flags, 0644);
+    if (ctx->fd < 0) {
+        ESP_LOGE(TAG, "open %s: %s", ctx->path, strerror(errno));
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    struct stat st;
+    if (fstat(ctx->fd, &st) != 0) {
+        fram_hal_file_deinit(hal);
+        return ESP_FAIL;
+    }
+    size_t old_size = (size_t)st.st_size;
+    ctx->created = old_size < ctx->size_bytes;
+    if (ctx->created && ftruncate(ctx->fd, (off_t)ctx->size_bytes) != 0) {
+        ESP_LOGE(TAG, "resize %s: %s", ctx->path, strerror(errno));
+        fram_hal_file_deinit(hal);
+        return ESP_ERR_NO_MEM;
+    }
+    if (old_size > ctx->size_bytes) {
+        ESP_LOGW(TAG, "%s is %u bytes, using the first %u", ctx->path, (unsigned)old_size,
+                 (unsigned)ctx->size_bytes);
+    }
+
+    void *map = mmap(NULL, ctx->size_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, ctx->fd, 0);
+    if (map == MAP_FAILED) {
+        ESP_LOGE(TAG, "mmap %s: %s", ctx->path, strerror(errno));
+        fram_hal_file_deinit(hal);
+        return ESP_ERR_NO_MEM;
+    }
+    ctx->map = (uint8_t *)map;
+
+    // New bytes read as blank FRAM rather than zeroes
+    if (ctx->created) {
+        memset(ctx->map + old_size, 0xFF, ctx->size_bytes - old_size);
+    }
+    return ESP_OK;
+}
+
+static esp_err_t fram_hal_file_check(const fram_hal_t *hal, uint32_t addr, size_t len) {
+    if (hal == NULL || hal->ctx == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    const fram_hal_file_ctx_t *ctx = (const fram_hal_file_ctx_t *)hal->ctx;
+    if (ctx->map == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (addr > ctx->size_bytes || len > ctx->size_bytes || addr > ctx->size_bytes - len) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t fram_hal_file_sync_range(fram_hal_file_ctx_t *ctx, uint32_t addr, size_t len) {
+    if (!ctx->sync_on_write || len == 0) {
+        return ESP_OK;
+    }
+    // msync() wants a page-aligned start
+    uintptr_t page = (uintptr_t)sysconf(_SC_PAGESIZE);
+    uintptr_t start = ((uintptr_t)(ctx->map + addr)) & ~(page - 1);
+    uintptr_t end = (uintptr_t)(ctx->map + addr + len);
+    return msync((void *)start, end - start, MS_SYNC) == 0 ? ESP_OK : ESP_FAIL;
+}
+
+static esp_err_t fram_hal_file_read(fram_hal_t *hal, uint32_t addr, void *buf, size_t len) {
+    if (buf == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    ESP_RETURN_ON_ERROR(fram_hal_file_check(hal, addr, len), TAG, "read out of range");
+    const fram_hal_file_ctx_t *ctx = (const fram_hal_file_ctx_t *)hal->ctx;
+    memcpy(buf, ctx->map + addr, len);
+    return ESP_OK;
+}
+
+static esp_err_t fram_hal_file_write(fram_hal_t *hal, uint32_t addr, const void *buf, size_t len) {
+    if (buf == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    ESP_RETURN_ON_ERROR(fram_hal_file_check(hal, addr, len), TAG, "write out of range");
+    fram_hal_file_ctx_t *ctx = (fram_hal_file_ctx_t *)hal->ctx;
+    memcpy(ctx->map + addr, buf, len);
+    return fram_hal_file_sync_range(ctx, addr, len);
+}
+
+static esp_err_t fram_hal_file_fill(fram_hal_t *hal, uint32_t addr, uint8_t value, size_t len) {
+    ESP_RETURN_ON_ERROR(fram_hal_file_check(hal, addr, len), TAG, "fill out of range");
+    fram_hal_file_ctx_t *ctx = (fram_hal_file_ctx_t *)hal->ctx;
+    memset(ctx->map + addr, value, len);
+    return fram_hal_file_sync_range(ctx, addr, len);
+}
+
+static esp_err_t fram_hal_file_probe(fram_hal_t *hal) {
+    if (hal == NULL || hal->ctx == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    const fram_hal_file_ctx_t *ctx = (const fram_hal_file_ctx_t *)hal->ctx;
+    return ctx->map != NULL ? ESP_OK : ESP_ERR_INVALID_STATE;
+}
+
+esp_err_t fram_hal_file_create(fram_hal_t *hal,
+                               fram_hal_file_ctx_t *ctx,
+                               const fram_hal_file_config_t *cfg) {
+    if (hal == NULL || ctx == NULL || cfg == NULL || cfg->path == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    size_t size_bytes = cfg->size_bytes ? cfg->size_bytes : CONFIG_FRAM_HAL_FILE_DEFAULT_SIZE;
+    if (size_bytes > UINT32_MAX) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    memset(hal, 0, sizeof(*hal));
+    memset(ctx, 0, sizeof(*ctx));
+
+    ctx->path = cfg->path;
+    ctx->size_bytes = size_bytes;
+    ctx->truncate = cfg->truncate;
+    ctx->sync_on_write = cfg->sync_on_write;
+    ctx->fd = -1;
+
+    hal->init = fram_hal_file_init;
+    hal->deinit = fram_hal_file_deinit;
+    hal->read = fram_hal_file_read;
+    hal->write = fram_hal_file_write;
+    hal->probe = fram_hal_file_probe;
+    hal->fill = fram_hal_file_fill;
+    hal->size_bytes = (uint32_t)size_bytes;
+    hal->max_transfer = (uint32_t)size_bytes;
+    hal->caps = FRAM_HAL_CAP_CONTINUOUS;
+    hal->ctx = ctx;
+
+    return ESP_OK;
+}
+
+esp_err_t fram_hal_file_sync(fram_hal_t *hal) {
+    if (hal == NULL || hal->ctx == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    fram_hal_file_ctx_t *ctx = (fram_hal_file_ctx_t *)hal->ctx;
+    if (ctx->map == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    return msync(ctx->map, ctx->size_bytes, MS_SYNC) == 0 ? ESP_OK : ESP_FAIL;
+}
+
+#endif // CONFIG_FRAM_HAL_FILE_ENABLED
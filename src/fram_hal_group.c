@@ -0,0 +1,48 @@
+#include "fram_hal_group.h"
+
+#if CONFIG_FRAM_HAL_STRIPE_ENABLED || CONFIG_FRAM_HAL_MIRROR_ENABLED
+
+static bool fram_hal_group_shared(fram_hal_t *const *children, size_t count, size_t i) {
+    for (size_t j = 0; j < count; j++) {
+        if (j != i && (children[i]->buses & children[j]->buses) != 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+esp_err_t fram_hal_group_acquire(fram_hal_t *const *children, size_t count, uint32_t *acquired) {
+    *acquired = 0;
+    for (size_t i = 0; i < count; i++) {
+        fram_hal_t *child = children[i];
+        if (child->acquire == NULL || fram_hal_group_shared(children, count, i)) {
+            continue;
+        }
+        esp_err_t err = child->acquire(child);
+        if (err != ESP_OK) {
+            fram_hal_group_release(children, i, acquired);
+            return err;
+        }
+        *acquired |= 1U << i;
+    }
+    return ESP_OK;
+}
+
+void fram_hal_group_release(fram_hal_t *const *children, size_t count, uint32_t *acquired) {
+    for (size_t i = 0; i < count; i++) {
+        if ((*acquired & (1U << i)) && children[i]->release) {
+            children[i]->release(children[i]);
+        }
+    }
+    *acquired = 0;
+}
+
+uint32_t fram_hal_group_buses(fram_hal_t *const *children, size_t count) {
+    uint32_t buses = 0;
+    for (size_t i = 0; i < count; i++) {
+        buses |= children[i]->buses;
+    }
+    return buses;
+}
+
+#endif // CONFIG_FRAM_HAL_STRIPE_ENABLED || CONFIG_FRAM_HAL_MIRROR_ENABLED
@@ -0,0 +1,14 @@
+#pragma once
+
+#include "fram/fram_hal.h"
+
+// Bus ownership for HALs built from child HALs (stripe, mirror). A child
+// that shares a bus with another child is never acquired: on SPI, holding
+// the bus through one device defers every other device on that host, so the
+// first transfer to a sibling would wait on the caller itself. Children on
+// buses of their own are acquired; `acquired` records which, for release.
+esp_err_t fram_hal_group_acquire(fram_hal_t *const *children, size_t count, uint32_t *acquired);
+void fram_hal_group_release(fram_hal_t *const *children, size_t count, uint32_t *acquired);
+
+// Union of the children's fram_hal_t.buses, for the parent's own field.
+uint32_t fram_hal_group_buses(fram_hal_t *const *children, size_t count);
@@ -0,0 +1,518 @@
+#include "fram/fram_hal.h"
+
+#if CONFIG_FRAM_HAL_MIRROR_ENABLED
+
+#include "esp_check.h"
+#include "esp_log.h"
+#include "fram_hal_group.h"
+#include "sdkconfig.h"
+#include <string.h>
+
+#define TAG "fram_hal_mirror"
+
+static void fram_mirror_record(fram_hal_mirror_ctx_t *ctx, size_t child, esp_err_t err) {
+    fram_hal_mirror_child_t *c = &ctx->child[child];
+    if (err == ESP_OK) {
+        c->consecutive_errors = 0;
+        return;
+    }
+    c->error_count++;
+    c->consecutive_errors++;
+    if (c->consecutive_errors >= ctx->error_threshold) {
+        if (c->healthy) {
+            ESP_LOGW(TAG, "child %u unhealthy after %u errors", (unsigned)child,
+                     (unsigned)c->consecutive_errors);
+        }
+        c->healthy = false;
+    }
+}
+
+// Synchronous transfer on one child, chunked the way fram_dev would.
+static esp_err_t fram_mirror_child_xfer(fram_hal_t *child, uint32_t addr, uint8_t *rx, const uint8_t *tx,
+                                        size_t len) {
+    size_t chunk_max = ((child->caps & FRAM_HAL_CAP_CONTINUOUS) || child->max_transfer == 0)
+                           ? child->size_bytes : child->max_transfer;
+    size_t off = 0;
+    while (off < len) {
+        size_t chunk = len - off > chunk_max ? chunk_max : len - off;
+        esp_err_t err = rx ? child->read(child, addr + (uint32_t)off, rx + off, chunk)
+                           : child->write(child, addr + (uint32_t)off, tx + off, chunk);
+        if (err != ESP_OK) {
+            return err;
+        }
+        off += chunk;
+    }
+    return ESP_OK;
+}
+
+static bool fram_mirror_overlaps(uint32_t a, uint32_t a_len, uint32_t b, uint32_t b_len) {
+    return a < b + b_len && b < a + a_len;
+}
+
+// Child holds stale data somewhere in [addr, addr + len).
+static bool fram_mirror_stale(const fram_hal_mirror_ctx_t *ctx, size_t child, uint32_t addr, size_t len) {
+    for (uint32_t i = 0; i < ctx->repair_count; i++) {
+        const fram_hal_mirror_range_t *r = &ctx->repair[i];
+        if (r->child == child && fram_mirror_overlaps(r->addr, r->len, addr, (uint32_t)len)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool fram_mirror_can_read(const fram_hal_mirror_ctx_t *ctx, size_t child, uint32_t addr, size_t len) {
+    return ctx->child[child].healthy && !fram_mirror_stale(ctx, child, addr, len);
+}
+
+static void fram_mirror_remove_range(fram_hal_mirror_ctx_t *ctx, uint32_t index) {
+    ctx->repair_count--;
+    memmove(&ctx->repair[index], &ctx->repair[index + 1],
+            (ctx->repair_count - index) * sizeof(ctx->repair[0]));
+}
+
+// Merge every pending range of `child` into one covering range.
+static void fram_mirror_collapse(fram_hal_mirror_ctx_t *ctx, size_t child) {
+    int32_t keep = -1;
+    for (uint32_t i = 0; i < ctx->repair_count;) {
+        fram_hal_mirror_range_t *r = &ctx->repair[i];
+        if (r->child != child) {
+            i++;
+        } else if (keep < 0) {
+            keep = (int32_t)i++;
+        } else {
+            fram_hal_mirror_range_t *k = &ctx->repair[keep];
+            uint32_t start = r->addr < k->addr ? r->addr : k->addr;
+            uint32_t end = (r->addr + r->len) > (k->addr + k->len) ? (r->addr + r->len) : (k->addr + k->len);
+            k->addr = start;
+            k->len = end - start;
+            fram_mirror_remove_range(ctx, i);
+        }
+    }
+}
+
+static void fram_mirror_queue_repair(fram_hal_mirror_ctx_t *ctx, size_t child, uint32_t addr, size_t len) {
+    uint32_t end = addr + (uint32_t)len;
+    for (uint32_t i = 0; i < ctx->repair_count; i++) {
+        fram_hal_mirror_range_t *r = &ctx->repair[i];
+        // Overlapping or adjacent: extend in place
+        if (r->child == child && addr <= r->addr + r->len && r->addr <= end) {
+            uint32_t start = addr < r->addr ? addr : r->addr;
+            uint32_t r_end = end > r->addr + r->len ? end : r->addr + r->len;
+            r->addr = start;
+            r->len = r_end - start;
+            return;
+        }
+    }
+
+    if (ctx->repair_count == CONFIG_FRAM_HAL_MIRROR_REPAIR_SLOTS) {
+        // Never drop a stale range: trade precision for slots instead
+        if (fram_mirror_stale(ctx, child, 0, UINT32_MAX)) {
+            fram_mirror_collapse(ctx, child);
+            for (uint32_t i = 0; i < ctx->repair_count; i++) {
+                fram_hal_mirror_range_t *r = &ctx->repair[i];
+                if (r->child == child) {
+                    uint32_t start = addr < r->addr ? addr : r->addr;
+                    uint32_t r_end = end > r->addr + r->len ? end : r->addr + r->len;
+                    r->addr = start;
+                    r->len = r_end - start;
+                    return;
+                }
+            }
+        }
+        fram_mirror_collapse(ctx, 1 - child);
+    }
+    ctx->repair[ctx->repair_count++] = (fram_hal_mirror_range_t){
+        .addr = addr,
+        .len = (uint32_t)len,
+        .child = (uint8_t)child,
+    };
+}
+
+// A successful write of [addr, addr + len) to child makes ranges inside it fresh.
+static void fram_mirror_clear_repair(fram_hal_mirror_ctx_t *ctx, size_t child, uint32_t addr, size_t len) {
+    for (uint32_t i = 0; i < ctx->repair_count;) {
+        fram_hal_mirror_range_t *r = &ctx->repair[i];
+        if (r->child == child && r->addr >= addr && r->addr + r->len <= addr + len) {
+            fram_mirror_remove_range(ctx, i);
+        } else {
+            i++;
+        }
+    }
+}
+
+// Copy up to `budget` bytes of pending repairs from the good child. Ranges
+// whose source is itself stale or unhealthy wait: copying them would spread
+// bad data over the only other copy.
+static void fram_mirror_repair_step(fram_hal_mirror_ctx_t *ctx, uint32_t budget) {
+    uint32_t i = 0;
+    while (budget > 0 && i < ctx->repair_count) {
+        fram_hal_mirror_range_t *r = &ctx->repair[i];
+        size_t bad = r->child;
+        size_t good = 1 - bad;
+        uint32_t n = r->len;
+        if (n > budget) {
+            n = budget;
+        }
+        if (n > sizeof(ctx->scratch)) {
+            n = sizeof(ctx->scratch);
+        }
+        if (!fram_mirror_can_read(ctx, good, r->addr, n)) {
+            i++;
+            continue;
+        }
+
+        esp_err_t err = fram_mirror_child_xfer(ctx->children[good], r->addr, ctx->scratch, NULL, n);
+        fram_mirror_record(ctx, good, err);
+        if (err != ESP_OK) {
+            return;
+        }
+        err = fram_mirror_child_xfer(ctx->children[bad], r->addr, NULL, ctx->scratch, n);
+        fram_mirror_record(ctx, bad, err);
+        if (err != ESP_OK) {
+            return;
+        }
+
+        ctx->child[bad].repaired_bytes += n;
+        r->addr += n;
+        r->len -= n;
+        budget -= n;
+        if (r->len == 0) {
+            fram_mirror_remove_range(ctx, i);
+        }
+    }
+}
+
+static void fram_mirror_async_done(fram_hal_t *child, esp_err_t err, void *arg) {
+    fram_hal_mirror_ctx_t *ctx = (fram_hal_mirror_ctx_t *)arg;
+    size_t i = child == ctx->children[0] ? 0 : 1;
+    if (err != ESP_OK && ctx->async_err[i] == ESP_OK) {
+        ctx->async_err[i] = err;
+    }
+}
+
+static bool fram_mirror_async_capable(const fram_hal_mirror_ctx_t *ctx, bool read) {
+    for (size_t i = 0; i < FRAM_HAL_MIRROR_CHILDREN; i++) {
+        const fram_hal_t *child = ctx->children[i];
+        if ((read ? child->read_async == NULL : child->write_async == NULL) || child->wait == NULL) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static esp_err_t fram_mirror_check_range(const fram_hal_t *hal, uint32_t addr, size_t len) {
+    if (addr > hal->size_bytes || len > hal->size_bytes || addr > hal->size_bytes - len) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    return ESP_OK;
+}
+
+// Read [addr, addr + len) from `first`, falling back to the other child.
+// A child holding stale data in the range is never read; with both stale
+// there is no current copy and the read fails.
+static esp_err_t fram_mirror_read_one(fram_hal_mirror_ctx_t *ctx, size_t first, uint32_t addr,
+                                      uint8_t *buf, size_t len) {
+    size_t second = 1 - first;
+    esp_err_t err = ESP_ERR_INVALID_STATE;
+    if (!fram_mirror_stale(ctx, first, addr, len)) {
+        err = fram_mirror_child_xfer(ctx->children[first], addr, buf, NULL, len);
+        fram_mirror_record(ctx, first, err);
+        ctx->child[first].read_count++;
+        if (err == ESP_OK) {
+            return ESP_OK;
+        }
+        fram_mirror_queue_repair(ctx, first, addr, len);
+    }
+
+    if (fram_mirror_stale(ctx, second, addr, len)) {
+        ESP_LOGE(TAG, "read 0x%X+%u: no current copy", (unsigned)addr, (unsigned)len);
+        return err;
+    }
+    ESP_LOGW(TAG, "read 0x%X+%u failed on child %u, using child %u", (unsigned)addr, (unsigned)len,
+             (unsigned)first, (unsigned)second);
+    err = fram_mirror_child_xfer(ctx->children[second], addr, buf, NULL, len);
+    fram_mirror_record(ctx, second, err);
+    ctx->child[second].read_count++;
+    return err;
+}
+
+static esp_err_t fram_hal_mirror_read(fram_hal_t *hal, uint32_t addr, void *buf, size_t len) {
+    if (hal == NULL || hal->ctx == NULL || buf == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (len == 0) {
+        return ESP_OK;
+    }
+    ESP_RETURN_ON_ERROR(fram_mirror_check_range(hal, addr, len), TAG, "out of range");
+
+    fram_hal_mirror_ctx_t *ctx = (fram_hal_mirror_ctx_t *)hal->ctx;
+    uint8_t *out = (uint8_t *)buf;
+    esp_err_t err;
+
+    if (ctx->read_policy == FRAM_HAL_MIRROR_READ_SPLIT && len >= ctx->split_min &&
+        fram_mirror_async_capable(ctx, true) &&
+        fram_mirror_can_read(ctx, 0, addr, len) && fram_mirror_can_read(ctx, 1, addr, len)) {
+        // First half from child 0, second from child 1, in parallel
+        size_t half = (len / 2) & ~(size_t)3;
+        size_t part_len[FRAM_HAL_MIRROR_CHILDREN] = { half, len - half };
+        uint32_t part_addr[FRAM_HAL_MIRROR_CHILDREN] = { addr, addr + (uint32_t)half };
+        esp_err_t submit[FRAM_HAL_MIRROR_CHILDREN];
+
+        for (size_t i = 0; i < FRAM_HAL_MIRROR_CHILDREN; i++) {
+            ctx->async_err[i] = ESP_OK;
+            submit[i] = ctx->children[i]->read_async(ctx->children[i], part_addr[i], out + (part_addr[i] - addr),
+                                                     part_len[i], fram_mirror_async_done, ctx);
+        }
+        err = ESP_OK;
+        for (size_t i = 0; i < FRAM_HAL_MIRROR_CHILDREN; i++) {
+            esp_err_t part_err = submit[i];
+            if (part_err == ESP_OK) {
+                part_err = ctx->children[i]->wait(ctx->children[i], FRAM_HAL_WAIT_FOREVER);
+            }
+            if (part_err == ESP_OK) {
+                part_err = ctx->async_err[i];
+            }
+            fram_mirror_record(ctx, i, part_err);
+            ctx->child[i].read_count++;
+            if (part_err != ESP_OK) {
+                fram_mirror_queue_repair(ctx, i, part_addr[i], part_len[i]);
+                esp_err_t retry = ESP_ERR_INVALID_STATE;
+                if (!fram_mirror_stale(ctx, 1 - i, part_addr[i], part_len[i])) {
+                    retry = fram_mirror_child_xfer(ctx->children[1 - i], part_addr[i],
+                                                   out + (part_addr[i] - addr), NULL, part_len[i]);
+                    fram_mirror_record(ctx, 1 - i, retry);
+                }
+                if (retry != ESP_OK && err == ESP_OK) {
+                    err = retry;
+                }
+            }
+        }
+    } else {
+        size_t first = ctx->next_read;
+        ctx->next_read = 1 - ctx->next_read;
+        if (!fram_mirror_can_read(ctx, first, addr, len) && fram_mirror_can_read(ctx, 1 - first, addr, len)) {
+            first = 1 - first;
+        }
+        err = fram_mirror_read_one(ctx, first, addr, out, len);
+    }
+
+    fram_mirror_repair_step(ctx, ctx->repair_budget);
+    return err;
+}
+
+static esp_err_t fram_hal_mirror_write(fram_hal_t *hal, uint32_t addr, const void *buf, size_t len) {
+    if (hal == NULL || hal->ctx == NULL || buf == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (len == 0) {
+        return ESP_OK;
+    }
+    ESP_RETURN_ON_ERROR(fram_mirror_check_range(hal, addr, len), TAG, "out of range");
+
+    fram_hal_mirror_ctx_t *ctx = (fram_hal_mirror_ctx_t *)hal->ctx;
+    esp_err_t result[FRAM_HAL_MIRROR_CHILDREN];
+
+    if (fram_mirror_async_capable(ctx, false)) {
+        // Both copies in flight at once
+        for (size_t i = 0; i < FRAM_HAL_MIRROR_CHILDREN; i++) {
+            ctx->async_err[i] = ESP_OK;
+            result[i] = ctx->children[i]->write_async(ctx->children[i], addr, buf, len,
+                                                      fram_mirror_async_done, ctx);
+        }
+        for (size_t i = 0; i < FRAM_HAL_MIRROR_CHILDREN; i++) {
+            if (result[i] == ESP_OK) {
+                result[i] = ctx->children[i]->wait(ctx->children[i], FRAM_HAL_WAIT_FOREVER);
+            }
+            if (result[i] == ESP_OK) {
+                result[i] = ctx->async_err[i];
+            }
+        }
+    } else {
+        for (size_t i = 0; i < FRAM_HAL_MIRROR_CHILDREN; i++) {
+            result[i] = fram_mirror_child_xfer(ctx->children[i], addr, NULL, (const uint8_t *)buf, len);
+        }
+    }
+
+    for (size_t i = 0; i < FRAM_HAL_MIRROR_CHILDREN; i++) {
+        fram_mirror_record(ctx, i, result[i]);
+        ctx->child[i].write_count++;
+        if (result[i] == ESP_OK) {
+            fram_mirror_clear_repair(ctx, i, addr, len);
+        } else {
+            fram_mirror_queue_repair(ctx, i, addr, len);
+        }
+    }
+
+    fram_mirror_repair_step(ctx, ctx->repair_budget);
+    // One good copy is enough to keep serving
+    return result[0] == ESP_OK ? ESP_OK : result[1];
+}
+
+static esp_err_t fram_hal_mirror_read_copy(fram_hal_t *hal, uint32_t copy, uint32_t addr, void *buf, size_t len) {
+    if (hal == NULL || hal->ctx == NULL || buf == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (copy >= FRAM_HAL_MIRROR_CHILDREN) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    ESP_RETURN_ON_ERROR(fram_mirror_check_range(hal, addr, len), TAG, "out of range");
+
+    fram_hal_mirror_ctx_t *ctx = (fram_hal_mirror_ctx_t *)hal->ctx;
+    esp_err_t err = fram_mirror_child_xfer(ctx->children[copy], addr, (uint8_t *)buf, NULL, len);
+    fram_mirror_record(ctx, copy, err);
+    ctx->child[copy].read_count++;
+    return err;
+}
+
+static esp_err_t fram_hal_mirror_repair(fram_hal_t *hal, uint32_t good_copy, uint32_t addr, size_t len) {
+    if (hal == NULL || hal->ctx == NULL || good_copy >= FRAM_HAL_MIRROR_CHILDREN) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    ESP_RETURN_ON_ERROR(fram_mirror_check_range(hal, addr, len), TAG, "out of range");
+
+    fram_hal_mirror_ctx_t *ctx = (fram_hal_mirror_ctx_t *)hal->ctx;
+    if (!fram_mirror_can_read(ctx, good_copy, addr, len)) {
+        ESP_LOGE(TAG, "child %u cannot source 0x%X+%u", (unsigned)good_copy, (unsigned)addr, (unsigned)len);
+        return ESP_ERR_INVALID_STATE;
+    }
+    ESP_LOGW(TAG, "repairing 0x%X+%u on child %u", (unsigned)addr, (unsigned)len, (unsigned)(1 - good_copy));
+    fram_mirror_queue_repair(ctx, 1 - good_copy, addr, len);
+    fram_mirror_repair_step(ctx, ctx->repair_budget);
+    return ESP_OK;
+}
+
+static esp_err_t fram_hal_mirror_init(fram_hal_t *hal) {
+    if (hal == NULL || hal->ctx == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    fram_hal_mirror_ctx_t *ctx = (fram_hal_mirror_ctx_t *)hal->ctx;
+    for (size_t i = 0; i < FRAM_HAL_MIRROR_CHILDREN; i++) {
+        fram_hal_t *child = ctx->children[i];
+        if (child->init) {
+            ESP_RETURN_ON_ERROR(child->init(child), TAG, "child %u init failed", (unsigned)i);
+        }
+    }
+    return ESP_OK;
+}
+
+static esp_err_t fram_hal_mirror_deinit(fram_hal_t *hal) {
+    if (hal == NULL || hal->ctx == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    fram_hal_mirror_ctx_t *ctx = (fram_hal_mirror_ctx_t *)hal->ctx;
+    for (size_t i = 0; i < FRAM_HAL_MIRROR_CHILDREN; i++) {
+        fram_hal_t *child = ctx->children[i];
+        if (child->deinit) {
+            child->deinit(child);
+        }
+    }
+    return ESP_OK;
+}
+
+// Probe both children; the mirror is as large as the smaller one.
+static esp_err_t fram_hal_mirror_probe(fram_hal_t *hal) {
+    if (hal == NULL || hal->ctx == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    fram_hal_mirror_ctx_t *ctx = (fram_hal_mirror_ctx_t *)hal->ctx;
+    uint32_t size = UINT32_MAX;
+    for (size_t i = 0; i < FRAM_HAL_MIRROR_CHILDREN; i++) {
+        fram_hal_t *child = ctx->children[i];
+        if (child->probe) {
+            ESP_RETURN_ON_ERROR(child->probe(child), TAG, "child %u probe failed", (unsigned)i);
+        }
+        if (child->size_bytes < size) {
+            size = child->size_bytes;
+        }
+    }
+    if (size == 0) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (ctx->children[0]->size_bytes != ctx->children[1]->size_bytes) {
+        ESP_LOGW(TAG, "children differ in size, using %u bytes", (unsigned)size);
+    }
+
+    hal->size_bytes = size;
+    hal->max_transfer = size;
+    return ESP_OK;
+}
+
+static esp_err_t fram_hal_mirror_acquire(fram_hal_t *hal) {
+    fram_hal_mirror_ctx_t *ctx = (fram_hal_mirror_ctx_t *)hal->ctx;
+    return fram_hal_group_acquire(ctx->children, FRAM_HAL_MIRROR_CHILDREN, &ctx->acquired);
+}
+
+static void fram_hal_mirror_release(fram_hal_t *hal) {
+    fram_hal_mirror_ctx_t *ctx = (fram_hal_mirror_ctx_t *)hal->ctx;
+    fram_hal_group_release(ctx->children, FRAM_HAL_MIRROR_CHILDREN, &ctx->acquired);
+}
+
+esp_err_t fram_hal_mirror_create(fram_hal_t *hal,
+                                 fram_hal_mirror_ctx_t *ctx,
+                                 const fram_hal_mirror_config_t *cfg) {
+    if (hal == NULL || ctx == NULL || cfg == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (cfg->children[0] == NULL || cfg->children[1] == NULL || cfg->children[0] == cfg->children[1] ||
+        cfg->children[0] == hal || cfg->children[1] == hal) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (cfg->read_policy != FRAM_HAL_MIRROR_READ_ALTERNATE && cfg->read_policy != FRAM_HAL_MIRROR_READ_SPLIT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(hal, 0, sizeof(*hal));
+    memset(ctx, 0, sizeof(*ctx));
+
+    for (size_t i = 0; i < FRAM_HAL_MIRROR_CHILDREN; i++) {
+        ctx->children[i] = cfg->children[i];
+        ctx->child[i].healthy = true;
+    }
+    ctx->read_policy = cfg->read_policy;
+    ctx->split_min = cfg->split_min ? cfg->split_min : CONFIG_FRAM_HAL_MIRROR_SPLIT_MIN;
+    ctx->repair_budget = cfg->repair_budget ? cfg->repair_budget : CONFIG_FRAM_HAL_MIRROR_REPAIR_BUDGET;
+    ctx->error_threshold = cfg->error_threshold ? cfg->error_threshold : CONFIG_FRAM_DEFAULT_ERROR_THRESHOLD;
+
+    hal->init = fram_hal_mirror_init;
+    hal->deinit = fram_hal_mirror_deinit;
+    hal->read = fram_hal_mirror_read;
+    hal->write = fram_hal_mirror_write;
+    hal->probe = fram_hal_mirror_probe;
+    hal->acquire = fram_hal_mirror_acquire;
+    hal->release = fram_hal_mirror_release;
+    hal->read_copy = fram_hal_mirror_read_copy;
+    hal->repair = fram_hal_mirror_repair;
+    hal->caps = FRAM_HAL_CAP_CONTINUOUS; // chunks per child itself
+    hal->copies = FRAM_HAL_MIRROR_CHILDREN;
+    hal->buses = fram_hal_group_buses(ctx->children, FRAM_HAL_MIRROR_CHILDREN);
+    hal->ctx = ctx;
+
+    return ESP_OK;
+}
+
+esp_err_t fram_hal_mirror_get_child_stats(const fram_hal_t *hal, size_t child,
+                                          fram_hal_mirror_child_t *stats) {
+    if (hal == NULL || hal->ctx == NULL || stats == NULL || child >= FRAM_HAL_MIRROR_CHILDREN) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    const fram_hal_mirror_ctx_t *ctx = (const fram_hal_mirror_ctx_t *)hal->ctx;
+    *stats = ctx->child[child];
+    return ESP_OK;
+}
+
+uint32_t fram_hal_mirror_repair_pending(const fram_hal_t *hal) {
+    if (hal == NULL || hal->ctx == NULL) {
+        return 0;
+    }
+    const fram_hal_mirror_ctx_t *ctx = (const fram_hal_mirror_ctx_t *)hal->ctx;
+    uint32_t pending = 0;
+    for (uint32_t i = 0; i < ctx->repair_count; i++) {
+        pending += ctx->repair[i].len;
+    }
+    return pending;
+}
+
+#endif // CONFIG_FRAM_HAL_MIRROR_ENABLED
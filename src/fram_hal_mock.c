@@ -3,6 +3,7 @@
 #if CONFIG_FRAM_HAL_MOCK_ENABLED
 
 #include "esp_check.h"
+#include "esp_rom_sys.h"
 #include <string.h>
 
 #define TAG "fram_hal_mock"
@@ -31,26 +32,50 @@ static esp_err_t fram_hal_mock_probe(fram_hal_t *hal) {
     if (hal == NULL || hal->ctx == NULL) {
         return ESP_ERR_INVALID_ARG;
     }
-    return ESP_OK;
-}
 
-static esp_err_t fram_hal_mock_read(fram_hal_t *hal, uint32_t addr, void *buf, size_t len) {
-    if (hal == NULL || hal->ctx == NULL || buf == NULL) {
-        return ESP_ERR_INVALID_ARG;
-    }
-    if (len == 0) {
+    fram_hal_mock_ctx_t *ctx = (fram_hal_mock_ctx_t *)hal->ctx;
+    if (ctx->rdid == NULL) {
         return ESP_OK;
     }
-    if (addr > hal->size_bytes || len > hal->size_bytes || addr > hal->size_bytes - len) {
+
+    // Same identification as the SPI HAL, against the emulated RDID response
+    const fram_chip_t *chip = NULL;
+    esp_err_t err = fram_chip_identify(ctx->rdid, ctx->rdid_len, &chip);
+    if (err != ESP_OK) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (hal->size_bytes > chip->size_bytes) {
         return ESP_ERR_INVALID_SIZE;
     }
+    hal->chip = chip;
+    return ESP_OK;
+}
 
+// Charge one read or write of `len` bytes to the bus model.
+static void fram_hal_mock_account(fram_hal_t *hal, size_t len, bool write) {
     fram_hal_mock_ctx_t *ctx = (fram_hal_mock_ctx_t *)hal->ctx;
-    ctx->op_count++;
-    if (fram_mock_should_fail(ctx)) {
-        return ESP_FAIL;
+    size_t per_cmd = (hal->caps & FRAM_HAL_CAP_CONTINUOUS) ? len : hal->max_transfer;
+    uint32_t cmds = (uint32_t)((len + per_cmd - 1) / per_cmd);
+    uint32_t addr_bytes = ctx->addr_bytes ? ctx->addr_bytes : (hal->chip ? hal->chip->addr_bytes : 2);
+    uint64_t wire = (uint64_t)cmds * (1 + addr_bytes) + len;
+    uint32_t txns = cmds;
+
+    if (write) {
+        ctx->wren_count += cmds;
+        txns += cmds;
+        wire += cmds; // WREN opcode
+    }
+    ctx->txn_count += txns;
+    ctx->wire_bytes += wire;
+    uint64_t ns = (uint64_t)txns * ctx->cs_overhead_ns + wire * ctx->byte_ns;
+    ctx->sim_time_ns += ns;
+    if (ctx->realtime) {
+        esp_rom_delay_us((uint32_t)(ns / 1000));
     }
+}
 
+// Copy from the backing store, flipping bytes in the injected-error range.
+static void fram_hal_mock_copy_out(const fram_hal_mock_ctx_t *ctx, uint32_t addr, void *buf, size_t len) {
     memcpy(buf, &ctx->buffer[addr], len);
 
     if (ctx->inject_enabled) {
@@ -68,11 +93,31 @@ static esp_err_t fram_hal_mock_read(fram_hal_t *hal, uint32_t addr, void *buf, s
             }
         }
     }
+}
+
+static esp_err_t fram_hal_mock_do_read(fram_hal_t *hal, uint32_t addr, void *buf, size_t len) {
+    if (hal == NULL || hal->ctx == NULL || buf == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (len == 0) {
+        return ESP_OK;
+    }
+    if (addr > hal->size_bytes || len > hal->size_bytes || addr > hal->size_bytes - len) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    fram_hal_mock_ctx_t *ctx = (fram_hal_mock_ctx_t *)hal->ctx;
+    ctx->op_count++;
+    if (fram_mock_should_fail(ctx)) {
+        return ESP_FAIL;
+    }
 
+    fram_hal_mock_account(hal, len, false);
+    fram_hal_mock_copy_out(ctx, addr, buf, len);
     return ESP_OK;
 }
 
-static esp_err_t fram_hal_mock_write(fram_hal_t *hal, uint32_t addr, const void *buf, size_t len) {
+static esp_err_t fram_hal_mock_do_write(fram_hal_t *hal, uint32_t addr, const void *buf, size_t len) {
     if (hal == NULL || hal->ctx == NULL || buf == NULL) {
         return ESP_ERR_INVALID_ARG;
     }
@@ -89,10 +134,187 @@ static esp_err_t fram_hal_mock_write(fram_hal_t *hal, uint32_t addr, const void
         return ESP_FAIL;
     }
 
+    fram_hal_mock_account(hal, len, true);
     memcpy(&ctx->buffer[addr], buf, len);
     return ESP_OK;
 }
 
+// Perform and complete queued async ops in submission order.
+static esp_err_t fram_hal_mock_async_drain(fram_hal_t *hal) {
+    fram_hal_mock_ctx_t *ctx = (fram_hal_mock_ctx_t *)hal->ctx;
+    while (ctx->async_count > 0) {
+        fram_hal_mock_async_t op = ctx->async[ctx->async_head];
+        ctx->async_head = (ctx->async_head + 1) % FRAM_HAL_MOCK_ASYNC_DEPTH;
+        ctx->async_count--;
+
+        esp_err_t err = op.rx ? fram_hal_mock_do_read(hal, op.addr, op.rx, op.len)
+                              : fram_hal_mock_do_write(hal, op.addr, op.tx, op.len);
+        if (op.done) {
+            op.done(hal, err, op.arg);
+        }
+    }
+    return ESP_OK;
+}
+
+static esp_err_t fram_hal_mock_submit(fram_hal_t *hal, uint32_t addr, void *rx, const void *tx, size_t len,
+                                      fram_hal_done_fn done, void *arg) {
+    if (hal == NULL || hal->ctx == NULL || (rx == NULL && tx == NULL)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (addr > hal->size_bytes || len > hal->size_bytes || addr > hal->size_bytes - len) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    fram_hal_mock_ctx_t *ctx = (fram_hal_mock_ctx_t *)hal->ctx;
+    if (ctx->async_count == FRAM_HAL_MOCK_ASYNC_DEPTH) {
+        fram_hal_mock_async_drain(hal);
+    }
+    ctx->async[(ctx->async_head + ctx->async_count) % FRAM_HAL_MOCK_ASYNC_DEPTH] = (fram_hal_mock_async_t){
+        .addr = addr,
+        .rx = rx,
+        .tx = tx,
+        .len = len,
+        .done = done,
+        .arg = arg,
+    };
+    ctx->async_count++;
+    return ESP_OK;
+}
+
+// Sync ops complete anything queued before them, as on a real bus.
+static esp_err_t fram_hal_mock_read(fram_hal_t *hal, uint32_t addr, void *buf, size_t len) {
+    if (hal && hal->ctx) {
+        fram_hal_mock_async_drain(hal);
+    }
+    return fram_hal_mock_do_read(hal, addr, buf, len);
+}
+
+static esp_err_t fram_hal_mock_write(fram_hal_t *hal, uint32_t addr, const void *buf, size_t len) {
+    if (hal && hal->ctx) {
+        fram_hal_mock_async_drain(hal);
+    }
+    return fram_hal_mock_do_write(hal, addr, buf, len);
+}
+
+static esp_err_t fram_hal_mock_fill_range(fram_hal_t *hal, uint32_t addr, uint8_t value, size_t len) {
+    if (hal == NULL || hal->ctx == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (len == 0) {
+        return ESP_OK;
+    }
+    if (addr > hal->size_bytes || len > hal->size_bytes || addr > hal->size_bytes - len) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    fram_hal_mock_ctx_t *ctx = (fram_hal_mock_ctx_t *)hal->ctx;
+    fram_hal_mock_async_drain(hal);
+    ctx->op_count++;
+    if (fram_mock_should_fail(ctx)) {
+        return ESP_FAIL;
+    }
+
+    fram_hal_mock_account(hal, len, true);
+    memset(&ctx->buffer[addr], value, len);
+    return ESP_OK;
+}
+
+static bool fram_hal_mock_vec_ok(const fram_hal_t *hal, uint32_t addr, const void *buf, size_t len) {
+    return (buf != NULL || len == 0) && addr <= hal->size_bytes && len <= hal->size_bytes &&
+           addr <= hal->size_bytes - len;
+}
+
+// Each run of contiguous segments is one command (one fail_after op).
+static esp_err_t fram_hal_mock_readv(fram_hal_t *hal, const fram_rvec_t *vec, size_t count) {
+    if (hal == NULL || hal->ctx == NULL || vec == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    fram_hal_mock_ctx_t *ctx = (fram_hal_mock_ctx_t *)hal->ctx;
+    fram_hal_mock_async_drain(hal);
+
+    size_t i = 0;
+    while (i < count) {
+        size_t end = i;
+        size_t run_len = 0;
+        do {
+            if (!fram_hal_mock_vec_ok(hal, vec[end].offset, vec[end].buf, vec[end].len)) {
+                return ESP_ERR_INVALID_SIZE;
+            }
+            run_len += vec[end].len;
+            end++;
+        } while (end < count && vec[end].offset == vec[end - 1].offset + vec[end - 1].len);
+
+        if (run_len > 0) {
+            ctx->op_count++;
+            if (fram_mock_should_fail(ctx)) {
+                return ESP_FAIL;
+            }
+            fram_hal_mock_account(hal, run_len, false);
+            for (; i < end; i++) {
+                if (vec[i].len > 0) {
+                    fram_hal_mock_copy_out(ctx, vec[i].offset, vec[i].buf, vec[i].len);
+                }
+            }
+        }
+        i = end;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t fram_hal_mock_writev(fram_hal_t *hal, const fram_wvec_t *vec, size_t count) {
+    if (hal == NULL || hal->ctx == NULL || vec == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    fram_hal_mock_ctx_t *ctx = (fram_hal_mock_ctx_t *)hal->ctx;
+    fram_hal_mock_async_drain(hal);
+
+    size_t i = 0;
+    while (i < count) {
+        size_t end = i;
+        size_t run_len = 0;
+        do {
+            if (!fram_hal_mock_vec_ok(hal, vec[end].offset, vec[end].buf, vec[end].len)) {
+                return ESP_ERR_INVALID_SIZE;
+            }
+            run_len += vec[end].len;
+            end++;
+        } while (end < count && vec[end].offset == vec[end - 1].offset + vec[end - 1].len);
+
+        if (run_len > 0) {
+            ctx->op_count++;
+            if (fram_mock_should_fail(ctx)) {
+                return ESP_FAIL;
+            }
+            fram_hal_mock_account(hal, run_len, true);
+            for (; i < end; i++) {
+                if (vec[i].len > 0) {
+                    memcpy(&ctx->buffer[vec[i].offset], vec[i].buf, vec[i].len);
+                }
+            }
+        }
+        i = end;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t fram_hal_mock_read_async(fram_hal_t *hal, uint32_t addr, void *buf, size_t len,
+                                          fram_hal_done_fn done, void *arg) {
+    return fram_hal_mock_submit(hal, addr, buf, NULL, len, done, arg);
+}
+
+static esp_err_t fram_hal_mock_write_async(fram_hal_t *hal, uint32_t addr, const void *buf, size_t len,
+                                           fram_hal_done_fn done, void *arg) {
+    return fram_hal_mock_submit(hal, addr, NULL, buf, len, done, arg);
+}
+
+static esp_err_t fram_hal_mock_wait(fram_hal_t *hal, uint32_t timeout_ms) {
+    (void)timeout_ms;
+    if (hal == NULL || hal->ctx == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return fram_hal_mock_async_drain(hal);
+}
+
 esp_err_t fram_hal_mock_create(fram_hal_t *hal,
                                fram_hal_mock_ctx_t *ctx,
                                const fram_hal_mock_config_t *cfg) {
@@ -102,6 +324,9 @@ esp_err_t fram_hal_mock_create(fram_hal_t *hal,
     if (cfg->size_bytes == 0 || cfg->size_bytes > cfg->buffer_len) {
         return ESP_ERR_INVALID_SIZE;
     }
+    if (cfg->max_transfer > cfg->size_bytes) {
+        return ESP_ERR_INVALID_SIZE;
+    }
 
     memset(hal, 0, sizeof(*hal));
     memset(ctx, 0, sizeof(*ctx));
@@ -110,14 +335,30 @@ esp_err_t fram_hal_mock_create(fram_hal_t *hal,
     ctx->size_bytes = cfg->size_bytes;
     ctx->fail_after = 0;
     ctx->fail_enabled = false;
+    ctx->rdid = cfg->rdid;
+    ctx->rdid_len = cfg->rdid_len;
+    ctx->byte_ns = cfg->byte_ns;
+    if (ctx->byte_ns == 0 && cfg->clock_hz > 0) {
+        ctx->byte_ns = (uint32_t)((8ULL * 1000000000ULL + cfg->clock_hz / 2) / cfg->clock_hz);
+    }
+    ctx->cs_overhead_ns = cfg->cs_overhead_ns;
+    ctx->realtime = cfg->realtime;
+    ctx->addr_bytes = cfg->addr_bytes;
 
     hal->init = fram_hal_mock_noop_init;
     hal->deinit = fram_hal_mock_deinit;
     hal->read = fram_hal_mock_read;
     hal->write = fram_hal_mock_write;
     hal->probe = fram_hal_mock_probe;
+    hal->read_async = fram_hal_mock_read_async;
+    hal->write_async = fram_hal_mock_write_async;
+    hal->wait = fram_hal_mock_wait;
+    hal->readv = fram_hal_mock_readv;
+    hal->writev = fram_hal_mock_writev;
+    hal->fill = fram_hal_mock_fill_range;
     hal->size_bytes = (uint32_t)cfg->size_bytes;
-    hal->max_transfer = (uint32_t)cfg->size_bytes;
+    hal->max_transfer = (uint32_t)(cfg->max_transfer ? cfg->max_transfer : cfg->size_bytes);
+    hal->caps = cfg->continuous ? FRAM_HAL_CAP_CONTINUOUS : 0;
     hal->ctx = ctx;
 
     return ESP_OK;
@@ -158,4 +399,16 @@ void fram_hal_mock_inject_error(fram_hal_t *hal, uint32_t offset, size_t len) {
     ctx->inject_enabled = true;
 }
 
+void fram_hal_mock_reset_counters(fram_hal_t *hal) {
+    if (hal == NULL || hal->ctx == NULL) {
+        return;
+    }
+    fram_hal_mock_ctx_t *ctx = (fram_hal_mock_ctx_t *)hal->ctx;
+    ctx->op_count = 0;
+    ctx->txn_count = 0;
+    ctx->wren_count = 0;
+    ctx->wire_bytes = 0;
+    ctx->sim_time_ns = 0;
+}
+
 #endif // CONFIG_FRAM_HAL_MOCK_ENABLED
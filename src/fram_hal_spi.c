@@ -3,31 +3,87 @@
 #if CONFIG_FRAM_HAL_SPI_ENABLED
 
 #include "esp_check.h"
+#include "esp_clk_tree.h"
 #include "esp_log.h"
+#include "esp_memory_utils.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "sdkconfig.h"
+#include <stddef.h>
 #include <string.h>
 
 #define TAG "fram_hal_spi"
 
-#define FM25V02A_CMD_WREN  0x06
-#define FM25V02A_CMD_WRDI  0x04
-#define FM25V02A_CMD_RDSR  0x05
-#define FM25V02A_CMD_WRSR  0x01
-#define FM25V02A_CMD_READ  0x03
-#define FM25V02A_CMD_WRITE 0x02
-#define FM25V02A_CMD_RDID  0x9F
-#define FM25V02A_CMD_SLEEP 0xB9
+#define FRAM_SPI_CMD_WREN  0x06
+#define FRAM_SPI_CMD_WRDI  0x04
+#define FRAM_SPI_CMD_RDSR  0x05
+#define FRAM_SPI_CMD_WRSR  0x01
+#define FRAM_SPI_CMD_READ  0x03
+#define FRAM_SPI_CMD_WRITE 0x02
+#define FRAM_SPI_CMD_RDID  0x9F
+#define FRAM_SPI_CMD_SLEEP 0xB9
 
-#define FM25V02A_SIZE_BYTES (32 * 1024U)
-#define FM25V02A_MANUF_ID   0xC2
-#define FM25V02A_RDID_LEN   9
-#define FM25V02A_FAMILY_ID  0x22
-#define FM25V02A_PROD_ID_A  0x08
-#define FM25V02A_PROD_ID_B  0x48
+#define FRAM_SPI_RDID_LEN          FRAM_CHIP_RDID_LEN
+#define FRAM_SPI_DEFAULT_ADDR_BITS 16
 
-#define FRAM_SPI_BUF_MAX ((CONFIG_FRAM_SPI_MAX_TRANSFER) > 0 ? (CONFIG_FRAM_SPI_MAX_TRANSFER) : 1)
+#define FRAM_SPI_BOUNCE_LEN (sizeof(((fram_hal_spi_ctx_t *)0)->bounce))
+
+// Clock calibration defaults
+#define FRAM_SPI_CALIB_SRC_HZ     80000000U // if the clock tree cannot be queried
+#define FRAM_SPI_CALIB_DIVIDERS   16U
+#define FRAM_SPI_CALIB_DELAY_MAX  50U
+#define FRAM_SPI_CALIB_DELAY_STEP 5U
+#define FRAM_SPI_CALIB_PASSES     4U
+#define FRAM_SPI_CALIB_MARGIN     1U
+
+#if CONFIG_FRAM_SPI_SINGLE_CS
+#define FRAM_SPI_SINGLE_CS 1
+#else
+#define FRAM_SPI_SINGLE_CS 0
+#endif
+
+// Mirrors the driver's own check: anything it would have to copy into a
+// private DMA buffer goes through ctx->bounce instead (no heap per transfer).
+static bool fram_hal_spi_dma_capable(const void *buf, size_t len, bool rx) {
+    if (!esp_ptr_dma_capable(buf) || ((uintptr_t)buf & 3U) != 0) {
+        return false;
+    }
+    return !rx || (len & 3U) == 0;
+}
+
+// Retire the oldest queued descriptor; the op's callback runs once its last
+// descriptor has been reaped. Results come back in queue order.
+static esp_err_t fram_hal_spi_async_reap(fram_hal_t *hal, TickType_t ticks) {
+    fram_hal_spi_ctx_t *ctx = (fram_hal_spi_ctx_t *)hal->ctx;
+    spi_transaction_t *t = NULL;
+    esp_err_t err = spi_device_get_trans_result(ctx->dev, &t, ticks);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    fram_hal_spi_async_t *slot = &ctx->async[ctx->async_head];
+    fram_hal_done_fn done = slot->done;
+    void *arg = slot->arg;
+    ctx->async_head = (ctx->async_head + 1) % ctx->queue_depth;
+    ctx->async_count--;
+
+    if (done) {
+        done(hal, ESP_OK, arg);
+    }
+    return ESP_OK;
+}
+
+// spi_device_transmit() must not run while queued transactions are pending.
+static esp_err_t fram_hal_spi_async_drain(fram_hal_t *hal) {
+    fram_hal_spi_ctx_t *ctx = (fram_hal_spi_ctx_t *)hal->ctx;
+    while (ctx->async_count > 0) {
+        esp_err_t err = fram_hal_spi_async_reap(hal, portMAX_DELAY);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+    return ESP_OK;
+}
 
 static esp_err_t fram_hal_spi_noop_init(fram_hal_t *hal) {
     (void)hal;
@@ -41,6 +97,7 @@ static esp_err_t fram_hal_spi_deinit(fram_hal_t *hal) {
 
     fram_hal_spi_ctx_t *ctx = (fram_hal_spi_ctx_t *)hal->ctx;
     if (ctx->dev != NULL) {
+        fram_hal_spi_async_drain(hal);
         spi_bus_remove_device(ctx->dev);
         ctx->dev = NULL;
     }
@@ -51,37 +108,49 @@ static esp_err_t fram_hal_spi_deinit(fram_hal_t *hal) {
     return ESP_OK;
 }
 
-static esp_err_t fram_hal_spi_write_enable(fram_hal_spi_ctx_t *ctx) {
-    uint8_t cmd = FM25V02A_CMD_WREN;
-    spi_transaction_t t = {
-        .length = 8,
-        .tx_buffer = &cmd,
+// Small transfers busy-wait on the peripheral: cheaper than the ISR and task
+// switch of spi_device_transmit() when only a few bytes are on the wire.
+static esp_err_t fram_hal_spi_transmit(fram_hal_spi_ctx_t *ctx, spi_transaction_t *t, bool polling) {
+    if (ctx->dev == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (polling) {
+        return spi_device_polling_transmit(ctx->dev, t);
+    }
+    return spi_device_transmit(ctx->dev, t);
+}
+
+// Opcode-only command (no address phase), optionally clocking in rx_len bytes.
+static esp_err_t fram_hal_spi_command(fram_hal_spi_ctx_t *ctx, uint8_t cmd, void *rx, size_t rx_len,
+                                      bool polling) {
+    spi_transaction_ext_t t = {
+        .base = {
+            .flags = SPI_TRANS_VARIABLE_ADDR,
+            .cmd = cmd,
+            .length = rx_len * 8,
+            .rx_buffer = rx,
+        },
+        .address_bits = 0,
     };
-    return spi_device_transmit(ctx->dev, &t);
+    return fram_hal_spi_transmit(ctx, &t.base, polling);
+}
+
+static esp_err_t fram_hal_spi_write_enable(fram_hal_spi_ctx_t *ctx, bool polling) {
+    return fram_hal_spi_command(ctx, FRAM_SPI_CMD_WREN, NULL, 0, polling);
 }
 
 static esp_err_t fram_hal_spi_read_id(fram_hal_spi_ctx_t *ctx, uint8_t *id, size_t len) {
-    if (len < FM25V02A_RDID_LEN) {
+    if (len < FRAM_SPI_RDID_LEN) {
         return ESP_ERR_INVALID_SIZE;
     }
 
-    uint8_t tx[1 + FM25V02A_RDID_LEN];
-    uint8_t rx[1 + FM25V02A_RDID_LEN];
-    memset(tx, 0, sizeof(tx));
-    tx[0] = FM25V02A_CMD_RDID;
-
-    spi_transaction_t t = {
-        .length = (sizeof(tx) * 8),
-        .tx_buffer = tx,
-        .rx_buffer = rx,
-    };
-
-    esp_err_t err = spi_device_transmit(ctx->dev, &t);
+    size_t xfer = (FRAM_SPI_RDID_LEN + 3U) & ~3U;
+    esp_err_t err = fram_hal_spi_command(ctx, FRAM_SPI_CMD_RDID, ctx->bounce, xfer, false);
     if (err != ESP_OK) {
         return err;
     }
 
-    memcpy(id, &rx[1], FM25V02A_RDID_LEN);
+    memcpy(id, ctx->bounce, FRAM_SPI_RDID_LEN);
     return ESP_OK;
 }
 
@@ -91,24 +160,288 @@ static esp_err_t fram_hal_spi_probe(fram_hal_t *hal) {
     }
 
     fram_hal_spi_ctx_t *ctx = (fram_hal_spi_ctx_t *)hal->ctx;
-    uint8_t id[FM25V02A_RDID_LEN];
-    esp_err_t err = fram_hal_spi_read_id(ctx, id, sizeof(id));
+    uint8_t id[FRAM_SPI_RDID_LEN];
+    esp_err_t err = fram_hal_spi_async_drain(hal);
+    if (err == ESP_OK) {
+        err = fram_hal_spi_read_id(ctx, id, sizeof(id));
+    }
     if (err != ESP_OK) {
         return err;
     }
 
-    if (id[6] != FM25V02A_MANUF_ID || id[7] != FM25V02A_FAMILY_ID) {
-        ESP_LOGW(TAG, "unexpected RDID bytes: %02X %02X %02X", id[6], id[7], id[8]);
+    const fram_chip_t *chip = NULL;
+    err = fram_chip_identify(id, sizeof(id), &chip);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "unknown RDID: %02X %02X %02X %02X %02X %02X %02X %02X %02X",
+                 id[0], id[1], id[2], id[3], id[4], id[5], id[6], id[7], id[8]);
         return ESP_ERR_NOT_FOUND;
     }
 
     if (hal->size_bytes == 0) {
-        hal->size_bytes = FM25V02A_SIZE_BYTES;
+        hal->size_bytes = chip->size_bytes;
+    } else if (hal->size_bytes > chip->size_bytes) {
+        ESP_LOGE(TAG, "%s is %u bytes, configured %u", chip->name,
+                 (unsigned)chip->size_bytes, (unsigned)hal->size_bytes);
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (ctx->freq_hz > chip->max_freq_hz) {
+        ESP_LOGW(TAG, "%s: %u Hz exceeds rated %u Hz", chip->name,
+                 (unsigned)ctx->freq_hz, (unsigned)chip->max_freq_hz);
     }
 
+    ctx->addr_bits = chip->addr_bytes * 8U;
+    hal->chip = chip;
     return ESP_OK;
 }
 
+// Largest data segment for one DMA transaction; kept word-sized so that only
+// the final segment of a stream can have an odd length.
+static size_t fram_hal_spi_segment_max(const fram_hal_t *hal) {
+    size_t seg_max = hal->max_transfer & ~3U;
+    return seg_max ? seg_max : hal->max_transfer;
+}
+
+// Stream one READ or WRITE over [addr, addr + len), where the data is the
+// concatenation of `pieces` (tx for WRITE, rx for READ).
+//
+// Opcode and address go out in the command/address phases and the data phase
+// DMAs straight from/to the caller's buffer, split into segments of at most
+// max_transfer bytes (or the bounce buffer size when staging). With
+// CONFIG_FRAM_SPI_SINGLE_CS the whole range is one CS window: only the first
+// segment carries opcode+address, the rest continue the data phase under
+// SPI_TRANS_CS_KEEP_ACTIVE, and a write needs a single WREN. Otherwise every
+// segment is its own transaction (and WREN).
+// Small write pieces (record headers, keys) are gathered into the bounce
+// buffer so a vector goes out in as few segments as possible.
+// Transfers of up to 4 bytes (commit markers) use the transaction's inline
+// tx_data/rx_data instead of a DMA buffer.
+typedef struct {
+    const uint8_t *tx;
+    uint8_t *rx;
+    size_t len;
+    bool fill;           // tx is `len` copies of `value` (no buffer)
+    uint8_t value;
+} fram_hal_spi_piece_t;
+
+static esp_err_t fram_hal_spi_short(fram_hal_spi_ctx_t *ctx, uint8_t cmd, uint32_t addr,
+                                    const uint8_t *tx, uint8_t *rx, size_t len, bool polling) {
+    spi_transaction_ext_t t = {
+        .base = {
+            .flags = SPI_TRANS_VARIABLE_ADDR | (tx ? SPI_TRANS_USE_TXDATA : SPI_TRANS_USE_RXDATA),
+            .cmd = cmd,
+            .addr = addr,
+            .length = len * 8,
+        },
+        .address_bits = ctx->addr_bits,
+    };
+    if (tx) {
+        memcpy(t.base.tx_data, tx, len);
+        esp_err_t err = fram_hal_spi_write_enable(ctx, polling);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+
+    esp_err_t err = fram_hal_spi_transmit(ctx, &t.base, polling);
+    if (err == ESP_OK && rx) {
+        memcpy(rx, t.base.rx_data, len);
+    }
+    return err;
+}
+
+// Copy up to `max` bytes of tx pieces into dst, starting at the cursor.
+static size_t fram_hal_spi_gather(uint8_t *dst, const fram_hal_spi_piece_t *pieces, size_t count,
+                                  size_t piece, size_t off, size_t max) {
+    size_t n = 0;
+    while (n < max && piece < count) {
+        size_t take = pieces[piece].len - off;
+        if (take > max - n) {
+            take = max - n;
+        }
+        if (pieces[piece].fill) {
+            memset(dst + n, pieces[piece].value, take);
+        } else {
+            memcpy(dst + n, pieces[piece].tx + off, take);
+        }
+        n += take;
+        off += take;
+        if (off == pieces[piece].len) {
+            piece++;
+            off = 0;
+        }
+    }
+    return n;
+}
+
+// Copy n bytes from src into the rx pieces, starting at the cursor.
+static void fram_hal_spi_scatter(const uint8_t *src, const fram_hal_spi_piece_t *pieces, size_t count,
+                                 size_t piece, size_t off, size_t n) {
+    while (n > 0 && piece < count) {
+        size_t take = pieces[piece].len - off;
+        if (take > n) {
+            take = n;
+        }
+        memcpy(pieces[piece].rx + off, src, take);
+        src += take;
+        n -= take;
+        off += take;
+        if (off == pieces[piece].len) {
+            piece++;
+            off = 0;
+        }
+    }
+}
+
+// Move the cursor forward by n bytes, skipping empty pieces.
+static void fram_hal_spi_advance(const fram_hal_spi_piece_t *pieces, size_t count,
+                                 size_t *piece, size_t *off, size_t n) {
+    *off += n;
+    while (*piece < count && *off >= pieces[*piece].len) {
+        *off -= pieces[*piece].len;
+        (*piece)++;
+    }
+}
+
+static esp_err_t fram_hal_spi_stream(fram_hal_t *hal, uint8_t cmd, uint32_t addr,
+                                     const fram_hal_spi_piece_t *pieces, size_t count) {
+    fram_hal_spi_ctx_t *ctx = (fram_hal_spi_ctx_t *)hal->ctx;
+    size_t seg_max = fram_hal_spi_segment_max(hal);
+    bool write = cmd == FRAM_SPI_CMD_WRITE;
+    bool single_cs = false;
+    bool acquired = false;
+    esp_err_t err = fram_hal_spi_async_drain(hal);
+
+    size_t len = 0;
+    for (size_t i = 0; i < count; i++) {
+        len += pieces[i].len;
+    }
+    bool polling = len <= ctx->polling_threshold;
+
+    if (err == ESP_OK && len <= sizeof(uint32_t)) {
+        uint8_t small[sizeof(uint32_t)];
+        if (write) {
+            fram_hal_spi_gather(small, pieces, count, 0, 0, len);
+            return fram_hal_spi_short(ctx, cmd, addr, small, NULL, len, polling);
+        }
+        err = fram_hal_spi_short(ctx, cmd, addr, NULL, small, len, polling);
+        if (err == ESP_OK) {
+            fram_hal_spi_scatter(small, pieces, count, 0, 0, len);
+        }
+        return err;
+    }
+
+    size_t piece = 0;
+    size_t off = 0;
+    fram_hal_spi_advance(pieces, count, &piece, &off, 0);
+
+    size_t done = 0;
+    while (err == ESP_OK && done < len) {
+        size_t remaining = len - done;
+        size_t avail = pieces[piece].len - off;
+        size_t seg = remaining > seg_max ? seg_max : remaining;
+        if (seg > avail) {
+            seg = avail;
+        }
+        const void *seg_tx = NULL;
+        void *seg_rx = NULL;
+        size_t xfer = seg;
+
+        if (write) {
+            seg_tx = pieces[piece].fill ? NULL : pieces[piece].tx + off;
+            if (seg_tx == NULL || (seg < remaining && seg < FRAM_SPI_BOUNCE_LEN) ||
+                !fram_hal_spi_dma_capable(seg_tx, seg, false)) {
+                // Fill, short piece with more to follow, or not DMA-able:
+                // gather as many following bytes as fit into one bounce
+                // segment. A fill re-sends the same bounce pattern.
+                size_t max = remaining > seg_max ? seg_max : remaining;
+                if (max > FRAM_SPI_BOUNCE_LEN) {
+                    max = FRAM_SPI_BOUNCE_LEN;
+                }
+                seg = fram_hal_spi_gather(ctx->bounce, pieces, count, piece, off, max);
+                seg_tx = ctx->bounce;
+                xfer = seg;
+            }
+        } else {
+            uint8_t *rx = pieces[piece].rx + off;
+            if (fram_hal_spi_dma_capable(rx, seg, true)) {
+                seg_rx = rx;
+            } else if (seg > 3 && fram_hal_spi_dma_capable(rx, seg & ~3U, true)) {
+                // Word-aligned body straight into the caller's buffer; the odd
+                // tail is picked up by the bounce path on the next pass.
+                seg &= ~3U;
+                xfer = seg;
+                seg_rx = rx;
+            } else {
+                // Through the bounce buffer, possibly spanning several pieces.
+                // RX DMA wants whole words: segments before the last stay
+                // word-sized so a CS window keeps its address in step, and the
+                // last may over-read up to 3 bytes (the array address wraps),
+                // so the driver never has to allocate.
+                seg = remaining > seg_max ? seg_max : remaining;
+                if (seg > FRAM_SPI_BOUNCE_LEN) {
+                    seg = FRAM_SPI_BOUNCE_LEN;
+                }
+                if (seg < remaining && seg > 3) {
+                    seg &= ~3U;
+                }
+                xfer = (seg + 3U) & ~3U;
+                seg_rx = ctx->bounce;
+            }
+        }
+
+        spi_transaction_ext_t t = {
+            .base = {
+                .flags = SPI_TRANS_VARIABLE_ADDR,
+                .cmd = cmd,
+                .addr = addr + done,
+                .length = xfer * 8,
+                .tx_buffer = seg_tx,
+                .rx_buffer = seg_rx,
+            },
+            .address_bits = ctx->addr_bits,
+        };
+        if (done == 0 && seg < len && FRAM_SPI_SINGLE_CS) {
+            // CS_KEEP_ACTIVE requires the bus to be held for the whole window.
+            if (!ctx->bus_held) {
+                err = ctx->dev ? spi_device_acquire_bus(ctx->dev, portMAX_DELAY) : ESP_ERR_INVALID_STATE;
+                if (err != ESP_OK) {
+                    break;
+                }
+                acquired = true;
+            }
+            single_cs = true;
+        }
+        if (write && (done == 0 || !single_cs)) {
+            err = fram_hal_spi_write_enable(ctx, polling);
+            if (err != ESP_OK) {
+                break;
+            }
+        }
+        if (single_cs) {
+            if (done > 0) {
+                t.base.flags |= SPI_TRANS_VARIABLE_CMD;
+                t.command_bits = 0;
+                t.address_bits = 0;
+            }
+            if (done + seg < len) {
+                t.base.flags |= SPI_TRANS_CS_KEEP_ACTIVE;
+            }
+        }
+
+        err = fram_hal_spi_transmit(ctx, &t.base, polling);
+        if (err == ESP_OK && seg_rx == ctx->bounce) {
+            fram_hal_spi_scatter(ctx->bounce, pieces, count, piece, off, seg);
+        }
+        done += seg;
+        fram_hal_spi_advance(pieces, count, &piece, &off, seg);
+    }
+
+    if (acquired) {
+        spi_device_release_bus(ctx->dev);
+    }
+    return err;
+}
+
 static esp_err_t fram_hal_spi_read(fram_hal_t *hal, uint32_t addr, void *buf, size_t len) {
     if (hal == NULL || hal->ctx == NULL || buf == NULL) {
         return ESP_ERR_INVALID_ARG;
@@ -121,99 +454,535 @@ static esp_err_t fram_hal_spi_read(fram_hal_t *hal, uint32_t addr, void *buf, si
         return ESP_ERR_INVALID_SIZE;
     }
 
-    fram_hal_spi_ctx_t *ctx = (fram_hal_spi_ctx_t *)hal->ctx;
-    uint8_t *out = (uint8_t *)buf;
-    size_t remaining = len;
-    uint32_t offset = addr;
+    fram_hal_spi_piece_t piece = { .rx = (uint8_t *)buf, .len = len };
+    return fram_hal_spi_stream(hal, FRAM_SPI_CMD_READ, addr, &piece, 1);
+}
+
+static esp_err_t fram_hal_spi_write(fram_hal_t *hal, uint32_t addr, const void *buf, size_t len) {
+    if (hal == NULL || hal->ctx == NULL || buf == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (len == 0) {
+        return ESP_OK;
+    }
+    if (hal->size_bytes == 0 || addr > hal->size_bytes || len > hal->size_bytes ||
+        addr > hal->size_bytes - len) {
+        return ESP_ERR_INVALID_SIZE;
+    }
 
-    while (remaining > 0) {
-        size_t chunk = remaining;
-        if (chunk > hal->max_transfer) {
-            chunk = hal->max_transfer;
+    fram_hal_spi_piece_t piece = { .tx = (const uint8_t *)buf, .len = len };
+    return fram_hal_spi_stream(hal, FRAM_SPI_CMD_WRITE, addr, &piece, 1);
+}
+
+static esp_err_t fram_hal_spi_fill(fram_hal_t *hal, uint32_t addr, uint8_t value, size_t len) {
+    if (hal == NULL || hal->ctx == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (len == 0) {
+        return ESP_OK;
+    }
+    if (hal->size_bytes == 0 || addr > hal->size_bytes || len > hal->size_bytes ||
+        addr > hal->size_bytes - len) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    fram_hal_spi_piece_t piece = { .len = len, .fill = true, .value = value };
+    return fram_hal_spi_stream(hal, FRAM_SPI_CMD_WRITE, addr, &piece, 1);
+}
+
+static bool fram_hal_spi_vec_ok(const fram_hal_t *hal, uint32_t addr, const void *buf, size_t len) {
+    return (buf != NULL || len == 0) && addr <= hal->size_bytes && len <= hal->size_bytes &&
+           addr <= hal->size_bytes - len;
+}
+
+// Each run of contiguous segments is streamed as one READ/WRITE.
+static esp_err_t fram_hal_spi_readv(fram_hal_t *hal, const fram_rvec_t *vec, size_t count) {
+    if (hal == NULL || hal->ctx == NULL || vec == NULL || count > FRAM_VEC_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    fram_hal_spi_piece_t pieces[FRAM_VEC_MAX];
+    size_t i = 0;
+    while (i < count) {
+        uint32_t addr = vec[i].offset;
+        size_t n = 0;
+        size_t run_len = 0;
+        do {
+            if (!fram_hal_spi_vec_ok(hal, vec[i].offset, vec[i].buf, vec[i].len)) {
+                return ESP_ERR_INVALID_SIZE;
+            }
+            pieces[n++] = (fram_hal_spi_piece_t){ .rx = (uint8_t *)vec[i].buf, .len = vec[i].len };
+            run_len += vec[i].len;
+            i++;
+        } while (i < count && vec[i].offset == vec[i - 1].offset + vec[i - 1].len);
+
+        if (run_len > 0) {
+            ESP_RETURN_ON_ERROR(fram_hal_spi_stream(hal, FRAM_SPI_CMD_READ, addr, pieces, n),
+                                TAG, "readv failed");
         }
-        if (chunk > (size_t)FRAM_SPI_BUF_MAX) {
-            chunk = FRAM_SPI_BUF_MAX;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t fram_hal_spi_writev(fram_hal_t *hal, const fram_wvec_t *vec, size_t count) {
+    if (hal == NULL || hal->ctx == NULL || vec == NULL || count > FRAM_VEC_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    fram_hal_spi_piece_t pieces[FRAM_VEC_MAX];
+    size_t i = 0;
+    while (i < count) {
+        uint32_t addr = vec[i].offset;
+        size_t n = 0;
+        size_t run_len = 0;
+        do {
+            if (!fram_hal_spi_vec_ok(hal, vec[i].offset, vec[i].buf, vec[i].len)) {
+                return ESP_ERR_INVALID_SIZE;
+            }
+            pieces[n++] = (fram_hal_spi_piece_t){ .tx = (const uint8_t *)vec[i].buf, .len = vec[i].len };
+            run_len += vec[i].len;
+            i++;
+        } while (i < count && vec[i].offset == vec[i - 1].offset + vec[i - 1].len);
+
+        if (run_len > 0) {
+            ESP_RETURN_ON_ERROR(fram_hal_spi_stream(hal, FRAM_SPI_CMD_WRITE, addr, pieces, n),
+                                TAG, "writev failed");
         }
+    }
+    return ESP_OK;
+}
 
-        uint8_t tx[3 + FRAM_SPI_BUF_MAX];
-        uint8_t rx[3 + FRAM_SPI_BUF_MAX];
-        tx[0] = FM25V02A_CMD_READ;
-        tx[1] = (uint8_t)((offset >> 8) & 0xFF);
-        tx[2] = (uint8_t)(offset & 0xFF);
-        memset(&tx[3], 0, chunk);
+// Queue one descriptor, retiring the oldest first if the pool is full.
+static esp_err_t fram_hal_spi_async_push(fram_hal_t *hal, const spi_transaction_ext_t *t,
+                                         fram_hal_done_fn done, void *arg) {
+    fram_hal_spi_ctx_t *ctx = (fram_hal_spi_ctx_t *)hal->ctx;
+    if (ctx->dev == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (ctx->async_count == ctx->queue_depth) {
+        ESP_RETURN_ON_ERROR(fram_hal_spi_async_reap(hal, portMAX_DELAY), TAG, "reap failed");
+    }
 
-        spi_transaction_t t = {
-            .length = (3 + chunk) * 8,
-            .tx_buffer = tx,
-            .rx_buffer = rx,
-        };
+    fram_hal_spi_async_t *slot = &ctx->async[(ctx->async_head + ctx->async_count) % ctx->queue_depth];
+    slot->trans = *t;
+    slot->done = done;
+    slot->arg = arg;
+
+    esp_err_t err = spi_device_queue_trans(ctx->dev, &slot->trans.base, portMAX_DELAY);
+    if (err == ESP_OK) {
+        ctx->async_count++;
+    }
+    return err;
+}
 
-        esp_err_t err = spi_device_transmit(ctx->dev, &t);
+// Queue a READ/WRITE of [addr, addr + len) without waiting. Each segment is
+// its own CS window; for writes the WREN of every segment is queued right in
+// front of it, so the whole op goes out back to back.
+static esp_err_t fram_hal_spi_submit(fram_hal_t *hal, uint8_t cmd, uint32_t addr,
+                                     const uint8_t *tx, uint8_t *rx, size_t len,
+                                     fram_hal_done_fn done, void *arg) {
+    size_t seg_max = fram_hal_spi_segment_max(hal);
+    size_t off = 0;
+
+    while (off < len) {
+        size_t seg = (len - off) > seg_max ? seg_max : (len - off);
+        bool last = (off + seg) == len;
+        esp_err_t err = ESP_OK;
+
+        if (tx) {
+            spi_transaction_ext_t wren = {
+                .base = {
+                    .flags = SPI_TRANS_VARIABLE_ADDR,
+                    .cmd = FRAM_SPI_CMD_WREN,
+                },
+                .address_bits = 0,
+            };
+            err = fram_hal_spi_async_push(hal, &wren, NULL, NULL);
+        }
+        if (err == ESP_OK) {
+            spi_transaction_ext_t t = {
+                .base = {
+                    .flags = SPI_TRANS_VARIABLE_ADDR,
+                    .cmd = cmd,
+                    .addr = addr + off,
+                    .length = seg * 8,
+                    .tx_buffer = tx ? tx + off : NULL,
+                    .rx_buffer = rx ? rx + off : NULL,
+                },
+                .address_bits = ((fram_hal_spi_ctx_t *)hal->ctx)->addr_bits,
+            };
+            err = fram_hal_spi_async_push(hal, &t, last ? done : NULL, arg);
+        }
         if (err != ESP_OK) {
+            // Part of the op may already be queued; let it finish so the
+            // driver queue is clean, but do not report completion.
+            fram_hal_spi_async_drain(hal);
             return err;
         }
-
-        memcpy(out, &rx[3], chunk);
-        out += chunk;
-        offset += chunk;
-        remaining -= chunk;
+        off += seg;
     }
-
     return ESP_OK;
 }
 
-static esp_err_t fram_hal_spi_write(fram_hal_t *hal, uint32_t addr, const void *buf, size_t len) {
+static esp_err_t fram_hal_spi_read_async(fram_hal_t *hal, uint32_t addr, void *buf, size_t len,
+                                         fram_hal_done_fn done, void *arg) {
     if (hal == NULL || hal->ctx == NULL || buf == NULL) {
         return ESP_ERR_INVALID_ARG;
     }
-    if (len == 0) {
-        return ESP_OK;
+    if (hal->size_bytes == 0 || addr > hal->size_bytes || len > hal->size_bytes ||
+        addr > hal->size_bytes - len) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    if (len == 0 || !fram_hal_spi_dma_capable(buf, len, true)) {
+        // Buffers that need the bounce buffer cannot be queued; complete inline.
+        esp_err_t err = len ? fram_hal_spi_read(hal, addr, buf, len) : fram_hal_spi_async_drain(hal);
+        if (done) {
+            done(hal, err, arg);
+        }
+        return err;
+    }
+    return fram_hal_spi_submit(hal, FRAM_SPI_CMD_READ, addr, NULL, (uint8_t *)buf, len, done, arg);
+}
+
+static esp_err_t fram_hal_spi_write_async(fram_hal_t *hal, uint32_t addr, const void *buf, size_t len,
+                                          fram_hal_done_fn done, void *arg) {
+    if (hal == NULL || hal->ctx == NULL || buf == NULL) {
+        return ESP_ERR_INVALID_ARG;
     }
     if (hal->size_bytes == 0 || addr > hal->size_bytes || len > hal->size_bytes ||
         addr > hal->size_bytes - len) {
         return ESP_ERR_INVALID_SIZE;
     }
 
+    if (len == 0 || !fram_hal_spi_dma_capable(buf, len, false)) {
+        esp_err_t err = len ? fram_hal_spi_write(hal, addr, buf, len) : fram_hal_spi_async_drain(hal);
+        if (done) {
+            done(hal, err, arg);
+        }
+        return err;
+    }
+    return fram_hal_spi_submit(hal, FRAM_SPI_CMD_WRITE, addr, (const uint8_t *)buf, NULL, len, done, arg);
+}
+
+static esp_err_t fram_hal_spi_wait(fram_hal_t *hal, uint32_t timeout_ms) {
+    if (hal == NULL || hal->ctx == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
     fram_hal_spi_ctx_t *ctx = (fram_hal_spi_ctx_t *)hal->ctx;
-    const uint8_t *in = (const uint8_t *)buf;
-    size_t remaining = len;
-    uint32_t offset = addr;
+    TickType_t start = xTaskGetTickCount();
+    TickType_t budget = timeout_ms == FRAM_HAL_WAIT_FOREVER ? portMAX_DELAY : pdMS_TO_TICKS(timeout_ms);
+    while (ctx->async_count > 0) {
+        TickType_t elapsed = xTaskGetTickCount() - start;
+        TickType_t left = budget == portMAX_DELAY ? portMAX_DELAY
+                          : elapsed >= budget ? 0 : budget - elapsed;
+        esp_err_t err = fram_hal_spi_async_reap(hal, left);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+    return ESP_OK;
+}
 
-    while (remaining > 0) {
-        size_t chunk = remaining;
-        if (chunk > hal->max_transfer) {
-            chunk = hal->max_transfer;
+#if CONFIG_FRAM_SPI_ACQUIRE_BUS
+// Held for one fram_dev call so the WREN and WRITE of a record (and any
+// polling transfers) are never interleaved with other devices on the bus.
+static esp_err_t fram_hal_spi_acquire(fram_hal_t *hal) {
+    if (hal == NULL || hal->ctx == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    fram_hal_spi_ctx_t *ctx = (fram_hal_spi_ctx_t *)hal->ctx;
+    if (ctx->dev == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    ESP_RETURN_ON_ERROR(fram_hal_spi_async_drain(hal), TAG, "async drain failed");
+    ESP_RETURN_ON_ERROR(spi_device_acquire_bus(ctx->dev, portMAX_DELAY), TAG, "acquire bus failed");
+    ctx->bus_held = true;
+    return ESP_OK;
+}
+
+static void fram_hal_spi_release(fram_hal_t *hal) {
+    if (hal == NULL || hal->ctx == NULL) {
+        return;
+    }
+
+    fram_hal_spi_ctx_t *ctx = (fram_hal_spi_ctx_t *)hal->ctx;
+    if (ctx->bus_held) {
+        ctx->bus_held = false;
+        spi_device_release_bus(ctx->dev);
+    }
+}
+#endif
+
+static esp_err_t fram_hal_spi_add_device(fram_hal_spi_ctx_t *ctx, uint32_t freq_hz, uint32_t input_delay_ns) {
+    spi_device_interface_config_t devcfg = {
+        .command_bits = 8,
+        .address_bits = FRAM_SPI_DEFAULT_ADDR_BITS, // per transaction once probed
+        .clock_speed_hz = (int)freq_hz,
+        .input_delay_ns = (int)input_delay_ns,
+        .mode = ctx->spi_mode,
+        .spics_io_num = ctx->cs_pin,
+        .queue_size = (int)ctx->queue_depth,
+        .flags = 0,
+    };
+    return spi_bus_add_device(ctx->host, &devcfg, &ctx->dev);
+}
+
+esp_err_t fram_hal_spi_set_clock(fram_hal_t *hal, uint32_t freq_hz, uint32_t input_delay_ns) {
+    if (hal == NULL || hal->ctx == NULL || freq_hz == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    fram_hal_spi_ctx_t *ctx = (fram_hal_spi_ctx_t *)hal->ctx;
+    if (ctx->dev == NULL || ctx->bus_held) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    ESP_RETURN_ON_ERROR(fram_hal_spi_async_drain(hal), TAG, "async drain failed");
+
+    // The driver fixes the clock per device handle, so swap the handle
+    ESP_RETURN_ON_ERROR(spi_bus_remove_device(ctx->dev), TAG, "spi_bus_remove_device failed");
+    ctx->dev = NULL;
+    esp_err_t err = fram_hal_spi_add_device(ctx, freq_hz, input_delay_ns);
+    if (err != ESP_OK) {
+        // Keep a usable handle at the previous setting
+        esp_err_t back = fram_hal_spi_add_device(ctx, ctx->freq_hz, ctx->input_delay_ns);
+        if (back != ESP_OK) {
+            ctx->dev = NULL;
+            ESP_LOGE(TAG, "re-adding the device at %u Hz failed (%s), HAL unusable", (unsigned)ctx->freq_hz,
+                     esp_err_to_name(back));
+            return ESP_ERR_INVALID_STATE;
         }
-        if (chunk > (size_t)FRAM_SPI_BUF_MAX) {
-            chunk = FRAM_SPI_BUF_MAX;
+        return err;
+    }
+    ctx->freq_hz = freq_hz;
+    ctx->input_delay_ns = input_delay_ns;
+    return ESP_OK;
+}
+
+// Scratch contents known to be on the chip, and what to compare against
+typedef struct {
+    fram_hal_t *hal;
+    uint32_t addr;
+    uint32_t passes;
+    uint8_t id[FRAM_SPI_RDID_LEN];
+    uint8_t orig[FRAM_HAL_SPI_CALIB_LEN];
+    uint8_t expect[FRAM_HAL_SPI_CALIB_LEN];
+    uint8_t buf[FRAM_HAL_SPI_CALIB_LEN];
+    uint32_t base_freq_hz;
+    uint32_t base_delay_ns;
+} fram_hal_spi_calib_t;
+
+// Alternating bits, walking ones and a scrambled sequence, so that both
+// stuck lines and sampling on the wrong edge show up.
+static uint8_t fram_hal_spi_calib_pattern(uint32_t pass, size_t i) {
+    switch (pass % 4U) {
+    case 0:
+        return (i & 1U) ? 0xAA : 0x55;
+    case 1:
+        return (i & 1U) ? 0x55 : 0xAA;
+    case 2:
+        return (uint8_t)(1U << (i & 7U));
+    default:
+        return (uint8_t)(i * 167U + pass * 61U);
+    }
+}
+
+// Read-only checks first: a write at a clock that corrupts MOSI could land
+// outside the scratch, so patterns are only written once reads are clean.
+static bool fram_hal_spi_calib_check(fram_hal_spi_calib_t *cal) {
+    fram_hal_t *hal = cal->hal;
+    fram_hal_spi_ctx_t *ctx = (fram_hal_spi_ctx_t *)hal->ctx;
+    uint8_t id[FRAM_SPI_RDID_LEN];
+    if (fram_hal_spi_read_id(ctx, id, sizeof(id)) != ESP_OK || memcmp(id, cal->id, sizeof(id)) != 0) {
+        return false;
+    }
+    if (fram_hal_spi_read(hal, cal->addr, cal->buf, sizeof(cal->buf)) != ESP_OK ||
+        memcmp(cal->buf, cal->expect, sizeof(cal->buf)) != 0) {
+        return false;
+    }
+
+    for (uint32_t pass = 0; pass < cal->passes; pass++) {
+        for (size_t i = 0; i < sizeof(cal->buf); i++) {
+            cal->buf[i] = fram_hal_spi_calib_pattern(pass, i);
+        }
+        if (fram_hal_spi_write(hal, cal->addr, cal->buf, sizeof(cal->buf)) != ESP_OK) {
+            return false;
+        }
+        memcpy(cal->expect, cal->buf, sizeof(cal->expect));
+        if (fram_hal_spi_read(hal, cal->addr, cal->buf, sizeof(cal->buf)) != ESP_OK ||
+            memcmp(cal->buf, cal->expect, sizeof(cal->buf)) != 0) {
+            return false;
         }
+    }
+    return true;
+}
 
-        esp_err_t err = fram_hal_spi_write_enable(ctx);
-        if (err != ESP_OK) {
-            return err;
+// Back to the configured clock and put the original scratch contents back
+static esp_err_t fram_hal_spi_calib_restore(fram_hal_spi_calib_t *cal) {
+    fram_hal_t *hal = cal->hal;
+    ESP_RETURN_ON_ERROR(fram_hal_spi_set_clock(hal, cal->base_freq_hz, cal->base_delay_ns), TAG,
+                        "restore clock failed");
+    ESP_RETURN_ON_ERROR(fram_hal_spi_write(hal, cal->addr, cal->orig, sizeof(cal->orig)), TAG,
+                        "restore scratch failed");
+    ESP_RETURN_ON_ERROR(fram_hal_spi_read(hal, cal->addr, cal->buf, sizeof(cal->buf)), TAG,
+                        "verify scratch failed");
+    if (memcmp(cal->buf, cal->orig, sizeof(cal->buf)) != 0) {
+        ESP_LOGE(TAG, "scratch not restored at the configured clock");
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+    memcpy(cal->expect, cal->orig, sizeof(cal->expect));
+    return ESP_OK;
+}
+
+static esp_err_t fram_hal_spi_calib_try(fram_hal_spi_calib_t *cal, uint32_t freq_hz, uint32_t delay_ns,
+                                        fram_hal_spi_calib_result_t *res, bool *ok) {
+    ESP_RETURN_ON_ERROR(fram_hal_spi_set_clock(cal->hal, freq_hz, delay_ns), TAG, "set clock failed");
+    res->tested++;
+    *ok = fram_hal_spi_calib_check(cal);
+    if (*ok) {
+        res->passed++;
+        return ESP_OK;
+    }
+    // Scratch contents are unknown after a failure
+    return fram_hal_spi_calib_restore(cal);
+}
+
+// Frequency of the clock source devices use by default (clock_source = 0)
+static uint32_t fram_hal_spi_src_hz(void) {
+    uint32_t hz = 0;
+    if (esp_clk_tree_src_get_freq_hz((soc_module_clk_t)SPI_CLK_SRC_DEFAULT, ESP_CLK_TREE_SRC_FREQ_PRECISION_CACHED,
+                                     &hz) != ESP_OK || hz == 0) {
+        hz = FRAM_SPI_CALIB_SRC_HZ;
+    }
+    return hz;
+}
+
+// Best delay at one clock: centre of the longest run of passing delays, if
+// that run leaves `margin` passing steps on either side.
+static esp_err_t fram_hal_spi_calib_sweep(fram_hal_spi_calib_t *cal, uint32_t freq_hz,
+                                          const fram_hal_spi_calib_config_t *cfg, uint32_t margin,
+                                          fram_hal_spi_calib_result_t *res, bool *found,
+                                          uint32_t *delay_ns) {
+    uint32_t step = cfg->delay_step_ns ? cfg->delay_step_ns : FRAM_SPI_CALIB_DELAY_STEP;
+    uint32_t max = cfg->delay_max_ns ? cfg->delay_max_ns : FRAM_SPI_CALIB_DELAY_MAX;
+    fram_hal_spi_calib_window_t win = {0};
+
+    for (uint32_t d = 0; d <= max; d += step) {
+        bool ok = false;
+        ESP_RETURN_ON_ERROR(fram_hal_spi_calib_try(cal, freq_hz, d, res, &ok), TAG, "calibration step failed");
+        fram_hal_spi_calib_window_add(&win, d, ok);
+    }
+
+    *found = fram_hal_spi_calib_window_pick(&win, step, margin, delay_ns);
+    return ESP_OK;
+}
+
+esp_err_t fram_hal_spi_calibrate(fram_hal_t *hal, const fram_hal_spi_calib_config_t *cfg,
+                                 fram_hal_spi_calib_result_t *result) {
+    if (hal == NULL || hal->ctx == NULL || cfg == NULL || (cfg->freqs_hz == NULL && cfg->freq_count != 0)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    fram_hal_spi_ctx_t *ctx = (fram_hal_spi_ctx_t *)hal->ctx;
+    if (ctx->bus_held) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    ESP_RETURN_ON_ERROR(fram_hal_spi_probe(hal), TAG, "probe at the configured clock failed");
+
+    uint32_t size = hal->size_bytes;
+    if (cfg->scratch_addr > size || size - cfg->scratch_addr < FRAM_HAL_SPI_CALIB_LEN) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (cfg->persist) {
+        if (cfg->record_addr > size || size - cfg->record_addr < FRAM_HAL_SPI_CALIB_RECORD_LEN) {
+            return ESP_ERR_INVALID_SIZE;
         }
+        if (cfg->record_addr < cfg->scratch_addr + FRAM_HAL_SPI_CALIB_LEN &&
+            cfg->scratch_addr < cfg->record_addr + FRAM_HAL_SPI_CALIB_RECORD_LEN) {
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
 
-        uint8_t tx[3 + FRAM_SPI_BUF_MAX];
-        tx[0] = FM25V02A_CMD_WRITE;
-        tx[1] = (uint8_t)((offset >> 8) & 0xFF);
-        tx[2] = (uint8_t)(offset & 0xFF);
-        memcpy(&tx[3], in, chunk);
+    fram_hal_spi_calib_t cal = {0};
+    cal.hal = hal;
+    cal.addr = cfg->scratch_addr;
+    cal.passes = cfg->passes ? cfg->passes : FRAM_SPI_CALIB_PASSES;
+    cal.base_freq_hz = ctx->freq_hz;
+    cal.base_delay_ns = ctx->input_delay_ns;
+    ESP_RETURN_ON_ERROR(fram_hal_spi_read_id(ctx, cal.id, sizeof(cal.id)), TAG, "RDID failed");
+    ESP_RETURN_ON_ERROR(fram_hal_spi_read(hal, cal.addr, cal.orig, sizeof(cal.orig)), TAG, "scratch read failed");
+    memcpy(cal.expect, cal.orig, sizeof(cal.expect));
 
-        spi_transaction_t t = {
-            .length = (3 + chunk) * 8,
-            .tx_buffer = tx,
-        };
+    uint32_t max_hz = hal->chip->max_freq_hz;
+    uint32_t margin = cfg->margin_steps ? cfg->margin_steps : FRAM_SPI_CALIB_MARGIN;
+    fram_hal_spi_calib_result_t res = {
+        .freq_hz = cal.base_freq_hz,
+        .input_delay_ns = cal.base_delay_ns,
+    };
+    bool found = false;
+    esp_err_t err = ESP_OK;
 
-        err = spi_device_transmit(ctx->dev, &t);
-        if (err != ESP_OK) {
-            return err;
+    if (cfg->persist) {
+        fram_hal_spi_calib_record_t rec;
+        err = fram_hal_spi_read(hal, cfg->record_addr, &rec, sizeof(rec));
+        if (err == ESP_OK && fram_hal_spi_calib_record_valid(&rec, max_hz)) {
+            // A stored setting must still pass before it is trusted
+            err = fram_hal_spi_calib_try(&cal, rec.freq_hz, rec.input_delay_ns, &res, &found);
+            if (found) {
+                res.freq_hz = rec.freq_hz;
+                res.input_delay_ns = rec.input_delay_ns;
+                res.from_record = true;
+            } else if (err == ESP_OK) {
+                ESP_LOGW(TAG, "stored clock %u Hz / %u ns no longer passes, recalibrating",
+                         (unsigned)rec.freq_hz, (unsigned)rec.input_delay_ns);
+            }
         }
+    }
 
-        in += chunk;
-        offset += chunk;
-        remaining -= chunk;
+    uint32_t src_hz = cfg->src_hz ? cfg->src_hz : fram_hal_spi_src_hz();
+    size_t count = cfg->freqs_hz ? cfg->freq_count : FRAM_SPI_CALIB_DIVIDERS;
+    for (size_t i = 0; err == ESP_OK && !found && i < count; i++) {
+        uint32_t freq_hz = cfg->freqs_hz ? cfg->freqs_hz[i] : src_hz / (uint32_t)(i + 1);
+        if (freq_hz <= cal.base_freq_hz) {
+            break; // never slower than configured
+        }
+        if (freq_hz > max_hz) {
+            continue;
+        }
+        uint32_t delay_ns = 0;
+        err = fram_hal_spi_calib_sweep(&cal, freq_hz, cfg, margin, &res, &found, &delay_ns);
+        if (found) {
+            res.freq_hz = freq_hz;
+            res.input_delay_ns = delay_ns;
+        }
     }
 
+    esp_err_t restore = fram_hal_spi_calib_restore(&cal);
+    if (err == ESP_OK) {
+        err = restore;
+    }
+    if (err == ESP_OK && cfg->persist && !res.from_record) {
+        fram_hal_spi_calib_record_t rec;
+        fram_hal_spi_calib_record_make(&rec, res.freq_hz, res.input_delay_ns);
+        err = fram_hal_spi_write(hal, cfg->record_addr, &rec, sizeof(rec));
+    }
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    ESP_RETURN_ON_ERROR(fram_hal_spi_set_clock(hal, res.freq_hz, res.input_delay_ns), TAG, "apply clock failed");
+    int khz = 0;
+    spi_device_get_actual_freq(ctx->dev, &khz);
+    ESP_LOGI(TAG, "%s: %u Hz (actual %d kHz), input delay %u ns%s; %u/%u settings passed",
+             hal->chip->name, (unsigned)res.freq_hz, khz, (unsigned)res.input_delay_ns,
+             res.from_record ? " (stored)" : "", (unsigned)res.passed, (unsigned)res.tested);
+
+    ctx->calib = res;
+    if (result) {
+        *result = res;
+    }
     return ESP_OK;
 }
 
@@ -236,6 +1005,10 @@ esp_err_t fram_hal_spi_create(fram_hal_t *hal,
     if (max_transfer == 0) {
         max_transfer = 1;
     }
+    uint32_t queue_depth = cfg->queue_size ? cfg->queue_size : CONFIG_FRAM_SPI_QUEUE_SIZE;
+    if (queue_depth > CONFIG_FRAM_SPI_QUEUE_SIZE) {
+        return ESP_ERR_INVALID_ARG;
+    }
 
     if (cfg->init_bus) {
         spi_bus_config_t buscfg = {
@@ -244,7 +1017,7 @@ esp_err_t fram_hal_spi_create(fram_hal_t *hal,
             .sclk_io_num = cfg->sclk_pin,
             .quadwp_io_num = -1,
             .quadhd_io_num = -1,
-            .max_transfer_sz = (int)(max_transfer + 3),
+            .max_transfer_sz = (int)((max_transfer + 3U) & ~3U),
         };
 
         esp_err_t err = spi_bus_initialize(cfg->host, &buscfg, SPI_DMA_CH_AUTO);
@@ -256,33 +1029,53 @@ esp_err_t fram_hal_spi_create(fram_hal_t *hal,
         ESP_RETURN_ON_ERROR(err, TAG, "spi_bus_initialize failed");
     }
 
-    spi_device_interface_config_t devcfg = {
-        .clock_speed_hz = (int)freq_hz,
-        .mode = cfg->spi_mode,
-        .spics_io_num = cfg->cs_pin,
-        .queue_size = 1,
-        .flags = 0,
-    };
+    ctx->host = cfg->host;
+    ctx->cs_pin = cfg->cs_pin;
+    ctx->spi_mode = cfg->spi_mode;
+    ctx->deinit_bus = cfg->deinit_bus;
+    ctx->queue_depth = queue_depth;
+    ctx->freq_hz = freq_hz;
 
-    esp_err_t err = spi_bus_add_device(cfg->host, &devcfg, &ctx->dev);
+    esp_err_t err = fram_hal_spi_add_device(ctx, freq_hz, 0);
     ESP_RETURN_ON_ERROR(err, TAG, "spi_bus_add_device failed");
 
     if (cfg->powerup_delay_ms > 0) {
         vTaskDelay(pdMS_TO_TICKS(cfg->powerup_delay_ms));
     }
 
-    ctx->host = cfg->host;
-    ctx->deinit_bus = cfg->deinit_bus;
+    ctx->addr_bits = FRAM_SPI_DEFAULT_ADDR_BITS;
+    ctx->polling_threshold = cfg->polling_threshold ? cfg->polling_threshold : CONFIG_FRAM_SPI_POLLING_THRESHOLD;
 
     hal->init = fram_hal_spi_noop_init;
     hal->deinit = fram_hal_spi_deinit;
     hal->read = fram_hal_spi_read;
     hal->write = fram_hal_spi_write;
     hal->probe = fram_hal_spi_probe;
+    hal->read_async = fram_hal_spi_read_async;
+    hal->write_async = fram_hal_spi_write_async;
+    hal->wait = fram_hal_spi_wait;
+    hal->readv = fram_hal_spi_readv;
+    hal->writev = fram_hal_spi_writev;
+    hal->fill = fram_hal_spi_fill;
+#if CONFIG_FRAM_SPI_ACQUIRE_BUS
+    hal->acquire = fram_hal_spi_acquire;
+    hal->release = fram_hal_spi_release;
+#endif
     hal->size_bytes = cfg->size_bytes;
     hal->max_transfer = max_transfer;
+    hal->caps = FRAM_SPI_SINGLE_CS ? FRAM_HAL_CAP_CONTINUOUS : 0;
+    hal->buses = FRAM_HAL_BUS_SPI(cfg->host);
     hal->ctx = ctx;
 
+    if (cfg->calibrate) {
+        // Not fatal: the configured clock is still in place
+        err = fram_hal_spi_calibrate(hal, cfg->calibrate, NULL);
+        if (err != ESP_OK) {
+            ESP_LOGW(TAG, "calibration failed (%s), keeping %u Hz", esp_err_to_name(err),
+                     (unsigned)ctx->freq_hz);
+        }
+    }
+
     return ESP_OK;
 }
 
@@ -0,0 +1,38 @@
+#include "fram/fram_hal.h"
+#include "fram_crc.h"
+#include <stddef.h>
+
+#define FRAM_SPI_CALIB_MAGIC 0x4C414346U // "FCAL"
+
+_Static_assert(sizeof(fram_hal_spi_calib_record_t) == FRAM_HAL_SPI_CALIB_RECORD_LEN,
+               "calibration record size");
+
+void fram_hal_spi_calib_window_add(fram_hal_spi_calib_window_t *win, uint32_t delay_ns, bool pass) {
+    win->run = pass ? win->run + 1 : 0;
+    if (win->run > win->best_run) {
+        win->best_run = win->run;
+        win->best_end = delay_ns;
+    }
+}
+
+bool fram_hal_spi_calib_window_pick(const fram_hal_spi_calib_window_t *win, uint32_t step_ns,
+                                    uint32_t margin_steps, uint32_t *delay_ns) {
+    if (win->best_run < 1U + 2U * margin_steps) {
+        return false;
+    }
+    *delay_ns = win->best_end - ((win->best_run - 1U) / 2U) * step_ns;
+    return true;
+}
+
+void fram_hal_spi_calib_record_make(fram_hal_spi_calib_record_t *rec, uint32_t freq_hz, uint32_t input_delay_ns) {
+    rec->magic = FRAM_SPI_CALIB_MAGIC;
+    rec->freq_hz = freq_hz;
+    rec->input_delay_ns = input_delay_ns;
+    rec->crc32 = fram_crc32_le(0, rec, offsetof(fram_hal_spi_calib_record_t, crc32));
+}
+
+bool fram_hal_spi_calib_record_valid(const fram_hal_spi_calib_record_t *rec, uint32_t max_hz) {
+    return rec->magic == FRAM_SPI_CALIB_MAGIC &&
+           rec->crc32 == fram_crc32_le(0, rec, offsetof(fram_hal_spi_calib_record_t, crc32)) &&
+           rec->freq_hz != 0 && rec->freq_hz <= max_hz;
+}
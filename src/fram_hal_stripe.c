@@ -0,0 +1,244 @@
+#include "fram/fram_hal.h"
+
+#if CONFIG_FRAM_HAL_STRIPE_ENABLED
+
+#include "esp_check.h"
+#include "esp_log.h"
+#include "fram_hal_group.h"
+#include "sdkconfig.h"
+#include <string.h>
+
+#define TAG "fram_hal_stripe"
+
+// One contiguous piece of a request on a single child.
+typedef struct {
+    size_t child;
+    uint32_t child_addr;
+    size_t len;
+} fram_stripe_piece_t;
+
+// Map composite [addr, addr + len) to the first piece on one child.
+static void fram_hal_stripe_map(const fram_hal_stripe_ctx_t *ctx, uint32_t addr, size_t len,
+                                fram_stripe_piece_t *piece) {
+    if (ctx->mode == FRAM_HAL_STRIPE_MODE_CONCAT) {
+        size_t child = 0;
+        while (addr >= ctx->children[child]->size_bytes) {
+            addr -= ctx->children[child]->size_bytes;
+            child++;
+        }
+        uint32_t room = ctx->children[child]->size_bytes - addr;
+        piece->child = child;
+        piece->child_addr = addr;
+        piece->len = len > room ? room : len;
+        return;
+    }
+
+    uint32_t stripe = addr / ctx->stripe_size;
+    uint32_t in_stripe = addr % ctx->stripe_size;
+    uint32_t room = ctx->stripe_size - in_stripe;
+    piece->child = stripe % ctx->child_count;
+    piece->child_addr = (stripe / ctx->child_count) * ctx->stripe_size + in_stripe;
+    piece->len = len > room ? room : len;
+}
+
+// Per-call transfer limit of a child, as fram_dev would chunk it.
+static size_t fram_hal_stripe_child_chunk(const fram_hal_t *child) {
+    if ((child->caps & FRAM_HAL_CAP_CONTINUOUS) || child->max_transfer == 0) {
+        return child->size_bytes;
+    }
+    return child->max_transfer;
+}
+
+static void fram_hal_stripe_done(fram_hal_t *child, esp_err_t err, void *arg) {
+    (void)child;
+    fram_hal_stripe_ctx_t *ctx = (fram_hal_stripe_ctx_t *)arg;
+    if (err != ESP_OK && ctx->async_err == ESP_OK) {
+        ctx->async_err = err;
+    }
+}
+
+// Issue one transfer on every piece of the range. Children with async ops get
+// all their pieces queued first and are waited on afterwards, so children on
+// different buses transfer concurrently; the rest run synchronously.
+static esp_err_t fram_hal_stripe_xfer(fram_hal_t *hal, uint32_t addr, uint8_t *rx, const uint8_t *tx,
+                                      size_t len) {
+    if (hal == NULL || hal->ctx == NULL || (rx == NULL && tx == NULL)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (len == 0) {
+        return ESP_OK;
+    }
+    if (addr > hal->size_bytes || len > hal->size_bytes || addr > hal->size_bytes - len) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    fram_hal_stripe_ctx_t *ctx = (fram_hal_stripe_ctx_t *)hal->ctx;
+    uint32_t queued = 0; // bitmask of children with pending async pieces
+    esp_err_t err = ESP_OK;
+    size_t off = 0;
+
+    ctx->async_err = ESP_OK;
+    while (off < len && err == ESP_OK) {
+        fram_stripe_piece_t piece;
+        fram_hal_stripe_map(ctx, addr + (uint32_t)off, len - off, &piece);
+        fram_hal_t *child = ctx->children[piece.child];
+        size_t chunk_max = fram_hal_stripe_child_chunk(child);
+
+        for (size_t done = 0; done < piece.len && err == ESP_OK;) {
+            size_t chunk = piece.len - done > chunk_max ? chunk_max : piece.len - done;
+            uint32_t child_addr = piece.child_addr + (uint32_t)done;
+            if (rx && child->read_async) {
+                err = child->read_async(child, child_addr, rx + off + done, chunk, fram_hal_stripe_done, ctx);
+                queued |= 1U << piece.child;
+            } else if (tx && child->write_async) {
+                err = child->write_async(child, child_addr, tx + off + done, chunk, fram_hal_stripe_done, ctx);
+                queued |= 1U << piece.child;
+            } else if (rx) {
+                err = child->read(child, child_addr, rx + off + done, chunk);
+            } else {
+                err = child->write(child, child_addr, tx + off + done, chunk);
+            }
+            done += chunk;
+        }
+        off += piece.len;
+    }
+
+    for (size_t i = 0; i < ctx->child_count; i++) {
+        if (queued & (1U << i)) {
+            esp_err_t wait_err = ctx->children[i]->wait(ctx->children[i], FRAM_HAL_WAIT_FOREVER);
+            if (err == ESP_OK) {
+                err = wait_err;
+            }
+        }
+    }
+    return err != ESP_OK ? err : ctx->async_err;
+}
+
+static esp_err_t fram_hal_stripe_read(fram_hal_t *hal, uint32_t addr, void *buf, size_t len) {
+    return fram_hal_stripe_xfer(hal, addr, (uint8_t *)buf, NULL, len);
+}
+
+static esp_err_t fram_hal_stripe_write(fram_hal_t *hal, uint32_t addr, const void *buf, size_t len) {
+    return fram_hal_stripe_xfer(hal, addr, NULL, (const uint8_t *)buf, len);
+}
+
+static esp_err_t fram_hal_stripe_init(fram_hal_t *hal) {
+    if (hal == NULL || hal->ctx == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    fram_hal_stripe_ctx_t *ctx = (fram_hal_stripe_ctx_t *)hal->ctx;
+    for (size_t i = 0; i < ctx->child_count; i++) {
+        fram_hal_t *child = ctx->children[i];
+        if (child->init) {
+            ESP_RETURN_ON_ERROR(child->init(child), TAG, "child %u init failed", (unsigned)i);
+        }
+    }
+    return ESP_OK;
+}
+
+static esp_err_t fram_hal_stripe_deinit(fram_hal_t *hal) {
+    if (hal == NULL || hal->ctx == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    fram_hal_stripe_ctx_t *ctx = (fram_hal_stripe_ctx_t *)hal->ctx;
+    for (size_t i = 0; i < ctx->child_count; i++) {
+        fram_hal_t *child = ctx->children[i];
+        if (child->deinit) {
+            child->deinit(child);
+        }
+    }
+    return ESP_OK;
+}
+
+// Probe every child, then size the composite from what they report.
+static esp_err_t fram_hal_stripe_probe(fram_hal_t *hal) {
+    if (hal == NULL || hal->ctx == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    fram_hal_stripe_ctx_t *ctx = (fram_hal_stripe_ctx_t *)hal->ctx;
+    uint64_t total = 0;
+    uint32_t smallest = UINT32_MAX;
+    for (size_t i = 0; i < ctx->child_count; i++) {
+        fram_hal_t *child = ctx->children[i];
+        if (child->probe) {
+            ESP_RETURN_ON_ERROR(child->probe(child), TAG, "child %u probe failed", (unsigned)i);
+        }
+        if (child->size_bytes == 0) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+        total += child->size_bytes;
+        if (child->size_bytes < smallest) {
+            smallest = child->size_bytes;
+        }
+    }
+
+    if (ctx->mode == FRAM_HAL_STRIPE_MODE_STRIPE) {
+        // Whole stripes only, and the same amount of each child
+        ctx->child_size = smallest - (smallest % ctx->stripe_size);
+        total = (uint64_t)ctx->child_size * ctx->child_count;
+    }
+    if (total == 0 || total > UINT32_MAX) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    hal->size_bytes = (uint32_t)total;
+    hal->max_transfer = hal->size_bytes;
+    return ESP_OK;
+}
+
+// Hold the children's buses for the duration of one fram_dev call (shared
+// buses excepted, see fram_hal_group_acquire()).
+static esp_err_t fram_hal_stripe_acquire(fram_hal_t *hal) {
+    fram_hal_stripe_ctx_t *ctx = (fram_hal_stripe_ctx_t *)hal->ctx;
+    return fram_hal_group_acquire(ctx->children, ctx->child_count, &ctx->acquired);
+}
+
+static void fram_hal_stripe_release(fram_hal_t *hal) {
+    fram_hal_stripe_ctx_t *ctx = (fram_hal_stripe_ctx_t *)hal->ctx;
+    fram_hal_group_release(ctx->children, ctx->child_count, &ctx->acquired);
+}
+
+esp_err_t fram_hal_stripe_create(fram_hal_t *hal,
+                                 fram_hal_stripe_ctx_t *ctx,
+                                 const fram_hal_stripe_config_t *cfg) {
+    if (hal == NULL || ctx == NULL || cfg == NULL || cfg->children == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (cfg->child_count == 0 || cfg->child_count > CONFIG_FRAM_HAL_STRIPE_MAX_CHILDREN) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (cfg->mode != FRAM_HAL_STRIPE_MODE_STRIPE && cfg->mode != FRAM_HAL_STRIPE_MODE_CONCAT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(hal, 0, sizeof(*hal));
+    memset(ctx, 0, sizeof(*ctx));
+
+    for (size_t i = 0; i < cfg->child_count; i++) {
+        if (cfg->children[i] == NULL || cfg->children[i] == hal) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        ctx->children[i] = cfg->children[i];
+    }
+    ctx->child_count = cfg->child_count;
+    ctx->mode = cfg->mode;
+    ctx->stripe_size = cfg->stripe_size ? cfg->stripe_size : CONFIG_FRAM_HAL_STRIPE_DEFAULT_SIZE;
+
+    hal->init = fram_hal_stripe_init;
+    hal->deinit = fram_hal_stripe_deinit;
+    hal->read = fram_hal_stripe_read;
+    hal->write = fram_hal_stripe_write;
+    hal->probe = fram_hal_stripe_probe;
+    hal->acquire = fram_hal_stripe_acquire;
+    hal->release = fram_hal_stripe_release;
+    hal->caps = FRAM_HAL_CAP_CONTINUOUS; // splits per child itself
+    hal->buses = fram_hal_group_buses(ctx->children, ctx->child_count);
+    hal->ctx = ctx;
+
+    return ESP_OK;
+}
+
+#endif // CONFIG_FRAM_HAL_STRIPE_ENABLED
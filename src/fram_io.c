@@ -0,0 +1,367 @@
+#include "fram/fram_io.h"
+
+#if CONFIG_FRAM_IO_ENABLED
+
+#include "esp_check.h"
+#include <string.h>
+
+#define TAG "fram_io"
+
+// Room for the wake-ups of a full table plus those left over by merged
+// requests, which finish without consuming their own.
+#define FRAM_IO_PENDING_MAX (2 * FRAM_IO_QUEUE_DEPTH + 1)
+
+static void fram_io_range(const fram_io_req_t *req, uint32_t *start, uint32_t *end) {
+    if (req->op != FRAM_IO_OP_WRITE) {
+        *start = req->offset;
+        *end = req->offset + (uint32_t)req->len;
+        return;
+    }
+    *start = UINT32_MAX;
+    *end = 0;
+    for (size_t i = 0; i < req->count; i++) {
+        uint32_t seg_end = req->vec[i].offset + (uint32_t)req->vec[i].len;
+        if (req->vec[i].offset < *start) {
+            *start = req->vec[i].offset;
+        }
+        if (seg_end > *end) {
+            *end = seg_end;
+        }
+    }
+}
+
+// An earlier request that overlaps this one, with a write on either side,
+// has to run first.
+static bool fram_io_blocked(const fram_io_t *io, const fram_io_slot_t *slot) {
+    uint32_t start, end;
+    fram_io_range(&slot->req, &start, &end);
+    for (size_t i = 0; i < FRAM_IO_QUEUE_DEPTH; i++) {
+        const fram_io_slot_t *other = &io->slots[i];
+        if (other == slot || (other->state != FRAM_IO_SLOT_QUEUED && other->state != FRAM_IO_SLOT_RUNNING)) {
+            continue;
+        }
+        if ((int32_t)(other->seq - slot->seq) >= 0) {
+            continue;
+        }
+        if (other->req.op == FRAM_IO_OP_READ && slot->req.op == FRAM_IO_OP_READ) {
+            continue;
+        }
+        uint32_t other_start, other_end;
+        fram_io_range(&other->req, &other_start, &other_end);
+        if (other_start < end && start < other_end) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static int64_t fram_io_deadline(const fram_io_slot_t *slot) {
+    return slot->req.opts.deadline_us ? slot->req.opts.deadline_us : INT64_MAX;
+}
+
+static bool fram_io_before(const fram_io_slot_t *a, const fram_io_slot_t *b) {
+    if (a->req.opts.priority != b->req.opts.priority) {
+        return a->req.opts.priority > b->req.opts.priority;
+    }
+    if (fram_io_deadline(a) != fram_io_deadline(b)) {
+        return fram_io_deadline(a) < fram_io_deadline(b);
+    }
+    return (int32_t)(a->seq - b->seq) < 0;
+}
+
+// Caller holds io->lock. Takes the next request and, for a write, queued
+// writes that continue it back to back, up to FRAM_VEC_MAX segments in all.
+// Returns the number of slots put in `run`; 0 only if nothing is queued, as
+// the oldest request is never blocked.
+static size_t fram_io_pick(fram_io_t *io, fram_io_slot_t **run) {
+    fram_io_slot_t *best = NULL;
+    for (size_t i = 0; i < FRAM_IO_QUEUE_DEPTH; i++) {
+        fram_io_slot_t *slot = &io->slots[i];
+        if (slot->state == FRAM_IO_SLOT_QUEUED && !fram_io_blocked(io, slot) &&
+            (best == NULL || fram_io_before(slot, best))) {
+            best = slot;
+        }
+    }
+    if (best == NULL) {
+        return 0;
+    }
+    best->state = FRAM_IO_SLOT_RUNNING;
+    run[0] = best;
+    size_t n = 1;
+    if (best->req.op != FRAM_IO_OP_WRITE || !io->merge) {
+        return n;
+    }
+
+    size_t segs = best->req.count;
+    const fram_wvec_t *last = &best->req.vec[best->req.count - 1];
+    uint32_t end = last->offset + (uint32_t)last->len;
+    bool grew = true;
+    while (grew && n < FRAM_VEC_MAX) {
+        grew = false;
+        for (size_t i = 0; i < FRAM_IO_QUEUE_DEPTH; i++) {
+            fram_io_slot_t *slot = &io->slots[i];
+            if (slot->state != FRAM_IO_SLOT_QUEUED || slot->req.op != FRAM_IO_OP_WRITE ||
+                slot->req.vec[0].offset != end || segs + slot->req.count > FRAM_VEC_MAX ||
+                fram_io_blocked(io, slot)) {
+                continue;
+            }
+            slot->state = FRAM_IO_SLOT_RUNNING;
+            run[n++] = slot;
+            segs += slot->req.count;
+            last = &slot->req.vec[slot->req.count - 1];
+            end = last->offset + (uint32_t)last->len;
+            io->merged++;
+            grew = true;
+            break;
+        }
+    }
+    return n;
+}
+
+static esp_err_t fram_io_exec(fram_io_t *io, fram_io_req_t *const *run, size_t n) {
+    const fram_io_req_t *req = run[0];
+    switch (req->op) {
+    case FRAM_IO_OP_READ:
+        return fram_dev_read(io->dev, req->offset, req->rbuf, req->len);
+    case FRAM_IO_OP_FILL:
+        return fram_dev_fill(io->dev, req->offset, req->value, req->len);
+    case FRAM_IO_OP_WRITE:
+        break;
+    }
+    if (n == 1) {
+        return fram_dev_writev(io->dev, req->vec, req->count);
+    }
+    fram_wvec_t vec[FRAM_VEC_MAX];
+    size_t count = 0;
+    for (size_t i = 0; i < n; i++) {
+        for (size_t k = 0; k < run[i]->count; k++) {
+            vec[count++] = run[i]->vec[k];
+        }
+    }
+    return fram_dev_writev(io->dev, vec, count);
+}
+
+static void fram_io_notify(const fram_io_opts_t *opts, esp_err_t err) {
+    if (opts->done) {
+        opts->done(err, opts->arg);
+    } else if (opts->notify) {
+        if (opts->result) {
+            *opts->result = err;
+        }
+        xTaskNotifyGive(opts->notify);
+    }
+}
+
+// Blocking submitters collect and free their slot themselves.
+static void fram_io_complete(fram_io_t *io, fram_io_slot_t *slot, esp_err_t err) {
+    fram_io_opts_t opts = slot->req.opts;
+    xSemaphoreTake(io->lock, portMAX_DELAY);
+    io->completed++;
+    slot->err = err;
+    if (slot->wait) {
+        slot->state = FRAM_IO_SLOT_DONE;
+        xSemaphoreGive(io->lock);
+        xSemaphoreGive(slot->done_sem);
+        return;
+    }
+    slot->state = FRAM_IO_SLOT_FREE;
+    xSemaphoreGive(io->lock);
+    xSemaphoreGive(io->free);
+    fram_io_notify(&opts, err);
+}
+
+// Timer service task: only wake the worker
+static void fram_io_flush_notify(void *arg) {
+    fram_io_t *io = (fram_io_t *)arg;
+    io->flush = true;
+    xSemaphoreGive(io->pending);
+}
+
+static void fram_io_task(void *arg) {
+    fram_io_t *io = (fram_io_t *)arg;
+    for (;;) {
+        xSemaphoreTake(io->pending, portMAX_DELAY);
+
+        fram_io_slot_t *run[FRAM_VEC_MAX];
+        xSemaphoreTake(io->lock, portMAX_DELAY);
+        size_t n = fram_io_pick(io, run);
+        xSemaphoreGive(io->lock);
+        if (io->flush) {
+            io->flush = false;
+            if (fram_dev_barrier(io->dev) != ESP_OK) {
+                ESP_LOGW(TAG, "timed flush of staged writes failed");
+            }
+        }
+        if (n == 0) {
+            if (io->stop) {
+                break;
+            }
+            continue;
+        }
+
+        fram_io_req_t *reqs[FRAM_VEC_MAX];
+        for (size_t i = 0; i < n; i++) {
+            reqs[i] = &run[i]->req;
+        }
+        esp_err_t err = fram_io_exec(io, reqs, n);
+        for (size_t i = 0; i < n; i++) {
+            // A merged writev fails as a whole (e.g. one request out of
+            // range): rerun each request alone so it gets its own result.
+            // Repeating a write that did land is harmless.
+            esp_err_t own = err;
+            if (err != ESP_OK && n > 1) {
+                own = fram_io_exec(io, &reqs[i], 1);
+            }
+            fram_io_complete(io, run[i], own);
+        }
+    }
+    xSemaphoreGive(io->stopped);
+    vTaskDelete(NULL);
+}
+
+static esp_err_t fram_io_submit(fram_io_t *io, fram_io_req_t *req, const fram_io_opts_t *opts) {
+    if (opts) {
+        req->opts = *opts;
+    }
+    bool wait = req->opts.done == NULL && req->opts.notify == NULL;
+
+    // Queueing would deadlock: the worker cannot get the device (or itself)
+    if (xTaskGetCurrentTaskHandle() == io->task || fram_dev_in_scope(io->dev)) {
+        fram_io_req_t *run[1] = { req };
+        esp_err_t err = fram_io_exec(io, run, 1);
+        if (wait) {
+            return err;
+        }
+        fram_io_notify(&req->opts, err);
+        return ESP_OK;
+    }
+
+    if (xSemaphoreTake(io->free, pdMS_TO_TICKS(io->submit_timeout_ms)) != pdTRUE) {
+        return ESP_ERR_TIMEOUT;
+    }
+    xSemaphoreTake(io->lock, portMAX_DELAY);
+    fram_io_slot_t *slot = NULL;
+    for (size_t i = 0; i < FRAM_IO_QUEUE_DEPTH && slot == NULL; i++) {
+        if (io->slots[i].state == FRAM_IO_SLOT_FREE) {
+            slot = &io->slots[i];
+        }
+    }
+    slot->req = *req;
+    slot->seq = io->next_seq++;
+    slot->wait = wait;
+    slot->state = FRAM_IO_SLOT_QUEUED;
+    xSemaphoreGive(io->lock);
+    xSemaphoreGive(io->pending);
+    if (!wait) {
+        return ESP_OK;
+    }
+
+    xSemaphoreTake(slot->done_sem, portMAX_DELAY);
+    xSemaphoreTake(io->lock, portMAX_DELAY);
+    esp_err_t err = slot->err;
+    slot->state = FRAM_IO_SLOT_FREE;
+    xSemaphoreGive(io->lock);
+    xSemaphoreGive(io->free);
+    return err;
+}
+
+esp_err_t fram_io_init(fram_io_t *io, const fram_io_config_t *cfg) {
+    if (io == NULL || cfg == NULL || cfg->dev == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(io, 0, sizeof(*io));
+    io->dev = cfg->dev;
+    io->merge = !cfg->no_merge;
+    io->submit_timeout_ms = cfg->submit_timeout_ms ? cfg->submit_timeout_ms : cfg->dev->mutex_timeout_ms;
+
+    io->lock = xSemaphoreCreateMutexStatic(&io->lock_buf);
+    io->free = xSemaphoreCreateCountingStatic(FRAM_IO_QUEUE_DEPTH, FRAM_IO_QUEUE_DEPTH, &io->free_buf);
+    io->pending = xSemaphoreCreateCountingStatic(FRAM_IO_PENDING_MAX, 0, &io->pending_buf);
+    io->stopped = xSemaphoreCreateBinaryStatic(&io->stopped_buf);
+    if (io->lock == NULL || io->free == NULL || io->pending == NULL || io->stopped == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    for (size_t i = 0; i < FRAM_IO_QUEUE_DEPTH; i++) {
+        io->slots[i].done_sem = xSemaphoreCreateBinaryStatic(&io->slots[i].done_buf);
+        if (io->slots[i].done_sem == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    esp_err_t err = fram_dev_set_flush_notify(io->dev, fram_io_flush_notify, io);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    uint32_t priority = cfg->task_priority ? cfg->task_priority : CONFIG_FRAM_IO_TASK_PRIORITY;
+    BaseType_t core = CONFIG_FRAM_IO_TASK_CORE < 0 ? tskNO_AFFINITY : CONFIG_FRAM_IO_TASK_CORE;
+    io->task = xTaskCreateStaticPinnedToCore(fram_io_task, "fram_io", sizeof(io->stack), io, priority,
+                                             io->stack, &io->task_buf, core);
+    if (io->task == NULL) {
+        ESP_LOGE(TAG, "worker task create failed");
+        fram_dev_set_flush_notify(io->dev, NULL, NULL);
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+esp_err_t fram_io_deinit(fram_io_t *io) {
+    if (io == NULL || io->task == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    fram_dev_set_flush_notify(io->dev, NULL, NULL);
+    io->stop = true;
+    xSemaphoreGive(io->pending);
+    xSemaphoreTake(io->stopped, portMAX_DELAY);
+    io->task = NULL;
+    return ESP_OK;
+}
+
+esp_err_t fram_io_read(fram_io_t *io, uint32_t offset, void *buf, size_t len, const fram_io_opts_t *opts) {
+    if (io == NULL || io->task == NULL || buf == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    fram_io_req_t req = {
+        .op = FRAM_IO_OP_READ,
+        .offset = offset,
+        .len = len,
+        .rbuf = buf,
+    };
+    return fram_io_submit(io, &req, opts);
+}
+
+esp_err_t fram_io_write(fram_io_t *io, uint32_t offset, const void *buf, size_t len, const fram_io_opts_t *opts) {
+    const fram_wvec_t seg = { .offset = offset, .buf = buf, .len = len };
+    return fram_io_writev(io, &seg, 1, opts);
+}
+
+esp_err_t fram_io_writev(fram_io_t *io, const fram_wvec_t *vec, size_t count, const fram_io_opts_t *opts) {
+    if (io == NULL || io->task == NULL || vec == NULL || count == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (count > FRAM_VEC_MAX) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    fram_io_req_t req = {
+        .op = FRAM_IO_OP_WRITE,
+        .count = count,
+    };
+    memcpy(req.vec, vec, count * sizeof(vec[0]));
+    return fram_io_submit(io, &req, opts);
+}
+
+esp_err_t fram_io_fill(fram_io_t *io, uint32_t offset, uint8_t value, size_t len, const fram_io_opts_t *opts) {
+    if (io == NULL || io->task == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    fram_io_req_t req = {
+        .op = FRAM_IO_OP_FILL,
+        .offset = offset,
+        .len = len,
+        .value = value,
+    };
+    return fram_io_submit(io, &req, opts);
+}
+
+#endif // CONFIG_FRAM_IO_ENABLED
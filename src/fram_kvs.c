@@ -40,9 +40,9 @@ static void fram_kvs_unlock(fram_kvs_t *kvs) {
     }
 }
 
-static esp_err_t fram_kvs_read_header(fram_kvs_t *kvs, uint32_t offset, fram_kvs_header_t *hdr) {
+static esp_err_t fram_kvs_read_header(fram_kvs_t *kvs, uint32_t offset, uint32_t copy, fram_kvs_header_t *hdr) {
     uint8_t buf[sizeof(fram_kvs_header_t)];
-    esp_err_t err = fram_pm_read(kvs->pm, kvs->part, offset, buf, sizeof(buf));
+    esp_err_t err = fram_pm_read_copy(kvs->pm, kvs->part, copy, offset, buf, sizeof(buf));
     if (err != ESP_OK) {
         return err;
     }
@@ -50,14 +50,27 @@ static esp_err_t fram_kvs_read_header(fram_kvs_t *kvs, uint32_t offset, fram_kvs
     return ESP_OK;
 }
 
-static esp_err_t fram_kvs_read_commit(fram_kvs_t *kvs, uint32_t offset, uint16_t key_len, uint16_t value_len, uint8_t *commit) {
+static esp_err_t fram_kvs_read_commit(fram_kvs_t *kvs, uint32_t offset, uint32_t copy, uint16_t key_len, uint16_t value_len, uint8_t *commit) {
     uint32_t commit_offset = offset + sizeof(fram_kvs_header_t) + key_len + value_len;
-    return fram_pm_read(kvs->pm, kvs->part, commit_offset, commit, sizeof(*commit));
+    return fram_pm_read_copy(kvs->pm, kvs->part, copy, commit_offset, commit, sizeof(*commit));
 }
 
-static esp_err_t fram_kvs_write_commit(fram_kvs_t *kvs, uint32_t offset, uint16_t key_len, uint16_t value_len, uint8_t commit) {
-    uint32_t commit_offset = offset + sizeof(fram_kvs_header_t) + key_len + value_len;
-    return fram_pm_write(kvs->pm, kvs->part, commit_offset, &commit, sizeof(commit));
+// Append one record at write_offset: commit cleared first, then header, key,
+// value and commit set in one contiguous transaction (commit byte last).
+static esp_err_t fram_kvs_write_record(fram_kvs_t *kvs, const fram_kvs_header_t *hdr,
+                                       const void *key, const void *value) {
+    uint32_t offset = kvs->write_offset;
+    uint32_t commit_offset = offset + sizeof(*hdr) + hdr->key_len + hdr->value_len;
+    const uint8_t commit_clear = 0x00;
+    const uint8_t commit_set = FRAM_KVS_COMMIT;
+    const fram_wvec_t vec[] = {
+        { .offset = commit_offset, .buf = &commit_clear, .len = sizeof(commit_clear) },
+        { .offset = offset, .buf = hdr, .len = sizeof(*hdr) },
+        { .offset = offset + sizeof(*hdr), .buf = key, .len = hdr->key_len },
+        { .offset = offset + sizeof(*hdr) + hdr->key_len, .buf = value, .len = hdr->value_len },
+        { .offset = commit_offset, .buf = &commit_set, .len = sizeof(commit_set) },
+    };
+    return fram_pm_writev(kvs->pm, kvs->part, vec, sizeof(vec) / sizeof(vec[0]));
 }
 
 static bool fram_kvs_header_valid(const fram_kvs_t *kvs, const fram_kvs_header_t *hdr) {
@@ -73,15 +86,15 @@ static bool fram_kvs_header_valid(const fram_kvs_t *kvs, const fram_kvs_header_t
     return true;
 }
 
-static esp_err_t fram_kvs_compute_crc(fram_kvs_t *kvs, uint32_t offset,
+static esp_err_t fram_kvs_compute_crc(fram_kvs_t *kvs, uint32_t offset, uint32_t copy,
                                      const fram_kvs_header_t *hdr,
                                      uint8_t *key_buf) {
     uint32_t crc = fram_crc32_le(0, hdr, offsetof(fram_kvs_header_t, crc32));
 
     if (hdr->key_len > 0) {
-        esp_err_t err = fram_pm_read(kvs->pm, kvs->part,
-                                     offset + sizeof(fram_kvs_header_t),
-                                     key_buf, hdr->key_len);
+        esp_err_t err = fram_pm_read_copy(kvs->pm, kvs->part, copy,
+                                          offset + sizeof(fram_kvs_header_t),
+                                          key_buf, hdr->key_len);
         if (err != ESP_OK) {
             return err;
         }
@@ -93,7 +106,7 @@ static esp_err_t fram_kvs_compute_crc(fram_kvs_t *kvs, uint32_t offset,
     uint8_t buf[FRAM_KVS_CRC_CHUNK];
     while (remaining > 0) {
         uint32_t chunk = remaining > FRAM_KVS_CRC_CHUNK ? FRAM_KVS_CRC_CHUNK : remaining;
-        esp_err_t err = fram_pm_read(kvs->pm, kvs->part, value_offset, buf, chunk);
+        esp_err_t err = fram_pm_read_copy(kvs->pm, kvs->part, copy, value_offset, buf, chunk);
         if (err != ESP_OK) {
             return err;
         }
@@ -108,6 +121,96 @@ static esp_err_t fram_kvs_compute_crc(fram_kvs_t *kvs, uint32_t offset,
     return ESP_OK;
 }
 
+// Loads and verifies the record at `offset` from one copy. ESP_ERR_NOT_FOUND
+// marks the end of the log: no valid header, no commit byte or a bad CRC.
+static esp_err_t fram_kvs_load_record(fram_kvs_t *kvs, uint32_t offset, uint32_t copy,
+                                      fram_kvs_header_t *hdr, uint8_t *key_buf,
+                                      uint32_t *record_size) {
+    esp_err_t err = fram_kvs_read_header(kvs, offset, copy, hdr);
+    if (err != ESP_OK) {
+        return err;
+    }
+    if (!fram_kvs_header_valid(kvs, hdr)) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    uint32_t size = sizeof(fram_kvs_header_t) + hdr->key_len + hdr->value_len + 1;
+    if (offset > kvs->part->size || size > kvs->part->size || offset + size > kvs->part->size) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    uint8_t commit = 0;
+    err = fram_kvs_read_commit(kvs, offset, copy, hdr->key_len, hdr->value_len, &commit);
+    if (err != ESP_OK) {
+        return err;
+    }
+    if (commit != FRAM_KVS_COMMIT) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    err = fram_kvs_compute_crc(kvs, offset, copy, hdr, key_buf);
+    if (err == ESP_ERR_INVALID_CRC) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (err != ESP_OK) {
+        return err;
+    }
+    *record_size = size;
+    return ESP_OK;
+}
+
+typedef struct {
+    fram_kvs_t *kvs;
+    uint32_t offset;
+    fram_kvs_header_t *hdr;
+    uint8_t *key_buf;
+    uint32_t *record_size;
+} fram_kvs_check_t;
+
+static esp_err_t fram_kvs_check_copy(void *arg, uint32_t copy, size_t *len) {
+    fram_kvs_check_t *check = arg;
+    esp_err_t err = fram_kvs_load_record(check->kvs, check->offset, copy, check->hdr,
+                                         check->key_buf, check->record_size);
+    if (err == ESP_OK) {
+        *len = *check->record_size;
+    }
+    return err;
+}
+
+// Like fram_kvs_load_record(), but on redundant devices a record that ends the
+// log in one copy is looked up in the others before giving up, so a damaged
+// copy does not truncate the store.
+static esp_err_t fram_kvs_find_record(fram_kvs_t *kvs, uint32_t offset, fram_kvs_header_t *hdr,
+                                      uint8_t *key_buf, uint32_t *record_size) {
+    esp_err_t err = fram_kvs_load_record(kvs, offset, FRAM_PM_COPY_ANY, hdr, key_buf, record_size);
+    if (err != ESP_ERR_NOT_FOUND) {
+        return err;
+    }
+    fram_kvs_check_t check = {
+        .kvs = kvs,
+        .offset = offset,
+        .hdr = hdr,
+        .key_buf = key_buf,
+        .record_size = record_size,
+    };
+    if (fram_pm_recover(kvs->pm, kvs->part, offset, fram_kvs_check_copy, &check) != ESP_OK) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    return ESP_OK;
+}
+
+// One device scope per record: header, commit and key reads are not
+// interleaved with other tasks' I/O, which can still run between records.
+static esp_err_t fram_kvs_next_record(fram_kvs_t *kvs, uint32_t offset, fram_kvs_header_t *hdr,
+                                      uint8_t *key_buf, uint32_t *record_size) {
+    esp_err_t err = fram_pm_begin(kvs->pm);
+    if (err != ESP_OK) {
+        return err;
+    }
+    err = fram_kvs_find_record(kvs, offset, hdr, key_buf, record_size);
+    fram_pm_end(kvs->pm);
+    return err;
+}
+
 static esp_err_t fram_kvs_scan(fram_kvs_t *kvs, const char *key,
                                fram_kvs_header_t *out_hdr, uint32_t *out_offset,
                                bool *out_deleted) {
@@ -122,37 +225,15 @@ static esp_err_t fram_kvs_scan(fram_kvs_t *kvs, const char *key,
 
     while (offset + sizeof(fram_kvs_header_t) + 1 <= kvs->part->size) {
         fram_kvs_header_t hdr;
-        esp_err_t err = fram_kvs_read_header(kvs, offset, &hdr);
-        if (err != ESP_OK) {
-            return err;
-        }
-        if (!fram_kvs_header_valid(kvs, &hdr)) {
-            break;
-        }
-        uint32_t record_size = sizeof(fram_kvs_header_t) + hdr.key_len + hdr.value_len + 1;
-        if (offset > kvs->part->size || record_size > kvs->part->size || offset + record_size > kvs->part->size) {
-            break;
-        }
-
-        uint8_t commit = 0;
-        err = fram_kvs_read_commit(kvs, offset, hdr.key_len, hdr.value_len, &commit);
-        if (err != ESP_OK) {
-            return err;
-        }
-        if (commit != FRAM_KVS_COMMIT) {
-            break;
-        }
-
-        err = fram_kvs_compute_crc(kvs, offset, &hdr, key_buf);
-        if (err == ESP_ERR_INVALID_CRC) {
+        uint32_t record_size = 0;
+        esp_err_t err = fram_kvs_next_record(kvs, offset, &hdr, key_buf, &record_size);
+        if (err == ESP_ERR_NOT_FOUND) {
             break;
         }
         if (err != ESP_OK) {
             return err;
         }
-        bool crc_ok = true;
-
-        if (crc_ok && key && hdr.key_len == key_len_in &&
+        if (key && hdr.key_len == key_len_in &&
             memcmp(key_buf, key, key_len_in) == 0) {
             last_hdr = hdr;
             last_offset = offset;
@@ -183,29 +264,9 @@ static esp_err_t fram_kvs_find_end(fram_kvs_t *kvs, uint32_t *out_offset, uint32
 
     while (offset + sizeof(fram_kvs_header_t) + 1 <= kvs->part->size) {
         fram_kvs_header_t hdr;
-        esp_err_t err = fram_kvs_read_header(kvs, offset, &hdr);
-        if (err != ESP_OK) {
-            return err;
-        }
-        if (!fram_kvs_header_valid(kvs, &hdr)) {
-            break;
-        }
-        uint32_t record_size = sizeof(fram_kvs_header_t) + hdr.key_len + hdr.value_len + 1;
-        if (offset > kvs->part->size || record_size > kvs->part->size || offset + record_size > kvs->part->size) {
-            break;
-        }
-
-        uint8_t commit = 0;
-        err = fram_kvs_read_commit(kvs, offset, hdr.key_len, hdr.value_len, &commit);
-        if (err != ESP_OK) {
-            return err;
-        }
-        if (commit != FRAM_KVS_COMMIT) {
-            break;
-        }
-
-        err = fram_kvs_compute_crc(kvs, offset, &hdr, key_buf);
-        if (err == ESP_ERR_INVALID_CRC) {
+        uint32_t record_size = 0;
+        esp_err_t err = fram_kvs_next_record(kvs, offset, &hdr, key_buf, &record_size);
+        if (err == ESP_ERR_NOT_FOUND) {
             break;
         }
         if (err != ESP_OK) {
@@ -262,6 +323,31 @@ esp_err_t fram_kvs_deinit(fram_kvs_t *kvs) {
     return ESP_OK;
 }
 
+esp_err_t fram_kvs_clear(fram_kvs_t *kvs) {
+    if (kvs == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!kvs->ready) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    esp_err_t err = fram_kvs_lock(kvs);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    // The whole partition: records past write_offset (left behind by an
+    // interrupted clear, say) would be picked up again once new records
+    // happen to end where one of them starts.
+    err = fram_pm_erase(kvs->pm, kvs->part);
+    if (err == ESP_OK) {
+        kvs->write_offset = 0;
+    }
+
+    fram_kvs_unlock(kvs);
+    return err;
+}
+
 esp_err_t fram_kvs_get(fram_kvs_t *kvs, const char *key, void *buf, size_t *len) {
     if (kvs == NULL || key == NULL || buf == NULL || len == NULL) {
         return ESP_ERR_INVALID_ARG;
@@ -347,23 +433,7 @@ esp_err_t fram_kvs_set(fram_kvs_t *kvs, const char *key, const void *buf, size_t
     }
     hdr.crc32 = crc;
 
-    err = fram_kvs_write_commit(kvs, kvs->write_offset, hdr.key_len, hdr.value_len, 0x00);
-    if (err != ESP_OK) {
-        fram_kvs_unlock(kvs);
-        return err;
-    }
-
-    err = fram_pm_write(kvs->pm, kvs->part, kvs->write_offset, &hdr, sizeof(hdr));
-    if (err == ESP_OK) {
-        err = fram_pm_write(kvs->pm, kvs->part, kvs->write_offset + sizeof(hdr), key, key_len);
-    }
-    if (err == ESP_OK && len > 0) {
-        err = fram_pm_write(kvs->pm, kvs->part,
-                            kvs->write_offset + sizeof(hdr) + key_len, buf, len);
-    }
-    if (err == ESP_OK) {
-        err = fram_kvs_write_commit(kvs, kvs->write_offset, hdr.key_len, hdr.value_len, FRAM_KVS_COMMIT);
-    }
+    err = fram_kvs_write_record(kvs, &hdr, key, buf);
 
     if (err == ESP_OK) {
         kvs->write_offset += record_size;
@@ -408,19 +478,7 @@ esp_err_t fram_kvs_delete(fram_kvs_t *kvs, const char *key) {
     crc = fram_crc32_le(crc, key, key_len);
     hdr.crc32 = crc;
 
-    err = fram_kvs_write_commit(kvs, kvs->write_offset, hdr.key_len, hdr.value_len, 0x00);
-    if (err != ESP_OK) {
-        fram_kvs_unlock(kvs);
-        return err;
-    }
-
-    err = fram_pm_write(kvs->pm, kvs->part, kvs->write_offset, &hdr, sizeof(hdr));
-    if (err == ESP_OK) {
-        err = fram_pm_write(kvs->pm, kvs->part, kvs->write_offset + sizeof(hdr), key, key_len);
-    }
-    if (err == ESP_OK) {
-        err = fram_kvs_write_commit(kvs, kvs->write_offset, hdr.key_len, hdr.value_len, FRAM_KVS_COMMIT);
-    }
+    err = fram_kvs_write_record(kvs, &hdr, key, NULL);
 
     if (err == ESP_OK) {
         kvs->write_offset += record_size;
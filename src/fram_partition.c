@@ -1,10 +1,67 @@
 #include "fram/fram_partition.h"
 
 #include "esp_check.h"
+#include "esp_timer.h"
 #include <string.h>
 
 #define TAG "fram_pm"
-#define FRAM_PM_ERASE_CHUNK 64
+
+#if CONFIG_FRAM_DEV_STATS
+#define FRAM_PM_STAT_ADD(field, n) __atomic_fetch_add(&(field), (n), __ATOMIC_RELAXED)
+#define FRAM_PM_STAT_GET(field) __atomic_load_n(&(field), __ATOMIC_RELAXED)
+
+// Partitions normally come from fram_pm_find(); copies are matched by range.
+static fram_part_stats_t *fram_pm_stats_of(fram_pm_t *pm, const fram_partition_t *part) {
+    if (part >= pm->partitions && part < pm->partitions + pm->partition_count) {
+        return &pm->stats[part - pm->partitions];
+    }
+    for (size_t i = 0; i < pm->partition_count; i++) {
+        if (pm->partitions[i].offset == part->offset && pm->partitions[i].size == part->size) {
+            return &pm->stats[i];
+        }
+    }
+    return NULL;
+}
+#endif
+
+static int64_t fram_pm_stat_start(void) {
+#if CONFIG_FRAM_DEV_STATS
+    return esp_timer_get_time();
+#else
+    return 0;
+#endif
+}
+
+// Charge a finished fram_dev call to its partition and pass `err` through.
+static esp_err_t fram_pm_stat_done(fram_pm_t *pm, const fram_partition_t *part, bool write,
+                                   size_t bytes, int64_t start, esp_err_t err) {
+#if CONFIG_FRAM_DEV_STATS
+    fram_part_stats_t *st = fram_pm_stats_of(pm, part);
+    if (st == NULL) {
+        return err;
+    }
+    int64_t elapsed = esp_timer_get_time() - start;
+    uint32_t us = elapsed > UINT32_MAX ? UINT32_MAX : (uint32_t)elapsed;
+    if (write) {
+        FRAM_PM_STAT_ADD(st->write_ops, 1);
+        FRAM_PM_STAT_ADD(st->bytes_written, err == ESP_OK ? (uint64_t)bytes : 0);
+    } else {
+        FRAM_PM_STAT_ADD(st->read_ops, 1);
+        FRAM_PM_STAT_ADD(st->bytes_read, err == ESP_OK ? (uint64_t)bytes : 0);
+    }
+    FRAM_PM_STAT_ADD(st->busy_us, (uint64_t)us);
+    uint32_t cur = FRAM_PM_STAT_GET(st->max_us);
+    while (us > cur && !__atomic_compare_exchange_n(&st->max_us, &cur, us, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+#else
+    (void)pm;
+    (void)part;
+    (void)write;
+    (void)bytes;
+    (void)start;
+#endif
+    return err;
+}
 
 static bool fram_pm_ranges_overlap(uint32_t a_start, uint32_t a_end, uint32_t b_start, uint32_t b_end) {
     return (a_start < b_end) && (b_start < a_end);
@@ -103,6 +160,65 @@ bool fram_pm_is_valid_range(const fram_partition_t *part, uint32_t offset, size_
     return true;
 }
 
+esp_err_t fram_pm_begin(fram_pm_t *pm) {
+    if (pm == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!pm->initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    return fram_dev_begin(pm->dev);
+}
+
+esp_err_t fram_pm_end(fram_pm_t *pm) {
+    if (pm == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return fram_dev_end(pm->dev);
+}
+
+#if CONFIG_FRAM_IO_ENABLED
+esp_err_t fram_pm_set_io(fram_pm_t *pm, fram_io_t *io, uint8_t priority) {
+    if (pm == NULL || (io != NULL && io->dev != pm->dev)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pm->io = io;
+    pm->io_priority = priority;
+    return ESP_OK;
+}
+#endif
+
+// Device writes, through the I/O worker if one is attached.
+static esp_err_t fram_pm_dev_write(fram_pm_t *pm, uint32_t offset, const void *buf, size_t len) {
+#if CONFIG_FRAM_IO_ENABLED
+    if (pm->io) {
+        const fram_io_opts_t opts = { .priority = pm->io_priority };
+        return fram_io_write(pm->io, offset, buf, len, &opts);
+    }
+#endif
+    return fram_dev_write(pm->dev, offset, buf, len);
+}
+
+static esp_err_t fram_pm_dev_writev(fram_pm_t *pm, const fram_wvec_t *vec, size_t count) {
+#if CONFIG_FRAM_IO_ENABLED
+    if (pm->io && count > 0) {
+        const fram_io_opts_t opts = { .priority = pm->io_priority };
+        return fram_io_writev(pm->io, vec, count, &opts);
+    }
+#endif
+    return fram_dev_writev(pm->dev, vec, count);
+}
+
+static esp_err_t fram_pm_dev_fill(fram_pm_t *pm, uint32_t offset, uint8_t value, size_t len) {
+#if CONFIG_FRAM_IO_ENABLED
+    if (pm->io) {
+        const fram_io_opts_t opts = { .priority = pm->io_priority };
+        return fram_io_fill(pm->io, offset, value, len, &opts);
+    }
+#endif
+    return fram_dev_fill(pm->dev, offset, value, len);
+}
+
 esp_err_t fram_pm_read(fram_pm_t *pm, const fram_partition_t *part,
                        uint32_t offset, void *buf, size_t len) {
     if (pm == NULL || part == NULL || buf == NULL) {
@@ -114,7 +230,9 @@ esp_err_t fram_pm_read(fram_pm_t *pm, const fram_partition_t *part,
     if (!fram_pm_is_valid_range(part, offset, len)) {
         return ESP_ERR_INVALID_SIZE;
     }
-    return fram_dev_read(pm->dev, part->offset + offset, buf, len);
+    int64_t start = fram_pm_stat_start();
+    esp_err_t err = fram_dev_read(pm->dev, part->offset + offset, buf, len);
+    return fram_pm_stat_done(pm, part, false, len, start, err);
 }
 
 esp_err_t fram_pm_write(fram_pm_t *pm, const fram_partition_t *part,
@@ -131,10 +249,70 @@ esp_err_t fram_pm_write(fram_pm_t *pm, const fram_partition_t *part,
     if (!fram_pm_is_valid_range(part, offset, len)) {
         return ESP_ERR_INVALID_SIZE;
     }
-    return fram_dev_write(pm->dev, part->offset + offset, buf, len);
+    int64_t start = fram_pm_stat_start();
+    esp_err_t err = fram_pm_dev_write(pm, part->offset + offset, buf, len);
+    return fram_pm_stat_done(pm, part, true, len, start, err);
 }
 
-esp_err_t fram_pm_erase(fram_pm_t *pm, const fram_partition_t *part) {
+esp_err_t fram_pm_readv(fram_pm_t *pm, const fram_partition_t *part,
+                        const fram_rvec_t *vec, size_t count) {
+    if (pm == NULL || part == NULL || (vec == NULL && count > 0)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!pm->initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (count > FRAM_VEC_MAX) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    fram_rvec_t dev_vec[FRAM_VEC_MAX];
+    size_t total = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (!fram_pm_is_valid_range(part, vec[i].offset, vec[i].len)) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+        dev_vec[i] = vec[i];
+        dev_vec[i].offset += part->offset;
+        total += vec[i].len;
+    }
+    int64_t start = fram_pm_stat_start();
+    esp_err_t err = fram_dev_readv(pm->dev, dev_vec, count);
+    return fram_pm_stat_done(pm, part, false, total, start, err);
+}
+
+esp_err_t fram_pm_writev(fram_pm_t *pm, const fram_partition_t *part,
+                         const fram_wvec_t *vec, size_t count) {
+    if (pm == NULL || part == NULL || (vec == NULL && count > 0)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!pm->initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (part->flags & FRAM_PART_FLAG_READONLY) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (count > FRAM_VEC_MAX) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    fram_wvec_t dev_vec[FRAM_VEC_MAX];
+    size_t total = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (!fram_pm_is_valid_range(part, vec[i].offset, vec[i].len)) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+        dev_vec[i] = vec[i];
+        dev_vec[i].offset += part->offset;
+        total += vec[i].len;
+    }
+    int64_t start = fram_pm_stat_start();
+    esp_err_t err = fram_pm_dev_writev(pm, dev_vec, count);
+    return fram_pm_stat_done(pm, part, true, total, start, err);
+}
+
+esp_err_t fram_pm_fill(fram_pm_t *pm, const fram_partition_t *part,
+                       uint32_t offset, uint8_t value, size_t len) {
     if (pm == NULL || part == NULL) {
         return ESP_ERR_INVALID_ARG;
     }
@@ -144,20 +322,99 @@ esp_err_t fram_pm_erase(fram_pm_t *pm, const fram_partition_t *part) {
     if (part->flags & FRAM_PART_FLAG_READONLY) {
         return ESP_ERR_INVALID_STATE;
     }
+    if (!fram_pm_is_valid_range(part, offset, len)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    int64_t start = fram_pm_stat_start();
+    esp_err_t err = fram_pm_dev_fill(pm, part->offset + offset, value, len);
+    return fram_pm_stat_done(pm, part, true, len, start, err);
+}
 
-    uint8_t buf[FRAM_PM_ERASE_CHUNK];
-    memset(buf, 0xFF, sizeof(buf));
+esp_err_t fram_pm_erase(fram_pm_t *pm, const fram_partition_t *part) {
+    if (part == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return fram_pm_fill(pm, part, 0, 0xFF, part->size);
+}
 
-    uint32_t offset = 0;
-    uint32_t remaining = part->size;
-    while (remaining > 0) {
-        uint32_t chunk = remaining > FRAM_PM_ERASE_CHUNK ? FRAM_PM_ERASE_CHUNK : remaining;
-        esp_err_t err = fram_pm_write(pm, part, offset, buf, chunk);
-        if (err != ESP_OK) {
-            return err;
+esp_err_t fram_pm_read_copy(fram_pm_t *pm, const fram_partition_t *part, uint32_t copy,
+                            uint32_t offset, void *buf, size_t len) {
+    if (copy == FRAM_PM_COPY_ANY) {
+        return fram_pm_read(pm, part, offset, buf, len);
+    }
+    if (pm == NULL || part == NULL || buf == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!pm->initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (!fram_pm_is_valid_range(part, offset, len)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    int64_t start = fram_pm_stat_start();
+    esp_err_t err = fram_dev_read_copy(pm->dev, copy, part->offset + offset, buf, len);
+    return fram_pm_stat_done(pm, part, false, len, start, err);
+}
+
+esp_err_t fram_pm_recover(fram_pm_t *pm, const fram_partition_t *part, uint32_t offset,
+                          fram_pm_check_fn check, void *arg) {
+    if (pm == NULL || part == NULL || check == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!pm->initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    uint32_t copies = fram_dev_get_copies(pm->dev);
+    if (copies < 2) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    for (uint32_t copy = 0; copy < copies; copy++) {
+        size_t len = 0;
+        if (check(arg, copy, &len) != ESP_OK) {
+            continue;
+        }
+        if (!fram_pm_is_valid_range(part, offset, len)) {
+            return ESP_ERR_INVALID_SIZE;
         }
-        offset += chunk;
-        remaining -= chunk;
+        ESP_LOGW(TAG, "%s: record at 0x%X recovered from copy %u", part->name, (unsigned)offset,
+                 (unsigned)copy);
+        return fram_dev_repair(pm->dev, copy, part->offset + offset, len);
+    }
+    return ESP_ERR_INVALID_CRC;
+}
+
+#if CONFIG_FRAM_DEV_STATS
+esp_err_t fram_pm_get_stats(const fram_pm_t *pm, const fram_partition_t *part, fram_part_stats_t *stats) {
+    if (pm == NULL || part == NULL || stats == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    fram_part_stats_t *st = fram_pm_stats_of((fram_pm_t *)pm, part);
+    if (st == NULL) {
+        return ESP_ERR_NOT_FOUND;
     }
+    stats->read_ops = FRAM_PM_STAT_GET(st->read_ops);
+    stats->write_ops = FRAM_PM_STAT_GET(st->write_ops);
+    stats->bytes_read = FRAM_PM_STAT_GET(st->bytes_read);
+    stats->bytes_written = FRAM_PM_STAT_GET(st->bytes_written);
+    stats->busy_us = FRAM_PM_STAT_GET(st->busy_us);
+    stats->max_us = FRAM_PM_STAT_GET(st->max_us);
     return ESP_OK;
 }
+
+void fram_pm_reset_stats(fram_pm_t *pm) {
+    if (pm == NULL) {
+        return;
+    }
+    for (size_t i = 0; i < FRAM_PART_MAX; i++) {
+        fram_part_stats_t *st = &pm->stats[i];
+        __atomic_store_n(&st->read_ops, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&st->write_ops, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&st->bytes_read, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&st->bytes_written, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&st->busy_us, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&st->max_us, 0, __ATOMIC_RELAXED);
+    }
+}
+#endif
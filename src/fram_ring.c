@@ -10,25 +10,48 @@
 #define TAG "fram_ring"
 
 #define FRAM_RING_COMMIT 0xA5
+#define FRAM_RING_HINT_MAGIC 0x544E4948 // "HINT"
 
-static uint32_t fram_ring_slot_offset(const fram_ring_t *ring, uint32_t slot) {
-    return slot * ring->entry_size;
-}
+// Head hint, two copies at the start of the partition written alternately.
+// Either copy may be stale or torn; it is only a starting point for the
+// search in fram_ring_recover_hint().
+typedef struct {
+    uint32_t magic;
+    uint32_t seq;
+    uint32_t slot;
+    uint32_t crc32;
+} __attribute__((packed)) fram_ring_hint_t;
 
-static esp_err_t fram_ring_read_commit(const fram_ring_t *ring, uint32_t slot, uint8_t *commit) {
-    uint32_t offset = fram_ring_slot_offset(ring, slot) + sizeof(fram_ring_header_t) + ring->max_payload;
-    return fram_pm_read(ring->pm, ring->part, offset, commit, sizeof(*commit));
+#define FRAM_RING_HINT_AREA (2 * sizeof(fram_ring_hint_t))
+
+// Packed rings: position and seq of the oldest record, two copies at the
+// start of the partition. Rewritten, alternating copies, in the same vector
+// as an append that evicts and before the evicted bytes are overwritten, so
+// the copy with the higher seq always points at an intact record.
+#define FRAM_RING_ANCHOR_MAGIC 0x524B4E41 // "ANKR"
+
+typedef struct {
+    uint32_t magic;
+    uint32_t seq;
+    uint32_t off;
+    uint32_t crc32;
+} __attribute__((packed)) fram_ring_anchor_t;
+
+#define FRAM_RING_ANCHOR_AREA (2 * sizeof(fram_ring_anchor_t))
+
+static uint32_t fram_ring_slot_offset(const fram_ring_t *ring, uint32_t slot) {
+    return ring->base + slot * ring->entry_size;
 }
 
-static esp_err_t fram_ring_write_commit(const fram_ring_t *ring, uint32_t slot, uint8_t commit) {
+static esp_err_t fram_ring_read_commit(const fram_ring_t *ring, uint32_t slot, uint32_t copy, uint8_t *commit) {
     uint32_t offset = fram_ring_slot_offset(ring, slot) + sizeof(fram_ring_header_t) + ring->max_payload;
-    return fram_pm_write(ring->pm, ring->part, offset, &commit, sizeof(commit));
+    return fram_pm_read_copy(ring->pm, ring->part, copy, offset, commit, sizeof(*commit));
 }
 
-static esp_err_t fram_ring_read_header(const fram_ring_t *ring, uint32_t slot, fram_ring_header_t *hdr) {
+static esp_err_t fram_ring_read_header(const fram_ring_t *ring, uint32_t slot, uint32_t copy, fram_ring_header_t *hdr) {
     uint8_t buf[sizeof(fram_ring_header_t)];
-    esp_err_t err = fram_pm_read(ring->pm, ring->part,
-                                 fram_ring_slot_offset(ring, slot), buf, sizeof(buf));
+    esp_err_t err = fram_pm_read_copy(ring->pm, ring->part, copy,
+                                      fram_ring_slot_offset(ring, slot), buf, sizeof(buf));
     if (err != ESP_OK) {
         return err;
     }
@@ -36,15 +59,15 @@ static esp_err_t fram_ring_read_header(const fram_ring_t *ring, uint32_t slot, f
     return ESP_OK;
 }
 
-static esp_err_t fram_ring_validate_slot(const fram_ring_t *ring, uint32_t slot, fram_ring_header_t *hdr_out) {
+static esp_err_t fram_ring_check_slot(const fram_ring_t *ring, uint32_t slot, uint32_t copy, fram_ring_header_t *hdr_out) {
     uint8_t commit = 0;
-    esp_err_t err = fram_ring_read_commit(ring, slot, &commit);
+    esp_err_t err = fram_ring_read_commit(ring, slot, copy, &commit);
     if (err != ESP_OK || commit != FRAM_RING_COMMIT) {
         return ESP_ERR_NOT_FOUND;
     }
 
     fram_ring_header_t hdr;
-    err = fram_ring_read_header(ring, slot, &hdr);
+    err = fram_ring_read_header(ring, slot, copy, &hdr);
     if (err != ESP_OK) {
         return err;
     }
@@ -57,9 +80,9 @@ static esp_err_t fram_ring_validate_slot(const fram_ring_t *ring, uint32_t slot,
 
     uint8_t payload_buf[CONFIG_FRAM_RING_MAX_PAYLOAD];
     if (hdr.len > 0) {
-        err = fram_pm_read(ring->pm, ring->part,
-                           fram_ring_slot_offset(ring, slot) + sizeof(fram_ring_header_t),
-                           payload_buf, hdr.len);
+        err = fram_pm_read_copy(ring->pm, ring->part, copy,
+                                fram_ring_slot_offset(ring, slot) + sizeof(fram_ring_header_t),
+                                payload_buf, hdr.len);
         if (err != ESP_OK) {
             return err;
         }
@@ -79,6 +102,40 @@ static esp_err_t fram_ring_validate_slot(const fram_ring_t *ring, uint32_t slot,
     return ESP_OK;
 }
 
+typedef struct {
+    const fram_ring_t *ring;
+    uint32_t slot;
+    fram_ring_header_t *hdr_out;
+} fram_ring_check_t;
+
+static esp_err_t fram_ring_check_copy(void *arg, uint32_t copy, size_t *len) {
+    fram_ring_check_t *check = arg;
+    esp_err_t err = fram_ring_check_slot(check->ring, check->slot, copy, check->hdr_out);
+    if (err == ESP_OK) {
+        *len = check->ring->entry_size;
+    }
+    return err;
+}
+
+// On redundant devices a slot that fails validation may still be intact in
+// another copy; if so the bad copy is repaired and the slot is used.
+static esp_err_t fram_ring_validate_slot(const fram_ring_t *ring, uint32_t slot, fram_ring_header_t *hdr_out) {
+    esp_err_t err = fram_ring_check_slot(ring, slot, FRAM_PM_COPY_ANY, hdr_out);
+    if (err != ESP_ERR_NOT_FOUND && err != ESP_ERR_INVALID_SIZE && err != ESP_ERR_INVALID_CRC) {
+        return err;
+    }
+    fram_ring_check_t check = { .ring = ring, .slot = slot, .hdr_out = hdr_out };
+    if (fram_pm_recover(ring->pm, ring->part, fram_ring_slot_offset(ring, slot),
+                        fram_ring_check_copy, &check) != ESP_OK) {
+        return err;
+    }
+    return ESP_OK;
+}
+
+static uint64_t fram_ring_now(const fram_ring_t *ring) {
+    return ring->clock ? ring->clock() : (uint64_t)esp_timer_get_time();
+}
+
 static esp_err_t fram_ring_lock(fram_ring_t *ring) {
     if (ring == NULL || ring->mutex == NULL) {
         return ESP_ERR_INVALID_STATE;
@@ -95,36 +152,135 @@ static void fram_ring_unlock(fram_ring_t *ring) {
     }
 }
 
-esp_err_t fram_ring_init(fram_ring_t *ring, const fram_ring_config_t *cfg) {
-    if (ring == NULL || cfg == NULL || cfg->pm == NULL || cfg->partition_name == NULL) {
-        return ESP_ERR_INVALID_ARG;
+static void fram_ring_make_hint(fram_ring_hint_t *hint, uint32_t slot, uint32_t seq) {
+    hint->magic = FRAM_RING_HINT_MAGIC;
+    hint->seq = seq;
+    hint->slot = slot;
+    hint->crc32 = fram_crc32_le(0, hint, offsetof(fram_ring_hint_t, crc32));
+}
+
+// Copy with the higher seq of the ones that pass their CRC.
+static bool fram_ring_load_hint(const fram_ring_t *ring, fram_ring_hint_t *out) {
+    fram_ring_hint_t hint[2];
+    if (fram_pm_read(ring->pm, ring->part, 0, hint, sizeof(hint)) != ESP_OK) {
+        return false;
     }
-    if (cfg->max_payload == 0 || cfg->max_payload > CONFIG_FRAM_RING_MAX_PAYLOAD) {
-        return ESP_ERR_INVALID_SIZE;
+    bool found = false;
+    for (size_t i = 0; i < 2; i++) {
+        if (hint[i].magic != FRAM_RING_HINT_MAGIC || hint[i].slot >= ring->capacity ||
+            hint[i].crc32 != fram_crc32_le(0, &hint[i], offsetof(fram_ring_hint_t, crc32))) {
+            continue;
+        }
+        if (!found || hint[i].seq > out->seq) {
+            *out = hint[i];
+            found = true;
+        }
     }
+    return found;
+}
 
-    memset(ring, 0, sizeof(*ring));
-    ring->pm = cfg->pm;
-    ring->part = fram_pm_find(cfg->pm, cfg->partition_name);
-    if (ring->part == NULL) {
-        return ESP_ERR_NOT_FOUND;
+// Commit byte and header only, enough to place a slot in the sequence. The
+// payload CRC is checked when the slot is read.
+static bool fram_ring_probe(const fram_ring_t *ring, uint32_t slot, uint32_t seq) {
+    fram_ring_header_t hdr;
+    uint8_t commit = 0;
+    uint32_t offset = fram_ring_slot_offset(ring, slot);
+    const fram_rvec_t vec[] = {
+        { .offset = offset, .buf = &hdr, .len = sizeof(hdr) },
+        { .offset = offset + sizeof(hdr) + ring->max_payload, .buf = &commit, .len = sizeof(commit) },
+    };
+    if (fram_pm_readv(ring->pm, ring->part, vec, sizeof(vec) / sizeof(vec[0])) != ESP_OK) {
+        return false;
     }
+    return commit == FRAM_RING_COMMIT && hdr.magic == ring->magic && hdr.seq == seq &&
+           hdr.len <= ring->max_payload;
+}
 
-    ring->max_payload = cfg->max_payload;
-    ring->entry_size = sizeof(fram_ring_header_t) + ring->max_payload + 1;
-    ring->capacity = ring->part->size / ring->entry_size;
-    ring->magic = cfg->magic;
+// Mount from the head hint. Entries written since the hint fill the slots
+// after it in seq order, so the newest one is found by galloping forward and
+// the oldest by a binary search back from there, O(log n) header reads in
+// all. Only the hinted slot and the newest are validated in full here; the
+// rest are validated when they are read.
+static bool fram_ring_recover_hint(fram_ring_t *ring) {
+    fram_ring_hint_t hint = {0};
+    if (!fram_ring_load_hint(ring, &hint)) {
+        return false;
+    }
+    fram_ring_header_t hdr;
+    if (fram_ring_validate_slot(ring, hint.slot, &hdr) != ESP_OK || hdr.seq != hint.seq) {
+        return false;
+    }
 
-    if (ring->capacity == 0) {
-        return ESP_ERR_INVALID_SIZE;
+    // lo: distance known written, hi: distance known not written (capacity
+    // would be the hinted slot again)
+    const uint32_t cap = ring->capacity;
+    uint32_t lo = 0;
+    uint32_t hi = 1;
+    while (hi < cap && fram_ring_probe(ring, (hint.slot + hi) % cap, hint.seq + hi)) {
+        lo = hi;
+        hi *= 2;
+    }
+    if (hi > cap) {
+        hi = cap;
+    }
+    while (hi - lo > 1) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (fram_ring_probe(ring, (hint.slot + mid) % cap, hint.seq + mid)) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    while (lo > 0) {
+        esp_err_t err = fram_ring_validate_slot(ring, (hint.slot + lo) % cap, &hdr);
+        if (err == ESP_OK && hdr.seq == hint.seq + lo) {
+            break;
+        }
+        lo--;
     }
+    uint32_t newest_slot = (hint.slot + lo) % cap;
+    uint32_t newest_seq = hint.seq + lo;
 
-    ring->mutex = xSemaphoreCreateMutexStatic(&ring->mutex_buf);
-    if (ring->mutex == NULL) {
-        return ESP_ERR_NO_MEM;
+    // Same search backwards for the length of the run ending at the newest
+    // entry; a full ring is settled by the first probe.
+    uint32_t max_run = newest_seq < cap - 1 ? newest_seq + 1 : cap;
+    uint32_t back = max_run - 1;
+    if (back > 0 && !fram_ring_probe(ring, (newest_slot + cap - back) % cap, newest_seq - back)) {
+        uint32_t ok = 0;
+        while (back - ok > 1) {
+            uint32_t mid = ok + (back - ok) / 2;
+            if (fram_ring_probe(ring, (newest_slot + cap - mid) % cap, newest_seq - mid)) {
+                ok = mid;
+            } else {
+                back = mid;
+            }
+        }
+        back = ok;
+    }
+
+    ring->count = back + 1;
+    ring->head_slot = (newest_slot + 1) % cap;
+    ring->head_seq = newest_seq + 1;
+    ring->tail_slot = (ring->head_slot + cap - ring->count) % cap;
+    return true;
+}
+
+// After a full scan, point both hint copies at the recovered head (or erase
+// them for an empty ring) so a stale copy cannot outrank new ones.
+static esp_err_t fram_ring_reset_hint(fram_ring_t *ring) {
+    if (ring->count == 0) {
+        return fram_pm_fill(ring->pm, ring->part, 0, 0xFF, FRAM_RING_HINT_AREA);
     }
+    fram_ring_hint_t hint[2];
+    fram_ring_make_hint(&hint[0], (ring->head_slot + ring->capacity - 1) % ring->capacity, ring->head_seq - 1);
+    hint[1] = hint[0];
+    // A writev is not staged, so the hint is on the device before init returns
+    const fram_wvec_t vec = { .offset = 0, .buf = hint, .len = sizeof(hint) };
+    return fram_pm_writev(ring->pm, ring->part, &vec, 1);
+}
 
-    // Recovery
+// Find the newest valid slot and walk back over consecutive sequence numbers.
+static void fram_ring_recover(fram_ring_t *ring) {
     uint32_t highest_seq = 0;
     uint32_t highest_slot = 0;
     bool found = false;
@@ -146,8 +302,7 @@ esp_err_t fram_ring_init(fram_ring_t *ring, const fram_ring_config_t *cfg) {
         ring->tail_slot = 0;
         ring->head_seq = 0;
         ring->count = 0;
-        ring->ready = true;
-        return ESP_OK;
+        return;
     }
 
     uint32_t run_len = 0;
@@ -172,184 +327,922 @@ esp_err_t fram_ring_init(fram_ring_t *ring, const fram_ring_config_t *cfg) {
     ring->head_slot = (highest_slot + 1) % ring->capacity;
     ring->head_seq = highest_seq + 1;
     ring->tail_slot = (ring->head_slot + ring->capacity - ring->count) % ring->capacity;
-    ring->ready = true;
-
-    return ESP_OK;
 }
 
-esp_err_t fram_ring_deinit(fram_ring_t *ring) {
-    if (ring == NULL) {
-        return ESP_ERR_INVALID_ARG;
+// Packed records. Positions are relative to ring->base and wrap at
+// data_size, so a record may be split over the end of the partition.
+
+static esp_err_t fram_ring_read_at(const fram_ring_t *ring, uint32_t copy, uint32_t pos, void *buf, size_t len) {
+    uint32_t first = ring->data_size - pos;
+    if (len <= first) {
+        return fram_pm_read_copy(ring->pm, ring->part, copy, ring->base + pos, buf, len);
     }
-    ring->ready = false;
-    return ESP_OK;
+    esp_err_t err = fram_pm_read_copy(ring->pm, ring->part, copy, ring->base + pos, buf, first);
+    if (err != ESP_OK) {
+        return err;
+    }
+    return fram_pm_read_copy(ring->pm, ring->part, copy, ring->base, (uint8_t *)buf + first, len - first);
 }
 
-esp_err_t fram_ring_append(fram_ring_t *ring, const void *payload, size_t len) {
-    if (ring == NULL || (payload == NULL && len > 0)) {
-        return ESP_ERR_INVALID_ARG;
+// Appends [pos, pos + len) to `vec` as one or two segments.
+static void fram_ring_push_wvec(const fram_ring_t *ring, fram_wvec_t *vec, size_t *count,
+                                uint32_t pos, const void *buf, size_t len) {
+    uint32_t first = ring->data_size - pos;
+    if (len <= first) {
+        vec[(*count)++] = (fram_wvec_t){ .offset = ring->base + pos, .buf = buf, .len = len };
+        return;
     }
-    if (!ring->ready) {
-        return ESP_ERR_INVALID_STATE;
+    vec[(*count)++] = (fram_wvec_t){ .offset = ring->base + pos, .buf = buf, .len = first };
+    vec[(*count)++] = (fram_wvec_t){ .offset = ring->base, .buf = (const uint8_t *)buf + first, .len = len - first };
+}
+
+static uint32_t fram_ring_advance(const fram_ring_t *ring, uint32_t pos, uint32_t len) {
+    return (pos + len) % ring->data_size;
+}
+
+// Header, then payload and commit byte in one read. `payload_out` receives
+// hdr.len bytes when set.
+static esp_err_t fram_ring_check_record(const fram_ring_t *ring, uint32_t pos, uint32_t copy,
+                                        fram_ring_packed_header_t *hdr_out, void *payload_out) {
+    fram_ring_packed_header_t hdr;
+    esp_err_t err = fram_ring_read_at(ring, copy, pos, &hdr, sizeof(hdr));
+    if (err != ESP_OK) {
+        return err;
     }
-    if (len > ring->max_payload || len > UINT16_MAX) {
+    if (hdr.len > ring->max_payload) {
         return ESP_ERR_INVALID_SIZE;
     }
 
-    esp_err_t err = fram_ring_lock(ring);
+    uint8_t buf[CONFIG_FRAM_RING_MAX_PAYLOAD + 1];
+    err = fram_ring_read_at(ring, copy, fram_ring_advance(ring, pos, sizeof(hdr)), buf, hdr.len + 1);
     if (err != ESP_OK) {
         return err;
     }
+    if (buf[hdr.len] != FRAM_RING_COMMIT) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    uint32_t crc = fram_crc32_le(ring->magic, &hdr, offsetof(fram_ring_packed_header_t, crc32));
+    crc = fram_crc32_le(crc, buf, hdr.len);
+    if (crc != hdr.crc32) {
+        return ESP_ERR_INVALID_CRC;
+    }
 
-    uint32_t slot = ring->head_slot;
-
-    // Clear commit first to avoid stale-valid entries
-    err = fram_ring_write_commit(ring, slot, 0x00);
-    if (err != ESP_OK) {
-        fram_ring_unlock(ring);
-        return err;
+    if (hdr_out) {
+        *hdr_out = hdr;
+    }
+    if (payload_out && hdr.len > 0) {
+        memcpy(payload_out, buf, hdr.len);
     }
+    return ESP_OK;
+}
 
-    fram_ring_header_t hdr = {
-        .magic = ring->magic,
-        .seq = ring->head_seq,
-        .ts_us = (uint64_t)esp_timer_get_time(),
-        .len = (uint16_t)len,
-        .reserved = 0,
-        .crc32 = 0,
-    };
+typedef struct {
+    const fram_ring_t *ring;
+    uint32_t pos;
+    fram_ring_packed_header_t *hdr_out;
+    void *payload_out;
+} fram_ring_check_record_t;
 
-    uint32_t crc = fram_crc32_le(0, &hdr, offsetof(fram_ring_header_t, crc32));
-    if (len > 0) {
-        crc = fram_crc32_le(crc, payload, len);
+static esp_err_t fram_ring_check_record_copy(void *arg, uint32_t copy, size_t *len) {
+    fram_ring_check_record_t *check = arg;
+    fram_ring_packed_header_t hdr;
+    esp_err_t err = fram_ring_check_record(check->ring, check->pos, copy, &hdr, check->payload_out);
+    if (err == ESP_OK) {
+        *len = FRAM_RING_PACKED_OVERHEAD + hdr.len;
+        if (check->hdr_out) {
+            *check->hdr_out = hdr;
+        }
     }
-    hdr.crc32 = crc;
+    return err;
+}
 
-    err = fram_pm_write(ring->pm, ring->part, fram_ring_slot_offset(ring, slot), &hdr, sizeof(hdr));
-    if (err == ESP_OK && len > 0) {
-        err = fram_pm_write(ring->pm, ring->part,
-                            fram_ring_slot_offset(ring, slot) + sizeof(hdr), payload, len);
+// Like fram_ring_validate_slot(). Records split over the end of the
+// partition are not recovered from another copy.
+static esp_err_t fram_ring_validate_record(const fram_ring_t *ring, uint32_t pos,
+                                           fram_ring_packed_header_t *hdr_out, void *payload_out) {
+    esp_err_t err = fram_ring_check_record(ring, pos, FRAM_PM_COPY_ANY, hdr_out, payload_out);
+    if (err != ESP_ERR_NOT_FOUND && err != ESP_ERR_INVALID_SIZE && err != ESP_ERR_INVALID_CRC) {
+        return err;
     }
-    if (err == ESP_OK) {
-        err = fram_ring_write_commit(ring, slot, FRAM_RING_COMMIT);
+    if (pos + FRAM_RING_PACKED_OVERHEAD + ring->max_payload > ring->data_size) {
+        return err;
     }
-
-    if (err != ESP_OK) {
-        fram_ring_unlock(ring);
+    fram_ring_check_record_t check = { .ring = ring, .pos = pos, .hdr_out = hdr_out, .payload_out = payload_out };
+    if (fram_pm_recover(ring->pm, ring->part, ring->base + pos, fram_ring_check_record_copy, &check) != ESP_OK) {
         return err;
     }
+    return ESP_OK;
+}
 
-    ring->head_seq++;
-    ring->head_slot = (ring->head_slot + 1) % ring->capacity;
-    if (ring->count < ring->capacity) {
+static void fram_ring_make_anchor(fram_ring_anchor_t *anchor, uint32_t off, uint32_t seq) {
+    anchor->magic = FRAM_RING_ANCHOR_MAGIC;
+    anchor->seq = seq;
+    anchor->off = off;
+    anchor->crc32 = fram_crc32_le(0, anchor, offsetof(fram_ring_anchor_t, crc32));
+}
+
+// Start at the anchored tail (position 0 with any seq if there is none) and
+// follow the length-prefixed chain while records validate with consecutive
+// seqs and fit in the data area.
+static void fram_ring_recover_packed(fram_ring_t *ring) {
+    fram_ring_anchor_t anchor[2];
+    int best = -1;
+    if (fram_pm_read(ring->pm, ring->part, 0, anchor, sizeof(anchor)) == ESP_OK) {
+        for (int i = 0; i < 2; i++) {
+            if (anchor[i].magic != FRAM_RING_ANCHOR_MAGIC || anchor[i].off >= ring->data_size ||
+                anchor[i].crc32 != fram_crc32_le(0, &anchor[i], offsetof(fram_ring_anchor_t, crc32))) {
+                continue;
+            }
+            if (best < 0 || anchor[i].seq > anchor[best].seq) {
+                best = i;
+            }
+        }
+    }
+
+    uint32_t pos = best >= 0 ? anchor[best].off : 0;
+    uint32_t seq = best >= 0 ? anchor[best].seq : 0;
+    bool seq_known = best >= 0;
+    ring->anchor_copy = best == 0 ? 1 : 0;
+    ring->tail_off = pos;
+    ring->newest_off = pos;
+    ring->used = 0;
+    ring->count = 0;
+
+    while (ring->used + FRAM_RING_PACKED_OVERHEAD <= ring->data_size) {
+        fram_ring_packed_header_t hdr;
+        if (fram_ring_validate_record(ring, pos, &hdr, NULL) != ESP_OK) {
+            break;
+        }
+        uint32_t size = FRAM_RING_PACKED_OVERHEAD + hdr.len;
+        if ((seq_known && hdr.seq != seq) || ring->used + size > ring->data_size) {
+            break;
+        }
+        seq = hdr.seq + 1;
+        seq_known = true;
+        ring->newest_off = pos;
+        ring->used += size;
         ring->count++;
-    } else {
-        ring->tail_slot = (ring->tail_slot + 1) % ring->capacity;
+        pos = fram_ring_advance(ring, pos, size);
     }
 
-    fram_ring_unlock(ring);
+    ring->head_off = pos;
+    ring->head_seq = seq;
+}
+
+static void fram_ring_make_packed_header(const fram_ring_t *ring, fram_ring_packed_header_t *hdr, uint32_t seq,
+                                         uint64_t ts_us, const void *payload, size_t len) {
+    hdr->seq = seq;
+    hdr->ts_us = ts_us;
+    hdr->len = (uint16_t)len;
+    uint32_t crc = fram_crc32_le(ring->magic, hdr, offsetof(fram_ring_packed_header_t, crc32));
+    if (len > 0) {
+        crc = fram_crc32_le(crc, payload, len);
+    }
+    hdr->crc32 = crc;
+}
+
+// Evict whole oldest records until `size` more bytes fit; their lengths are
+// the only reads needed. Works on copies of the tail state.
+static esp_err_t fram_ring_evict(const fram_ring_t *ring, uint32_t size,
+                                 uint32_t *tail_off, uint32_t *used, uint32_t *count) {
+    while (*used + size > ring->data_size) {
+        fram_ring_packed_header_t old;
+        esp_err_t err = fram_ring_read_at(ring, FRAM_PM_COPY_ANY, *tail_off, &old, sizeof(old));
+        if (err != ESP_OK) {
+            return err;
+        }
+        uint32_t old_size = FRAM_RING_PACKED_OVERHEAD + old.len;
+        if (old.len > ring->max_payload || old_size > *used) {
+            // Unreadable chain: drop everything up to the head
+            *tail_off = ring->head_off;
+            *used = 0;
+            *count = 0;
+            break;
+        }
+        *tail_off = fram_ring_advance(ring, *tail_off, old_size);
+        *used -= old_size;
+        (*count)--;
+    }
     return ESP_OK;
 }
 
-static esp_err_t fram_ring_read_slot_payload(fram_ring_t *ring, uint32_t slot,
-                                             void *payload, size_t *len,
-                                             uint32_t *seq, uint64_t *ts_us) {
-    fram_ring_header_t hdr;
-    esp_err_t err = fram_ring_validate_slot(ring, slot, &hdr);
+// Called with the ring locked.
+static esp_err_t fram_ring_append_packed(fram_ring_t *ring, const void *payload, size_t len) {
+    uint32_t size = FRAM_RING_PACKED_OVERHEAD + len;
+    uint32_t tail_off = ring->tail_off;
+    uint32_t used = ring->used;
+    uint32_t count = ring->count;
+    esp_err_t err = fram_ring_evict(ring, size, &tail_off, &used, &count);
     if (err != ESP_OK) {
         return err;
     }
 
-    if (len) {
-        if (payload && *len < hdr.len) {
-            *len = hdr.len;
-            return ESP_ERR_INVALID_SIZE;
-        }
-        if (payload && hdr.len > 0) {
-            err = fram_pm_read(ring->pm, ring->part,
-                               fram_ring_slot_offset(ring, slot) + sizeof(fram_ring_header_t),
-                               payload, hdr.len);
-            if (err != ESP_OK) {
-                return err;
-            }
-        }
-        *len = hdr.len;
+    fram_ring_packed_header_t hdr;
+    fram_ring_make_packed_header(ring, &hdr, ring->head_seq, fram_ring_now(ring), payload, len);
+
+    // Anchor (when the tail moved), commit clear, header and payload (one
+    // run unless split at the end of the partition), commit set
+    const uint8_t commit_clear = 0x00;
+    const uint8_t commit_set = FRAM_RING_COMMIT;
+    uint32_t commit_pos = fram_ring_advance(ring, ring->head_off, sizeof(hdr) + len);
+    fram_ring_anchor_t anchor;
+    fram_wvec_t vec[FRAM_VEC_MAX];
+    size_t n = 0;
+    bool moved = tail_off != ring->tail_off;
+    if (moved) {
+        fram_ring_make_anchor(&anchor, tail_off, ring->head_seq - count);
+        vec[n++] = (fram_wvec_t){ .offset = ring->anchor_copy * sizeof(anchor), .buf = &anchor, .len = sizeof(anchor) };
     }
-    if (seq) {
-        *seq = hdr.seq;
+    fram_ring_push_wvec(ring, vec, &n, commit_pos, &commit_clear, sizeof(commit_clear));
+    fram_ring_push_wvec(ring, vec, &n, ring->head_off, &hdr, sizeof(hdr));
+    fram_ring_push_wvec(ring, vec, &n, fram_ring_advance(ring, ring->head_off, sizeof(hdr)), payload, len);
+    fram_ring_push_wvec(ring, vec, &n, commit_pos, &commit_set, sizeof(commit_set));
+    err = fram_pm_writev(ring->pm, ring->part, vec, n);
+    if (err != ESP_OK) {
+        return err;
     }
-    if (ts_us) {
-        *ts_us = hdr.ts_us;
+
+    if (moved) {
+        ring->anchor_copy ^= 1;
     }
+    ring->tail_off = tail_off;
+    ring->newest_off = ring->head_off;
+    ring->head_off = fram_ring_advance(ring, ring->head_off, size);
+    ring->head_seq++;
+    ring->used = used + size;
+    ring->count = count + 1;
     return ESP_OK;
 }
 
-esp_err_t fram_ring_peek_oldest(fram_ring_t *ring, void *payload, size_t *len,
-                                uint32_t *seq, uint64_t *ts_us) {
-    if (ring == NULL || len == NULL) {
+esp_err_t fram_ring_init(fram_ring_t *ring, const fram_ring_config_t *cfg) {
+    if (ring == NULL || cfg == NULL || cfg->pm == NULL || cfg->partition_name == NULL) {
         return ESP_ERR_INVALID_ARG;
     }
-    if (!ring->ready || ring->count == 0) {
+    if (cfg->max_payload == 0 || cfg->max_payload > CONFIG_FRAM_RING_MAX_PAYLOAD) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    memset(ring, 0, sizeof(*ring));
+    ring->pm = cfg->pm;
+    ring->part = fram_pm_find(cfg->pm, cfg->partition_name);
+    if (ring->part == NULL) {
         return ESP_ERR_NOT_FOUND;
     }
 
-    esp_err_t err = fram_ring_lock(ring);
-    if (err != ESP_OK) {
-        return err;
+    ring->max_payload = cfg->max_payload;
+    ring->packed = cfg->packed;
+    if (ring->packed) {
+        // entry_size is the largest record, so capacity is a lower bound
+        ring->entry_size = FRAM_RING_PACKED_OVERHEAD + ring->max_payload;
+        ring->base = FRAM_RING_ANCHOR_AREA;
+    } else {
+        ring->entry_size = sizeof(fram_ring_header_t) + ring->max_payload + 1;
+        ring->base = cfg->hint_interval ? FRAM_RING_HINT_AREA : 0;
     }
-    err = fram_ring_read_slot_payload(ring, ring->tail_slot, payload, len, seq, ts_us);
-    fram_ring_unlock(ring);
-    return err;
-}
+    ring->data_size = ring->part->size > ring->base ? ring->part->size - ring->base : 0;
+    ring->capacity = ring->data_size / ring->entry_size;
+    ring->magic = cfg->magic;
+    ring->logical_clear = cfg->logical_clear;
+    ring->clock = cfg->clock;
 
-esp_err_t fram_ring_peek_newest(fram_ring_t *ring, void *payload, size_t *len,
-                                uint32_t *seq, uint64_t *ts_us) {
-    if (ring == NULL || len == NULL) {
-        return ESP_ERR_INVALID_ARG;
+    if (ring->capacity == 0) {
+        return ESP_ERR_INVALID_SIZE;
     }
-    if (!ring->ready || ring->count == 0) {
-        return ESP_ERR_NOT_FOUND;
+    if (cfg->hint_interval && !ring->packed) {
+        // Keeps the head within reach of the older hint copy without wrapping
+        uint32_t max_interval = ring->capacity / 2 ? ring->capacity / 2 : 1;
+        ring->hint_interval = cfg->hint_interval < max_interval ? cfg->hint_interval : max_interval;
     }
 
-    esp_err_t err = fram_ring_lock(ring);
+    ring->mutex = xSemaphoreCreateMutexStatic(&ring->mutex_buf);
+    if (ring->mutex == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    // Recovery: one device scope for the whole scan
+    esp_err_t err = fram_pm_begin(ring->pm);
     if (err != ESP_OK) {
         return err;
     }
-    uint32_t newest_slot = (ring->head_slot + ring->capacity - 1) % ring->capacity;
-    err = fram_ring_read_slot_payload(ring, newest_slot, payload, len, seq, ts_us);
-    fram_ring_unlock(ring);
-    return err;
+    if (ring->packed) {
+        fram_ring_recover_packed(ring);
+    } else if (ring->hint_interval == 0 || !fram_ring_recover_hint(ring)) {
+        fram_ring_recover(ring);
+        if (ring->hint_interval) {
+            err = fram_ring_reset_hint(ring);
+        }
+    }
+    fram_pm_end(ring->pm);
+    if (err != ESP_OK) {
+        return err;
+    }
+    ring->ready = true;
+    return ESP_OK;
 }
 
-esp_err_t fram_ring_peek_oldest_len(fram_ring_t *ring, size_t *len) {
-    if (len == NULL) {
+esp_err_t fram_ring_deinit(fram_ring_t *ring) {
+    if (ring == NULL) {
         return ESP_ERR_INVALID_ARG;
     }
-    return fram_ring_peek_oldest(ring, NULL, len, NULL, NULL);
+    ring->ready = false;
+    return ESP_OK;
 }
 
-esp_err_t fram_ring_peek_newest_len(fram_ring_t *ring, size_t *len) {
-    if (len == NULL) {
-        return ESP_ERR_INVALID_ARG;
+static void fram_ring_make_header(const fram_ring_t *ring, fram_ring_header_t *hdr, uint32_t seq,
+                                  uint64_t ts_us, const void *payload, size_t len) {
+    *hdr = (fram_ring_header_t){
+        .magic = ring->magic,
+        .seq = seq,
+        .ts_us = ts_us,
+        .len = (uint16_t)len,
+        .reserved = 0,
+        .crc32 = 0,
+    };
+    uint32_t crc = fram_crc32_le(0, hdr, offsetof(fram_ring_header_t, crc32));
+    if (len > 0) {
+        crc = fram_crc32_le(crc, payload, len);
     }
-    return fram_ring_peek_newest(ring, NULL, len, NULL, NULL);
+    hdr->crc32 = crc;
 }
 
-esp_err_t fram_ring_iterate(fram_ring_t *ring, fram_ring_iter_fn cb, void *ctx) {
-    if (ring == NULL || cb == NULL) {
+esp_err_t fram_ring_append(fram_ring_t *ring, const void *payload, size_t len) {
+    if (ring == NULL || (payload == NULL && len > 0)) {
         return ESP_ERR_INVALID_ARG;
     }
-    if (!ring->ready || ring->count == 0) {
+    if (!ring->ready) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (len > ring->max_payload || len > UINT16_MAX) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    esp_err_t err = fram_ring_lock(ring);
+    if (err != ESP_OK) {
+        return err;
+    }
+    if (ring->packed) {
+        err = fram_ring_append_packed(ring, payload, len);
+        fram_ring_unlock(ring);
+        return err;
+    }
+
+    uint32_t slot = ring->head_slot;
+    uint32_t slot_offset = fram_ring_slot_offset(ring, slot);
+    uint32_t commit_offset = slot_offset + sizeof(fram_ring_header_t) + ring->max_payload;
+
+    fram_ring_header_t hdr;
+    fram_ring_make_header(ring, &hdr, ring->head_seq, fram_ring_now(ring), payload, len);
+
+    // Clear commit first to avoid stale-valid entries, set it last. Header
+    // and payload are contiguous and go out as one transaction. Every
+    // hint_interval entries the head hint follows the commit in the same
+    // vector, alternating between its two copies.
+    const uint8_t commit_clear = 0x00;
+    const uint8_t commit_set = FRAM_RING_COMMIT;
+    fram_ring_hint_t hint;
+    fram_wvec_t vec[] = {
+        { .offset = commit_offset, .buf = &commit_clear, .len = sizeof(commit_clear) },
+        { .offset = slot_offset, .buf = &hdr, .len = sizeof(hdr) },
+        { .offset = slot_offset + sizeof(hdr), .buf = payload, .len = len },
+        { .offset = commit_offset, .buf = &commit_set, .len = sizeof(commit_set) },
+        { .offset = 0, .buf = &hint, .len = sizeof(hint) },
+    };
+    size_t count = sizeof(vec) / sizeof(vec[0]) - 1;
+    if (ring->hint_interval && (hdr.seq + 1) % ring->hint_interval == 0) {
+        fram_ring_make_hint(&hint, slot, hdr.seq);
+        vec[count].offset = ((hdr.seq / ring->hint_interval) % 2) * sizeof(hint);
+        count++;
+    }
+    err = fram_pm_writev(ring->pm, ring->part, vec, count);
+    if (err != ESP_OK) {
+        fram_ring_unlock(ring);
+        return err;
+    }
+
+    ring->head_seq++;
+    ring->head_slot = (ring->head_slot + 1) % ring->capacity;
+    if (ring->count < ring->capacity) {
+        ring->count++;
+    } else {
+        ring->tail_slot = (ring->tail_slot + 1) % ring->capacity;
+    }
+
+    fram_ring_unlock(ring);
+    return ESP_OK;
+}
+
+// Contiguous writes assembled in the caller's stack buffer. Each flush is a
+// one-segment writev, so it is an ordering point under write combining.
+typedef struct {
+    fram_ring_t *ring;
+    uint8_t *buf;
+    size_t len;
+    uint32_t offset;
+} fram_ring_batch_t;
+
+static esp_err_t fram_ring_batch_flush(fram_ring_batch_t *batch) {
+    if (batch->len == 0) {
         return ESP_OK;
     }
+    const fram_wvec_t vec = { .offset = batch->offset, .buf = batch->buf, .len = batch->len };
+    batch->len = 0;
+    return fram_pm_writev(batch->ring->pm, batch->ring->part, &vec, 1);
+}
+
+// Stage `len` bytes (zeros when `data` is NULL) at data-area position `pos`.
+// Bytes not adjacent to the staged run start a new write; pieces larger than
+// the buffer are written from `data` directly.
+static esp_err_t fram_ring_batch_put(fram_ring_batch_t *batch, uint32_t pos, const void *data, size_t len) {
+    const fram_ring_t *ring = batch->ring;
+    uint32_t first = ring->data_size - pos;
+    if (len > first) {
+        esp_err_t err = fram_ring_batch_put(batch, pos, data, first);
+        if (err != ESP_OK) {
+            return err;
+        }
+        return fram_ring_batch_put(batch, 0, data ? (const uint8_t *)data + first : NULL, len - first);
+    }
+
+    uint32_t offset = ring->base + pos;
+    if (batch->len > 0 && (offset != batch->offset + batch->len || batch->len + len > CONFIG_FRAM_RING_BATCH_BUF)) {
+        esp_err_t err = fram_ring_batch_flush(batch);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+    if (len > CONFIG_FRAM_RING_BATCH_BUF) {
+        const fram_wvec_t vec = { .offset = offset, .buf = data, .len = len };
+        return fram_pm_writev(ring->pm, ring->part, &vec, 1);
+    }
+    if (batch->len == 0) {
+        batch->offset = offset;
+    }
+    if (data) {
+        memcpy(batch->buf + batch->len, data, len);
+    } else {
+        memset(batch->buf + batch->len, 0, len);
+    }
+    batch->len += len;
+    return ESP_OK;
+}
+
+// Sets the commit byte of `count` slots from the head, oldest first.
+static esp_err_t fram_ring_batch_commits(fram_ring_t *ring, size_t count, const uint8_t *commit) {
+    fram_wvec_t vec[FRAM_VEC_MAX];
+    size_t done = 0;
+    while (done < count) {
+        size_t n = 0;
+        while (n < FRAM_VEC_MAX && done < count) {
+            uint32_t slot = (ring->head_slot + done) % ring->capacity;
+            vec[n].offset = fram_ring_slot_offset(ring, slot) + sizeof(fram_ring_header_t) + ring->max_payload;
+            vec[n].buf = commit;
+            vec[n].len = 1;
+            n++;
+            done++;
+        }
+        esp_err_t err = fram_pm_writev(ring->pm, ring->part, vec, n);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+    return ESP_OK;
+}
+
+// Fixed slots: clear all commit bytes, write headers and payloads, then set
+// the commit bytes oldest first. Recovery picks the highest seq and walks
+// back, so no slot may look valid before every older one in the batch does.
+static esp_err_t fram_ring_batch_slots(fram_ring_t *ring, const fram_ring_rec_t *recs, size_t count, uint64_t ts_us) {
+    const uint8_t commit_clear = 0x00;
+    const uint8_t commit_set = FRAM_RING_COMMIT;
+    esp_err_t err = fram_ring_batch_commits(ring, count, &commit_clear);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    // A gap up to a header's size (padding plus the cleared commit byte)
+    // costs less as zeros than as a separate transaction
+    uint8_t stage[CONFIG_FRAM_RING_BATCH_BUF];
+    fram_ring_batch_t batch = { .ring = ring, .buf = stage };
+    for (size_t i = 0; i < count && err == ESP_OK; i++) {
+        uint32_t slot = (ring->head_slot + i) % ring->capacity;
+        uint32_t pos = slot * ring->entry_size;
+        fram_ring_header_t hdr;
+        fram_ring_make_header(ring, &hdr, ring->head_seq + i, ts_us, recs[i].payload, recs[i].len);
+        err = fram_ring_batch_put(&batch, pos, &hdr, sizeof(hdr));
+        if (err == ESP_OK) {
+            err = fram_ring_batch_put(&batch, pos + sizeof(hdr), recs[i].payload, recs[i].len);
+        }
+        uint32_t gap = ring->entry_size - sizeof(hdr) - recs[i].len;
+        if (err == ESP_OK && i + 1 < count && slot + 1 < ring->capacity && gap <= sizeof(hdr)) {
+            err = fram_ring_batch_put(&batch, pos + sizeof(hdr) + recs[i].len, NULL, gap);
+        }
+    }
+    if (err == ESP_OK) {
+        err = fram_ring_batch_flush(&batch);
+    }
+    if (err == ESP_OK) {
+        err = fram_ring_batch_commits(ring, count, &commit_set);
+    }
+    if (err != ESP_OK || ring->hint_interval == 0) {
+        return err;
+    }
+
+    // Newest hint boundary crossed by the batch, if any
+    uint32_t first_seq = ring->head_seq;
+    uint32_t last_seq = first_seq + count - 1;
+    uint32_t hint_seq = last_seq - (last_seq + 1) % ring->hint_interval;
+    if (hint_seq < first_seq || hint_seq > last_seq) {
+        return ESP_OK;
+    }
+    fram_ring_hint_t hint;
+    fram_ring_make_hint(&hint, (ring->head_slot + (hint_seq - first_seq)) % ring->capacity, hint_seq);
+    const fram_wvec_t vec = {
+        .offset = ((hint_seq / ring->hint_interval) % 2) * sizeof(hint), .buf = &hint, .len = sizeof(hint)
+    };
+    return fram_pm_writev(ring->pm, ring->part, &vec, 1);
+}
+
+// Clears the commit byte each packed record of the batch will use, so a
+// stale one left by an earlier lap cannot complete a partly written record.
+static esp_err_t fram_ring_batch_packed_clear(fram_ring_t *ring, const fram_ring_rec_t *recs, size_t count) {
+    const uint8_t commit_clear = 0x00;
+    fram_wvec_t vec[FRAM_VEC_MAX];
+    size_t n = 0;
+    uint32_t pos = ring->head_off;
+    for (size_t i = 0; i < count; i++) {
+        uint32_t commit_pos = fram_ring_advance(ring, pos, sizeof(fram_ring_packed_header_t) + recs[i].len);
+        fram_ring_push_wvec(ring, vec, &n, commit_pos, &commit_clear, sizeof(commit_clear));
+        pos = fram_ring_advance(ring, pos, FRAM_RING_PACKED_OVERHEAD + recs[i].len);
+        if (n == FRAM_VEC_MAX || i + 1 == count) {
+            esp_err_t err = fram_pm_writev(ring->pm, ring->part, vec, n);
+            if (err != ESP_OK) {
+                return err;
+            }
+            n = 0;
+        }
+    }
+    return ESP_OK;
+}
+
+// Packed records: clear the batch's commit bytes, then write each record
+// with its commit byte set in one staged run. Recovery follows the chain
+// from the tail and stops at the first record that is not complete, so a
+// reset leaves a prefix of the batch.
+static esp_err_t fram_ring_batch_packed(fram_ring_t *ring, const fram_ring_rec_t *recs, size_t count,
+                                        uint32_t total, uint64_t ts_us) {
+    uint32_t tail_off = ring->tail_off;
+    uint32_t used = ring->used;
+    uint32_t live = ring->count;
+    esp_err_t err = fram_ring_evict(ring, total, &tail_off, &used, &live);
+    if (err != ESP_OK) {
+        return err;
+    }
+    bool moved = tail_off != ring->tail_off;
+    if (moved) {
+        fram_ring_anchor_t anchor;
+        fram_ring_make_anchor(&anchor, tail_off, ring->head_seq - live);
+        const fram_wvec_t vec = { .offset = ring->anchor_copy * sizeof(anchor), .buf = &anchor, .len = sizeof(anchor) };
+        err = fram_pm_writev(ring->pm, ring->part, &vec, 1);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+
+    err = fram_ring_batch_packed_clear(ring, recs, count);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    // RAM state follows only once every write has gone out
+    const uint8_t commit_set = FRAM_RING_COMMIT;
+    uint8_t stage[CONFIG_FRAM_RING_BATCH_BUF];
+    fram_ring_batch_t batch = { .ring = ring, .buf = stage };
+    uint32_t pos = ring->head_off;
+    uint32_t newest = pos;
+    for (size_t i = 0; i < count && err == ESP_OK; i++) {
+        fram_ring_packed_header_t hdr;
+        fram_ring_make_packed_header(ring, &hdr, ring->head_seq + i, ts_us, recs[i].payload, recs[i].len);
+        err = fram_ring_batch_put(&batch, pos, &hdr, sizeof(hdr));
+        if (err == ESP_OK) {
+            err = fram_ring_batch_put(&batch, fram_ring_advance(ring, pos, sizeof(hdr)), recs[i].payload, recs[i].len);
+        }
+        if (err == ESP_OK) {
+            err = fram_ring_batch_put(&batch, fram_ring_advance(ring, pos, sizeof(hdr) + recs[i].len),
+                                      &commit_set, sizeof(commit_set));
+        }
+        newest = pos;
+        pos = fram_ring_advance(ring, pos, FRAM_RING_PACKED_OVERHEAD + recs[i].len);
+    }
+    if (err == ESP_OK) {
+        err = fram_ring_batch_flush(&batch);
+    }
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    if (moved) {
+        ring->anchor_copy ^= 1;
+    }
+    ring->tail_off = tail_off;
+    ring->newest_off = newest;
+    ring->head_off = pos;
+    ring->used = used + total;
+    ring->count = live + count;
+    ring->head_seq += count;
+    return ESP_OK;
+}
+
+esp_err_t fram_ring_append_batch(fram_ring_t *ring, const fram_ring_rec_t *recs, size_t count) {
+    if (ring == NULL || (recs == NULL && count > 0)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!ring->ready) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    uint32_t total = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (recs[i].payload == NULL && recs[i].len > 0) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        if (recs[i].len > ring->max_payload) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+        total += FRAM_RING_PACKED_OVERHEAD + recs[i].len;
+    }
+    if (count == 0) {
+        return ESP_OK;
+    }
+    if (ring->packed ? total > ring->data_size : count > ring->capacity) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    // No device scope: the ring mutex already orders the writes, and without
+    // one they reach the I/O worker (if set) to be queued and merged.
+    esp_err_t err = fram_ring_lock(ring);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    uint64_t ts_us = fram_ring_now(ring);
+    if (ring->packed) {
+        err = fram_ring_batch_packed(ring, recs, count, total, ts_us);
+    } else {
+        err = fram_ring_batch_slots(ring, recs, count, ts_us);
+        if (err == ESP_OK) {
+            ring->head_seq += count;
+            ring->head_slot = (ring->head_slot + count) % ring->capacity;
+            ring->count = ring->count + count < ring->capacity ? ring->count + count : ring->capacity;
+            ring->tail_slot = (ring->head_slot + ring->capacity - ring->count) % ring->capacity;
+        } else if (ring->count > ring->capacity - count) {
+            // The oldest records in the batch's slots may have lost their
+            // commit bytes: stop counting them
+            ring->count = ring->capacity - count;
+            ring->tail_slot = (ring->head_slot + ring->capacity - ring->count) % ring->capacity;
+        }
+    }
+
+    fram_ring_unlock(ring);
+    return err;
+}
+
+static esp_err_t fram_ring_load_slot(fram_ring_t *ring, uint32_t slot,
+                                             void *payload, size_t *len,
+                                             uint32_t *seq, uint64_t *ts_us) {
+    fram_ring_header_t hdr;
+    esp_err_t err = fram_ring_validate_slot(ring, slot, &hdr);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    if (len) {
+        if (payload && *len < hdr.len) {
+            *len = hdr.len;
+            return ESP_ERR_INVALID_SIZE;
+        }
+        if (payload && hdr.len > 0) {
+            err = fram_pm_read(ring->pm, ring->part,
+                               fram_ring_slot_offset(ring, slot) + sizeof(fram_ring_header_t),
+                               payload, hdr.len);
+            if (err != ESP_OK) {
+                return err;
+            }
+        }
+        *len = hdr.len;
+    }
+    if (seq) {
+        *seq = hdr.seq;
+    }
+    if (ts_us) {
+        *ts_us = hdr.ts_us;
+    }
+    return ESP_OK;
+}
+
+// Packed records are read once, into a stack buffer, for validation.
+static esp_err_t fram_ring_load_record(fram_ring_t *ring, uint32_t pos,
+                                       void *payload, size_t *len,
+                                       uint32_t *seq, uint64_t *ts_us) {
+    fram_ring_packed_header_t hdr;
+    uint8_t buf[CONFIG_FRAM_RING_MAX_PAYLOAD];
+    esp_err_t err = fram_ring_validate_record(ring, pos, &hdr, buf);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    if (len) {
+        if (payload && *len < hdr.len) {
+            *len = hdr.len;
+            return ESP_ERR_INVALID_SIZE;
+        }
+        if (payload && hdr.len > 0) {
+            memcpy(payload, buf, hdr.len);
+        }
+        *len = hdr.len;
+    }
+    if (seq) {
+        *seq = hdr.seq;
+    }
+    if (ts_us) {
+        *ts_us = hdr.ts_us;
+    }
+    return ESP_OK;
+}
+
+// Validation and payload read of one slot (a byte position in packed rings)
+// in one device scope.
+static esp_err_t fram_ring_read_slot_payload(fram_ring_t *ring, uint32_t slot,
+                                             void *payload, size_t *len,
+                                             uint32_t *seq, uint64_t *ts_us) {
+    esp_err_t err = fram_pm_begin(ring->pm);
+    if (err != ESP_OK) {
+        return err;
+    }
+    if (ring->packed) {
+        err = fram_ring_load_record(ring, slot, payload, len, seq, ts_us);
+    } else {
+        err = fram_ring_load_slot(ring, slot, payload, len, seq, ts_us);
+    }
+    fram_pm_end(ring->pm);
+    return err;
+}
+
+esp_err_t fram_ring_peek_oldest(fram_ring_t *ring, void *payload, size_t *len,
+                                uint32_t *seq, uint64_t *ts_us) {
+    if (ring == NULL || len == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!ring->ready || ring->count == 0) {
+        return ESP_ERR_NOT_FOUND;
+    }
 
     esp_err_t err = fram_ring_lock(ring);
     if (err != ESP_OK) {
         return err;
     }
+    uint32_t oldest = ring->packed ? ring->tail_off : ring->tail_slot;
+    err = fram_ring_read_slot_payload(ring, oldest, payload, len, seq, ts_us);
+    fram_ring_unlock(ring);
+    return err;
+}
+
+esp_err_t fram_ring_peek_newest(fram_ring_t *ring, void *payload, size_t *len,
+                                uint32_t *seq, uint64_t *ts_us) {
+    if (ring == NULL || len == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!ring->ready || ring->count == 0) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    esp_err_t err = fram_ring_lock(ring);
+    if (err != ESP_OK) {
+        return err;
+    }
+    uint32_t newest_slot = ring->packed ? ring->newest_off
+                                        : (ring->head_slot + ring->capacity - 1) % ring->capacity;
+    err = fram_ring_read_slot_payload(ring, newest_slot, payload, len, seq, ts_us);
+    fram_ring_unlock(ring);
+    return err;
+}
+
+esp_err_t fram_ring_peek_oldest_len(fram_ring_t *ring, size_t *len) {
+    if (len == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return fram_ring_peek_oldest(ring, NULL, len, NULL, NULL);
+}
+
+esp_err_t fram_ring_peek_newest_len(fram_ring_t *ring, size_t *len) {
+    if (len == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return fram_ring_peek_newest(ring, NULL, len, NULL, NULL);
+}
+
+static uint32_t fram_ring_tail_seq(const fram_ring_t *ring) {
+    return ring->head_seq - ring->count;
+}
+
+// Sequence numbers compare modulo 2^32.
+static int32_t fram_ring_seq_diff(uint32_t a, uint32_t b) {
+    return (int32_t)(a - b);
+}
+
+// Slot of a live `seq`, or its byte position in a packed ring, found by
+// following the header chain from the tail.
+static esp_err_t fram_ring_locate(const fram_ring_t *ring, uint32_t seq, uint32_t *pos_out) {
+    uint32_t n = seq - fram_ring_tail_seq(ring);
+    if (!ring->packed) {
+        *pos_out = (ring->tail_slot + n) % ring->capacity;
+        return ESP_OK;
+    }
+
+    uint32_t pos = ring->tail_off;
+    while (n-- > 0) {
+        fram_ring_packed_header_t hdr;
+        esp_err_t err = fram_ring_read_at(ring, FRAM_PM_COPY_ANY, pos, &hdr, sizeof(hdr));
+        if (err != ESP_OK) {
+            return err;
+        }
+        if (hdr.len > ring->max_payload) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+        pos = fram_ring_advance(ring, pos, FRAM_RING_PACKED_OVERHEAD + hdr.len);
+    }
+    *pos_out = pos;
+    return ESP_OK;
+}
+
+// Header fields of the record at `pos` (a slot for fixed rings), without
+// payload or CRC check. Only used to pick records; the ones returned are
+// validated when they are read.
+static esp_err_t fram_ring_peek_header(const fram_ring_t *ring, uint32_t pos, uint64_t *ts_us, uint16_t *len) {
+    esp_err_t err;
+    if (ring->packed) {
+        fram_ring_packed_header_t hdr = {0};
+        err = fram_ring_read_at(ring, FRAM_PM_COPY_ANY, pos, &hdr, sizeof(hdr));
+        *ts_us = hdr.ts_us;
+        *len = hdr.len;
+    } else {
+        fram_ring_header_t hdr = {0};
+        err = fram_ring_read_header(ring, pos, FRAM_PM_COPY_ANY, &hdr);
+        *ts_us = hdr.ts_us;
+        *len = hdr.len;
+    }
+    if (err == ESP_OK && *len > ring->max_payload) {
+        err = ESP_ERR_INVALID_SIZE;
+    }
+    return err;
+}
+
+// First live seq with a timestamp >= ts_us, or head_seq if there is none,
+// and its position. Binary search over slot headers; packed rings walk the
+// header chain from the tail.
+static esp_err_t fram_ring_find_time(const fram_ring_t *ring, uint64_t ts_us, uint32_t *seq_out, uint32_t *pos_out) {
+    uint64_t rec_ts = 0;
+    uint16_t rec_len = 0;
+    uint32_t lo = 0;
+
+    if (!ring->packed) {
+        uint32_t hi = ring->count;
+        while (lo < hi) {
+            uint32_t mid = lo + (hi - lo) / 2;
+            esp_err_t err = fram_ring_peek_header(ring, (ring->tail_slot + mid) % ring->capacity, &rec_ts, &rec_len);
+            if (err != ESP_OK) {
+                return err;
+            }
+            if (rec_ts < ts_us) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        *seq_out = fram_ring_tail_seq(ring) + lo;
+        *pos_out = (ring->tail_slot + lo) % ring->capacity;
+        return ESP_OK;
+    }
+
+    uint32_t pos = ring->tail_off;
+    for (; lo < ring->count; lo++) {
+        esp_err_t err = fram_ring_peek_header(ring, pos, &rec_ts, &rec_len);
+        if (err != ESP_OK) {
+            return err;
+        }
+        if (rec_ts >= ts_us) {
+            break;
+        }
+        pos = fram_ring_advance(ring, pos, FRAM_RING_PACKED_OVERHEAD + rec_len);
+    }
+    *seq_out = fram_ring_tail_seq(ring) + lo;
+    *pos_out = pos;
+    return ESP_OK;
+}
 
-    uint32_t slot = ring->tail_slot;
-    uint32_t remaining = ring->count;
+// Up to `remaining` records from `slot` (a byte position in packed rings),
+// stopping before the first one stamped at or after `to_ts`.
+static esp_err_t fram_ring_iterate_run(fram_ring_t *ring, uint32_t slot, uint32_t remaining,
+                                       uint64_t to_ts, fram_ring_iter_fn cb, void *ctx) {
+    esp_err_t err = ESP_OK;
     uint8_t payload_buf[CONFIG_FRAM_RING_MAX_PAYLOAD];
 
     while (remaining > 0) {
@@ -361,21 +1254,190 @@ esp_err_t fram_ring_iterate(fram_ring_t *ring, fram_ring_iter_fn cb, void *ctx)
             // Skip if payload larger than buffer (should not happen due to max_payload check)
             break;
         }
-        if (err != ESP_OK) {
+        if (err != ESP_OK || ts_us >= to_ts) {
             break;
         }
         err = cb(seq, ts_us, payload_buf, len, ctx);
         if (err != ESP_OK) {
             break;
         }
-        slot = (slot + 1) % ring->capacity;
+        if (ring->packed) {
+            slot = fram_ring_advance(ring, slot, FRAM_RING_PACKED_OVERHEAD + len);
+        } else {
+            slot = (slot + 1) % ring->capacity;
+        }
         remaining--;
     }
+    return err;
+}
+
+esp_err_t fram_ring_iterate(fram_ring_t *ring, fram_ring_iter_fn cb, void *ctx) {
+    if (ring == NULL || cb == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!ring->ready || ring->count == 0) {
+        return ESP_OK;
+    }
+
+    esp_err_t err = fram_ring_lock(ring);
+    if (err != ESP_OK) {
+        return err;
+    }
+    uint32_t slot = ring->packed ? ring->tail_off : ring->tail_slot;
+    err = fram_ring_iterate_run(ring, slot, ring->count, UINT64_MAX, cb, ctx);
+    fram_ring_unlock(ring);
+    return err;
+}
+
+esp_err_t fram_ring_read_seq(fram_ring_t *ring, uint32_t seq, void *payload, size_t *len, uint64_t *ts_us) {
+    if (ring == NULL || len == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!ring->ready) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    esp_err_t err = fram_ring_lock(ring);
+    if (err != ESP_OK) {
+        return err;
+    }
+    if (fram_ring_seq_diff(seq, fram_ring_tail_seq(ring)) < 0 || fram_ring_seq_diff(seq, ring->head_seq) >= 0) {
+        fram_ring_unlock(ring);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    err = fram_pm_begin(ring->pm);
+    if (err != ESP_OK) {
+        fram_ring_unlock(ring);
+        return err;
+    }
+    uint32_t pos = 0;
+    uint32_t rec_seq = 0;
+    err = fram_ring_locate(ring, seq, &pos);
+    if (err == ESP_OK && ring->packed) {
+        err = fram_ring_load_record(ring, pos, payload, len, &rec_seq, ts_us);
+    } else if (err == ESP_OK) {
+        err = fram_ring_load_slot(ring, pos, payload, len, &rec_seq, ts_us);
+    }
+    if (err == ESP_OK && rec_seq != seq) {
+        err = ESP_ERR_INVALID_STATE;
+    }
+    fram_pm_end(ring->pm);
+    fram_ring_unlock(ring);
+    return err;
+}
+
+esp_err_t fram_ring_seek_time(fram_ring_t *ring, uint64_t ts_us, uint32_t *seq) {
+    if (ring == NULL || seq == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!ring->ready) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    esp_err_t err = fram_ring_lock(ring);
+    if (err != ESP_OK) {
+        return err;
+    }
+    err = fram_pm_begin(ring->pm);
+    if (err == ESP_OK) {
+        uint32_t pos = 0;
+        err = fram_ring_find_time(ring, ts_us, seq, &pos);
+        fram_pm_end(ring->pm);
+    }
+    if (err == ESP_OK && *seq == ring->head_seq) {
+        err = ESP_ERR_NOT_FOUND;
+    }
+    fram_ring_unlock(ring);
+    return err;
+}
+
+esp_err_t fram_ring_iterate_range(fram_ring_t *ring, uint32_t from_seq, uint32_t to_seq,
+                                  fram_ring_iter_fn cb, void *ctx) {
+    if (ring == NULL || cb == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!ring->ready || ring->count == 0) {
+        return ESP_OK;
+    }
+
+    esp_err_t err = fram_ring_lock(ring);
+    if (err != ESP_OK) {
+        return err;
+    }
+    uint32_t tail_seq = fram_ring_tail_seq(ring);
+    from_seq = fram_ring_seq_diff(from_seq, tail_seq) > 0 ? from_seq : tail_seq;
+    if (to_seq == UINT32_MAX || fram_ring_seq_diff(to_seq, ring->head_seq) > 0) {
+        to_seq = ring->head_seq;
+    }
+    uint32_t slot = 0;
+    if (fram_ring_seq_diff(from_seq, to_seq) < 0) {
+        err = fram_pm_begin(ring->pm);
+        if (err == ESP_OK) {
+            err = fram_ring_locate(ring, from_seq, &slot);
+            fram_pm_end(ring->pm);
+        }
+        if (err == ESP_OK) {
+            err = fram_ring_iterate_run(ring, slot, to_seq - from_seq, UINT64_MAX, cb, ctx);
+        }
+    }
+    fram_ring_unlock(ring);
+    return err;
+}
+
+esp_err_t fram_ring_iterate_time(fram_ring_t *ring, uint64_t from_ts, uint64_t to_ts,
+                                 fram_ring_iter_fn cb, void *ctx) {
+    if (ring == NULL || cb == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!ring->ready || ring->count == 0 || from_ts >= to_ts) {
+        return ESP_OK;
+    }
 
+    esp_err_t err = fram_ring_lock(ring);
+    if (err != ESP_OK) {
+        return err;
+    }
+    uint32_t seq = 0;
+    uint32_t slot = 0;
+    err = fram_pm_begin(ring->pm);
+    if (err == ESP_OK) {
+        err = fram_ring_find_time(ring, from_ts, &seq, &slot);
+        fram_pm_end(ring->pm);
+    }
+    if (err == ESP_OK && seq != ring->head_seq) {
+        err = fram_ring_iterate_run(ring, slot, ring->head_seq - seq, to_ts, cb, ctx);
+    }
     fram_ring_unlock(ring);
     return err;
 }
 
+// Logical clear: zero the commit byte of every live slot, oldest first and
+// FRAM_VEC_MAX slots per transfer. Slots outside the live run are already
+// invalid or hold entries older than the tail, so they stay unreachable.
+static esp_err_t fram_ring_invalidate_live(fram_ring_t *ring) {
+    const uint8_t commit_clear = 0x00;
+    fram_wvec_t vec[FRAM_VEC_MAX];
+    uint32_t done = 0;
+
+    while (done < ring->count) {
+        size_t n = 0;
+        while (n < FRAM_VEC_MAX && done < ring->count) {
+            uint32_t slot = (ring->tail_slot + done) % ring->capacity;
+            vec[n].offset = fram_ring_slot_offset(ring, slot) + sizeof(fram_ring_header_t) + ring->max_payload;
+            vec[n].buf = &commit_clear;
+            vec[n].len = sizeof(commit_clear);
+            n++;
+            done++;
+        }
+        esp_err_t err = fram_pm_writev(ring->pm, ring->part, vec, n);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+    return ESP_OK;
+}
+
 esp_err_t fram_ring_clear(fram_ring_t *ring) {
     if (ring == NULL) {
         return ESP_ERR_INVALID_ARG;
@@ -389,12 +1451,41 @@ esp_err_t fram_ring_clear(fram_ring_t *ring) {
         return err;
     }
 
-    err = fram_pm_erase(ring->pm, ring->part);
-    if (err == ESP_OK) {
-        ring->head_slot = 0;
-        ring->tail_slot = 0;
-        ring->head_seq = 0;
-        ring->count = 0;
+    if (ring->packed && ring->logical_clear) {
+        // Anchoring the tail at the head empties the chain
+        fram_ring_anchor_t anchor;
+        fram_ring_make_anchor(&anchor, ring->head_off, ring->head_seq);
+        // Unstaged, so the clear is durable when this returns
+        const fram_wvec_t vec = { .offset = ring->anchor_copy * sizeof(anchor), .buf = &anchor, .len = sizeof(anchor) };
+        err = fram_pm_writev(ring->pm, ring->part, &vec, 1);
+        if (err == ESP_OK) {
+            ring->anchor_copy ^= 1;
+            ring->tail_off = ring->head_off;
+            ring->newest_off = ring->head_off;
+            ring->used = 0;
+            ring->count = 0;
+        }
+    } else if (ring->logical_clear) {
+        err = fram_ring_invalidate_live(ring);
+        if (err == ESP_OK) {
+            // head_slot and head_seq carry on, so the first new entry is
+            // preceded by an invalidated slot and recovery stops there.
+            ring->tail_slot = ring->head_slot;
+            ring->count = 0;
+        }
+    } else {
+        err = fram_pm_erase(ring->pm, ring->part);
+        if (err == ESP_OK) {
+            ring->head_slot = 0;
+            ring->tail_slot = 0;
+            ring->head_seq = 0;
+            ring->count = 0;
+            ring->head_off = 0;
+            ring->tail_off = 0;
+            ring->newest_off = 0;
+            ring->used = 0;
+            ring->anchor_copy = 0;
+        }
     }
 
     fram_ring_unlock(ring);
@@ -410,9 +1501,273 @@ uint32_t fram_ring_capacity(const fram_ring_t *ring) {
 }
 
 bool fram_ring_is_full(const fram_ring_t *ring) {
+    if (ring && ring->packed) {
+        return ring->used + ring->entry_size > ring->data_size;
+    }
     return ring && ring->count == ring->capacity;
 }
 
 bool fram_ring_is_empty(const fram_ring_t *ring) {
     return ring == NULL || ring->count == 0;
 }
+
+// Consumer cursors.
+
+// Where a consumer at `seq` resumes: the oldest record if `seq` was
+// overwritten or cleared, or is ahead of the head because numbering
+// restarted.
+static uint32_t fram_ring_cursor_clamp(const fram_ring_t *ring, uint32_t seq) {
+    uint32_t tail_seq = fram_ring_tail_seq(ring);
+    if (fram_ring_seq_diff(seq, tail_seq) < 0 || fram_ring_seq_diff(seq, ring->head_seq) > 0) {
+        return tail_seq;
+    }
+    return seq;
+}
+
+static int fram_ring_cursor_find(const fram_ring_cursor_store_t *store, const char *name) {
+    for (int i = 0; i < CONFIG_FRAM_RING_MAX_CURSORS; i++) {
+        if (store->recs[i].name[0] != '\0' &&
+            strncmp(store->recs[i].name, name, FRAM_RING_CURSOR_NAME_LEN) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Saves the table with entry `index` replaced by `rec`; RAM is only updated
+// once the save has gone through.
+static esp_err_t fram_ring_cursor_save(fram_ring_cursor_store_t *store, uint32_t index,
+                                       const fram_ring_cursor_rec_t *rec) {
+    fram_ring_cursor_rec_t recs[CONFIG_FRAM_RING_MAX_CURSORS];
+    memcpy(recs, store->recs, sizeof(recs));
+    recs[index] = *rec;
+    esp_err_t err = fram_vslot_save(store->vs, recs, sizeof(recs));
+    if (err == ESP_OK) {
+        store->recs[index] = *rec;
+    }
+    return err;
+}
+
+esp_err_t fram_ring_cursor_store_init(fram_ring_cursor_store_t *store, fram_ring_t *ring, fram_vslot_t *vs) {
+    if (store == NULL || ring == NULL || vs == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!ring->ready) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (vs->max_payload < sizeof(store->recs)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    memset(store, 0, sizeof(*store));
+    store->ring = ring;
+    store->vs = vs;
+
+    // A table saved with fewer entries loads into the front of this one
+    size_t len = sizeof(store->recs);
+    esp_err_t err = fram_vslot_load(vs, store->recs, &len);
+    if (err == ESP_ERR_NOT_FOUND) {
+        return ESP_OK;
+    }
+    if (err != ESP_OK) {
+        memset(store->recs, 0, sizeof(store->recs));
+        return err;
+    }
+    for (int i = 0; i < CONFIG_FRAM_RING_MAX_CURSORS; i++) {
+        store->recs[i].name[FRAM_RING_CURSOR_NAME_LEN - 1] = '\0';
+    }
+    return ESP_OK;
+}
+
+esp_err_t fram_ring_cursor_open(fram_ring_cursor_store_t *store, const char *name, fram_ring_cursor_t *cur) {
+    if (store == NULL || store->ring == NULL || name == NULL || cur == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    size_t name_len = strlen(name);
+    if (name_len == 0 || name_len >= FRAM_RING_CURSOR_NAME_LEN) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    fram_ring_t *ring = store->ring;
+    esp_err_t err = fram_ring_lock(ring);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    int index = fram_ring_cursor_find(store, name);
+    if (index < 0) {
+        for (int i = 0; i < CONFIG_FRAM_RING_MAX_CURSORS && index < 0; i++) {
+            if (store->recs[i].name[0] == '\0') {
+                index = i;
+            }
+        }
+        if (index < 0) {
+            fram_ring_unlock(ring);
+            return ESP_ERR_NO_MEM;
+        }
+        fram_ring_cursor_rec_t rec = { .seq = fram_ring_tail_seq(ring) };
+        memcpy(rec.name, name, name_len);
+        err = fram_ring_cursor_save(store, index, &rec);
+        if (err != ESP_OK) {
+            fram_ring_unlock(ring);
+            return err;
+        }
+    }
+
+    *cur = (fram_ring_cursor_t){
+        .store = store,
+        .index = (uint32_t)index,
+        .next_seq = store->recs[index].seq,
+        .pos_valid = false,
+    };
+    fram_ring_unlock(ring);
+    return ESP_OK;
+}
+
+esp_err_t fram_ring_cursor_delete(fram_ring_cursor_store_t *store, const char *name) {
+    if (store == NULL || store->ring == NULL || name == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t err = fram_ring_lock(store->ring);
+    if (err != ESP_OK) {
+        return err;
+    }
+    int index = fram_ring_cursor_find(store, name);
+    if (index < 0) {
+        err = ESP_ERR_NOT_FOUND;
+    } else {
+        const fram_ring_cursor_rec_t rec = {0};
+        err = fram_ring_cursor_save(store, index, &rec);
+    }
+    fram_ring_unlock(store->ring);
+    return err;
+}
+
+// The cached position of a packed cursor is checked against the seq of the
+// record found there; if a clear() made it stale, the chain is walked again.
+esp_err_t fram_ring_read_next(fram_ring_cursor_t *cur, void *payload, size_t *len,
+                              uint32_t *seq, uint64_t *ts_us) {
+    if (cur == NULL || cur->store == NULL || len == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    fram_ring_t *ring = cur->store->ring;
+    if (!ring->ready) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    esp_err_t err = fram_ring_lock(ring);
+    if (err != ESP_OK) {
+        return err;
+    }
+    uint32_t next = fram_ring_cursor_clamp(ring, cur->next_seq);
+    if (next == ring->head_seq) {
+        fram_ring_unlock(ring);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    err = fram_pm_begin(ring->pm);
+    if (err != ESP_OK) {
+        fram_ring_unlock(ring);
+        return err;
+    }
+    bool cached = ring->packed && cur->pos_valid && next == cur->next_seq;
+    uint32_t pos = cur->next_pos;
+    uint32_t rec_seq = 0;
+    for (int attempt = 0; attempt < 2; attempt++) {
+        if (!cached) {
+            err = fram_ring_locate(ring, next, &pos);
+            if (err != ESP_OK) {
+                break;
+            }
+        }
+        if (ring->packed) {
+            err = fram_ring_load_record(ring, pos, payload, len, &rec_seq, ts_us);
+        } else {
+            err = fram_ring_load_slot(ring, pos, payload, len, &rec_seq, ts_us);
+        }
+        if (err == ESP_OK && rec_seq != next) {
+            err = ESP_ERR_INVALID_STATE;
+        }
+        if (err == ESP_OK || !cached) {
+            break;
+        }
+        cached = false;
+    }
+    fram_pm_end(ring->pm);
+
+    if (err == ESP_OK) {
+        cur->next_seq = next + 1;
+        cur->next_pos = ring->packed ? fram_ring_advance(ring, pos, FRAM_RING_PACKED_OVERHEAD + *len) : 0;
+        cur->pos_valid = ring->packed;
+        if (seq) {
+            *seq = rec_seq;
+        }
+    }
+    fram_ring_unlock(ring);
+    return err;
+}
+
+esp_err_t fram_ring_ack(fram_ring_cursor_t *cur, uint32_t seq) {
+    if (cur == NULL || cur->store == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    fram_ring_cursor_store_t *store = cur->store;
+    fram_ring_t *ring = store->ring;
+
+    esp_err_t err = fram_ring_lock(ring);
+    if (err != ESP_OK) {
+        return err;
+    }
+    uint32_t next = seq + 1;
+    uint32_t acked = store->recs[cur->index].seq;
+    if (fram_ring_seq_diff(next, ring->head_seq) > 0) {
+        err = ESP_ERR_INVALID_ARG;
+    } else if (fram_ring_seq_diff(next, acked) > 0 || fram_ring_seq_diff(acked, ring->head_seq) > 0) {
+        fram_ring_cursor_rec_t rec = store->recs[cur->index];
+        rec.seq = next;
+        err = fram_ring_cursor_save(store, cur->index, &rec);
+        if (err == ESP_OK && fram_ring_seq_diff(cur->next_seq, next) < 0) {
+            cur->next_seq = next;
+            cur->pos_valid = false;
+        }
+    }
+    fram_ring_unlock(ring);
+    return err;
+}
+
+esp_err_t fram_ring_cursor_rewind(fram_ring_cursor_t *cur) {
+    if (cur == NULL || cur->store == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    esp_err_t err = fram_ring_lock(cur->store->ring);
+    if (err != ESP_OK) {
+        return err;
+    }
+    cur->next_seq = cur->store->recs[cur->index].seq;
+    cur->pos_valid = false;
+    fram_ring_unlock(cur->store->ring);
+    return ESP_OK;
+}
+
+esp_err_t fram_ring_cursor_lag(fram_ring_cursor_t *cur, uint32_t *pending, uint32_t *lost) {
+    if (cur == NULL || cur->store == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    fram_ring_t *ring = cur->store->ring;
+    esp_err_t err = fram_ring_lock(ring);
+    if (err != ESP_OK) {
+        return err;
+    }
+    uint32_t acked = cur->store->recs[cur->index].seq;
+    uint32_t tail_seq = fram_ring_tail_seq(ring);
+    uint32_t from = fram_ring_cursor_clamp(ring, acked);
+    if (pending) {
+        *pending = ring->head_seq - from;
+    }
+    if (lost) {
+        *lost = fram_ring_seq_diff(acked, tail_seq) < 0 ? tail_seq - acked : 0;
+    }
+    fram_ring_unlock(ring);
+    return ESP_OK;
+}
@@ -0,0 +1,313 @@
+#include "fram/fram_stage.h"
+
+#if CONFIG_FRAM_STAGE_ENABLED
+
+#include "esp_attr.h"
+#include "esp_check.h"
+#include <string.h>
+
+#define TAG "fram_stage"
+
+// Every record starts on a 4-byte boundary with a header word: payload
+// length in the low 16 bits plus flags. Drained space is zeroed, so a word
+// without FRAM_STAGE_COMMIT is a reservation still being filled. A record
+// that would run past the end of the buffer is preceded by a pad record up
+// to the end.
+#define FRAM_STAGE_HDR sizeof(uint32_t)
+#define FRAM_STAGE_MASK (FRAM_STAGE_SIZE - 1)
+#define FRAM_STAGE_COMMIT 0x80000000u
+#define FRAM_STAGE_PAD 0x40000000u
+#define FRAM_STAGE_LEN_MASK 0xFFFFu
+#define FRAM_STAGE_DEFAULT_PERIOD_MS 100
+#define FRAM_STAGE_DRAIN_BATCH 16
+
+#define FRAM_STAGE_STAT_ADD(field, n) __atomic_fetch_add(&(field), (n), __ATOMIC_RELAXED)
+#define FRAM_STAGE_STAT_GET(field) __atomic_load_n(&(field), __ATOMIC_RELAXED)
+#define FRAM_STAGE_STAT_CLEAR(field) __atomic_store_n(&(field), 0, __ATOMIC_RELAXED)
+
+static inline uint32_t fram_stage_span(uint32_t len) {
+    return FRAM_STAGE_HDR + ((len + 3) & ~3u);
+}
+
+static inline uint32_t *fram_stage_word(fram_stage_t *stage, uint32_t pos) {
+    return (uint32_t *)(stage->buf + (pos & FRAM_STAGE_MASK));
+}
+
+static void IRAM_ATTR fram_stage_high_water(fram_stage_t *stage, uint32_t used) {
+    uint32_t cur = __atomic_load_n(&stage->stats.high_water, __ATOMIC_RELAXED);
+    while (used > cur && !__atomic_compare_exchange_n(&stage->stats.high_water, &cur, used, true, __ATOMIC_RELAXED,
+                                                      __ATOMIC_RELAXED)) {
+    }
+}
+
+static void IRAM_ATTR fram_stage_wake(fram_stage_t *stage) {
+    if (stage->task == NULL) {
+        return;
+    }
+    uint32_t used = __atomic_load_n(&stage->head, __ATOMIC_RELAXED) - __atomic_load_n(&stage->tail, __ATOMIC_RELAXED);
+    if (used < stage->wake_bytes || __atomic_exchange_n(&stage->wake_pending, 1, __ATOMIC_RELAXED) != 0) {
+        return;
+    }
+    if (xPortInIsrContext()) {
+        BaseType_t woken = pdFALSE;
+        xSemaphoreGiveFromISR(stage->wake, &woken);
+        portYIELD_FROM_ISR(woken);
+    } else {
+        xSemaphoreGive(stage->wake);
+    }
+}
+
+esp_err_t IRAM_ATTR fram_stage_reserve(fram_stage_t *stage, size_t len, void **buf) {
+    if (stage == NULL || buf == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (len > stage->max_record) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    uint32_t need = fram_stage_span((uint32_t)len);
+    uint32_t head = __atomic_load_n(&stage->head, __ATOMIC_RELAXED);
+    uint32_t pad;
+    uint32_t total;
+    for (;;) {
+        pad = FRAM_STAGE_SIZE - (head & FRAM_STAGE_MASK);
+        if (pad >= need) {
+            pad = 0;
+        }
+        total = pad + need;
+        uint32_t tail = __atomic_load_n(&stage->tail, __ATOMIC_ACQUIRE);
+        if (head + total - tail > FRAM_STAGE_SIZE) {
+            FRAM_STAGE_STAT_ADD(stage->stats.dropped, 1);
+            FRAM_STAGE_STAT_ADD(stage->stats.dropped_bytes, (uint32_t)len);
+            return ESP_ERR_NO_MEM;
+        }
+        if (__atomic_compare_exchange_n(&stage->head, &head, head + total, true, __ATOMIC_ACQ_REL,
+                                        __ATOMIC_RELAXED)) {
+            fram_stage_high_water(stage, head + total - tail);
+            break;
+        }
+    }
+
+    if (pad > 0) {
+        __atomic_store_n(fram_stage_word(stage, head), FRAM_STAGE_COMMIT | FRAM_STAGE_PAD | pad, __ATOMIC_RELEASE);
+    }
+    uint32_t *hdr = fram_stage_word(stage, head + pad);
+    __atomic_store_n(hdr, (uint32_t)len, __ATOMIC_RELAXED);
+    *buf = hdr + 1;
+    return ESP_OK;
+}
+
+esp_err_t IRAM_ATTR fram_stage_commit(fram_stage_t *stage, void *buf) {
+    if (stage == NULL || buf == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    uint8_t *p = (uint8_t *)buf;
+    if (p < stage->buf + FRAM_STAGE_HDR || p > stage->buf + FRAM_STAGE_SIZE ||
+        ((uintptr_t)p & 3) != 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    uint32_t *hdr = (uint32_t *)p - 1;
+    uint32_t prev = __atomic_fetch_or(hdr, FRAM_STAGE_COMMIT, __ATOMIC_RELEASE);
+    if (prev & FRAM_STAGE_COMMIT) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    FRAM_STAGE_STAT_ADD(stage->stats.pushed, 1);
+    fram_stage_wake(stage);
+    return ESP_OK;
+}
+
+esp_err_t IRAM_ATTR fram_stage_push(fram_stage_t *stage, const void *payload, size_t len) {
+    if (stage == NULL || (payload == NULL && len > 0)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    void *buf;
+    esp_err_t err = fram_stage_reserve(stage, len, &buf);
+    if (err != ESP_OK) {
+        return err;
+    }
+    if (len > 0) {
+        memcpy(buf, payload, len);
+    }
+    return fram_stage_commit(stage, buf);
+}
+
+// Zero the records in [tail, end) and hand their space back to producers
+static void fram_stage_release(fram_stage_t *stage, uint32_t tail, uint32_t end) {
+    while (tail != end) {
+        uint32_t *hdr = fram_stage_word(stage, tail);
+        uint32_t word = *hdr;
+        uint32_t span = (word & FRAM_STAGE_PAD) ? (word & FRAM_STAGE_LEN_MASK) : fram_stage_span(word & FRAM_STAGE_LEN_MASK);
+        memset(hdr, 0, span);
+        tail += span;
+    }
+    __atomic_store_n(&stage->tail, end, __ATOMIC_RELEASE);
+}
+
+esp_err_t fram_stage_drain(fram_stage_t *stage, size_t max, size_t *drained) {
+    if (drained) {
+        *drained = 0;
+    }
+    if (stage == NULL || stage->ring == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    // A batch larger than the ring would evict its own records
+    uint32_t batch_max = fram_ring_capacity(stage->ring);
+    if (batch_max > FRAM_STAGE_DRAIN_BATCH) {
+        batch_max = FRAM_STAGE_DRAIN_BATCH;
+    }
+
+    xSemaphoreTake(stage->drain_lock, portMAX_DELAY);
+    esp_err_t err = ESP_OK;
+    size_t n = 0;
+    uint32_t tail = stage->tail;
+    while (max == 0 || n < max) {
+        // Collect the next run of committed records, skipping pads. They stay
+        // in place until the ring has them, so the batch points into buf.
+        fram_ring_rec_t recs[FRAM_STAGE_DRAIN_BATCH];
+        size_t count = 0;
+        uint32_t end = tail;
+        uint32_t head = __atomic_load_n(&stage->head, __ATOMIC_ACQUIRE);
+        while (count < batch_max && (max == 0 || n + count < max) && end != head) {
+            uint32_t *hdr = fram_stage_word(stage, end);
+            uint32_t word = __atomic_load_n(hdr, __ATOMIC_ACQUIRE);
+            if (!(word & FRAM_STAGE_COMMIT)) {
+                break;
+            }
+            uint32_t len = word & FRAM_STAGE_LEN_MASK;
+            if (word & FRAM_STAGE_PAD) {
+                end += len;
+                continue;
+            }
+            recs[count++] = (fram_ring_rec_t){ .payload = hdr + 1, .len = len };
+            end += fram_stage_span(len);
+        }
+        if (count == 0) {
+            fram_stage_release(stage, tail, end);
+            break;
+        }
+
+        // The ring takes its lock and then the device's, like every other
+        // ring call, so a drain never holds the device while waiting
+        err = fram_ring_append_batch(stage->ring, recs, count);
+        if (err != ESP_OK) {
+            FRAM_STAGE_STAT_ADD(stage->stats.drain_errors, 1);
+            break;
+        }
+        fram_stage_release(stage, tail, end);
+        tail = end;
+        n += count;
+    }
+    xSemaphoreGive(stage->drain_lock);
+
+    FRAM_STAGE_STAT_ADD(stage->stats.drained, (uint32_t)n);
+    if (drained) {
+        *drained = n;
+    }
+    return err;
+}
+
+static void fram_stage_task(void *arg) {
+    fram_stage_t *stage = (fram_stage_t *)arg;
+    for (;;) {
+        xSemaphoreTake(stage->wake, pdMS_TO_TICKS(stage->period_ms));
+        __atomic_store_n(&stage->wake_pending, 0, __ATOMIC_RELAXED);
+        // Sampled before draining, so the last pass starts after deinit
+        bool stop = stage->stop;
+        if (fram_stage_drain(stage, 0, NULL) != ESP_OK) {
+            ESP_LOGW(TAG, "drain failed, %u bytes staged", (unsigned)fram_stage_used(stage));
+        }
+        if (stop) {
+            break;
+        }
+    }
+    xSemaphoreGive(stage->stopped);
+    vTaskDelete(NULL);
+}
+
+esp_err_t fram_stage_init(fram_stage_t *stage, const fram_stage_config_t *cfg) {
+    if (stage == NULL || cfg == NULL || cfg->ring == NULL || !cfg->ring->ready) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(stage, 0, sizeof(*stage));
+    stage->ring = cfg->ring;
+    // A quarter of the buffer keeps a record plus its wrap padding under half
+    uint32_t limit = FRAM_STAGE_SIZE / 4 - FRAM_STAGE_HDR;
+    stage->max_record = cfg->ring->max_payload < limit ? cfg->ring->max_payload : limit;
+    stage->wake_bytes = cfg->wake_bytes ? cfg->wake_bytes : FRAM_STAGE_SIZE / 2;
+    stage->period_ms = cfg->drain_period_ms ? cfg->drain_period_ms : FRAM_STAGE_DEFAULT_PERIOD_MS;
+
+    stage->drain_lock = xSemaphoreCreateMutexStatic(&stage->drain_lock_buf);
+    if (stage->drain_lock == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    if (!cfg->start_task) {
+        return ESP_OK;
+    }
+
+    stage->wake = xSemaphoreCreateBinaryStatic(&stage->wake_buf);
+    stage->stopped = xSemaphoreCreateBinaryStatic(&stage->stopped_buf);
+    if (stage->wake == NULL || stage->stopped == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    uint32_t priority = cfg->task_priority ? cfg->task_priority : CONFIG_FRAM_STAGE_TASK_PRIORITY;
+    stage->task = xTaskCreateStaticPinnedToCore(fram_stage_task, "fram_stage", sizeof(stage->stack), stage,
+                                                priority, stage->stack, &stage->task_buf, tskNO_AFFINITY);
+    if (stage->task == NULL) {
+        ESP_LOGE(TAG, "drain task create failed");
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+esp_err_t fram_stage_deinit(fram_stage_t *stage) {
+    if (stage == NULL || stage->ring == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (stage->task != NULL) {
+        stage->stop = true;
+        xSemaphoreGive(stage->wake);
+        xSemaphoreTake(stage->stopped, portMAX_DELAY);
+        stage->task = NULL;
+    } else {
+        fram_stage_drain(stage, 0, NULL);
+    }
+    if (fram_stage_used(stage) != 0) {
+        ESP_LOGW(TAG, "%u staged bytes dropped", (unsigned)fram_stage_used(stage));
+    }
+    stage->ring = NULL;
+    return ESP_OK;
+}
+
+uint32_t fram_stage_used(const fram_stage_t *stage) {
+    if (stage == NULL) {
+        return 0;
+    }
+    return __atomic_load_n(&stage->head, __ATOMIC_ACQUIRE) - __atomic_load_n(&stage->tail, __ATOMIC_ACQUIRE);
+}
+
+void fram_stage_get_stats(const fram_stage_t *stage, fram_stage_stats_t *stats) {
+    if (stage == NULL || stats == NULL) {
+        return;
+    }
+    stats->pushed = FRAM_STAGE_STAT_GET(stage->stats.pushed);
+    stats->dropped = FRAM_STAGE_STAT_GET(stage->stats.dropped);
+    stats->dropped_bytes = FRAM_STAGE_STAT_GET(stage->stats.dropped_bytes);
+    stats->drained = FRAM_STAGE_STAT_GET(stage->stats.drained);
+    stats->drain_errors = FRAM_STAGE_STAT_GET(stage->stats.drain_errors);
+    stats->high_water = FRAM_STAGE_STAT_GET(stage->stats.high_water);
+}
+
+void fram_stage_reset_stats(fram_stage_t *stage) {
+    if (stage == NULL) {
+        return;
+    }
+    FRAM_STAGE_STAT_CLEAR(stage->stats.pushed);
+    FRAM_STAGE_STAT_CLEAR(stage->stats.dropped);
+    FRAM_STAGE_STAT_CLEAR(stage->stats.dropped_bytes);
+    FRAM_STAGE_STAT_CLEAR(stage->stats.drained);
+    FRAM_STAGE_STAT_CLEAR(stage->stats.drain_errors);
+    FRAM_STAGE_STAT_CLEAR(stage->stats.high_water);
+}
+
+#endif // CONFIG_FRAM_STAGE_ENABLED
@@ -43,8 +43,15 @@ esp_err_t fram_superblock_read(fram_dev_t *dev, uint32_t base_offset, fram_super
     fram_superblock_t a;
     fram_superblock_t b;
 
-    esp_err_t err_a = fram_dev_read(dev, base_offset, &a, sizeof(a));
+    // Both copies in one device scope, so a concurrent write cannot land
+    // between them
+    esp_err_t err_a = fram_dev_begin(dev);
+    if (err_a != ESP_OK) {
+        return err_a;
+    }
+    err_a = fram_dev_read(dev, base_offset, &a, sizeof(a));
     esp_err_t err_b = fram_dev_read(dev, base_offset + sizeof(a), &b, sizeof(b));
+    fram_dev_end(dev);
     bool a_read_ok = (err_a == ESP_OK);
     bool b_read_ok = (err_b == ESP_OK);
 
@@ -68,19 +75,8 @@ esp_err_t fram_superblock_read(fram_dev_t *dev, uint32_t base_offset, fram_super
     return ESP_OK;
 }
 
-esp_err_t fram_superblock_write(fram_dev_t *dev, uint32_t base_offset, const fram_superblock_t *sb) {
-    if (dev == NULL || sb == NULL) {
-        return ESP_ERR_INVALID_ARG;
-    }
-
-    uint32_t dev_size = fram_dev_get_size(dev);
-    if (sb->magic != FRAM_SUPERBLOCK_MAGIC || sb->version != FRAM_SUPERBLOCK_VERSION) {
-        return ESP_ERR_INVALID_ARG;
-    }
-    if (sb->size_bytes != dev_size || sb->count > FRAM_PART_MAX) {
-        return ESP_ERR_INVALID_ARG;
-    }
-
+static esp_err_t fram_superblock_commit(fram_dev_t *dev, uint32_t base_offset,
+                                        const fram_superblock_t *sb, uint32_t dev_size) {
     fram_superblock_t a;
     fram_superblock_t b;
     bool a_valid = false;
@@ -124,9 +120,38 @@ esp_err_t fram_superblock_write(fram_dev_t *dev, uint32_t base_offset, const fra
 
     uint32_t offset = fram_superblock_offset(base_offset, target_index);
     esp_err_t err = fram_dev_write(dev, offset, &temp, sizeof(temp));
+    if (err == ESP_OK) {
+        // With write combining the commit byte would otherwise merge into
+        // the staged body and could land before it
+        err = fram_dev_barrier(dev);
+    }
     if (err != ESP_OK) {
         return err;
     }
     uint8_t commit = FRAM_SUPERBLOCK_COMMIT;
-    return fram_dev_write(dev, offset + offsetof(fram_superblock_t, commit), &commit, sizeof(commit));
+    err = fram_dev_write(dev, offset + offsetof(fram_superblock_t, commit), &commit, sizeof(commit));
+    return err == ESP_OK ? fram_dev_barrier(dev) : err;
+}
+
+esp_err_t fram_superblock_write(fram_dev_t *dev, uint32_t base_offset, const fram_superblock_t *sb) {
+    if (dev == NULL || sb == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint32_t dev_size = fram_dev_get_size(dev);
+    if (sb->magic != FRAM_SUPERBLOCK_MAGIC || sb->version != FRAM_SUPERBLOCK_VERSION) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (sb->size_bytes != dev_size || sb->count > FRAM_PART_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Pick the target copy and write it without another writer in between
+    esp_err_t err = fram_dev_begin(dev);
+    if (err != ESP_OK) {
+        return err;
+    }
+    err = fram_superblock_commit(dev, base_offset, sb, dev_size);
+    fram_dev_end(dev);
+    return err;
 }
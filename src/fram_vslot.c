@@ -15,19 +15,14 @@ static uint32_t fram_vslot_slot_offset(const fram_vslot_t *vs, uint32_t slot) {
     return slot * vs->slot_size;
 }
 
-static esp_err_t fram_vslot_read_commit(const fram_vslot_t *vs, uint32_t slot, uint8_t *commit) {
+static esp_err_t fram_vslot_read_commit(const fram_vslot_t *vs, uint32_t slot, uint32_t copy, uint8_t *commit) {
     uint32_t offset = fram_vslot_slot_offset(vs, slot) + sizeof(fram_vslot_header_t) + vs->max_payload;
-    return fram_pm_read(vs->pm, vs->part, offset, commit, sizeof(*commit));
+    return fram_pm_read_copy(vs->pm, vs->part, copy, offset, commit, sizeof(*commit));
 }
 
-static esp_err_t fram_vslot_write_commit(const fram_vslot_t *vs, uint32_t slot, uint8_t commit) {
-    uint32_t offset = fram_vslot_slot_offset(vs, slot) + sizeof(fram_vslot_header_t) + vs->max_payload;
-    return fram_pm_write(vs->pm, vs->part, offset, &commit, sizeof(commit));
-}
-
-static esp_err_t fram_vslot_read_header(const fram_vslot_t *vs, uint32_t slot, fram_vslot_header_t *hdr) {
+static esp_err_t fram_vslot_read_header(const fram_vslot_t *vs, uint32_t slot, uint32_t copy, fram_vslot_header_t *hdr) {
     uint8_t buf[sizeof(fram_vslot_header_t)];
-    esp_err_t err = fram_pm_read(vs->pm, vs->part, fram_vslot_slot_offset(vs, slot), buf, sizeof(buf));
+    esp_err_t err = fram_pm_read_copy(vs->pm, vs->part, copy, fram_vslot_slot_offset(vs, slot), buf, sizeof(buf));
     if (err != ESP_OK) {
         return err;
     }
@@ -35,15 +30,15 @@ static esp_err_t fram_vslot_read_header(const fram_vslot_t *vs, uint32_t slot, f
     return ESP_OK;
 }
 
-static esp_err_t fram_vslot_validate_slot(const fram_vslot_t *vs, uint32_t slot, fram_vslot_header_t *hdr_out) {
+static esp_err_t fram_vslot_check_slot(const fram_vslot_t *vs, uint32_t slot, uint32_t copy, fram_vslot_header_t *hdr_out) {
     uint8_t commit = 0;
-    esp_err_t err = fram_vslot_read_commit(vs, slot, &commit);
+    esp_err_t err = fram_vslot_read_commit(vs, slot, copy, &commit);
     if (err != ESP_OK || commit != FRAM_VSLOT_COMMIT) {
         return ESP_ERR_NOT_FOUND;
     }
 
     fram_vslot_header_t hdr;
-    err = fram_vslot_read_header(vs, slot, &hdr);
+    err = fram_vslot_read_header(vs, slot, copy, &hdr);
     if (err != ESP_OK) {
         return err;
     }
@@ -56,9 +51,9 @@ static esp_err_t fram_vslot_validate_slot(const fram_vslot_t *vs, uint32_t slot,
 
     uint8_t payload_buf[CONFIG_FRAM_VSLOT_MAX_PAYLOAD];
     if (hdr.len > 0) {
-        err = fram_pm_read(vs->pm, vs->part,
-                           fram_vslot_slot_offset(vs, slot) + sizeof(fram_vslot_header_t),
-                           payload_buf, hdr.len);
+        err = fram_pm_read_copy(vs->pm, vs->part, copy,
+                                fram_vslot_slot_offset(vs, slot) + sizeof(fram_vslot_header_t),
+                                payload_buf, hdr.len);
         if (err != ESP_OK) {
             return err;
         }
@@ -78,18 +73,58 @@ static esp_err_t fram_vslot_validate_slot(const fram_vslot_t *vs, uint32_t slot,
     return ESP_OK;
 }
 
-static esp_err_t fram_vslot_lock(fram_vslot_t *vs) {
+typedef struct {
+    const fram_vslot_t *vs;
+    uint32_t slot;
+    fram_vslot_header_t *hdr_out;
+} fram_vslot_check_t;
+
+static esp_err_t fram_vslot_check_copy(void *arg, uint32_t copy, size_t *len) {
+    fram_vslot_check_t *check = arg;
+    esp_err_t err = fram_vslot_check_slot(check->vs, check->slot, copy, check->hdr_out);
+    if (err == ESP_OK) {
+        *len = check->vs->slot_size;
+    }
+    return err;
+}
+
+// On redundant devices a slot that fails validation may still be intact in
+// another copy; if so the bad copy is repaired and the slot is used.
+static esp_err_t fram_vslot_validate_slot(const fram_vslot_t *vs, uint32_t slot, fram_vslot_header_t *hdr_out) {
+    esp_err_t err = fram_vslot_check_slot(vs, slot, FRAM_PM_COPY_ANY, hdr_out);
+    if (err != ESP_ERR_NOT_FOUND && err != ESP_ERR_INVALID_SIZE && err != ESP_ERR_INVALID_CRC) {
+        return err;
+    }
+    fram_vslot_check_t check = { .vs = vs, .slot = slot, .hdr_out = hdr_out };
+    if (fram_pm_recover(vs->pm, vs->part, fram_vslot_slot_offset(vs, slot),
+                        fram_vslot_check_copy, &check) != ESP_OK) {
+        return err;
+    }
+    return ESP_OK;
+}
+
+// Reads hold the device for their header, CRC and payload transfers.
+// Saves and clears are a single writev and take only the mutex, so with
+// fram_pm_set_io() they are queued to the worker rather than run inline.
+static esp_err_t fram_vslot_lock(fram_vslot_t *vs, bool scope) {
     if (vs == NULL || vs->mutex == NULL) {
         return ESP_ERR_INVALID_STATE;
     }
     if (xSemaphoreTake(vs->mutex, pdMS_TO_TICKS(CONFIG_FRAM_DEFAULT_MUTEX_TIMEOUT_MS)) != pdTRUE) {
         return ESP_ERR_TIMEOUT;
     }
-    return ESP_OK;
+    esp_err_t err = scope ? fram_pm_begin(vs->pm) : ESP_OK;
+    if (err != ESP_OK) {
+        xSemaphoreGive(vs->mutex);
+    }
+    return err;
 }
 
-static void fram_vslot_unlock(fram_vslot_t *vs) {
+static void fram_vslot_unlock(fram_vslot_t *vs, bool scope) {
     if (vs && vs->mutex) {
+        if (scope) {
+            fram_pm_end(vs->pm);
+        }
         xSemaphoreGive(vs->mutex);
     }
 }
@@ -116,6 +151,7 @@ esp_err_t fram_vslot_init(fram_vslot_t *vs, const fram_vslot_config_t *cfg) {
     vs->max_payload = cfg->max_payload;
     vs->slot_size = sizeof(fram_vslot_header_t) + vs->max_payload + 1;
     vs->magic = cfg->magic;
+    vs->logical_clear = cfg->logical_clear;
 
     if (vs->part->size < vs->slot_size * vs->slot_count) {
         return ESP_ERR_INVALID_SIZE;
@@ -126,14 +162,18 @@ esp_err_t fram_vslot_init(fram_vslot_t *vs, const fram_vslot_config_t *cfg) {
         return ESP_ERR_NO_MEM;
     }
 
+    esp_err_t err = fram_pm_begin(vs->pm);
+    if (err != ESP_OK) {
+        return err;
+    }
+
     uint32_t best_version = 0;
     uint32_t best_slot = 0;
     bool found = false;
 
     for (uint32_t slot = 0; slot < vs->slot_count; slot++) {
         fram_vslot_header_t hdr;
-        esp_err_t err = fram_vslot_validate_slot(vs, slot, &hdr);
-        if (err == ESP_OK) {
+        if (fram_vslot_validate_slot(vs, slot, &hdr) == ESP_OK) {
             if (!found || hdr.version > best_version) {
                 best_version = hdr.version;
                 best_slot = slot;
@@ -141,6 +181,7 @@ esp_err_t fram_vslot_init(fram_vslot_t *vs, const fram_vslot_config_t *cfg) {
             }
         }
     }
+    fram_pm_end(vs->pm);
 
     vs->has_data = found;
     if (found) {
@@ -170,7 +211,7 @@ esp_err_t fram_vslot_load(fram_vslot_t *vs, void *payload, size_t *len) {
         return ESP_ERR_NOT_FOUND;
     }
 
-    esp_err_t err = fram_vslot_lock(vs);
+    esp_err_t err = fram_vslot_lock(vs, true);
     if (err != ESP_OK) {
         return err;
     }
@@ -198,7 +239,7 @@ esp_err_t fram_vslot_load(fram_vslot_t *vs, void *payload, size_t *len) {
         }
     }
 
-    fram_vslot_unlock(vs);
+    fram_vslot_unlock(vs, true);
     return err;
 }
 
@@ -210,7 +251,7 @@ esp_err_t fram_vslot_save(fram_vslot_t *vs, const void *payload, size_t len) {
         return ESP_ERR_INVALID_SIZE;
     }
 
-    esp_err_t err = fram_vslot_lock(vs);
+    esp_err_t err = fram_vslot_lock(vs, false);
     if (err != ESP_OK) {
         return err;
     }
@@ -218,11 +259,8 @@ esp_err_t fram_vslot_save(fram_vslot_t *vs, const void *payload, size_t len) {
     uint32_t next_version = vs->has_data ? (vs->active_version + 1) : 1;
     uint32_t slot = vs->has_data ? ((vs->active_slot + 1) % vs->slot_count) : 0;
 
-    err = fram_vslot_write_commit(vs, slot, 0x00);
-    if (err != ESP_OK) {
-        fram_vslot_unlock(vs);
-        return err;
-    }
+    uint32_t slot_offset = fram_vslot_slot_offset(vs, slot);
+    uint32_t commit_offset = slot_offset + sizeof(fram_vslot_header_t) + vs->max_payload;
 
     fram_vslot_header_t hdr = {
         .magic = vs->magic,
@@ -238,14 +276,16 @@ esp_err_t fram_vslot_save(fram_vslot_t *vs, const void *payload, size_t len) {
     }
     hdr.crc32 = crc;
 
-    err = fram_pm_write(vs->pm, vs->part, fram_vslot_slot_offset(vs, slot), &hdr, sizeof(hdr));
-    if (err == ESP_OK && len > 0) {
-        err = fram_pm_write(vs->pm, vs->part,
-                            fram_vslot_slot_offset(vs, slot) + sizeof(hdr), payload, len);
-    }
-    if (err == ESP_OK) {
-        err = fram_vslot_write_commit(vs, slot, FRAM_VSLOT_COMMIT);
-    }
+    // Commit cleared first and set last, header + payload in between
+    const uint8_t commit_clear = 0x00;
+    const uint8_t commit_set = FRAM_VSLOT_COMMIT;
+    const fram_wvec_t vec[] = {
+        { .offset = commit_offset, .buf = &commit_clear, .len = sizeof(commit_clear) },
+        { .offset = slot_offset, .buf = &hdr, .len = sizeof(hdr) },
+        { .offset = slot_offset + sizeof(hdr), .buf = payload, .len = len },
+        { .offset = commit_offset, .buf = &commit_set, .len = sizeof(commit_set) },
+    };
+    err = fram_pm_writev(vs->pm, vs->part, vec, sizeof(vec) / sizeof(vec[0]));
 
     if (err == ESP_OK) {
         vs->active_slot = slot;
@@ -253,7 +293,7 @@ esp_err_t fram_vslot_save(fram_vslot_t *vs, const void *payload, size_t len) {
         vs->has_data = true;
     }
 
-    fram_vslot_unlock(vs);
+    fram_vslot_unlock(vs, false);
     return err;
 }
 
@@ -265,7 +305,7 @@ esp_err_t fram_vslot_peek_len(fram_vslot_t *vs, size_t *len) {
         return ESP_ERR_NOT_FOUND;
     }
 
-    esp_err_t err = fram_vslot_lock(vs);
+    esp_err_t err = fram_vslot_lock(vs, true);
     if (err != ESP_OK) {
         return err;
     }
@@ -276,7 +316,7 @@ esp_err_t fram_vslot_peek_len(fram_vslot_t *vs, size_t *len) {
         *len = hdr.len;
     }
 
-    fram_vslot_unlock(vs);
+    fram_vslot_unlock(vs, true);
     return err;
 }
 
@@ -293,18 +333,31 @@ esp_err_t fram_vslot_clear(fram_vslot_t *vs) {
         return ESP_ERR_INVALID_ARG;
     }
 
-    esp_err_t err = fram_vslot_lock(vs);
+    esp_err_t err = fram_vslot_lock(vs, false);
     if (err != ESP_OK) {
         return err;
     }
 
-    err = fram_pm_erase(vs->pm, vs->part);
+    if (vs->logical_clear) {
+        // A slot without its commit byte is never considered, so zeroing the
+        // commit bytes (one transfer, slot_count <= 3) is enough.
+        const uint8_t commit_clear = 0x00;
+        fram_wvec_t vec[FRAM_VEC_MAX];
+        for (uint32_t slot = 0; slot < vs->slot_count; slot++) {
+            vec[slot].offset = fram_vslot_slot_offset(vs, slot) + sizeof(fram_vslot_header_t) + vs->max_payload;
+            vec[slot].buf = &commit_clear;
+            vec[slot].len = sizeof(commit_clear);
+        }
+        err = fram_pm_writev(vs->pm, vs->part, vec, vs->slot_count);
+    } else {
+        err = fram_pm_erase(vs->pm, vs->part);
+    }
     if (err == ESP_OK) {
         vs->has_data = false;
         vs->active_version = 0;
         vs->active_slot = 0;
     }
 
-    fram_vslot_unlock(vs);
+    fram_vslot_unlock(vs, false);
     return err;
 }
@@ -5,9 +5,14 @@
 
 #include "unity.h"
 #include "fram/fram.h"
+#include "esp_timer.h"
 #include <stddef.h>
 #include <string.h>
 
+#if CONFIG_FRAM_HAL_FILE_ENABLED
+#include <unistd.h>
+#endif
+
 #if CONFIG_FRAM_HAL_MOCK_ENABLED
 
 #define FRAM_TEST_SIZE (32 * 1024)
@@ -108,6 +113,535 @@ TEST_CASE("fram_ring_recovery_commit_missing", "[fram]") {
     TEST_ASSERT_EQUAL_UINT32(sizeof(uint32_t), len);
 }
 
+TEST_CASE("fram_ring_head_hint_mount", "[fram]") {
+    fram_ring_t ring;
+    fram_ring_config_t cfg = {
+        .pm = &s_pm,
+        .partition_name = "ring",
+        .max_payload = 16,
+        .magic = 0x52494E47,
+        .hint_interval = 4,
+    };
+    TEST_ASSERT_EQUAL(ESP_OK, fram_ring_init(&ring, &cfg));
+    uint32_t cap = fram_ring_capacity(&ring);
+    for (uint32_t i = 0; i < 10; i++) {
+        TEST_ASSERT_EQUAL(ESP_OK, fram_ring_append(&ring, &i, sizeof(i)));
+    }
+    TEST_ASSERT_EQUAL(ESP_OK, fram_ring_init(&ring, &cfg));
+    TEST_ASSERT_EQUAL_UINT32(10, fram_ring_count(&ring));
+
+    const uint32_t total = 2 * cap + 7;
+    for (uint32_t i = 10; i < total; i++) {
+        TEST_ASSERT_EQUAL(ESP_OK, fram_ring_append(&ring, &i, sizeof(i)));
+    }
+
+    // Hinted mount against a full scan (hint copies wiped)
+    fram_hal_mock_reset_counters(&s_hal);
+    TEST_ASSERT_EQUAL(ESP_OK, fram_ring_init(&ring, &cfg));
+    uint32_t hinted_txns = s_mock_ctx.txn_count;
+    uint8_t *raw = fram_hal_mock_get_buffer(&s_hal);
+    memset(raw + s_parts[0].offset, 0x00, ring.base);
+    fram_hal_mock_reset_counters(&s_hal);
+    TEST_ASSERT_EQUAL(ESP_OK, fram_ring_init(&ring, &cfg));
+    TEST_ASSERT_LESS_THAN(s_mock_ctx.txn_count / 4, hinted_txns);
+    TEST_ASSERT_EQUAL_UINT32(cap, fram_ring_count(&ring));
+
+    uint32_t val = 0;
+    uint32_t seq = 0;
+    size_t len = sizeof(val);
+    TEST_ASSERT_EQUAL(ESP_OK, fram_ring_init(&ring, &cfg));
+    TEST_ASSERT_EQUAL_UINT32(cap, fram_ring_count(&ring));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_ring_peek_newest(&ring, &val, &len, &seq, NULL));
+    TEST_ASSERT_EQUAL_UINT32(total - 1, val);
+    TEST_ASSERT_EQUAL_UINT32(total - 1, seq);
+    TEST_ASSERT_EQUAL(ESP_OK, fram_ring_peek_oldest(&ring, &val, &len, &seq, NULL));
+    TEST_ASSERT_EQUAL_UINT32(total - cap, val);
+
+    // Torn newest entry: the run ends one entry earlier
+    uint32_t last_slot = (ring.head_slot + cap - 1) % cap;
+    raw[s_parts[0].offset + ring.base + last_slot * ring.entry_size + sizeof(fram_ring_header_t) + ring.max_payload] = 0x00;
+    TEST_ASSERT_EQUAL(ESP_OK, fram_ring_init(&ring, &cfg));
+    TEST_ASSERT_EQUAL_UINT32(cap - 1, fram_ring_count(&ring));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_ring_peek_newest(&ring, &val, &len, &seq, NULL));
+    TEST_ASSERT_EQUAL_UINT32(total - 2, val);
+
+    // Logical clear leaves the hint pointing at a cleared slot
+    cfg.logical_clear = true;
+    TEST_ASSERT_EQUAL(ESP_OK, fram_ring_init(&ring, &cfg));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_ring_clear(&ring));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_ring_init(&ring, &cfg));
+    TEST_ASSERT_EQUAL_UINT32(0, fram_ring_count(&ring));
+    for (uint32_t i = 0; i < 6; i++) {
+        TEST_ASSERT_EQUAL(ESP_OK, fram_ring_append(&ring, &i, sizeof(i)));
+    }
+    TEST_ASSERT_EQUAL(ESP_OK, fram_ring_init(&ring, &cfg));
+    TEST_ASSERT_EQUAL_UINT32(6, fram_ring_count(&ring));
+}
+
+typedef struct {
+    uint32_t seen;
+    uint32_t next_seq;
+    bool ok;
+} ring_packed_check_t;
+
+// Mostly small events with an occasional 120-byte one
+static size_t ring_packed_len(uint32_t seq) {
+    return seq % 16 == 0 ? 120 : 6 + (seq * 37) % 35;
+}
+
+static esp_err_t ring_packed_check(uint32_t seq, uint64_t ts_us, const void *payload, size_t len, void *ctx) {
+    ring_packed_check_t *check = ctx;
+    (void)ts_us;
+    if ((check->seen > 0 && seq != check->next_seq) || len != ring_packed_len(seq) ||
+        ((const uint8_t *)payload)[len - 1] != (uint8_t)seq) {
+        check->ok = false;
+    }
+    check->seen++;
+    check->next_seq = seq + 1;
+    return ESP_OK;
+}
+
+static esp_err_t ring_packed_check_seq(uint32_t seq, uint64_t ts_us, const void *payload, size_t len, void *ctx) {
+    ring_packed_check_t *check = ctx;
+    (void)ts_us;
+    (void)payload;
+    (void)len;
+    if (check->seen > 0 && seq != check->next_seq) {
+        check->ok = false;
+    }
+    check->seen++;
+    check->next_seq = seq + 1;
+    return ESP_OK;
+}
+
+TEST_CASE("fram_ring_packed_records", "[fram]") {
+    fram_ring_t ring;
+    fram_ring_config_t cfg = {
+        .pm = &s_pm,
+        .partition_name = "ring",
+        .max_payload = 128,
+        .magic = 0x52494E47,
+    };
+    TEST_ASSERT_EQUAL(ESP_OK, fram_ring_init(&ring, &cfg));
+    uint32_t fixed_cap = fram_ring_capacity(&ring);
+
+    cfg.packed = true;
+    TEST_ASSERT_EQUAL(ESP_OK, fram_ring_init(&ring, &cfg));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_ring_clear(&ring));
+    uint8_t rec[128];
+    const uint32_t total = 400; // wraps the partition several times
+    for (uint32_t seq = 0; seq < total; seq++) {
+        memset(rec, (uint8_t)seq, sizeof(rec));
+        TEST_ASSERT_EQUAL(ESP_OK, fram_ring_append(&ring, rec, ring_packed_len(seq)));
+    }
+    uint32_t count = fram_ring_count(&ring);
+    TEST_ASSERT_GREATER_THAN(3 * fixed_cap, count);
+    TEST_ASSERT_TRUE(fram_ring_is_full(&ring));
+
+    ring_packed_check_t check = { .ok = true };
+    TEST_ASSERT_EQUAL(ESP_OK, fram_ring_iterate(&ring, ring_packed_check, &check));
+    TEST_ASSERT_TRUE(check.ok);
+    TEST_ASSERT_EQUAL_UINT32(count, check.seen);
+    TEST_ASSERT_EQUAL_UINT32(total, check.next_seq);
+
+    // Recovery follows the chain from the anchored tail
+    uint32_t newest_off = ring.newest_off;
+    TEST_ASSERT_EQUAL(ESP_OK, fram_ring_init(&ring, &cfg));
+    TEST_ASSERT_EQUAL_UINT32(count, fram_ring_count(&ring));
+    size_t len = sizeof(rec);
+    uint32_t seq = 0;
+    TEST_ASSERT_EQUAL(ESP_OK, fram_ring_peek_oldest(&ring, rec, &len, &seq, NULL));
+    TEST_ASSERT_EQUAL_UINT32(total - count, seq);
+    TEST_ASSERT_EQUAL_UINT32(ring_packed_len(seq), len);
+
+    // Missing commit on the newest record drops just that record
+    uint32_t commit_pos = (newest_off + sizeof(fram_ring_packed_header_t) + ring_packed_len(total - 1)) % ring.data_size;
+    uint8_t *raw = fram_hal_mock_get_buffer(&s_hal);
+    raw[s_parts[0].offset + ring.base + commit_pos] = 0x00;
+    TEST_ASSERT_EQUAL(ESP_OK, fram_ring_init(&ring, &cfg));
+    TEST_ASSERT_EQUAL_UINT32(count - 1, fram_ring_count(&ring));
+    len = sizeof(rec);
+    TEST_ASSERT_EQUAL(ESP_OK, fram_ring_peek_newest(&ring, rec, &len, &seq, NULL));
+    TEST_ASSERT_EQUAL_UINT32(total - 2, seq);
+
+    // Logical clear is one anchor write
+    cfg.logical_clear = true;
+    TEST_ASSERT_EQUAL(ESP_OK, fram_ring_init(&ring, &cfg));
+    fram_hal_mock_reset_counters(&s_hal);
+    TEST_ASSERT_EQUAL(ESP_OK, fram_ring_clear(&ring));
+    TEST_ASSERT_EQUAL_UINT32(2, s_mock_ctx.txn_count);
+    TEST_ASSERT_EQUAL(ESP_OK, fram_ring_init(&ring, &cfg));
+    TEST_ASSERT_EQUAL_UINT32(0, fram_ring_count(&ring));
+}
+
+TEST_CASE("fram_ring_append_batch", "[fram]") {
+    uint8_t payloads[16][24];
+    fram_ring_rec_t recs[16];
+    for (uint32_t i = 0; i < 16; i++) {
+        memset(payloads[i], (uint8_t)i, sizeof(payloads[i]));
+        recs[i] = (fram_ring_rec_t){ .payload = payloads[i], .len = ring_packed_len(i) % sizeof(payloads[i]) };
+    }
+
+    for (int packed = 0; packed < 2; packed++) {
+        fram_ring_t ring;
+        fram_ring_config_t cfg = {
+            .pm = &s_pm,
+            .partition_name = "ring",
+            .max_payload = 24,
+            .magic = 0x52494E47,
+            .packed = packed,
+        };
+        TEST_ASSERT_EQUAL(ESP_OK, fram_pm_erase(&s_pm, &s_parts[0]));
+        TEST_ASSERT_EQUAL(ESP_OK, fram_ring_init(&ring, &cfg));
+        TEST_ASSERT_EQUAL(ESP_OK, fram_ring_append(&ring, payloads[0], 4));
+
+        // 16 single appends against one batch of 16
+        fram_hal_mock_reset_counters(&s_hal);
+        for (uint32_t i = 0; i < 16; i++) {
+            TEST_ASSERT_EQUAL(ESP_OK, fram_ring_append(&ring, recs[i].payload, recs[i].len));
+        }
+        uint32_t single_txns = s_mock_ctx.txn_count;
+        fram_hal_mock_reset_counters(&s_hal);
+        TEST_ASSERT_EQUAL(ESP_OK, fram_ring_append_batch(&ring, recs, 16));
+        TEST_ASSERT_LESS_THAN(single_txns, s_mock_ctx.txn_count);
+        TEST_ASSERT_EQUAL_UINT32(33, fram_ring_count(&ring));
+
+        uint8_t out[24];
+        size_t len = sizeof(out);
+        uint32_t seq = 0;
+        TEST_ASSERT_EQUAL(ESP_OK, fram_ring_peek_newest(&ring, out, &len, &seq, NULL));
+        TEST_ASSERT_EQUAL_UINT32(32, seq);
+        TEST_ASSERT_EQUAL_UINT32(recs[15].len, len);
+        TEST_ASSERT_EQUAL_MEMORY(payloads[15], out, len);
+
+        // A failure part-way through (in the commit phase for fixed slots,
+        // after the commit clears and first staged write for packed ones)
+        // leaves a prefix
+        fram_hal_mock_reset_counters(&s_hal);
+        fram_hal_mock_set_fail_after(&s_hal, packed ? 18 : 24);
+        TEST_ASSERT_EQUAL(ESP_FAIL, fram_ring_append_batch(&ring, recs, 16));
+        s_mock_ctx.fail_enabled = false;
+        TEST_ASSERT_EQUAL(ESP_OK, fram_ring_init(&ring, &cfg));
+        uint32_t count = fram_ring_count(&ring);
+        TEST_ASSERT_TRUE(count > 33 && count < 49);
+        ring_packed_check_t check = { .ok = true };
+        TEST_ASSERT_EQUAL(ESP_OK, fram_ring_iterate(&ring, ring_packed_check_seq, &check));
+        TEST_ASSERT_TRUE(check.ok);
+        TEST_ASSERT_EQUAL_UINT32(count, check.seen);
+    }
+}
+
+TEST_CASE("fram_ring_append_batch_failure_state", "[fram]") {
+    uint8_t payload[24] = {0};
+    fram_ring_rec_t recs[4];
+    for (uint32_t i = 0; i < 4; i++) {
+        recs[i] = (fram_ring_rec_t){ .payload = payload, .len = sizeof(payload) };
+    }
+
+    for (int packed = 0; packed < 2; packed++) {
+        fram_ring_t ring;
+        fram_ring_config_t cfg = {
+            .pm = &s_pm,
+            .partition_name = "ring",
+            .max_payload = 24,
+            .magic = 0x52494E47,
+            .packed = packed,
+        };
+        TEST_ASSERT_EQUAL(ESP_OK, fram_pm_erase(&s_pm, &s_parts[0]));
+        TEST_ASSERT_EQUAL(ESP_OK, fram_ring_init(&ring, &cfg));
+        while (!fram_ring_is_full(&ring)) {
+            TEST_ASSERT_EQUAL(ESP_OK, fram_ring_append(&ring, payload, sizeof(payload)));
+        }
+        uint32_t count = fram_ring_count(&ring);
+        uint8_t out[24];
+        size_t len = sizeof(out);
+        uint32_t oldest = 0;
+        TEST_ASSERT_EQUAL(ESP_OK, fram_ring_peek_oldest(&ring, out, &len, &oldest, NULL));
+
+        // Fail once the fixed ring has cleared its commit bytes, or once the
+        // packed ring has moved its anchor
+        fram_hal_mock_reset_counters(&s_hal);
+        fram_hal_mock_set_fail_after(&s_hal, packed ? 6 : 4);
+        TEST_ASSERT_EQUAL(ESP_FAIL, fram_ring_append_batch(&ring, recs, 4));
+        s_mock_ctx.fail_enabled = false;
+        uint32_t seq = 0;
+        len = sizeof(out);
+        TEST_ASSERT_EQUAL(ESP_OK, fram_ring_peek_oldest(&ring, out, &len, &seq, NULL));
+        TEST_ASSERT_EQUAL_UINT32(packed ? oldest : oldest + 4, seq);
+        TEST_ASSERT_EQUAL_UINT32(packed ? count : count - 4, fram_ring_count(&ring));
+
+        // The next append carries on from there
+        TEST_ASSERT_EQUAL(ESP_OK, fram_ring_append_batch(&ring, recs, 4));
+        uint32_t after = fram_ring_count(&ring);
+        TEST_ASSERT_EQUAL(ESP_OK, fram_ring_init(&ring, &cfg));
+        TEST_ASSERT_EQUAL_UINT32(after, fram_ring_count(&ring));
+        ring_packed_check_t check = { .ok = true };
+        TEST_ASSERT_EQUAL(ESP_OK, fram_ring_iterate(&ring, ring_packed_check_seq, &check));
+        TEST_ASSERT_TRUE(check.ok);
+        TEST_ASSERT_EQUAL_UINT32(after, check.seen);
+    }
+}
+
+// Bytes left from an earlier lap must not pass for the commit byte of a
+// packed record the batch has not finished writing
+TEST_CASE("fram_ring_append_batch_packed_stale_commit", "[fram]") {
+    uint8_t payload[8] = {0};
+    fram_ring_rec_t recs[4];
+    for (uint32_t i = 0; i < 4; i++) {
+        recs[i] = (fram_ring_rec_t){ .payload = payload, .len = i + 1 };
+    }
+    fram_ring_t ring;
+    fram_ring_config_t cfg = {
+        .pm = &s_pm,
+        .partition_name = "ring",
+        .max_payload = 8,
+        .magic = 0x52494E47,
+        .packed = true,
+    };
+    TEST_ASSERT_EQUAL(ESP_OK, fram_pm_erase(&s_pm, &s_parts[0]));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_ring_init(&ring, &cfg));
+    uint8_t *data = s_fram_buf + s_parts[0].offset + ring.base;
+    memset(data, 0xA5, 128);
+
+    // Fail on the first staged write, after the commit clears
+    fram_hal_mock_reset_counters(&s_hal);
+    fram_hal_mock_set_fail_after(&s_hal, 5);
+    TEST_ASSERT_EQUAL(ESP_FAIL, fram_ring_append_batch(&ring, recs, 4));
+    s_mock_ctx.fail_enabled = false;
+    uint32_t pos = ring.head_off;
+    for (uint32_t i = 0; i < 4; i++) {
+        TEST_ASSERT_EQUAL_HEX8(0x00, data[pos + sizeof(fram_ring_packed_header_t) + recs[i].len]);
+        pos += FRAM_RING_PACKED_OVERHEAD + recs[i].len;
+    }
+
+    TEST_ASSERT_EQUAL(ESP_OK, fram_ring_append_batch(&ring, recs, 4));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_ring_init(&ring, &cfg));
+    TEST_ASSERT_EQUAL_UINT32(4, fram_ring_count(&ring));
+}
+
+static void ring_cursor_append(fram_ring_t *ring, uint32_t first, uint32_t n) {
+    uint8_t buf[24] = {0};
+    for (uint32_t i = first; i < first + n; i++) {
+        memcpy(buf, &i, sizeof(i));
+        TEST_ASSERT_EQUAL(ESP_OK, fram_ring_append(ring, buf, sizeof(i) + i % 20));
+    }
+}
+
+static uint32_t ring_cursor_next(fram_ring_cursor_t *cur) {
+    uint8_t buf[24];
+    size_t len = sizeof(buf);
+    uint32_t seq = 0;
+    uint32_t val = 0;
+    TEST_ASSERT_EQUAL(ESP_OK, fram_ring_read_next(cur, buf, &len, &seq, NULL));
+    memcpy(&val, buf, sizeof(val));
+    TEST_ASSERT_EQUAL_UINT32(seq, val);
+    TEST_ASSERT_EQUAL_UINT32(sizeof(val) + val % 20, len);
+    return seq;
+}
+
+TEST_CASE("fram_ring_consumer_cursors", "[fram]") {
+    for (int packed = 0; packed < 2; packed++) {
+        fram_ring_config_t cfg = {
+            .pm = &s_pm,
+            .partition_name = "ring",
+            .max_payload = 24,
+            .magic = 0x52494E47,
+            .packed = packed,
+        };
+        fram_vslot_config_t vs_cfg = {
+            .pm = &s_pm,
+            .partition_name = "vslot",
+            .max_payload = sizeof(fram_ring_cursor_rec_t) * CONFIG_FRAM_RING_MAX_CURSORS,
+            .slot_count = 2,
+            .magic = 0x43555253,
+        };
+        TEST_ASSERT_EQUAL(ESP_OK, fram_pm_erase(&s_pm, &s_parts[0]));
+        TEST_ASSERT_EQUAL(ESP_OK, fram_pm_erase(&s_pm, &s_parts[1]));
+
+        fram_ring_t ring;
+        fram_vslot_t vs;
+        fram_ring_cursor_store_t store;
+        fram_ring_cursor_t uplink;
+        fram_ring_cursor_t stats;
+        TEST_ASSERT_EQUAL(ESP_OK, fram_ring_init(&ring, &cfg));
+        TEST_ASSERT_EQUAL(ESP_OK, fram_vslot_init(&vs, &vs_cfg));
+        TEST_ASSERT_EQUAL(ESP_OK, fram_ring_cursor_store_init(&store, &ring, &vs));
+        TEST_ASSERT_EQUAL(ESP_OK, fram_ring_cursor_open(&store, "uplink", &uplink));
+        TEST_ASSERT_EQUAL(ESP_OK, fram_ring_cursor_open(&store, "stats", &stats));
+
+        // Independent progress; only acks persist
+        ring_cursor_append(&ring, 0, 10);
+        for (uint32_t i = 0; i < 5; i++) {
+            TEST_ASSERT_EQUAL_UINT32(i, ring_cursor_next(&uplink));
+        }
+        TEST_ASSERT_EQUAL(ESP_OK, fram_ring_ack(&uplink, 4));
+        TEST_ASSERT_EQUAL_UINT32(5, ring_cursor_next(&uplink));
+        TEST_ASSERT_EQUAL_UINT32(6, ring_cursor_next(&uplink));
+        TEST_ASSERT_EQUAL(ESP_OK, fram_ring_cursor_rewind(&uplink));
+        TEST_ASSERT_EQUAL_UINT32(5, ring_cursor_next(&uplink));
+        for (uint32_t i = 0; i < 10; i++) {
+            TEST_ASSERT_EQUAL_UINT32(i, ring_cursor_next(&stats));
+        }
+        size_t len = 0;
+        TEST_ASSERT_EQUAL(ESP_ERR_NOT_FOUND, fram_ring_read_next(&stats, NULL, &len, NULL, NULL));
+        TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, fram_ring_ack(&stats, 10));
+        TEST_ASSERT_EQUAL(ESP_OK, fram_ring_ack(&stats, 9));
+
+        uint32_t pending = 0;
+        uint32_t lost = 0;
+        TEST_ASSERT_EQUAL(ESP_OK, fram_ring_cursor_lag(&uplink, &pending, &lost));
+        TEST_ASSERT_EQUAL_UINT32(5, pending);
+        TEST_ASSERT_EQUAL_UINT32(0, lost);
+        TEST_ASSERT_EQUAL(ESP_OK, fram_ring_cursor_lag(&stats, &pending, &lost));
+        TEST_ASSERT_EQUAL_UINT32(0, pending);
+
+        // Reset: both resume after their last ack
+        TEST_ASSERT_EQUAL(ESP_OK, fram_ring_init(&ring, &cfg));
+        TEST_ASSERT_EQUAL(ESP_OK, fram_vslot_init(&vs, &vs_cfg));
+        TEST_ASSERT_EQUAL(ESP_OK, fram_ring_cursor_store_init(&store, &ring, &vs));
+        TEST_ASSERT_EQUAL(ESP_OK, fram_ring_cursor_open(&store, "uplink", &uplink));
+        TEST_ASSERT_EQUAL(ESP_OK, fram_ring_cursor_open(&store, "stats", &stats));
+        TEST_ASSERT_EQUAL_UINT32(5, ring_cursor_next(&uplink));
+        TEST_ASSERT_EQUAL(ESP_ERR_NOT_FOUND, fram_ring_read_next(&stats, NULL, &len, NULL, NULL));
+
+        // The writer laps the slow consumer; the fast one keeps up
+        uint32_t seq = 10;
+        while (fram_ring_count(&ring) == seq) {
+            ring_cursor_append(&ring, seq, 1);
+            TEST_ASSERT_EQUAL_UINT32(seq, ring_cursor_next(&stats));
+            seq++;
+        }
+        ring_cursor_append(&ring, seq, 9);
+        TEST_ASSERT_EQUAL(ESP_OK, fram_ring_cursor_lag(&uplink, &pending, &lost));
+        uint32_t tail_seq = ring.head_seq - fram_ring_count(&ring);
+        TEST_ASSERT_EQUAL_UINT32(tail_seq - 5, lost);
+        TEST_ASSERT_EQUAL_UINT32(fram_ring_count(&ring), pending);
+        TEST_ASSERT_EQUAL_UINT32(tail_seq, ring_cursor_next(&uplink));
+        TEST_ASSERT_EQUAL_UINT32(tail_seq + 1, ring_cursor_next(&uplink));
+        TEST_ASSERT_EQUAL_UINT32(seq, ring_cursor_next(&stats));
+
+        // Table full, then a slot freed
+        fram_ring_cursor_t cur;
+        TEST_ASSERT_EQUAL(ESP_OK, fram_ring_cursor_open(&store, "a", &cur));
+        TEST_ASSERT_EQUAL(ESP_OK, fram_ring_cursor_open(&store, "b", &cur));
+        TEST_ASSERT_EQUAL(ESP_ERR_NO_MEM, fram_ring_cursor_open(&store, "c", &cur));
+        TEST_ASSERT_EQUAL(ESP_OK, fram_ring_cursor_delete(&store, "a"));
+        TEST_ASSERT_EQUAL(ESP_OK, fram_ring_cursor_open(&store, "c", &cur));
+        TEST_ASSERT_EQUAL_UINT32(tail_seq, ring_cursor_next(&cur));
+
+        // An erasing clear restarts numbering; cursors start over at the tail
+        TEST_ASSERT_EQUAL(ESP_OK, fram_ring_clear(&ring));
+        TEST_ASSERT_EQUAL(ESP_ERR_NOT_FOUND, fram_ring_read_next(&stats, NULL, &len, NULL, NULL));
+        ring_cursor_append(&ring, 0, 3);
+        TEST_ASSERT_EQUAL_UINT32(0, ring_cursor_next(&stats));
+        TEST_ASSERT_EQUAL(ESP_OK, fram_ring_ack(&stats, 0));
+        TEST_ASSERT_EQUAL(ESP_OK, fram_ring_cursor_lag(&stats, &pending, &lost));
+        TEST_ASSERT_EQUAL_UINT32(2, pending);
+    }
+}
+
+static uint64_t s_ring_now_us;
+
+static uint64_t ring_test_clock(void) {
+    return s_ring_now_us;
+}
+
+TEST_CASE("fram_ring_random_access", "[fram]") {
+    for (int packed = 0; packed < 2; packed++) {
+        fram_ring_t ring;
+        fram_ring_config_t cfg = {
+            .pm = &s_pm,
+            .partition_name = "ring",
+            .max_payload = 24,
+            .magic = 0x52494E47,
+            .packed = packed,
+            .clock = ring_test_clock,
+        };
+        TEST_ASSERT_EQUAL(ESP_OK, fram_pm_erase(&s_pm, &s_parts[0]));
+        TEST_ASSERT_EQUAL(ESP_OK, fram_ring_init(&ring, &cfg));
+
+        // Record i is stamped i ms; several laps so the live run wraps
+        for (uint32_t i = 0; i < 400; i++) {
+            s_ring_now_us = i * 1000ULL;
+            ring_cursor_append(&ring, i, 1);
+        }
+        uint32_t tail_seq = 400 - fram_ring_count(&ring);
+
+        uint8_t buf[24];
+        size_t len = sizeof(buf);
+        uint64_t ts_us = 0;
+        uint32_t val = 0;
+        fram_hal_mock_reset_counters(&s_hal);
+        TEST_ASSERT_EQUAL(ESP_OK, fram_ring_read_seq(&ring, 350, buf, &len, &ts_us));
+        if (!packed) {
+            TEST_ASSERT_LESS_THAN(5, s_mock_ctx.txn_count);
+        }
+        memcpy(&val, buf, sizeof(val));
+        TEST_ASSERT_EQUAL_UINT32(350, val);
+        TEST_ASSERT_EQUAL_UINT32(sizeof(val) + 350 % 20, len);
+        TEST_ASSERT_EQUAL_UINT64(350000, ts_us);
+        len = sizeof(buf);
+        TEST_ASSERT_EQUAL(ESP_OK, fram_ring_read_seq(&ring, tail_seq, buf, &len, NULL));
+        memcpy(&val, buf, sizeof(val));
+        TEST_ASSERT_EQUAL_UINT32(tail_seq, val);
+        TEST_ASSERT_EQUAL(ESP_ERR_NOT_FOUND, fram_ring_read_seq(&ring, tail_seq - 1, buf, &len, NULL));
+        TEST_ASSERT_EQUAL(ESP_ERR_NOT_FOUND, fram_ring_read_seq(&ring, 400, buf, &len, NULL));
+
+        uint32_t seq = 0;
+        fram_hal_mock_reset_counters(&s_hal);
+        TEST_ASSERT_EQUAL(ESP_OK, fram_ring_seek_time(&ring, 350001, &seq));
+        if (!packed) {
+            TEST_ASSERT_LESS_THAN(9, s_mock_ctx.txn_count);
+        }
+        TEST_ASSERT_EQUAL_UINT32(351, seq);
+        TEST_ASSERT_EQUAL(ESP_OK, fram_ring_seek_time(&ring, 0, &seq));
+        TEST_ASSERT_EQUAL_UINT32(tail_seq, seq);
+        TEST_ASSERT_EQUAL(ESP_ERR_NOT_FOUND, fram_ring_seek_time(&ring, 400000, &seq));
+
+        ring_packed_check_t check = { .ok = true };
+        TEST_ASSERT_EQUAL(ESP_OK, fram_ring_iterate_range(&ring, 360, 370, ring_packed_check_seq, &check));
+        TEST_ASSERT_TRUE(check.ok);
+        TEST_ASSERT_EQUAL_UINT32(10, check.seen);
+        TEST_ASSERT_EQUAL_UINT32(370, check.next_seq);
+        check = (ring_packed_check_t){ .ok = true };
+        TEST_ASSERT_EQUAL(ESP_OK, fram_ring_iterate_range(&ring, 0, UINT32_MAX, ring_packed_check_seq, &check));
+        TEST_ASSERT_EQUAL_UINT32(fram_ring_count(&ring), check.seen);
+        TEST_ASSERT_EQUAL_UINT32(400, check.next_seq);
+
+        check = (ring_packed_check_t){ .ok = true };
+        TEST_ASSERT_EQUAL(ESP_OK, fram_ring_iterate_time(&ring, 379500, 389000, ring_packed_check_seq, &check));
+        TEST_ASSERT_TRUE(check.ok);
+        TEST_ASSERT_EQUAL_UINT32(9, check.seen);
+        TEST_ASSERT_EQUAL_UINT32(389, check.next_seq);
+
+        // Bounds still hold once seq wraps past 2^32
+        TEST_ASSERT_EQUAL(ESP_OK, fram_ring_clear(&ring));
+        ring.head_seq = UINT32_MAX - 2;
+        for (uint32_t i = UINT32_MAX - 2; i != 3; i++) {
+            TEST_ASSERT_EQUAL(ESP_OK, fram_ring_append(&ring, &i, sizeof(i)));
+        }
+        len = sizeof(buf);
+        TEST_ASSERT_EQUAL(ESP_OK, fram_ring_read_seq(&ring, UINT32_MAX, buf, &len, NULL));
+        memcpy(&val, buf, sizeof(val));
+        TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, val);
+        TEST_ASSERT_EQUAL(ESP_OK, fram_ring_read_seq(&ring, 1, buf, &len, NULL));
+        memcpy(&val, buf, sizeof(val));
+        TEST_ASSERT_EQUAL_UINT32(1, val);
+        TEST_ASSERT_EQUAL(ESP_ERR_NOT_FOUND, fram_ring_read_seq(&ring, UINT32_MAX - 3, buf, &len, NULL));
+        TEST_ASSERT_EQUAL(ESP_ERR_NOT_FOUND, fram_ring_read_seq(&ring, 3, buf, &len, NULL));
+        check = (ring_packed_check_t){ .ok = true };
+        TEST_ASSERT_EQUAL(ESP_OK, fram_ring_iterate_range(&ring, UINT32_MAX - 1, 2, ring_packed_check_seq, &check));
+        TEST_ASSERT_TRUE(check.ok);
+        TEST_ASSERT_EQUAL_UINT32(4, check.seen);
+        TEST_ASSERT_EQUAL_UINT32(2, check.next_seq);
+        check = (ring_packed_check_t){ .ok = true };
+        TEST_ASSERT_EQUAL(ESP_OK, fram_ring_iterate_range(&ring, UINT32_MAX - 10, UINT32_MAX, ring_packed_check_seq,
+                                                          &check));
+        TEST_ASSERT_EQUAL_UINT32(6, check.seen);
+        TEST_ASSERT_EQUAL_UINT32(3, check.next_seq);
+    }
+}
+
 TEST_CASE("fram_vslot_recovery_commit_missing", "[fram]") {
     fram_vslot_t vs;
     fram_vslot_config_t cfg = {
@@ -185,6 +719,1572 @@ TEST_CASE("fram_kvs_crc_stop_and_len", "[fram]") {
     TEST_ASSERT_EQUAL_UINT32(3, val_len);
 }
 
+typedef struct {
+    uint32_t calls;
+    uint32_t order[4];
+    esp_err_t last_err;
+} fram_async_log_t;
+
+static fram_async_log_t s_async_log;
+
+static void async_done(fram_hal_t *hal, esp_err_t err, void *arg) {
+    (void)hal;
+    if (s_async_log.calls < 4) {
+        s_async_log.order[s_async_log.calls] = (uint32_t)(uintptr_t)arg;
+    }
+    s_async_log.calls++;
+    s_async_log.last_err = err;
+}
+
+TEST_CASE("fram_dev_async_queue_and_wait", "[fram]") {
+    memset(&s_async_log, 0, sizeof(s_async_log));
+    static const uint8_t pattern[16] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16 };
+    uint8_t readback[16] = {0};
+
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_write_async(&s_dev, 0x100, pattern, sizeof(pattern),
+                                                   async_done, (void *)1));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_read_async(&s_dev, 0x100, readback, sizeof(readback),
+                                                  async_done, (void *)2));
+    // Nothing is retired until wait
+    TEST_ASSERT_EQUAL_UINT32(0, s_async_log.calls);
+
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_async_wait(&s_dev, 100));
+    TEST_ASSERT_EQUAL_UINT32(2, s_async_log.calls);
+    TEST_ASSERT_EQUAL_UINT32(1, s_async_log.order[0]);
+    TEST_ASSERT_EQUAL_UINT32(2, s_async_log.order[1]);
+    TEST_ASSERT_EQUAL(ESP_OK, s_async_log.last_err);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(pattern, readback, sizeof(pattern));
+
+    // A synchronous access completes anything still queued first
+    uint8_t one = 0xA5;
+    uint8_t check = 0;
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_write_async(&s_dev, 0x200, &one, 1, async_done, (void *)3));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_read_u8(&s_dev, 0x200, &check));
+    TEST_ASSERT_EQUAL_UINT32(3, s_async_log.calls);
+    TEST_ASSERT_EQUAL_HEX8(0xA5, check);
+
+    // Out-of-range submissions fail without a callback
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_SIZE, fram_dev_read_async(&s_dev, FRAM_TEST_SIZE - 4, readback, 8,
+                                                                async_done, (void *)4));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_async_wait(&s_dev, 100));
+    TEST_ASSERT_EQUAL_UINT32(3, s_async_log.calls);
+}
+
+typedef struct {
+    const char *name;
+    uint8_t rdid[FRAM_CHIP_RDID_LEN];
+    uint8_t rdid_len;
+    uint32_t size_bytes;
+    uint8_t addr_bytes;
+} fram_rdid_case_t;
+
+TEST_CASE("fram_chip_identify_rdid", "[fram]") {
+    static const fram_rdid_case_t cases[] = {
+        { "FM25V01A",   { 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0xC2, 0x21, 0x08 }, 9, 16 * 1024, 2 },
+        { "FM25V02A",   { 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0xC2, 0x22, 0x08 }, 9, 32 * 1024, 2 },
+        { "FM25V05",    { 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0xC2, 0x23, 0x00 }, 9, 64 * 1024, 2 },
+        { "FM25V10",    { 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0xC2, 0x24, 0x00 }, 9, 128 * 1024, 3 },
+        { "FM25V20A",   { 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0xC2, 0x25, 0x08 }, 9, 256 * 1024, 3 },
+        { "CY15B104Q",  { 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0xC2, 0x26, 0x08 }, 9, 512 * 1024, 3 },
+        { "MB85RS64V",  { 0x04, 0x7F, 0x03, 0x02 }, 4, 8 * 1024, 2 },
+        { "MB85RS512T", { 0x04, 0x7F, 0x26, 0x03 }, 4, 64 * 1024, 2 },
+        { "MB85RS1MT",  { 0x04, 0x7F, 0x27, 0x03 }, 4, 128 * 1024, 3 },
+        { "MB85RS2MT",  { 0x04, 0x7F, 0x48, 0x03 }, 4, 256 * 1024, 3 },
+        { "MB85RS4MT",  { 0x04, 0x7F, 0x49, 0x03 }, 4, 512 * 1024, 3 },
+    };
+    TEST_ASSERT_EQUAL_UINT32(sizeof(cases) / sizeof(cases[0]), fram_chip_count());
+
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        fram_dev_deinit(&s_dev);
+        fram_hal_mock_config_t cfg = {
+            .buffer = s_fram_buf,
+            .buffer_len = sizeof(s_fram_buf),
+            .size_bytes = 8 * 1024,
+            .rdid = cases[i].rdid,
+            .rdid_len = cases[i].rdid_len,
+        };
+        TEST_ASSERT_EQUAL(ESP_OK, fram_hal_mock_create(&s_hal, &s_mock_ctx, &cfg));
+        fram_dev_config_t dev_cfg = { .hal = &s_hal };
+        TEST_ASSERT_EQUAL(ESP_OK, fram_dev_init(&s_dev, &dev_cfg));
+
+        TEST_ASSERT_NOT_NULL(s_hal.chip);
+        TEST_ASSERT_EQUAL_STRING(cases[i].name, s_hal.chip->name);
+        TEST_ASSERT_EQUAL_UINT32(cases[i].size_bytes, s_hal.chip->size_bytes);
+        TEST_ASSERT_EQUAL_UINT8(cases[i].addr_bytes, s_hal.chip->addr_bytes);
+    }
+
+    // Unknown manufacturer, unknown density, truncated response
+    static const uint8_t unknown[] = { 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0xC2, 0x3F, 0x00 };
+    static const uint8_t other[] = { 0x20, 0xBA, 0x18 };
+    static const uint8_t truncated[] = { 0x7F, 0x7F, 0x7F };
+    const fram_chip_t *chip = NULL;
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_FOUND, fram_chip_identify(unknown, sizeof(unknown), &chip));
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_FOUND, fram_chip_identify(other, sizeof(other), &chip));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_SIZE, fram_chip_identify(truncated, sizeof(truncated), &chip));
+
+    // Configured size larger than the identified part
+    fram_dev_deinit(&s_dev);
+    fram_hal_mock_config_t cfg = {
+        .buffer = s_fram_buf,
+        .buffer_len = sizeof(s_fram_buf),
+        .size_bytes = sizeof(s_fram_buf),
+        .rdid = cases[6].rdid,
+        .rdid_len = cases[6].rdid_len,
+    };
+    TEST_ASSERT_EQUAL(ESP_OK, fram_hal_mock_create(&s_hal, &s_mock_ctx, &cfg));
+    fram_dev_config_t dev_cfg = { .hal = &s_hal };
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_SIZE, fram_dev_init(&s_dev, &dev_cfg));
+}
+
+static bool calib_pick(const char *map, uint32_t margin, uint32_t *delay_ns) {
+    fram_hal_spi_calib_window_t win = {0};
+    for (uint32_t i = 0; map[i]; i++) {
+        fram_hal_spi_calib_window_add(&win, i * 5, map[i] == 'P');
+    }
+    return fram_hal_spi_calib_window_pick(&win, 5, margin, delay_ns);
+}
+
+TEST_CASE("fram_hal_spi_calib_window_and_record", "[fram]") {
+    // Longest run 5..25 ns: centre 15 ns, room for two margin steps
+    uint32_t delay = 0;
+    TEST_ASSERT_TRUE(calib_pick("FPPPPPFPP", 1, &delay));
+    TEST_ASSERT_EQUAL_UINT32(15, delay);
+    TEST_ASSERT_TRUE(calib_pick("FPPPPPFPP", 2, &delay));
+    TEST_ASSERT_EQUAL_UINT32(15, delay);
+    TEST_ASSERT_FALSE(calib_pick("FPPPPPFPP", 3, &delay));
+    // Even run: the later of the two middle steps; ties go to the first run
+    TEST_ASSERT_TRUE(calib_pick("PPPPF", 1, &delay));
+    TEST_ASSERT_EQUAL_UINT32(10, delay);
+    TEST_ASSERT_TRUE(calib_pick("FPPPFPPP", 1, &delay));
+    TEST_ASSERT_EQUAL_UINT32(10, delay);
+    TEST_ASSERT_FALSE(calib_pick("FFFFFF", 0, &delay));
+    TEST_ASSERT_TRUE(calib_pick("FFPFF", 0, &delay));
+    TEST_ASSERT_EQUAL_UINT32(10, delay);
+
+    fram_hal_spi_calib_record_t rec;
+    fram_hal_spi_calib_record_make(&rec, 40000000, 15);
+    TEST_ASSERT_TRUE(fram_hal_spi_calib_record_valid(&rec, 40000000));
+    TEST_ASSERT_FALSE(fram_hal_spi_calib_record_valid(&rec, 20000000));
+    rec.input_delay_ns ^= 1;
+    TEST_ASSERT_FALSE(fram_hal_spi_calib_record_valid(&rec, 40000000));
+    fram_hal_spi_calib_record_make(&rec, 0, 0);
+    TEST_ASSERT_FALSE(fram_hal_spi_calib_record_valid(&rec, 40000000));
+}
+
+TEST_CASE("fram_dev_vectored_io", "[fram]") {
+    uint8_t hdr[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+    uint8_t body[24];
+    memset(body, 0x3C, sizeof(body));
+    const uint8_t clear = 0x00;
+    const uint8_t set = 0xA5;
+    const fram_wvec_t wv[] = {
+        { .offset = 0x232, .buf = &clear, .len = 1 },
+        { .offset = 0x200, .buf = hdr, .len = sizeof(hdr) },
+        { .offset = 0x208, .buf = body, .len = sizeof(body) },
+        { .offset = 0x220, .buf = NULL, .len = 0 },
+        { .offset = 0x232, .buf = &set, .len = 1 },
+    };
+
+    // Commit clear, header + body as one run, commit set: 3 WREN + WRITE
+    fram_hal_mock_reset_counters(&s_hal);
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_writev(&s_dev, wv, 5));
+    TEST_ASSERT_EQUAL_UINT32(6, s_mock_ctx.txn_count);
+    TEST_ASSERT_EQUAL_MEMORY(hdr, s_fram_buf + 0x200, sizeof(hdr));
+    TEST_ASSERT_EQUAL_MEMORY(body, s_fram_buf + 0x208, sizeof(body));
+    TEST_ASSERT_EQUAL_HEX8(0xA5, s_fram_buf[0x232]);
+
+    uint8_t out_hdr[8];
+    uint8_t out_body[24];
+    const fram_rvec_t rv[] = {
+        { .offset = 0x200, .buf = out_hdr, .len = sizeof(out_hdr) },
+        { .offset = 0x208, .buf = out_body, .len = sizeof(out_body) },
+    };
+    fram_hal_mock_reset_counters(&s_hal);
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_readv(&s_dev, rv, 2));
+    TEST_ASSERT_EQUAL_UINT32(1, s_mock_ctx.txn_count);
+    TEST_ASSERT_EQUAL_MEMORY(hdr, out_hdr, sizeof(hdr));
+    TEST_ASSERT_EQUAL_MEMORY(body, out_body, sizeof(body));
+
+    // A failing run stops the vector: the commit byte is never set
+    s_fram_buf[0x232] = 0xFF;
+    fram_hal_mock_reset_counters(&s_hal);
+    fram_hal_mock_set_fail_after(&s_hal, 2);
+    TEST_ASSERT_EQUAL(ESP_FAIL, fram_dev_writev(&s_dev, wv, 5));
+    TEST_ASSERT_EQUAL_HEX8(0x00, s_fram_buf[0x232]);
+    s_mock_ctx.fail_enabled = false;
+
+    const fram_wvec_t too_far = { .offset = FRAM_TEST_SIZE - 4, .buf = body, .len = 8 };
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_SIZE, fram_dev_writev(&s_dev, &too_far, 1));
+}
+
+TEST_CASE("fram_hal_mock_bus_timing", "[fram]") {
+    fram_dev_deinit(&s_dev);
+    fram_hal_mock_config_t cfg = {
+        .buffer = s_fram_buf,
+        .buffer_len = sizeof(s_fram_buf),
+        .size_bytes = sizeof(s_fram_buf),
+        .max_transfer = 16,
+        .clock_hz = 20000000,
+        .cs_overhead_ns = 1000,
+    };
+    TEST_ASSERT_EQUAL(ESP_OK, fram_hal_mock_create(&s_hal, &s_mock_ctx, &cfg));
+    TEST_ASSERT_EQUAL_UINT32(400, s_mock_ctx.byte_ns);
+    uint8_t buf[40] = {0};
+
+    // WREN + WRITE: 2 transactions, WREN + opcode + 2 address + 10 data bytes
+    TEST_ASSERT_EQUAL(ESP_OK, s_hal.write(&s_hal, 0x100, buf, 10));
+    TEST_ASSERT_EQUAL_UINT32(2, s_mock_ctx.txn_count);
+    TEST_ASSERT_EQUAL_UINT32(1, s_mock_ctx.wren_count);
+    TEST_ASSERT_EQUAL_UINT64(14, s_mock_ctx.wire_bytes);
+    TEST_ASSERT_EQUAL_UINT64(2 * 1000 + 14 * 400, s_mock_ctx.sim_time_ns);
+
+    // 40 bytes over max_transfer 16: three READ commands
+    fram_hal_mock_reset_counters(&s_hal);
+    TEST_ASSERT_EQUAL(ESP_OK, s_hal.read(&s_hal, 0, buf, sizeof(buf)));
+    TEST_ASSERT_EQUAL_UINT32(3, s_mock_ctx.txn_count);
+    TEST_ASSERT_EQUAL_UINT64(3 * 3 + 40, s_mock_ctx.wire_bytes);
+    TEST_ASSERT_EQUAL_UINT64(3 * 1000 + (3 * 3 + 40) * 400, s_mock_ctx.sim_time_ns);
+}
+
+TEST_CASE("fram_dev_scope_nesting", "[fram]") {
+    uint8_t buf[16];
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, fram_dev_end(&s_dev));
+
+    TEST_ASSERT_EQUAL(ESP_OK, fram_pm_begin(&s_pm));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_begin(&s_dev));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_pm_read(&s_pm, &s_parts[0], 0, buf, sizeof(buf)));
+
+    // Primitives open their own scopes; inside ours they nest
+    fram_ring_t ring;
+    fram_ring_config_t cfg = {
+        .pm = &s_pm,
+        .partition_name = "ring",
+        .max_payload = 16,
+        .magic = 0x52494E47,
+    };
+    TEST_ASSERT_EQUAL(ESP_OK, fram_ring_init(&ring, &cfg));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_ring_append(&ring, buf, sizeof(buf)));
+    TEST_ASSERT_EQUAL_UINT32(2, s_dev.lock_depth);
+
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_end(&s_dev));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_pm_end(&s_pm));
+    TEST_ASSERT_EQUAL_UINT32(0, s_dev.lock_depth);
+    TEST_ASSERT_NULL(s_dev.lock_owner);
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, fram_dev_end(&s_dev));
+
+    TEST_ASSERT_EQUAL(ESP_OK, fram_ring_init(&ring, &cfg));
+    TEST_ASSERT_EQUAL_UINT32(1, fram_ring_count(&ring));
+}
+
+static uint8_t s_shadow[FRAM_TEST_SIZE];
+
+TEST_CASE("fram_dev_shadow_mode", "[fram]") {
+    uint8_t data[16];
+    uint8_t out[16];
+    for (size_t i = 0; i < sizeof(data); i++) {
+        data[i] = (uint8_t)(0x40 + i);
+    }
+    memcpy(&s_fram_buf[0x100], data, sizeof(data));
+
+    fram_dev_deinit(&s_dev);
+    fram_dev_config_t dev_cfg = {
+        .hal = &s_hal,
+        .shadow = s_shadow,
+        .shadow_len = sizeof(s_shadow) - 1,
+    };
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_SIZE, fram_dev_init(&s_dev, &dev_cfg));
+    dev_cfg.shadow_len = sizeof(s_shadow);
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_init(&s_dev, &dev_cfg));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_pm_init(&s_pm, &s_dev, s_parts, 3));
+
+    // Reads and unchanged writes never reach the bus
+    fram_hal_mock_reset_counters(&s_hal);
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_read(&s_dev, 0x100, out, sizeof(out)));
+    TEST_ASSERT_EQUAL_MEMORY(data, out, sizeof(out));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_write(&s_dev, 0x100, data, sizeof(data)));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_fill(&s_dev, 0x200, 0xFF, 64));
+    TEST_ASSERT_EQUAL_UINT32(0, s_mock_ctx.op_count);
+
+    // Only the differing middle is written
+    data[5] = 0x00;
+    data[6] = 0x00;
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_write(&s_dev, 0x100, data, sizeof(data)));
+    TEST_ASSERT_EQUAL_UINT32(1, s_mock_ctx.op_count);
+    fram_dev_stats_t stats;
+    fram_dev_get_stats(&s_dev, &stats);
+    TEST_ASSERT_EQUAL_UINT32(16 + 64 + 14, stats.shadow_skipped);
+    TEST_ASSERT_EQUAL_MEMORY(data, &s_fram_buf[0x100], sizeof(data));
+
+    // Primitives run on top unchanged
+    fram_ring_t ring;
+    fram_ring_config_t ring_cfg = {
+        .pm = &s_pm,
+        .partition_name = "ring",
+        .max_payload = 16,
+        .magic = 0x52494E47,
+    };
+    TEST_ASSERT_EQUAL(ESP_OK, fram_ring_init(&ring, &ring_cfg));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_ring_append(&ring, data, sizeof(data)));
+    fram_hal_mock_reset_counters(&s_hal);
+    TEST_ASSERT_EQUAL(ESP_OK, fram_ring_init(&ring, &ring_cfg));
+    TEST_ASSERT_EQUAL_UINT32(1, fram_ring_count(&ring));
+    TEST_ASSERT_EQUAL_UINT32(0, s_mock_ctx.op_count);
+    TEST_ASSERT_EQUAL_MEMORY(s_fram_buf, s_shadow, sizeof(s_shadow));
+
+    // Verify catches a change behind the shadow's back and adopts it
+    s_fram_buf[0x300] ^= 0x01;
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_shadow_verify(&s_dev, 0x300));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_CRC, fram_dev_shadow_verify(&s_dev, 64));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_shadow_verify(&s_dev, FRAM_TEST_SIZE));
+    fram_dev_get_stats(&s_dev, &stats);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.shadow_mismatches);
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_read(&s_dev, 0x300, out, 1));
+    TEST_ASSERT_EQUAL_HEX8(s_fram_buf[0x300], out[0]);
+
+    // A failed write that cannot be re-read drops back to device reads
+    fram_hal_mock_set_fail_after(&s_hal, 0);
+    TEST_ASSERT_EQUAL(ESP_FAIL, fram_dev_write(&s_dev, 0x400, data, sizeof(data)));
+    TEST_ASSERT_FALSE(s_dev.shadow_valid);
+    s_mock_ctx.fail_enabled = false;
+    fram_hal_mock_reset_counters(&s_hal);
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_read(&s_dev, 0x100, out, sizeof(out)));
+    TEST_ASSERT_EQUAL_UINT32(1, s_mock_ctx.op_count);
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, fram_dev_shadow_verify(&s_dev, 64));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_shadow_sync(&s_dev));
+    TEST_ASSERT_TRUE(s_dev.shadow_valid);
+
+    // Async ops complete inline and return what they passed to the callback
+    memset(&s_async_log, 0, sizeof(s_async_log));
+    fram_hal_mock_set_fail_after(&s_hal, 0);
+    TEST_ASSERT_EQUAL(ESP_FAIL, fram_dev_write_async(&s_dev, 0x400, data, sizeof(data),
+                                                     async_done, (void *)1));
+    s_mock_ctx.fail_enabled = false;
+    TEST_ASSERT_EQUAL_UINT32(1, s_async_log.calls);
+    TEST_ASSERT_EQUAL(ESP_FAIL, s_async_log.last_err);
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_shadow_sync(&s_dev));
+}
+
+#if CONFIG_FRAM_DEV_CACHE_LINES
+TEST_CASE("fram_dev_cache_lines_and_pins", "[fram]") {
+    uint8_t buf[FRAM_DEV_CACHE_LINE_SIZE * 2];
+    fram_dev_deinit(&s_dev);
+    fram_dev_config_t dev_cfg = { .hal = &s_hal, .cache = true };
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_init(&s_dev, &dev_cfg));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_pm_init(&s_pm, &s_dev, s_parts, 3));
+    s_fram_buf[0x104] = 0x5A;
+
+    // One miss loads the line, the second read hits
+    fram_hal_mock_reset_counters(&s_hal);
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_read(&s_dev, 0x100, buf, 8));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_read(&s_dev, 0x104, buf, 1));
+    TEST_ASSERT_EQUAL_HEX8(0x5A, buf[0]);
+    TEST_ASSERT_EQUAL_UINT32(1, s_mock_ctx.op_count);
+    fram_dev_stats_t stats;
+    fram_dev_get_stats(&s_dev, &stats);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.cache_hits);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.cache_misses);
+
+    // read and readv count cache hits the same way
+    const fram_rvec_t rv = { .offset = 0x100, .buf = buf, .len = 8 };
+    fram_dev_reset_stats(&s_dev);
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_read(&s_dev, 0x100, buf, 8));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_readv(&s_dev, &rv, 1));
+    fram_dev_get_stats(&s_dev, &stats);
+    TEST_ASSERT_EQUAL_UINT32(2, stats.cache_hits);
+    TEST_ASSERT_EQUAL_UINT32(2, stats.read_count);
+#if CONFIG_FRAM_DEV_STATS
+    TEST_ASSERT_EQUAL_UINT64(16, stats.x.bytes_read);
+#endif
+
+    // Writes and fills go through and update the line
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_write_u8(&s_dev, 0x104, 0xA5));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_fill(&s_dev, 0x108, 0x00, 4));
+    fram_hal_mock_reset_counters(&s_hal);
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_read(&s_dev, 0x104, buf, 8));
+    TEST_ASSERT_EQUAL_HEX8(0xA5, buf[0]);
+    TEST_ASSERT_EQUAL_HEX8(0x00, buf[4]);
+    TEST_ASSERT_EQUAL_UINT32(0, s_mock_ctx.op_count);
+
+    // Longer reads bypass the cache
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_read(&s_dev, 0x100, buf, sizeof(buf)));
+    TEST_ASSERT_EQUAL_UINT32(1, s_mock_ctx.op_count);
+
+    // A pinned range survives a sweep over every line
+    uint32_t sb_len = (uint32_t)fram_superblock_storage_size();
+    TEST_ASSERT_EQUAL(ESP_ERR_NO_MEM, fram_dev_cache_pin(&s_dev, 0, FRAM_DEV_CACHE_LINES * FRAM_DEV_CACHE_LINE_SIZE));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_cache_pin(&s_dev, 0, sb_len));
+    for (uint32_t i = 0; i < 2 * FRAM_DEV_CACHE_LINES; i++) {
+        TEST_ASSERT_EQUAL(ESP_OK, fram_dev_read(&s_dev, 0x2000 + i * FRAM_DEV_CACHE_LINE_SIZE, buf, 4));
+    }
+    fram_hal_mock_reset_counters(&s_hal);
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_read(&s_dev, sb_len - 4, buf, 4));
+    TEST_ASSERT_EQUAL_UINT32(0, s_mock_ctx.op_count);
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_FOUND, fram_dev_cache_unpin(&s_dev, 0, 4));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_cache_unpin(&s_dev, 0, sb_len));
+
+    // Changes behind fram_dev's back need an invalidate; a failed write
+    // drops the line
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_read(&s_dev, 0x200, buf, 1));
+    s_fram_buf[0x200] = 0x11;
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_read(&s_dev, 0x200, buf, 1));
+    TEST_ASSERT_EQUAL_HEX8(0xFF, buf[0]);
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_cache_invalidate(&s_dev));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_read(&s_dev, 0x200, buf, 1));
+    TEST_ASSERT_EQUAL_HEX8(0x11, buf[0]);
+
+    fram_hal_mock_set_fail_after(&s_hal, 0);
+    TEST_ASSERT_EQUAL(ESP_FAIL, fram_dev_write_u8(&s_dev, 0x200, 0x22));
+    s_mock_ctx.fail_enabled = false;
+    s_fram_buf[0x200] = 0x33;
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_read(&s_dev, 0x200, buf, 1));
+    TEST_ASSERT_EQUAL_HEX8(0x33, buf[0]);
+}
+#endif // CONFIG_FRAM_DEV_CACHE_LINES
+
+// A high-priority task doing 4-byte writes while this task, at low
+// priority, fills and reads 16 KiB ranges. Returns the small writer's worst
+// latency.
+typedef struct {
+    volatile bool stop;
+    uint32_t writes;
+    int64_t worst_us;
+    esp_err_t err;
+} preempt_probe_t;
+
+static preempt_probe_t s_probe;
+static SemaphoreHandle_t s_probe_done;
+static StaticSemaphore_t s_probe_done_buf;
+
+static void preempt_small_writer(void *arg) {
+    while (!s_probe.stop) {
+        int64_t start = esp_timer_get_time();
+        esp_err_t err = fram_dev_write_u32(&s_dev, 0x10, s_probe.writes);
+        if (err != ESP_OK) {
+            s_probe.err = err;
+        }
+        int64_t took = esp_timer_get_time() - start;
+        if (took > s_probe.worst_us) {
+            s_probe.worst_us = took;
+        }
+        s_probe.writes++;
+        vTaskDelay(1);
+    }
+    xSemaphoreGive(s_probe_done);
+    vTaskDelete(NULL);
+}
+
+static int64_t preempt_worst_latency(uint32_t preempt_chunk, uint32_t *yields) {
+    static uint8_t buf[16 * 1024];
+    fram_dev_deinit(&s_dev);
+    fram_hal_mock_config_t mock_cfg = {
+        .buffer = s_fram_buf,
+        .buffer_len = sizeof(s_fram_buf),
+        .size_bytes = sizeof(s_fram_buf),
+        .byte_ns = 100,
+        .cs_overhead_ns = 2000,
+        .realtime = true,
+    };
+    TEST_ASSERT_EQUAL(ESP_OK, fram_hal_mock_create(&s_hal, &s_mock_ctx, &mock_cfg));
+    fram_dev_config_t dev_cfg = { .hal = &s_hal, .preempt_chunk = preempt_chunk, .preempt_budget_us = 200 };
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_init(&s_dev, &dev_cfg));
+
+    UBaseType_t prio = uxTaskPriorityGet(NULL);
+    vTaskPrioritySet(NULL, 2);
+    memset(&s_probe, 0, sizeof(s_probe));
+    s_probe_done = xSemaphoreCreateBinaryStatic(&s_probe_done_buf);
+    TEST_ASSERT_EQUAL(pdPASS, xTaskCreate(preempt_small_writer, "small", 3072, NULL, 10, NULL));
+    for (uint32_t i = 0; i < 20; i++) {
+        TEST_ASSERT_EQUAL(ESP_OK, fram_dev_fill(&s_dev, 0x1000, (uint8_t)i, sizeof(buf)));
+        TEST_ASSERT_EQUAL(ESP_OK, fram_dev_read(&s_dev, 0x1000, buf, sizeof(buf)));
+        TEST_ASSERT_EACH_EQUAL_UINT8((uint8_t)i, buf, sizeof(buf));
+    }
+    s_probe.stop = true;
+    TEST_ASSERT_TRUE(xSemaphoreTake(s_probe_done, pdMS_TO_TICKS(1000)));
+    vTaskPrioritySet(NULL, prio);
+    TEST_ASSERT_EQUAL(ESP_OK, s_probe.err);
+    TEST_ASSERT_GREATER_THAN(0, s_probe.writes);
+
+    fram_dev_stats_t stats;
+    fram_dev_get_stats(&s_dev, &stats);
+    *yields = stats.preempt_yields;
+    return s_probe.worst_us;
+}
+
+TEST_CASE("fram_dev_preemptible_transfers", "[fram]") {
+    uint32_t yields;
+    int64_t before = preempt_worst_latency(0, &yields);
+    TEST_ASSERT_EQUAL_UINT32(0, yields);
+    int64_t after = preempt_worst_latency(256, &yields);
+    printf("small write worst case: %lld us unsplit, %lld us preemptible (%u yields)\n", (long long)before,
+           (long long)after, (unsigned)yields);
+    TEST_ASSERT_GREATER_THAN(0, yields);
+    TEST_ASSERT_LESS_THAN(before, after);
+
+    // Per-task budgets
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_set_latency_budget(&s_dev, 50));
+    TEST_ASSERT_EQUAL_UINT32(50, s_dev.budgets[0].budget_us);
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_set_latency_budget(&s_dev, 0));
+    TEST_ASSERT_NULL(s_dev.budgets[0].task);
+}
+
+static esp_err_t s_holder_err;
+static bool s_holder_owned;
+
+// Takes the device from the yielding transfer and keeps it past that
+// transfer's mutex timeout
+static void preempt_holder(void *arg) {
+    vTaskDelay(pdMS_TO_TICKS(2));
+    s_holder_err = fram_dev_begin(&s_dev);
+    if (s_holder_err == ESP_OK) {
+        vTaskDelay(pdMS_TO_TICKS(100));
+        s_holder_owned = s_dev.lock_owner == xTaskGetCurrentTaskHandle() && s_dev.lock_depth == 1 &&
+                         !s_dev.preemptible;
+        s_holder_err = fram_dev_end(&s_dev);
+    }
+    xSemaphoreGive(s_probe_done);
+    vTaskDelete(NULL);
+}
+
+TEST_CASE("fram_dev_preempt_lost_device", "[fram]") {
+    fram_dev_deinit(&s_dev);
+    fram_hal_mock_config_t mock_cfg = {
+        .buffer = s_fram_buf,
+        .buffer_len = sizeof(s_fram_buf),
+        .size_bytes = sizeof(s_fram_buf),
+        .byte_ns = 1000,
+        .realtime = true,
+    };
+    TEST_ASSERT_EQUAL(ESP_OK, fram_hal_mock_create(&s_hal, &s_mock_ctx, &mock_cfg));
+    fram_dev_config_t dev_cfg = {
+        .hal = &s_hal,
+        .preempt_chunk = 256,
+        .preempt_budget_us = 200,
+        .mutex_timeout_ms = 20,
+    };
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_init(&s_dev, &dev_cfg));
+
+    UBaseType_t prio = uxTaskPriorityGet(NULL);
+    vTaskPrioritySet(NULL, 2);
+    s_holder_err = ESP_FAIL;
+    s_holder_owned = false;
+    s_probe_done = xSemaphoreCreateBinaryStatic(&s_probe_done_buf);
+    TEST_ASSERT_EQUAL(pdPASS, xTaskCreate(preempt_holder, "holder", 3072, NULL, 10, NULL));
+    // The holder's dev state must be left alone once the fill lost the device
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_FINISHED, fram_dev_fill(&s_dev, 0, 0xA5, 16 * 1024));
+    TEST_ASSERT_TRUE(xSemaphoreTake(s_probe_done, pdMS_TO_TICKS(1000)));
+    vTaskPrioritySet(NULL, prio);
+    TEST_ASSERT_EQUAL(ESP_OK, s_holder_err);
+    TEST_ASSERT_TRUE(s_holder_owned);
+
+    TEST_ASSERT_EQUAL_UINT32(0, s_dev.lock_depth);
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_fill(&s_dev, 0, 0xA5, 16 * 1024));
+    TEST_ASSERT_EQUAL_UINT8(0xA5, s_fram_buf[16 * 1024 - 1]);
+}
+
+#if CONFIG_FRAM_DEV_COMBINE_SIZE
+TEST_CASE("fram_dev_write_combining", "[fram]") {
+    uint8_t buf[16];
+    fram_dev_deinit(&s_dev);
+    fram_dev_config_t dev_cfg = { .hal = &s_hal, .combine = true };
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_init(&s_dev, &dev_cfg));
+
+    // Adjacent and overlapping small writes stay staged and reads see them
+    fram_hal_mock_reset_counters(&s_hal);
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_write_u32(&s_dev, 0x100, 0x11111111));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_write_u32(&s_dev, 0x104, 0x22222222));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_write_u8(&s_dev, 0x0FF, 0x33));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_write_u8(&s_dev, 0x102, 0x44));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_write_u8(&s_dev, 0x200, 0x55));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_read(&s_dev, 0x0FF, buf, 10));
+    TEST_ASSERT_EQUAL_HEX8(0x33, buf[0]);
+    TEST_ASSERT_EQUAL_HEX8(0x44, buf[3]);
+    TEST_ASSERT_EQUAL_HEX8(0x22, buf[8]);
+    TEST_ASSERT_EQUAL_HEX8(0xFF, s_fram_buf[0x100]);
+    TEST_ASSERT_EQUAL_UINT32(1, s_mock_ctx.txn_count);
+
+    // One flush writes both ranges: WREN + write each, instead of five times
+    fram_hal_mock_reset_counters(&s_hal);
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_barrier(&s_dev));
+    TEST_ASSERT_EQUAL_UINT32(4, s_mock_ctx.txn_count);
+    TEST_ASSERT_EQUAL_HEX8(0x33, s_fram_buf[0x0FF]);
+    TEST_ASSERT_EQUAL_HEX8(0x44, s_fram_buf[0x102]);
+    TEST_ASSERT_EQUAL_HEX8(0x22, s_fram_buf[0x107]);
+    TEST_ASSERT_EQUAL_HEX8(0x55, s_fram_buf[0x200]);
+    fram_dev_stats_t stats;
+    fram_dev_get_stats(&s_dev, &stats);
+    TEST_ASSERT_EQUAL_UINT32(3, stats.combined_writes);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.combine_flushes);
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_barrier(&s_dev));
+
+    // writev keeps its order behind staged writes
+    const uint8_t one = 0x01;
+    const fram_wvec_t seg = { .offset = 0x300, .buf = &one, .len = 1 };
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_write_u8(&s_dev, 0x300, 0x02));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_writev(&s_dev, &seg, 1));
+    TEST_ASSERT_EQUAL_HEX8(0x01, s_fram_buf[0x300]);
+
+    // Filling the buffer flushes it; longer writes go straight through
+    uint8_t big[FRAM_DEV_COMBINE_SIZE];
+    memset(big, 0x66, sizeof(big));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_write(&s_dev, 0x400, big, sizeof(big)));
+    TEST_ASSERT_EQUAL_HEX8(0x66, s_fram_buf[0x400 + sizeof(big) - 1]);
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_write_u8(&s_dev, 0x500, 0x77));
+    TEST_ASSERT_EQUAL_HEX8(0xFF, s_fram_buf[0x500]);
+
+    // The timer leaves the bus alone: the next call flushes what is left
+    vTaskDelay(pdMS_TO_TICKS(5 * CONFIG_FRAM_DEV_COMBINE_TIMEOUT_MS));
+    TEST_ASSERT_EQUAL_HEX8(0xFF, s_fram_buf[0x500]);
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_read(&s_dev, 0x000, buf, 1));
+    TEST_ASSERT_EQUAL_HEX8(0x77, s_fram_buf[0x500]);
+
+    // Staged data survives deinit
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_write_u8(&s_dev, 0x501, 0x88));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_deinit(&s_dev));
+    TEST_ASSERT_EQUAL_HEX8(0x88, s_fram_buf[0x501]);
+
+    // Ring metadata rewritten at init and by a logical clear is not staged
+    dev_cfg.combine = true;
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_init(&s_dev, &dev_cfg));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_pm_init(&s_pm, &s_dev, s_parts, 3));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_pm_erase(&s_pm, &s_parts[0]));
+    fram_ring_t ring;
+    fram_ring_config_t cfg = {
+        .pm = &s_pm,
+        .partition_name = "ring",
+        .max_payload = 16,
+        .magic = 0x52494E47,
+        .hint_interval = 4,
+    };
+    TEST_ASSERT_EQUAL(ESP_OK, fram_ring_init(&ring, &cfg));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_ring_append(&ring, buf, 4));
+    memset(s_fram_buf + s_parts[0].offset, 0x00, ring.base);
+    TEST_ASSERT_EQUAL(ESP_OK, fram_ring_init(&ring, &cfg));
+    TEST_ASSERT_NOT_EQUAL(0x00, s_fram_buf[s_parts[0].offset]);
+
+    cfg.hint_interval = 0;
+    cfg.packed = true;
+    cfg.logical_clear = true;
+    TEST_ASSERT_EQUAL(ESP_OK, fram_pm_erase(&s_pm, &s_parts[0]));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_ring_init(&ring, &cfg));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_ring_append(&ring, buf, 4));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_barrier(&s_dev));
+    fram_hal_mock_reset_counters(&s_hal);
+    TEST_ASSERT_EQUAL(ESP_OK, fram_ring_clear(&ring));
+    TEST_ASSERT_EQUAL_UINT32(2, s_mock_ctx.txn_count);
+}
+#endif // CONFIG_FRAM_DEV_COMBINE_SIZE
+
+#if CONFIG_FRAM_STAGE_ENABLED
+static fram_stage_t s_stage;
+static SemaphoreHandle_t s_stage_done;
+static StaticSemaphore_t s_stage_done_buf;
+
+#define STAGE_TEST_PRODUCERS 3
+#define STAGE_TEST_RECORDS 300
+
+static void stage_producer(void *arg) {
+    uint32_t id = (uint32_t)(uintptr_t)arg;
+    for (uint32_t i = 0; i < STAGE_TEST_RECORDS; i++) {
+        uint32_t rec = id << 16 | i;
+        while (fram_stage_push(&s_stage, &rec, sizeof(rec)) == ESP_ERR_NO_MEM) {
+            vTaskDelay(1);
+        }
+    }
+    xSemaphoreGive(s_stage_done);
+    vTaskDelete(NULL);
+}
+
+typedef struct {
+    uint32_t next[STAGE_TEST_PRODUCERS];
+    uint32_t seen;
+} stage_check_t;
+
+static esp_err_t stage_check_order(uint32_t seq, uint64_t ts_us, const void *payload, size_t len, void *ctx) {
+    stage_check_t *check = (stage_check_t *)ctx;
+    uint32_t rec;
+    TEST_ASSERT_EQUAL(sizeof(rec), len);
+    memcpy(&rec, payload, sizeof(rec));
+    uint32_t id = rec >> 16;
+    TEST_ASSERT_LESS_THAN(STAGE_TEST_PRODUCERS, id);
+    TEST_ASSERT_GREATER_OR_EQUAL(check->next[id], rec & 0xFFFF);
+    check->next[id] = (rec & 0xFFFF) + 1;
+    check->seen++;
+    return ESP_OK;
+}
+
+TEST_CASE("fram_stage_push_drain_and_overflow", "[fram]") {
+    fram_ring_t ring;
+    fram_ring_config_t ring_cfg = {
+        .pm = &s_pm,
+        .partition_name = "ring",
+        .max_payload = 16,
+        .magic = 0x53544147,
+    };
+    TEST_ASSERT_EQUAL(ESP_OK, fram_ring_init(&ring, &ring_cfg));
+    fram_stage_config_t cfg = { .ring = &ring };
+    TEST_ASSERT_EQUAL(ESP_OK, fram_stage_init(&s_stage, &cfg));
+
+    // An open reservation holds back later records until it is committed
+    uint32_t val = 1;
+    uint32_t out = 0;
+    size_t n = 0;
+    void *slot;
+    TEST_ASSERT_EQUAL(ESP_OK, fram_stage_reserve(&s_stage, sizeof(val), &slot));
+    val = 2;
+    TEST_ASSERT_EQUAL(ESP_OK, fram_stage_push(&s_stage, &val, sizeof(val)));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_stage_drain(&s_stage, 0, &n));
+    TEST_ASSERT_EQUAL(0, n);
+    val = 1;
+    memcpy(slot, &val, sizeof(val));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_stage_commit(&s_stage, slot));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, fram_stage_commit(&s_stage, slot));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_stage_drain(&s_stage, 0, &n));
+    TEST_ASSERT_EQUAL(2, n);
+    size_t len = sizeof(out);
+    TEST_ASSERT_EQUAL(ESP_OK, fram_ring_peek_oldest(&ring, &out, &len, NULL, NULL));
+    TEST_ASSERT_EQUAL_UINT32(1, out);
+    TEST_ASSERT_EQUAL(ESP_OK, fram_ring_peek_newest(&ring, &out, &len, NULL, NULL));
+    TEST_ASSERT_EQUAL_UINT32(2, out);
+    uint8_t big[17] = {0};
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_SIZE, fram_stage_push(&s_stage, big, sizeof(big)));
+
+    // A full buffer drops and counts new records
+    uint32_t pushed = 0;
+    while (fram_stage_push(&s_stage, &pushed, sizeof(pushed)) == ESP_OK) {
+        pushed++;
+    }
+    TEST_ASSERT_EQUAL(ESP_ERR_NO_MEM, fram_stage_push(&s_stage, &pushed, sizeof(pushed)));
+    fram_stage_stats_t stats;
+    fram_stage_get_stats(&s_stage, &stats);
+    TEST_ASSERT_EQUAL_UINT32(2, stats.dropped);
+    TEST_ASSERT_EQUAL_UINT32(2 * sizeof(pushed), stats.dropped_bytes);
+    TEST_ASSERT_EQUAL_UINT32(2 + pushed, stats.pushed);
+    TEST_ASSERT_EQUAL_UINT32(fram_stage_used(&s_stage), stats.high_water);
+    TEST_ASSERT_GREATER_THAN(FRAM_STAGE_SIZE - 8, stats.high_water);
+
+    TEST_ASSERT_EQUAL(ESP_OK, fram_stage_drain(&s_stage, 5, &n));
+    TEST_ASSERT_EQUAL(5, n);
+    TEST_ASSERT_EQUAL(ESP_OK, fram_stage_drain(&s_stage, 0, &n));
+    TEST_ASSERT_EQUAL(pushed - 5, n);
+    TEST_ASSERT_EQUAL_UINT32(0, fram_stage_used(&s_stage));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_ring_peek_newest(&ring, &out, &len, NULL, NULL));
+    TEST_ASSERT_EQUAL_UINT32(pushed - 1, out);
+
+    // Odd sizes wrap the buffer through pad records
+    for (uint32_t i = 0; i < 4 * FRAM_STAGE_SIZE / 16; i++) {
+        memset(big, (int)i, sizeof(big));
+        TEST_ASSERT_EQUAL(ESP_OK, fram_stage_push(&s_stage, big, 1 + i % 16));
+        TEST_ASSERT_EQUAL(ESP_OK, fram_stage_drain(&s_stage, 0, &n));
+        TEST_ASSERT_EQUAL(1, n);
+        uint8_t rec[16];
+        len = sizeof(rec);
+        TEST_ASSERT_EQUAL(ESP_OK, fram_ring_peek_newest(&ring, rec, &len, NULL, NULL));
+        TEST_ASSERT_EQUAL(1 + i % 16, len);
+        TEST_ASSERT_EACH_EQUAL_UINT8((uint8_t)i, rec, len);
+    }
+    TEST_ASSERT_EQUAL(ESP_OK, fram_stage_deinit(&s_stage));
+
+    // Drain task: woken by fill level, final drain at deinit
+    cfg.start_task = true;
+    cfg.wake_bytes = 64;
+    TEST_ASSERT_EQUAL(ESP_OK, fram_stage_init(&s_stage, &cfg));
+    uint32_t count = fram_ring_count(&ring);
+    for (val = 0; val < 40; val++) {
+        TEST_ASSERT_EQUAL(ESP_OK, fram_stage_push(&s_stage, &val, sizeof(val)));
+    }
+    TEST_ASSERT_EQUAL(ESP_OK, fram_stage_deinit(&s_stage));
+    TEST_ASSERT_EQUAL_UINT32(count + 40 < ring.capacity ? count + 40 : ring.capacity, fram_ring_count(&ring));
+    len = sizeof(out);
+    TEST_ASSERT_EQUAL(ESP_OK, fram_ring_peek_newest(&ring, &out, &len, NULL, NULL));
+    TEST_ASSERT_EQUAL_UINT32(39, out);
+
+    // Concurrent producers: nothing lost (they retry on a full buffer) and
+    // each producer's records reach the ring in order
+    TEST_ASSERT_EQUAL(ESP_OK, fram_ring_clear(&ring));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_stage_init(&s_stage, &cfg));
+    s_stage_done = xSemaphoreCreateCountingStatic(STAGE_TEST_PRODUCERS, 0, &s_stage_done_buf);
+    for (uintptr_t id = 0; id < STAGE_TEST_PRODUCERS; id++) {
+        TEST_ASSERT_EQUAL(pdPASS, xTaskCreate(stage_producer, "producer", 2048, (void *)id, 5, NULL));
+    }
+    for (size_t i = 0; i < STAGE_TEST_PRODUCERS; i++) {
+        TEST_ASSERT_TRUE(xSemaphoreTake(s_stage_done, pdMS_TO_TICKS(5000)));
+    }
+    TEST_ASSERT_EQUAL(ESP_OK, fram_stage_deinit(&s_stage));
+    fram_stage_get_stats(&s_stage, &stats);
+    TEST_ASSERT_EQUAL_UINT32(STAGE_TEST_PRODUCERS * STAGE_TEST_RECORDS, stats.pushed);
+    TEST_ASSERT_EQUAL_UINT32(stats.pushed, stats.drained);
+    stage_check_t check = {0};
+    TEST_ASSERT_EQUAL(ESP_OK, fram_ring_iterate(&ring, stage_check_order, &check));
+    TEST_ASSERT_EQUAL_UINT32(fram_ring_count(&ring), check.seen);
+}
+
+static fram_ring_t *s_stage_reader_ring;
+static volatile bool s_stage_reader_stop;
+static uint32_t s_stage_reader_passes;
+static esp_err_t s_stage_reader_err;
+
+static esp_err_t stage_count_records(uint32_t seq, uint64_t ts_us, const void *payload, size_t len, void *ctx) {
+    (*(uint32_t *)ctx)++;
+    return ESP_OK;
+}
+
+static void stage_reader(void *arg) {
+    while (!s_stage_reader_stop && s_stage_reader_err == ESP_OK) {
+        uint32_t seen = 0;
+        s_stage_reader_err = fram_ring_iterate(s_stage_reader_ring, stage_count_records, &seen);
+        s_stage_reader_passes++;
+    }
+    xSemaphoreGive(s_stage_done);
+    vTaskDelete(NULL);
+}
+
+// Drains and a reader on another task share the ring without waiting out
+// the mutex timeout: both take the ring lock before the device lock
+TEST_CASE("fram_stage_drain_with_concurrent_reader", "[fram]") {
+    fram_ring_t ring;
+    fram_ring_config_t ring_cfg = {
+        .pm = &s_pm,
+        .partition_name = "ring",
+        .max_payload = 16,
+        .magic = 0x53544147,
+    };
+    TEST_ASSERT_EQUAL(ESP_OK, fram_pm_erase(&s_pm, &s_parts[0]));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_ring_init(&ring, &ring_cfg));
+    fram_stage_config_t cfg = { .ring = &ring };
+    TEST_ASSERT_EQUAL(ESP_OK, fram_stage_init(&s_stage, &cfg));
+
+    s_stage_reader_ring = &ring;
+    s_stage_reader_stop = false;
+    s_stage_reader_passes = 0;
+    s_stage_reader_err = ESP_OK;
+    s_stage_done = xSemaphoreCreateBinaryStatic(&s_stage_done_buf);
+    TEST_ASSERT_EQUAL(pdPASS, xTaskCreate(stage_reader, "reader", 3072, NULL, 5, NULL));
+
+    int64_t start = esp_timer_get_time();
+    uint32_t total = 0;
+    for (uint32_t round = 0; round < 50; round++) {
+        for (uint32_t i = 0; i < 20; i++) {
+            TEST_ASSERT_EQUAL(ESP_OK, fram_stage_push(&s_stage, &total, sizeof(total)));
+            total++;
+        }
+        size_t n = 0;
+        TEST_ASSERT_EQUAL(ESP_OK, fram_stage_drain(&s_stage, 0, &n));
+        TEST_ASSERT_EQUAL(20, n);
+        vTaskDelay(1);
+    }
+    s_stage_reader_stop = true;
+    TEST_ASSERT_TRUE(xSemaphoreTake(s_stage_done, pdMS_TO_TICKS(5000)));
+    TEST_ASSERT_EQUAL(ESP_OK, s_stage_reader_err);
+    TEST_ASSERT_GREATER_THAN(0, s_stage_reader_passes);
+    TEST_ASSERT_LESS_THAN(CONFIG_FRAM_DEFAULT_MUTEX_TIMEOUT_MS * 1000, esp_timer_get_time() - start);
+    TEST_ASSERT_EQUAL(ESP_OK, fram_stage_deinit(&s_stage));
+
+    uint32_t out = 0;
+    size_t len = sizeof(out);
+    TEST_ASSERT_EQUAL(ESP_OK, fram_ring_peek_newest(&ring, &out, &len, NULL, NULL));
+    TEST_ASSERT_EQUAL_UINT32(total - 1, out);
+}
+#endif // CONFIG_FRAM_STAGE_ENABLED
+
+#if CONFIG_FRAM_IO_ENABLED
+static fram_io_t s_io;
+static SemaphoreHandle_t s_io_gate;
+static StaticSemaphore_t s_io_gate_buf;
+static uint32_t s_io_order[8];
+static esp_err_t s_io_err[8];
+static uint32_t s_io_done;
+
+// First request to complete parks the worker until the test opens the gate,
+// so the following ones pile up in the queue.
+static void io_hold(esp_err_t err, void *arg) {
+    (void)err;
+    (void)arg;
+    xSemaphoreTake(s_io_gate, portMAX_DELAY);
+}
+
+// Runs on the worker: only record, the test task checks
+static void io_record(esp_err_t err, void *arg) {
+    s_io_err[s_io_done] = err;
+    s_io_order[s_io_done++] = (uint32_t)(uintptr_t)arg;
+}
+
+TEST_CASE("fram_io_worker_order_and_merge", "[fram]") {
+    fram_io_config_t io_cfg = { .dev = &s_dev };
+    TEST_ASSERT_EQUAL(ESP_OK, fram_io_init(&s_io, &io_cfg));
+    s_io_gate = xSemaphoreCreateBinaryStatic(&s_io_gate_buf);
+    s_io_done = 0;
+
+    // Blocking round trip
+    uint32_t val = 0x12345678;
+    uint32_t out = 0;
+    TEST_ASSERT_EQUAL(ESP_OK, fram_io_write(&s_io, 0x100, &val, sizeof(val), NULL));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_io_read(&s_io, 0x100, &out, sizeof(out), NULL));
+    TEST_ASSERT_EQUAL_HEX32(val, out);
+
+    static const uint8_t a[8] = { 1, 1, 1, 1, 1, 1, 1, 1 };
+    static const uint8_t b[8] = { 2, 2, 2, 2, 2, 2, 2, 2 };
+    uint8_t rd[4];
+    fram_io_opts_t hold = { .done = io_hold };
+    TEST_ASSERT_EQUAL(ESP_OK, fram_io_fill(&s_io, 0x200, 0x00, 4, &hold));
+    fram_io_opts_t low = { .priority = 1, .done = io_record, .arg = (void *)1 };
+    fram_io_opts_t high = { .priority = 5, .done = io_record, .arg = (void *)2 };
+    fram_io_opts_t urgent = { .priority = 5, .deadline_us = 1, .done = io_record, .arg = (void *)3 };
+    fram_io_opts_t tail = { .priority = 5, .done = io_record, .arg = (void *)4 };
+    fram_io_opts_t after = { .priority = 9, .done = io_record, .arg = (void *)5 };
+    TEST_ASSERT_EQUAL(ESP_OK, fram_io_write(&s_io, 0x300, a, sizeof(a), &low));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_io_write(&s_io, 0x400, a, sizeof(a), &high));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_io_write(&s_io, 0x500, a, sizeof(a), &urgent));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_io_write(&s_io, 0x408, b, sizeof(b), &tail));
+    // Overlaps the low-priority write, so it waits for it despite priority 9
+    TEST_ASSERT_EQUAL(ESP_OK, fram_io_read(&s_io, 0x302, rd, sizeof(rd), &after));
+
+    fram_hal_mock_reset_counters(&s_hal);
+    xSemaphoreGive(s_io_gate);
+    esp_err_t result = ESP_FAIL;
+    fram_io_opts_t notify = { .notify = xTaskGetCurrentTaskHandle(), .result = &result };
+    TEST_ASSERT_EQUAL(ESP_OK, fram_io_read(&s_io, 0x400, &out, sizeof(out), &notify));
+    TEST_ASSERT_EQUAL_UINT32(1, ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(1000)));
+    TEST_ASSERT_EQUAL(ESP_OK, result);
+
+    // Deadline first within a priority; 0x400 and 0x408 went out as one writev
+    TEST_ASSERT_EQUAL_UINT32(5, s_io_done);
+    const uint32_t expect[] = { 3, 2, 4, 1, 5 };
+    TEST_ASSERT_EQUAL_UINT32_ARRAY(expect, s_io_order, 5);
+    for (uint32_t i = 0; i < 5; i++) {
+        TEST_ASSERT_EQUAL(ESP_OK, s_io_err[i]);
+    }
+    TEST_ASSERT_EQUAL_UINT32(1, s_io.merged);
+    TEST_ASSERT_EQUAL_MEMORY(a, rd, sizeof(rd));
+    TEST_ASSERT_EQUAL_MEMORY(b, &s_fram_buf[0x408], sizeof(b));
+
+    // A merged write that fails is split up: only the bad request fails
+    s_io_done = 0;
+    fram_io_opts_t first = { .done = io_record, .arg = (void *)1 };
+    fram_io_opts_t past_end = { .done = io_record, .arg = (void *)2 };
+    TEST_ASSERT_EQUAL(ESP_OK, fram_io_fill(&s_io, 0x200, 0x00, 4, &hold));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_io_write(&s_io, FRAM_TEST_SIZE - sizeof(a), a, sizeof(a), &first));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_io_write(&s_io, FRAM_TEST_SIZE, b, sizeof(b), &past_end));
+    xSemaphoreGive(s_io_gate);
+    TEST_ASSERT_EQUAL(ESP_OK, fram_io_read(&s_io, 0x400, &out, sizeof(out), NULL));
+    TEST_ASSERT_EQUAL_UINT32(2, s_io_done);
+    TEST_ASSERT_EQUAL_UINT32(2, s_io.merged);
+    TEST_ASSERT_EQUAL(ESP_OK, s_io_err[0]);
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_SIZE, s_io_err[1]);
+    TEST_ASSERT_EQUAL_MEMORY(a, &s_fram_buf[FRAM_TEST_SIZE - sizeof(a)], sizeof(a));
+
+    // Primitive writes through the worker; inside a scope they run inline
+    TEST_ASSERT_EQUAL(ESP_OK, fram_pm_set_io(&s_pm, &s_io, 3));
+    fram_ring_t ring;
+    fram_ring_config_t ring_cfg = {
+        .pm = &s_pm,
+        .partition_name = "ring",
+        .max_payload = 16,
+        .magic = 0x52494E47,
+    };
+    TEST_ASSERT_EQUAL(ESP_OK, fram_ring_init(&ring, &ring_cfg));
+    uint32_t completed = s_io.completed;
+    TEST_ASSERT_EQUAL(ESP_OK, fram_ring_append(&ring, &val, sizeof(val)));
+    TEST_ASSERT_EQUAL_UINT32(completed + 1, s_io.completed);
+    TEST_ASSERT_EQUAL(ESP_OK, fram_pm_begin(&s_pm));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_ring_append(&ring, &val, sizeof(val)));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_pm_end(&s_pm));
+    TEST_ASSERT_EQUAL_UINT32(completed + 1, s_io.completed);
+    TEST_ASSERT_EQUAL(ESP_OK, fram_ring_init(&ring, &ring_cfg));
+    TEST_ASSERT_EQUAL_UINT32(2, fram_ring_count(&ring));
+
+    TEST_ASSERT_EQUAL(ESP_OK, fram_pm_set_io(&s_pm, NULL, 0));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_io_deinit(&s_io));
+}
+
+// Each write path must reach the worker rather than run inline under a
+// device scope of its own.
+TEST_CASE("fram_io_write_paths_queued", "[fram]") {
+    fram_io_config_t io_cfg = { .dev = &s_dev };
+    TEST_ASSERT_EQUAL(ESP_OK, fram_io_init(&s_io, &io_cfg));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_pm_set_io(&s_pm, &s_io, 3));
+
+    fram_ring_t ring;
+    fram_ring_config_t ring_cfg = {
+        .pm = &s_pm,
+        .partition_name = "ring",
+        .max_payload = 16,
+        .magic = 0x52494E47,
+        .logical_clear = true,
+    };
+    uint32_t val = 0x12345678;
+    const fram_ring_rec_t recs[] = { { &val, sizeof(val) }, { &val, sizeof(val) }, { &val, sizeof(val) } };
+    for (int packed = 0; packed < 2; packed++) {
+        ring_cfg.packed = packed;
+        TEST_ASSERT_EQUAL(ESP_OK, fram_ring_init(&ring, &ring_cfg));
+        TEST_ASSERT_EQUAL(ESP_OK, fram_ring_clear(&ring));
+
+        uint32_t completed = s_io.completed;
+        TEST_ASSERT_EQUAL(ESP_OK, fram_ring_append(&ring, &val, sizeof(val)));
+        TEST_ASSERT_GREATER_THAN(completed, s_io.completed);
+        completed = s_io.completed;
+        TEST_ASSERT_EQUAL(ESP_OK, fram_ring_append_batch(&ring, recs, 3));
+        TEST_ASSERT_GREATER_THAN(completed, s_io.completed);
+        completed = s_io.completed;
+        TEST_ASSERT_EQUAL(ESP_OK, fram_ring_clear(&ring));
+        TEST_ASSERT_GREATER_THAN(completed, s_io.completed);
+    }
+
+    fram_vslot_t vs;
+    fram_vslot_config_t vs_cfg = {
+        .pm = &s_pm,
+        .partition_name = "vslot",
+        .max_payload = 16,
+        .slot_count = 2,
+        .magic = 0x56534C54,
+        .logical_clear = true,
+    };
+    TEST_ASSERT_EQUAL(ESP_OK, fram_vslot_init(&vs, &vs_cfg));
+    uint32_t completed = s_io.completed;
+    TEST_ASSERT_EQUAL(ESP_OK, fram_vslot_save(&vs, &val, sizeof(val)));
+    TEST_ASSERT_GREATER_THAN(completed, s_io.completed);
+    completed = s_io.completed;
+    TEST_ASSERT_EQUAL(ESP_OK, fram_vslot_clear(&vs));
+    TEST_ASSERT_GREATER_THAN(completed, s_io.completed);
+
+    fram_kvs_t kvs;
+    fram_kvs_config_t kvs_cfg = {
+        .pm = &s_pm,
+        .partition_name = "kvs",
+        .magic = 0x4B56534D,
+    };
+    TEST_ASSERT_EQUAL(ESP_OK, fram_kvs_init(&kvs, &kvs_cfg));
+    completed = s_io.completed;
+    TEST_ASSERT_EQUAL(ESP_OK, fram_kvs_set(&kvs, "a", "one", 3));
+    TEST_ASSERT_GREATER_THAN(completed, s_io.completed);
+    completed = s_io.completed;
+    TEST_ASSERT_EQUAL(ESP_OK, fram_kvs_delete(&kvs, "a"));
+    TEST_ASSERT_GREATER_THAN(completed, s_io.completed);
+
+#if CONFIG_FRAM_STAGE_ENABLED
+    ring_cfg.packed = false;
+    TEST_ASSERT_EQUAL(ESP_OK, fram_ring_init(&ring, &ring_cfg));
+    fram_stage_config_t stage_cfg = { .ring = &ring };
+    TEST_ASSERT_EQUAL(ESP_OK, fram_stage_init(&s_stage, &stage_cfg));
+    for (uint32_t i = 0; i < 4; i++) {
+        TEST_ASSERT_EQUAL(ESP_OK, fram_stage_push(&s_stage, &i, sizeof(i)));
+    }
+    completed = s_io.completed;
+    size_t drained = 0;
+    TEST_ASSERT_EQUAL(ESP_OK, fram_stage_drain(&s_stage, 0, &drained));
+    TEST_ASSERT_EQUAL_UINT32(4, drained);
+    TEST_ASSERT_GREATER_THAN(completed, s_io.completed);
+    TEST_ASSERT_EQUAL(ESP_OK, fram_stage_deinit(&s_stage));
+#endif
+
+    TEST_ASSERT_EQUAL(ESP_OK, fram_pm_set_io(&s_pm, NULL, 0));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_io_deinit(&s_io));
+}
+
+#if CONFIG_FRAM_DEV_COMBINE_SIZE
+TEST_CASE("fram_io_flushes_combined_writes", "[fram]") {
+    fram_dev_deinit(&s_dev);
+    fram_dev_config_t dev_cfg = { .hal = &s_hal, .combine = true };
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_init(&s_dev, &dev_cfg));
+    fram_io_config_t io_cfg = { .dev = &s_dev };
+    TEST_ASSERT_EQUAL(ESP_OK, fram_io_init(&s_io, &io_cfg));
+
+    // An idle device is flushed by the worker once the timeout passes
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_write_u8(&s_dev, 0x500, 0x77));
+    TEST_ASSERT_EQUAL_HEX8(0xFF, s_fram_buf[0x500]);
+    vTaskDelay(pdMS_TO_TICKS(5 * CONFIG_FRAM_DEV_COMBINE_TIMEOUT_MS));
+    TEST_ASSERT_EQUAL_HEX8(0x77, s_fram_buf[0x500]);
+
+    // Detached again, the device waits for its next call
+    TEST_ASSERT_EQUAL(ESP_OK, fram_io_deinit(&s_io));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_write_u8(&s_dev, 0x501, 0x88));
+    vTaskDelay(pdMS_TO_TICKS(5 * CONFIG_FRAM_DEV_COMBINE_TIMEOUT_MS));
+    TEST_ASSERT_EQUAL_HEX8(0xFF, s_fram_buf[0x501]);
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_barrier(&s_dev));
+    TEST_ASSERT_EQUAL_HEX8(0x88, s_fram_buf[0x501]);
+}
+#endif // CONFIG_FRAM_DEV_COMBINE_SIZE
+#endif // CONFIG_FRAM_IO_ENABLED
+
+#if CONFIG_FRAM_DEV_STATS
+static uint32_t hist_total(const uint32_t *hist) {
+    uint32_t total = 0;
+    for (size_t i = 0; i < FRAM_DEV_HIST_BUCKETS; i++) {
+        total += hist[i];
+    }
+    return total;
+}
+
+TEST_CASE("fram_dev_extended_stats", "[fram]") {
+    uint8_t buf[100];
+    memset(buf, 0x42, sizeof(buf));
+    fram_dev_reset_stats(&s_dev);
+
+    TEST_ASSERT_EQUAL(ESP_OK, fram_pm_write(&s_pm, &s_parts[0], 0, buf, sizeof(buf)));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_pm_fill(&s_pm, &s_parts[0], 100, 0xFF, 28));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_pm_read(&s_pm, &s_parts[1], 0, buf, 40));
+    const fram_rvec_t rv[] = {
+        { .offset = 0, .buf = buf, .len = 10 },
+        { .offset = 50, .buf = buf + 10, .len = 20 },
+    };
+    TEST_ASSERT_EQUAL(ESP_OK, fram_pm_readv(&s_pm, &s_parts[1], rv, 2));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_SIZE, fram_pm_read(&s_pm, &s_parts[1], 0x0800, buf, 1));
+
+    fram_dev_stats_t stats;
+    fram_dev_get_stats(&s_dev, &stats);
+    TEST_ASSERT_EQUAL_UINT64(128, stats.x.bytes_written);
+    TEST_ASSERT_EQUAL_UINT64(70, stats.x.bytes_read);
+    TEST_ASSERT_EQUAL_UINT32(2, hist_total(stats.x.write_hist));
+    TEST_ASSERT_EQUAL_UINT32(2, hist_total(stats.x.read_hist));
+    TEST_ASSERT_TRUE(stats.x.lock_wait_max_us <= stats.x.lock_wait_us);
+
+    fram_part_stats_t ring_stats;
+    fram_part_stats_t vslot_stats;
+    TEST_ASSERT_EQUAL(ESP_OK, fram_pm_get_stats(&s_pm, fram_pm_find(&s_pm, "ring"), &ring_stats));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_pm_get_stats(&s_pm, &s_parts[1], &vslot_stats));
+    TEST_ASSERT_EQUAL_UINT32(2, ring_stats.write_ops);
+    TEST_ASSERT_EQUAL_UINT32(0, ring_stats.read_ops);
+    TEST_ASSERT_EQUAL_UINT64(128, ring_stats.bytes_written);
+    TEST_ASSERT_EQUAL_UINT32(2, vslot_stats.read_ops);
+    TEST_ASSERT_EQUAL_UINT64(70, vslot_stats.bytes_read);
+    TEST_ASSERT_TRUE(vslot_stats.max_us <= vslot_stats.busy_us);
+
+    fram_dev_reset_stats(&s_dev);
+    fram_pm_reset_stats(&s_pm);
+    fram_dev_get_stats(&s_dev, &stats);
+    TEST_ASSERT_EQUAL_UINT64(0, stats.x.bytes_written);
+    TEST_ASSERT_EQUAL(ESP_OK, fram_pm_get_stats(&s_pm, &s_parts[0], &ring_stats));
+    TEST_ASSERT_EQUAL_UINT32(0, ring_stats.write_ops);
+
+    // Inside a scope a call is timed from the scope's start
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_begin(&s_dev));
+    vTaskDelay(pdMS_TO_TICKS(20));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_read(&s_dev, 0, buf, 4));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_end(&s_dev));
+    fram_dev_get_stats(&s_dev, &stats);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.x.read_hist[FRAM_DEV_HIST_BUCKETS - 1]);
+}
+#endif // CONFIG_FRAM_DEV_STATS
+
+TEST_CASE("fram_pm_fill_and_erase", "[fram]") {
+    // Streamed fill: one WREN + WRITE for the whole 4 KB partition
+    fram_hal_mock_reset_counters(&s_hal);
+    TEST_ASSERT_EQUAL(ESP_OK, fram_pm_erase(&s_pm, &s_parts[0]));
+    TEST_ASSERT_EQUAL_UINT32(2, s_mock_ctx.txn_count);
+
+    TEST_ASSERT_EQUAL(ESP_OK, fram_pm_fill(&s_pm, &s_parts[0], 0x10, 0x5A, 300));
+    TEST_ASSERT_EQUAL_HEX8(0xFF, s_fram_buf[s_parts[0].offset + 0x0F]);
+    TEST_ASSERT_EQUAL_HEX8(0x5A, s_fram_buf[s_parts[0].offset + 0x10]);
+    TEST_ASSERT_EQUAL_HEX8(0x5A, s_fram_buf[s_parts[0].offset + 0x10 + 299]);
+    TEST_ASSERT_EQUAL_HEX8(0xFF, s_fram_buf[s_parts[0].offset + 0x10 + 300]);
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_SIZE, fram_pm_fill(&s_pm, &s_parts[0], 0x0FF0, 0, 0x20));
+
+    // Without a fill op fram_dev falls back to pattern writes
+    s_hal.fill = NULL;
+    TEST_ASSERT_EQUAL(ESP_OK, fram_pm_fill(&s_pm, &s_parts[0], 0x10, 0xC3, 300));
+    TEST_ASSERT_EQUAL_HEX8(0xC3, s_fram_buf[s_parts[0].offset + 0x10 + 299]);
+    TEST_ASSERT_EQUAL_HEX8(0xFF, s_fram_buf[s_parts[0].offset + 0x10 + 300]);
+    TEST_ASSERT_EQUAL(ESP_OK, fram_pm_erase(&s_pm, &s_parts[0]));
+    TEST_ASSERT_EQUAL_HEX8(0xFF, s_fram_buf[s_parts[0].offset + 0x10]);
+}
+
+TEST_CASE("fram_logical_clear", "[fram]") {
+    fram_ring_t ring;
+    fram_ring_config_t ring_cfg = {
+        .pm = &s_pm,
+        .partition_name = "ring",
+        .max_payload = 16,
+        .magic = 0x52494E47,
+        .logical_clear = true,
+    };
+    TEST_ASSERT_EQUAL(ESP_OK, fram_ring_init(&ring, &ring_cfg));
+    for (uint32_t i = 0; i < ring.capacity + 3; i++) {
+        TEST_ASSERT_EQUAL(ESP_OK, fram_ring_append(&ring, &i, sizeof(i)));
+    }
+
+    // One zeroed commit byte per live slot, payloads left in place
+    fram_hal_mock_reset_counters(&s_hal);
+    TEST_ASSERT_EQUAL(ESP_OK, fram_ring_clear(&ring));
+    TEST_ASSERT_EQUAL_UINT32(2 * ring.capacity, s_mock_ctx.txn_count);
+    TEST_ASSERT_TRUE(fram_ring_is_empty(&ring));
+    uint32_t first = 0;
+    memcpy(&first, s_fram_buf + s_parts[0].offset + sizeof(fram_ring_header_t), sizeof(first));
+    TEST_ASSERT_EQUAL_UINT32(ring.capacity, first);
+
+    fram_ring_t recovered;
+    TEST_ASSERT_EQUAL(ESP_OK, fram_ring_init(&recovered, &ring_cfg));
+    TEST_ASSERT_EQUAL_UINT32(0, fram_ring_count(&recovered));
+
+    // New entries after a clear never chain into the old ones
+    uint32_t val = 0x1234;
+    TEST_ASSERT_EQUAL(ESP_OK, fram_ring_append(&ring, &val, sizeof(val)));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_ring_init(&recovered, &ring_cfg));
+    TEST_ASSERT_EQUAL_UINT32(1, fram_ring_count(&recovered));
+
+    fram_vslot_t vs;
+    fram_vslot_config_t vs_cfg = {
+        .pm = &s_pm,
+        .partition_name = "vslot",
+        .max_payload = 16,
+        .slot_count = 3,
+        .magic = 0x56534C54,
+        .logical_clear = true,
+    };
+    TEST_ASSERT_EQUAL(ESP_OK, fram_vslot_init(&vs, &vs_cfg));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_vslot_save(&vs, &val, sizeof(val)));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_vslot_save(&vs, &val, sizeof(val)));
+    fram_hal_mock_reset_counters(&s_hal);
+    TEST_ASSERT_EQUAL(ESP_OK, fram_vslot_clear(&vs));
+    TEST_ASSERT_EQUAL_UINT32(6, s_mock_ctx.txn_count);
+    TEST_ASSERT_FALSE(fram_vslot_has_data(&vs));
+
+    fram_vslot_t vs_recovered;
+    TEST_ASSERT_EQUAL(ESP_OK, fram_vslot_init(&vs_recovered, &vs_cfg));
+    TEST_ASSERT_FALSE(fram_vslot_has_data(&vs_recovered));
+
+#if CONFIG_FRAM_KVS_ENABLED
+    fram_kvs_t kvs;
+    fram_kvs_config_t kvs_cfg = {
+        .pm = &s_pm,
+        .partition_name = "kvs",
+        .magic = 0x4B56534D,
+    };
+    TEST_ASSERT_EQUAL(ESP_OK, fram_kvs_init(&kvs, &kvs_cfg));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_kvs_set_u32(&kvs, "a", 1));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_kvs_set_u32(&kvs, "b", 2));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_kvs_clear(&kvs));
+    TEST_ASSERT_FALSE(fram_kvs_exists(&kvs, "a"));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_kvs_set_u32(&kvs, "b", 3));
+
+    fram_kvs_t kvs_recovered;
+    uint32_t out = 0;
+    TEST_ASSERT_EQUAL(ESP_OK, fram_kvs_init(&kvs_recovered, &kvs_cfg));
+    TEST_ASSERT_FALSE(fram_kvs_exists(&kvs_recovered, "a"));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_kvs_get_u32(&kvs_recovered, "b", &out));
+    TEST_ASSERT_EQUAL_UINT32(3, out);
+
+    // Records past the recovered end do not come back: here the first one
+    // is gone, and a new record of the same size ends where "d" starts
+    TEST_ASSERT_EQUAL(ESP_OK, fram_kvs_clear(&kvs_recovered));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_kvs_set_u32(&kvs_recovered, "c", 4));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_kvs_set_u32(&kvs_recovered, "d", 5));
+    s_fram_buf[s_parts[2].offset] = 0xFF;
+    TEST_ASSERT_EQUAL(ESP_OK, fram_kvs_init(&kvs_recovered, &kvs_cfg));
+    TEST_ASSERT_FALSE(fram_kvs_exists(&kvs_recovered, "d"));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_kvs_clear(&kvs_recovered));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_kvs_set_u32(&kvs_recovered, "e", 6));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_kvs_init(&kvs_recovered, &kvs_cfg));
+    TEST_ASSERT_TRUE(fram_kvs_exists(&kvs_recovered, "e"));
+    TEST_ASSERT_FALSE(fram_kvs_exists(&kvs_recovered, "d"));
+#endif
+}
+
+#if CONFIG_FRAM_HAL_STRIPE_ENABLED || CONFIG_FRAM_HAL_MIRROR_ENABLED
+// Stand-in for the SPI HAL's bus ownership on mock children
+static uint32_t s_bus_held;
+static uint32_t s_bus_acquires;
+
+static esp_err_t bus_acquire(fram_hal_t *hal) {
+    TEST_ASSERT_EQUAL_UINT32(0, s_bus_held & hal->buses);
+    s_bus_held |= hal->buses;
+    s_bus_acquires++;
+    return ESP_OK;
+}
+
+static void bus_release(fram_hal_t *hal) {
+    s_bus_held &= ~hal->buses;
+}
+
+static void bus_attach(fram_hal_t *hal, uint32_t buses) {
+    hal->buses = buses;
+    hal->acquire = bus_acquire;
+    hal->release = bus_release;
+}
+#endif
+
+#if CONFIG_FRAM_HAL_STRIPE_ENABLED
+
+#define STRIPE_TEST_CHILDREN 3
+#define STRIPE_TEST_CHILD_SIZE (4 * 1024)
+
+static uint8_t s_child_buf[STRIPE_TEST_CHILDREN][STRIPE_TEST_CHILD_SIZE];
+static fram_hal_t s_child_hal[STRIPE_TEST_CHILDREN];
+static fram_hal_mock_ctx_t s_child_ctx[STRIPE_TEST_CHILDREN];
+static fram_hal_stripe_ctx_t s_stripe_ctx;
+
+static void stripe_open(fram_hal_stripe_mode_t mode, uint32_t stripe_size) {
+    fram_dev_deinit(&s_dev);
+    fram_hal_t *children[STRIPE_TEST_CHILDREN];
+    for (size_t i = 0; i < STRIPE_TEST_CHILDREN; i++) {
+        fram_hal_mock_config_t cfg = {
+            .buffer = s_child_buf[i],
+            .buffer_len = sizeof(s_child_buf[i]),
+            .size_bytes = sizeof(s_child_buf[i]) - (i == 2 ? 1024 : 0),
+        };
+        TEST_ASSERT_EQUAL(ESP_OK, fram_hal_mock_create(&s_child_hal[i], &s_child_ctx[i], &cfg));
+        fram_hal_mock_fill(&s_child_hal[i], 0xFF);
+        children[i] = &s_child_hal[i];
+    }
+    fram_hal_stripe_config_t cfg = {
+        .children = children,
+        .child_count = STRIPE_TEST_CHILDREN,
+        .mode = mode,
+        .stripe_size = stripe_size,
+    };
+    TEST_ASSERT_EQUAL(ESP_OK, fram_hal_stripe_create(&s_hal, &s_stripe_ctx, &cfg));
+    fram_dev_config_t dev_cfg = { .hal = &s_hal };
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_init(&s_dev, &dev_cfg));
+}
+
+TEST_CASE("fram_hal_stripe_layout", "[fram]") {
+    static uint8_t data[9 * 1024];
+    for (size_t i = 0; i < sizeof(data); i++) {
+        data[i] = (uint8_t)(i * 31 + (i >> 8));
+    }
+
+    // Striped: the smallest child (3 KB) bounds every child
+    stripe_open(FRAM_HAL_STRIPE_MODE_STRIPE, 256);
+    TEST_ASSERT_EQUAL_UINT32(3 * 3 * 1024, fram_dev_get_size(&s_dev));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_write(&s_dev, 0, data, sizeof(data)));
+    // Composite 256..511 is child 1 at 0, 768..1023 is child 0 at 256
+    TEST_ASSERT_EQUAL_MEMORY(data + 256, s_child_buf[1], 256);
+    TEST_ASSERT_EQUAL_MEMORY(data + 768, s_child_buf[0] + 256, 256);
+    TEST_ASSERT_EQUAL_MEMORY(data + 512 + 3 * 256, s_child_buf[2] + 256, 256);
+
+    static uint8_t readback[9 * 1024];
+    memset(readback, 0, sizeof(readback));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_read(&s_dev, 100, readback, sizeof(readback) - 200));
+    TEST_ASSERT_EQUAL_MEMORY(data + 100, readback, sizeof(readback) - 200);
+
+    // Concatenated: children back to back, full capacity
+    stripe_open(FRAM_HAL_STRIPE_MODE_CONCAT, 0);
+    TEST_ASSERT_EQUAL_UINT32(4096 + 4096 + 3072, fram_dev_get_size(&s_dev));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_write(&s_dev, 4000, data, 200));
+    TEST_ASSERT_EQUAL_MEMORY(data, s_child_buf[0] + 4000, 96);
+    TEST_ASSERT_EQUAL_MEMORY(data + 96, s_child_buf[1], 104);
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_SIZE, fram_dev_write(&s_dev, 11 * 1024 - 4, data, 8));
+
+    // Primitives run unchanged on top
+    fram_partition_t part = { .name = "ring", .offset = 0x100, .size = 0x800 };
+    TEST_ASSERT_EQUAL(ESP_OK, fram_pm_init(&s_pm, &s_dev, &part, 1));
+    fram_ring_t ring;
+    fram_ring_config_t ring_cfg = { .pm = &s_pm, .partition_name = "ring", .max_payload = 64 };
+    TEST_ASSERT_EQUAL(ESP_OK, fram_ring_init(&ring, &ring_cfg));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_ring_append(&ring, data, 40));
+    uint8_t out[64];
+    size_t out_len = sizeof(out);
+    TEST_ASSERT_EQUAL(ESP_OK, fram_ring_peek_newest(&ring, out, &out_len, NULL, NULL));
+    TEST_ASSERT_EQUAL_UINT32(40, out_len);
+    TEST_ASSERT_EQUAL_MEMORY(data, out, 40);
+    fram_ring_deinit(&ring);
+}
+
+TEST_CASE("fram_hal_stripe_shared_bus", "[fram]") {
+    uint8_t buf[16];
+    // Children 0 and 1 share bus 0, child 2 has bus 1 to itself: only child
+    // 2 is held, even for a read that spans 0 and 1
+    stripe_open(FRAM_HAL_STRIPE_MODE_CONCAT, 0);
+    bus_attach(&s_child_hal[0], FRAM_HAL_BUS_SPI(0));
+    bus_attach(&s_child_hal[1], FRAM_HAL_BUS_SPI(0));
+    bus_attach(&s_child_hal[2], FRAM_HAL_BUS_SPI(1));
+    s_bus_held = 0;
+    s_bus_acquires = 0;
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_read(&s_dev, STRIPE_TEST_CHILD_SIZE - 8, buf, sizeof(buf)));
+    TEST_ASSERT_EQUAL_UINT32(1, s_bus_acquires);
+    TEST_ASSERT_EQUAL_UINT32(0, s_bus_held);
+    TEST_ASSERT_EQUAL_UINT32(0, s_stripe_ctx.acquired);
+
+    // Composites report every bus below them
+    fram_hal_t *children[] = { &s_child_hal[0], &s_child_hal[2] };
+    fram_hal_stripe_config_t cfg = { .children = children, .child_count = 2, .mode = FRAM_HAL_STRIPE_MODE_CONCAT };
+    fram_hal_t outer;
+    fram_hal_stripe_ctx_t outer_ctx;
+    TEST_ASSERT_EQUAL(ESP_OK, fram_hal_stripe_create(&outer, &outer_ctx, &cfg));
+    TEST_ASSERT_EQUAL_HEX32(FRAM_HAL_BUS_SPI(0) | FRAM_HAL_BUS_SPI(1), outer.buses);
+}
+
+#endif // CONFIG_FRAM_HAL_STRIPE_ENABLED
+
+#if CONFIG_FRAM_HAL_MIRROR_ENABLED
+
+#define MIRROR_TEST_SIZE (4 * 1024)
+
+static uint8_t s_mirror_buf[FRAM_HAL_MIRROR_CHILDREN][MIRROR_TEST_SIZE];
+static fram_hal_t s_mirror_child[FRAM_HAL_MIRROR_CHILDREN];
+static fram_hal_mock_ctx_t s_mirror_child_ctx[FRAM_HAL_MIRROR_CHILDREN];
+static fram_hal_mirror_ctx_t s_mirror_ctx;
+
+static void mirror_open(void) {
+    fram_dev_deinit(&s_dev);
+    fram_hal_mirror_config_t cfg = {0};
+    for (size_t i = 0; i < FRAM_HAL_MIRROR_CHILDREN; i++) {
+        fram_hal_mock_config_t child_cfg = {
+            .buffer = s_mirror_buf[i],
+            .buffer_len = sizeof(s_mirror_buf[i]),
+            .size_bytes = sizeof(s_mirror_buf[i]),
+        };
+        TEST_ASSERT_EQUAL(ESP_OK, fram_hal_mock_create(&s_mirror_child[i], &s_mirror_child_ctx[i], &child_cfg));
+        fram_hal_mock_fill(&s_mirror_child[i], 0xFF);
+        cfg.children[i] = &s_mirror_child[i];
+    }
+    TEST_ASSERT_EQUAL(ESP_OK, fram_hal_mirror_create(&s_hal, &s_mirror_ctx, &cfg));
+    fram_dev_config_t dev_cfg = { .hal = &s_hal };
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_init(&s_dev, &dev_cfg));
+}
+
+TEST_CASE("fram_hal_mirror_shared_bus", "[fram]") {
+    uint8_t buf[16] = {0};
+    // A pair on one host is left alone, a pair on two hosts is held
+    for (uint32_t shared = 0; shared < 2; shared++) {
+        mirror_open();
+        bus_attach(&s_mirror_child[0], FRAM_HAL_BUS_SPI(0));
+        bus_attach(&s_mirror_child[1], FRAM_HAL_BUS_SPI(shared ? 0 : 1));
+        s_bus_held = 0;
+        s_bus_acquires = 0;
+        TEST_ASSERT_EQUAL(ESP_OK, fram_dev_write(&s_dev, 0x100, buf, sizeof(buf)));
+        TEST_ASSERT_EQUAL(ESP_OK, fram_dev_read(&s_dev, 0x100, buf, sizeof(buf)));
+        TEST_ASSERT_EQUAL_UINT32(shared ? 0 : 4, s_bus_acquires);
+        TEST_ASSERT_EQUAL_UINT32(0, s_bus_held);
+    }
+}
+
+TEST_CASE("fram_hal_mirror_failover_and_repair", "[fram]") {
+    uint8_t data[128];
+    uint8_t out[128];
+    for (size_t i = 0; i < sizeof(data); i++) {
+        data[i] = (uint8_t)(i * 7 + 1);
+    }
+
+    mirror_open();
+    TEST_ASSERT_EQUAL_UINT32(MIRROR_TEST_SIZE, fram_dev_get_size(&s_dev));
+    TEST_ASSERT_EQUAL_UINT32(2, fram_dev_get_copies(&s_dev));
+
+    // Writes land on both copies, reads alternate
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_write(&s_dev, 0x200, data, sizeof(data)));
+    TEST_ASSERT_EQUAL_MEMORY(data, s_mirror_buf[0] + 0x200, sizeof(data));
+    TEST_ASSERT_EQUAL_MEMORY(data, s_mirror_buf[1] + 0x200, sizeof(data));
+    for (int i = 0; i < 4; i++) {
+        TEST_ASSERT_EQUAL(ESP_OK, fram_dev_read(&s_dev, 0x200, out, sizeof(out)));
+    }
+    fram_hal_mirror_child_t stats[FRAM_HAL_MIRROR_CHILDREN];
+    for (size_t i = 0; i < FRAM_HAL_MIRROR_CHILDREN; i++) {
+        TEST_ASSERT_EQUAL(ESP_OK, fram_hal_mirror_get_child_stats(&s_hal, i, &stats[i]));
+        TEST_ASSERT_EQUAL_UINT32(2, stats[i].read_count);
+    }
+
+    // Child 1 fails: the write still succeeds and child 1 is queued for repair
+    fram_hal_mock_set_fail_after(&s_mirror_child[1], 0);
+    data[0] ^= 0xFF;
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_write(&s_dev, 0x200, data, sizeof(data)));
+    TEST_ASSERT_EQUAL_UINT32(sizeof(data), fram_hal_mirror_repair_pending(&s_hal));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_read_copy(&s_dev, 0, 0x200, out, sizeof(out)));
+    TEST_ASSERT_EQUAL_MEMORY(data, out, sizeof(out));
+
+    // Child 1 comes back: the next operations copy the range over
+    s_mirror_child_ctx[1].fail_enabled = false;
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_read(&s_dev, 0x200, out, sizeof(out)));
+    TEST_ASSERT_EQUAL_MEMORY(data, out, sizeof(out));
+    TEST_ASSERT_EQUAL_UINT32(0, fram_hal_mirror_repair_pending(&s_hal));
+    TEST_ASSERT_EQUAL_MEMORY(data, s_mirror_buf[1] + 0x200, sizeof(data));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_hal_mirror_get_child_stats(&s_hal, 1, &stats[1]));
+    TEST_ASSERT_EQUAL_UINT32(sizeof(data), stats[1].repaired_bytes);
+    TEST_ASSERT_GREATER_THAN_UINT32(0, stats[1].error_count);
+
+    // A ring record damaged in one copy is recovered from the other
+    fram_partition_t part = { .name = "ring", .offset = 0x400, .size = 0x800 };
+    TEST_ASSERT_EQUAL(ESP_OK, fram_pm_init(&s_pm, &s_dev, &part, 1));
+    fram_ring_t ring;
+    fram_ring_config_t ring_cfg = { .pm = &s_pm, .partition_name = "ring", .max_payload = 64 };
+    TEST_ASSERT_EQUAL(ESP_OK, fram_ring_init(&ring, &ring_cfg));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_ring_append(&ring, data, 40));
+    fram_ring_deinit(&ring);
+
+    s_mirror_buf[0][part.offset + sizeof(fram_ring_header_t) + 3] ^= 0x5A;
+    TEST_ASSERT_EQUAL(ESP_OK, fram_ring_init(&ring, &ring_cfg));
+    TEST_ASSERT_EQUAL_UINT32(1, fram_ring_count(&ring));
+    TEST_ASSERT_EQUAL_MEMORY(s_mirror_buf[1] + part.offset, s_mirror_buf[0] + part.offset, ring.entry_size);
+    size_t out_len = sizeof(out);
+    TEST_ASSERT_EQUAL(ESP_OK, fram_ring_peek_newest(&ring, out, &out_len, NULL, NULL));
+    TEST_ASSERT_EQUAL_UINT32(40, out_len);
+    TEST_ASSERT_EQUAL_MEMORY(data, out, 40);
+    fram_ring_deinit(&ring);
+
+    // Child 1 misses a write, then child 0 fails the read: child 1's old data
+    // must not be served, nor used as a repair source
+    fram_hal_mock_set_fail_after(&s_mirror_child[1], 0);
+    data[1] ^= 0xFF;
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_write(&s_dev, 0x100, data, sizeof(data)));
+    fram_hal_mock_set_fail_after(&s_mirror_child[0], 0);
+    s_mirror_child_ctx[1].fail_enabled = false;
+    TEST_ASSERT_NOT_EQUAL(ESP_OK, fram_dev_read(&s_dev, 0x100, out, sizeof(out)));
+    s_mirror_child_ctx[0].fail_enabled = false;
+    TEST_ASSERT_EQUAL_UINT32(2 * sizeof(data), fram_hal_mirror_repair_pending(&s_hal));
+    TEST_ASSERT_NOT_EQUAL(0, memcmp(data, s_mirror_buf[1] + 0x100, sizeof(data)));
+    uint32_t errors = s_dev.error_count;
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, fram_dev_repair(&s_dev, 1, 0x100, sizeof(data)));
+    TEST_ASSERT_EQUAL_UINT32(errors + 1, s_dev.error_count);
+
+    // Rewriting the range makes both copies current again
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_write(&s_dev, 0x100, data, sizeof(data)));
+    TEST_ASSERT_EQUAL_UINT32(0, fram_hal_mirror_repair_pending(&s_hal));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_read(&s_dev, 0x100, out, sizeof(out)));
+    TEST_ASSERT_EQUAL_MEMORY(data, out, sizeof(out));
+}
+
+#endif // CONFIG_FRAM_HAL_MIRROR_ENABLED
+
+#if CONFIG_FRAM_HAL_FILE_ENABLED
+
+#define FILE_TEST_PATH "/tmp/fram_test.img"
+#define FILE_TEST_SIZE (2 * 1024 * 1024)
+
+static fram_hal_file_ctx_t s_file_ctx;
+
+static void file_open(bool truncate) {
+    fram_dev_deinit(&s_dev);
+    fram_hal_file_config_t cfg = {
+        .path = FILE_TEST_PATH,
+        .size_bytes = FILE_TEST_SIZE,
+        .truncate = truncate,
+    };
+    TEST_ASSERT_EQUAL(ESP_OK, fram_hal_file_create(&s_hal, &s_file_ctx, &cfg));
+    fram_dev_config_t dev_cfg = { .hal = &s_hal };
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_init(&s_dev, &dev_cfg));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_pm_init(&s_pm, &s_dev, s_parts, 3));
+}
+
+TEST_CASE("fram_hal_file_persists_across_reopen", "[fram]") {
+    file_open(true);
+    TEST_ASSERT_TRUE(s_file_ctx.created);
+    TEST_ASSERT_EQUAL_UINT32(FILE_TEST_SIZE, fram_dev_get_size(&s_dev));
+    uint8_t byte = 0;
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_read(&s_dev, FILE_TEST_SIZE - 1, &byte, 1));
+    TEST_ASSERT_EQUAL_HEX8(0xFF, byte);
+
+    fram_ring_t ring;
+    fram_ring_config_t ring_cfg = { .pm = &s_pm, .partition_name = "ring", .max_payload = 32 };
+    TEST_ASSERT_EQUAL(ESP_OK, fram_ring_init(&ring, &ring_cfg));
+    for (uint32_t i = 0; i < 3; i++) {
+        TEST_ASSERT_EQUAL(ESP_OK, fram_ring_append(&ring, &i, sizeof(i)));
+    }
+    fram_ring_deinit(&ring);
+
+    // Reopening the image is a reboot: the ring recovers its entries
+    file_open(false);
+    TEST_ASSERT_FALSE(s_file_ctx.created);
+    TEST_ASSERT_EQUAL(ESP_OK, fram_ring_init(&ring, &ring_cfg));
+    TEST_ASSERT_EQUAL_UINT32(3, fram_ring_count(&ring));
+    uint32_t value = 0;
+    size_t len = sizeof(value);
+    TEST_ASSERT_EQUAL(ESP_OK, fram_ring_peek_newest(&ring, &value, &len, NULL, NULL));
+    TEST_ASSERT_EQUAL_UINT32(2, value);
+    fram_ring_deinit(&ring);
+
+    fram_dev_deinit(&s_dev);
+    unlink(FILE_TEST_PATH);
+}
+
+#endif // CONFIG_FRAM_HAL_FILE_ENABLED
+
 #else
 
 TEST_CASE("fram_tests_skipped", "[fram]") {
@@ -0,0 +1,638 @@
+/**
+ * @file test_fram_bench.c
+ * @brief Benchmarks for FRAM (mock HAL transaction counters)
+ */
+
+#include "unity.h"
+#include "fram/fram.h"
+#include "esp_timer.h"
+#include <stdio.h>
+#include <string.h>
+
+#if CONFIG_FRAM_HAL_MOCK_ENABLED
+
+#define FRAM_BENCH_SIZE (32 * 1024)
+
+static uint8_t s_bench_buf[FRAM_BENCH_SIZE];
+static fram_hal_t s_bench_hal;
+static fram_hal_mock_ctx_t s_bench_ctx;
+static fram_dev_t s_bench_dev;
+static fram_pm_t s_bench_pm;
+static const fram_partition_t s_bench_parts[] = {
+    { .name = "bench", .offset = 0x0400, .size = 0x1000 },
+    { .name = "vslot", .offset = 0x1400, .size = 0x0400 },
+    { .name = "kvs", .offset = 0x1800, .size = 0x1000 },
+};
+#define BENCH_PART_COUNT (sizeof(s_bench_parts) / sizeof(s_bench_parts[0]))
+
+// Pass-through HAL that times every call into the mock, so a primitive's
+// operation can be broken down into the device ops it issues.
+#define BENCH_TIMED_OPS 8
+
+typedef struct {
+    uint32_t ops;
+    int64_t us[BENCH_TIMED_OPS];
+    size_t len[BENCH_TIMED_OPS];
+} bench_timing_t;
+
+static fram_hal_t s_timed_hal;
+static bench_timing_t s_timing;
+
+static void bench_timed_record(int64_t start, size_t len) {
+    if (s_timing.ops < BENCH_TIMED_OPS) {
+        s_timing.us[s_timing.ops] += esp_timer_get_time() - start;
+        s_timing.len[s_timing.ops] = len;
+    }
+    s_timing.ops++;
+}
+
+static esp_err_t bench_timed_read(fram_hal_t *hal, uint32_t addr, void *buf, size_t len) {
+    (void)hal;
+    int64_t start = esp_timer_get_time();
+    esp_err_t err = s_bench_hal.read(&s_bench_hal, addr, buf, len);
+    bench_timed_record(start, len);
+    return err;
+}
+
+static esp_err_t bench_timed_write(fram_hal_t *hal, uint32_t addr, const void *buf, size_t len) {
+    (void)hal;
+    int64_t start = esp_timer_get_time();
+    esp_err_t err = s_bench_hal.write(&s_bench_hal, addr, buf, len);
+    bench_timed_record(start, len);
+    return err;
+}
+
+static void bench_open_dev(const fram_hal_mock_config_t *overrides, bool timed) {
+    fram_hal_mock_config_t cfg = overrides ? *overrides : (fram_hal_mock_config_t){0};
+    cfg.buffer = s_bench_buf;
+    cfg.buffer_len = sizeof(s_bench_buf);
+    cfg.size_bytes = sizeof(s_bench_buf);
+    TEST_ASSERT_EQUAL(ESP_OK, fram_hal_mock_create(&s_bench_hal, &s_bench_ctx, &cfg));
+    fram_hal_mock_fill(&s_bench_hal, 0xFF);
+
+    s_timed_hal = (fram_hal_t){
+        .read = bench_timed_read,
+        .write = bench_timed_write,
+        .size_bytes = s_bench_hal.size_bytes,
+        .max_transfer = s_bench_hal.max_transfer,
+        .caps = s_bench_hal.caps,
+    };
+    memset(&s_timing, 0, sizeof(s_timing));
+
+    fram_dev_config_t dev_cfg = {
+        .hal = timed ? &s_timed_hal : &s_bench_hal,
+    };
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_init(&s_bench_dev, &dev_cfg));
+    TEST_ASSERT_EQUAL(ESP_OK, fram_pm_init(&s_bench_pm, &s_bench_dev, s_bench_parts, BENCH_PART_COUNT));
+    fram_hal_mock_reset_counters(&s_bench_hal);
+}
+
+static void bench_open(const fram_hal_mock_config_t *overrides) {
+    bench_open_dev(overrides, false);
+}
+
+static void bench_open_timed(const fram_hal_mock_config_t *overrides) {
+    bench_open_dev(overrides, true);
+}
+
+static void bench_close(void) {
+    fram_dev_deinit(&s_bench_dev);
+}
+
+static uint32_t bench_erase_txns(const fram_hal_mock_config_t *cfg) {
+    bench_open(cfg);
+    TEST_ASSERT_EQUAL(ESP_OK, fram_pm_erase(&s_bench_pm, &s_bench_parts[0]));
+    uint32_t txns = s_bench_ctx.txn_count;
+    bench_close();
+    return txns;
+}
+
+TEST_CASE("fram_bench_erase_4k_transactions", "[fram][bench]") {
+    // "chunked": HAL limited to 32-byte transfers, fram_dev splits every write.
+    // "single-CS": HAL streams any length in one WREN + WRITE window.
+    fram_hal_mock_config_t chunked = { .max_transfer = 32 };
+    fram_hal_mock_config_t single_cs = { .max_transfer = 32, .continuous = true };
+
+    uint32_t before = bench_erase_txns(&chunked);
+    uint32_t after = bench_erase_txns(&single_cs);
+
+    printf("fram_pm_erase(4 KB): chunked %u txns, single-CS %u txns\n",
+           (unsigned)before, (unsigned)after);
+    TEST_ASSERT_LESS_THAN(before, after);
+}
+
+#if CONFIG_FRAM_HAL_STRIPE_ENABLED
+
+#define BENCH_STRIPE_CHILDREN 4
+#define BENCH_BYTE_NS 400 // 20 MHz SPI
+
+static uint8_t s_stripe_mem[32 * 1024];
+static fram_hal_t s_stripe_child[BENCH_STRIPE_CHILDREN];
+static fram_hal_mock_ctx_t s_stripe_child_ctx[BENCH_STRIPE_CHILDREN];
+
+// Simulated time of a read of `len` bytes through `children` striped mocks.
+// Children on separate buses run in parallel, so the transfer takes as long
+// as the busiest child.
+static uint64_t bench_stripe_read_ns(size_t children, size_t len) {
+    static uint8_t data[16 * 1024];
+    fram_hal_t *child_hals[BENCH_STRIPE_CHILDREN];
+    size_t child_size = sizeof(s_stripe_mem) / children;
+    for (size_t i = 0; i < children; i++) {
+        fram_hal_mock_config_t cfg = {
+            .buffer = s_stripe_mem + i * child_size,
+            .buffer_len = child_size,
+            .size_bytes = child_size,
+            .byte_ns = BENCH_BYTE_NS,
+        };
+        TEST_ASSERT_EQUAL(ESP_OK, fram_hal_mock_create(&s_stripe_child[i], &s_stripe_child_ctx[i], &cfg));
+        child_hals[i] = &s_stripe_child[i];
+    }
+
+    fram_hal_t hal;
+    fram_hal_stripe_ctx_t ctx;
+    fram_hal_stripe_config_t cfg = {
+        .children = child_hals,
+        .child_count = children,
+        .mode = FRAM_HAL_STRIPE_MODE_STRIPE,
+        .stripe_size = 512,
+    };
+    TEST_ASSERT_EQUAL(ESP_OK, fram_hal_stripe_create(&hal, &ctx, &cfg));
+    fram_dev_t dev;
+    fram_dev_config_t dev_cfg = { .hal = &hal };
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_init(&dev, &dev_cfg));
+
+    TEST_ASSERT_EQUAL(ESP_OK, fram_dev_read(&dev, 0, data, len));
+
+    uint64_t busiest = 0;
+    for (size_t i = 0; i < children; i++) {
+        if (s_stripe_child_ctx[i].sim_time_ns > busiest) {
+            busiest = s_stripe_child_ctx[i].sim_time_ns;
+        }
+    }
+    fram_dev_deinit(&dev);
+    return busiest;
+}
+
+TEST_CASE("fram_bench_stripe_throughput", "[fram][bench]") {
+    const size_t len = 16 * 1024;
+    uint64_t single = bench_stripe_read_ns(1, len);
+    uint64_t striped = bench_stripe_read_ns(BENCH_STRIPE_CHILDREN, len);
+
+    printf("fram_dev_read(16 KB) @ %u ns/B: 1 chip %.2f MB/s, %u chips striped %.2f MB/s\n",
+           (unsigned)BENCH_BYTE_NS, (double)len * 1000.0 / (double)single,
+           (unsigned)BENCH_STRIPE_CHILDREN, (double)len * 1000.0 / (double)striped);
+    TEST_ASSERT_LESS_THAN(single, striped * 2);
+}
+
+#endif // CONFIG_FRAM_HAL_STRIPE_ENABLED
+
+// Bus model of a 20 MHz SPI part with a few microseconds of driver and CS
+// overhead per transaction, close to a polled spi_master transaction.
+#define BENCH_CLOCK_HZ 20000000
+#define BENCH_CS_OVERHEAD_NS 3000
+
+typedef struct {
+    uint32_t txns;
+    uint64_t ns;
+} bench_bus_t;
+
+static bench_bus_t bench_bus_take(void) {
+    bench_bus_t bus = { .txns = s_bench_ctx.txn_count, .ns = s_bench_ctx.sim_time_ns };
+    fram_hal_mock_reset_counters(&s_bench_hal);
+    return bus;
+}
+
+static void bench_bus_print(const char *op, bench_bus_t bus, uint32_t ops) {
+    printf("  %-22s %5.1f txns  %8.2f us\n", op, (double)bus.txns / ops,
+           (double)bus.ns / 1000.0 / ops);
+}
+
+TEST_CASE("fram_bench_primitive_bus_time", "[fram][bench]") {
+    const uint32_t ops = 32;
+    uint8_t payload[32];
+    memset(payload, 0xA5, sizeof(payload));
+
+    fram_hal_mock_config_t bus_cfg = {
+        .clock_hz = BENCH_CLOCK_HZ,
+        .cs_overhead_ns = BENCH_CS_OVERHEAD_NS,
+        .continuous = true,
+    };
+    bench_open(&bus_cfg);
+    printf("simulated bus @ %u Hz, %u ns per transaction:\n", (unsigned)BENCH_CLOCK_HZ,
+           (unsigned)BENCH_CS_OVERHEAD_NS);
+
+    fram_ring_t ring;
+    fram_ring_config_t ring_cfg = { .pm = &s_bench_pm, .partition_name = "bench", .max_payload = sizeof(payload) };
+    TEST_ASSERT_EQUAL(ESP_OK, fram_ring_init(&ring, &ring_cfg));
+    bench_bus_take();
+    for (uint32_t i = 0; i < ops; i++) {
+        TEST_ASSERT_EQUAL(ESP_OK, fram_ring_append(&ring, payload, sizeof(payload)));
+    }
+    bench_bus_print("fram_ring_append(32 B)", bench_bus_take(), ops);
+    fram_ring_deinit(&ring);
+
+    fram_vslot_t vs;
+    fram_vslot_config_t vs_cfg = {
+        .pm = &s_bench_pm,
+        .partition_name = "vslot",
+        .max_payload = sizeof(payload),
+        .slot_count = 2,
+    };
+    TEST_ASSERT_EQUAL(ESP_OK, fram_vslot_init(&vs, &vs_cfg));
+    bench_bus_take();
+    for (uint32_t i = 0; i < ops; i++) {
+        TEST_ASSERT_EQUAL(ESP_OK, fram_vslot_save(&vs, payload, sizeof(payload)));
+    }
+    bench_bus_print("fram_vslot_save(32 B)", bench_bus_take(), ops);
+    fram_vslot_deinit(&vs);
+
+#if CONFIG_FRAM_KVS_ENABLED
+    fram_kvs_t kvs;
+    fram_kvs_config_t kvs_cfg = { .pm = &s_bench_pm, .partition_name = "kvs" };
+    TEST_ASSERT_EQUAL(ESP_OK, fram_kvs_init(&kvs, &kvs_cfg));
+    char key[8];
+    for (uint32_t i = 0; i < 8; i++) {
+        snprintf(key, sizeof(key), "key%u", (unsigned)i);
+        TEST_ASSERT_EQUAL(ESP_OK, fram_kvs_set(&kvs, key, payload, sizeof(payload)));
+    }
+    bench_bus_take();
+    for (uint32_t i = 0; i < ops; i++) {
+        size_t len = sizeof(payload);
+        snprintf(key, sizeof(key), "key%u", (unsigned)(i % 8));
+        TEST_ASSERT_EQUAL(ESP_OK, fram_kvs_get(&kvs, key, payload, &len));
+    }
+    bench_bus_print("fram_kvs_get(8 keys)", bench_bus_take(), ops);
+    fram_kvs_deinit(&kvs);
+#endif
+
+    bench_close();
+}
+
+static uint8_t s_bench_shadow[FRAM_BENCH_SIZE];
+
+typedef enum {
+    BENCH_RAM_NONE,
+    BENCH_RAM_CACHE,
+    BENCH_RAM_SHADOW,
+} bench_ram_t;
+
+typedef struct {
+    bench_bus_t recover; // ring init after 64 appends
+    bench_bus_t save;    // 32 saves of an unchanged vslot payload
+    bench_bus_t get;     // 32 KVS lookups over 8 keys
+} bench_ram_result_t;
+
+static void bench_ram_run(bench_ram_t ram, bench_ram_result_t *res) {
+    uint8_t payload[32];
+    memset(payload, 0xA5, sizeof(payload));
+    memset(res, 0, sizeof(*res));
+    fram_hal_mock_config_t bus_cfg = {
+        .clock_hz = BENCH_CLOCK_HZ,
+        .cs_overhead_ns = BENCH_CS_OVERHEAD_NS,
+        .continuous = true,
+    };
+    bench_open(&bus_cfg);
+    if (ram != BENCH_RAM_NONE) {
+        fram_dev_deinit(&s_bench_dev);
+        fram_dev_config_t dev_cfg = {
+            .hal = &s_bench_hal,
+            .shadow = ram == BENCH_RAM_SHADOW ? s_bench_shadow : NULL,
+            .shadow_len = sizeof(s_bench_shadow),
+            .cache = ram == BENCH_RAM_CACHE,
+        };
+        TEST_ASSERT_EQUAL(ESP_OK, fram_dev_init(&s_bench_dev, &dev_cfg));
+        TEST_ASSERT_EQUAL(ESP_OK, fram_pm_init(&s_bench_pm, &s_bench_dev, s_bench_parts, BENCH_PART_COUNT));
+    }
+
+    fram_ring_t ring;
+    fram_ring_config_t ring_cfg = { .pm = &s_bench_pm, .partition_name = "bench", .max_payload = sizeof(payload) };
+    TEST_ASSERT_EQUAL(ESP_OK, fram_ring_init(&ring, &ring_cfg));
+    for (uint32_t i = 0; i < 64; i++) {
+        TEST_ASSERT_EQUAL(ESP_OK, fram_ring_append(&ring, payload, sizeof(payload)));
+    }
+    bench_bus_take();
+    TEST_ASSERT_EQUAL(ESP_OK, fram_ring_init(&ring, &ring_cfg));
+    res->recover = bench_bus_take();
+    fram_ring_deinit(&ring);
+
+    fram_vslot_t vs;
+    fram_vslot_config_t vs_cfg = {
+        .pm = &s_bench_pm,
+        .partition_name = "vslot",
+        .max_payload = sizeof(payload),
+        .slot_count = 2,
+    };
+    TEST_ASSERT_EQUAL(ESP_OK, fram_vslot_init(&vs, &vs_cfg));
+    bench_bus_take();
+    for (uint32_t i = 0; i < 32; i++) {
+        TEST_ASSERT_EQUAL(ESP_OK, fram_vslot_save(&vs, payload, sizeof(payload)));
+    }
+    res->save = bench_bus_take();
+    fram_vslot_deinit(&vs);
+
+#if CONFIG_FRAM_KVS_ENABLED
+    fram_kvs_t kvs;
+    fram_kvs_config_t kvs_cfg = { .pm = &s_bench_pm, .partition_name = "kvs" };
+    TEST_ASSERT_EQUAL(ESP_OK, fram_kvs_init(&kvs, &kvs_cfg));
+    char key[8];
+    for (uint32_t i = 0; i < 8; i++) {
+        snprintf(key, sizeof(key), "key%u", (unsigned)i);
+        TEST_ASSERT_EQUAL(ESP_OK, fram_kvs_set(&kvs, key, payload, sizeof(payload)));
+    }
+    bench_bus_take();
+    for (uint32_t i = 0; i < 32; i++) {
+        size_t len = sizeof(payload);
+        snprintf(key, sizeof(key), "key%u", (unsigned)(i % 8));
+        TEST_ASSERT_EQUAL(ESP_OK, fram_kvs_get(&kvs, key, payload, &len));
+    }
+    res->get = bench_bus_take();
+    fram_kvs_deinit(&kvs);
+#endif
+    bench_close();
+}
+
+TEST_CASE("fram_bench_ram_bus_time", "[fram][bench]") {
+    static const char *const names[] = { "device", "cache", "shadow" };
+    bench_ram_result_t res[3];
+    bench_ram_run(BENCH_RAM_NONE, &res[0]);
+    bench_ram_run(BENCH_RAM_CACHE, &res[1]);
+    bench_ram_run(BENCH_RAM_SHADOW, &res[2]);
+
+    printf("RAM cache / shadow, simulated bus:\n");
+    for (int i = 0; i < 3; i++) {
+        char op[32];
+        snprintf(op, sizeof(op), "ring recover, %s", names[i]);
+        bench_bus_print(op, res[i].recover, 1);
+        snprintf(op, sizeof(op), "vslot_save, %s", names[i]);
+        bench_bus_print(op, res[i].save, 32);
+#if CONFIG_FRAM_KVS_ENABLED
+        snprintf(op, sizeof(op), "kvs_get, %s", names[i]);
+        bench_bus_print(op, res[i].get, 32);
+#endif
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, res[2].recover.txns);
+    TEST_ASSERT_LESS_THAN(res[0].save.ns, res[2].save.ns);
+#if CONFIG_FRAM_DEV_CACHE_LINES
+    TEST_ASSERT_LESS_THAN(res[0].get.txns, res[1].get.txns);
+#endif
+}
+
+// Ring mount on the simulated bus against partition size: full scan versus
+// the head hint, with small records and the ring wrapped once
+static bench_bus_t bench_ring_mount(uint32_t size, uint32_t hint_interval, uint32_t *capacity) {
+    const fram_partition_t part = { .name = "mount", .offset = 0, .size = size };
+    uint8_t payload[8];
+    memset(payload, 0x3C, sizeof(payload));
+    fram_hal_mock_config_t bus_cfg = {
+        .clock_hz = BENCH_CLOCK_HZ,
+        .cs_overhead_ns = BENCH_CS_OVERHEAD_NS,
+        .continuous = true,
+    };
+    bench_open(&bus_cfg);
+    TEST_ASSERT_EQUAL(ESP_OK, fram_pm_init(&s_bench_pm, &s_bench_dev, &part, 1));
+
+    fram_ring_t ring;
+    fram_ring_config_t cfg = {
+        .pm = &s_bench_pm,
+        .partition_name = "mount",
+        .max_payload = sizeof(payload),
+        .hint_interval = hint_interval,
+    };
+    TEST_ASSERT_EQUAL(ESP_OK, fram_ring_init(&ring, &cfg));
+    *capacity = fram_ring_capacity(&ring);
+    for (uint32_t i = 0; i < *capacity + *capacity / 3; i++) {
+        TEST_ASSERT_EQUAL(ESP_OK, fram_ring_append(&ring, payload, sizeof(payload)));
+    }
+    bench_bus_take();
+    TEST_ASSERT_EQUAL(ESP_OK, fram_ring_init(&ring, &cfg));
+    bench_bus_t bus = bench_bus_take();
+    TEST_ASSERT_EQUAL_UINT32(*capacity, fram_ring_count(&ring));
+    fram_ring_deinit(&ring);
+    bench_close();
+    return bus;
+}
+
+TEST_CASE("fram_bench_ring_mount", "[fram][bench]") {
+    static const uint32_t sizes[] = { 1024, 4096, 16384 };
+    printf("ring mount, 8 B records, simulated bus:\n");
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        uint32_t cap_full;
+        uint32_t cap_hint;
+        bench_bus_t full = bench_ring_mount(sizes[i], 0, &cap_full);
+        bench_bus_t hint = bench_ring_mount(sizes[i], 16, &cap_hint);
+        printf("  %5u B: full scan %4u slots %6u txns %9.2f us, hint %4u slots %3u txns %7.2f us\n",
+               (unsigned)sizes[i], (unsigned)cap_full, (unsigned)full.txns, (double)full.ns / 1000.0,
+               (unsigned)cap_hint, (unsigned)hint.txns, (double)hint.ns / 1000.0);
+        TEST_ASSERT_LESS_THAN(full.ns, hint.ns);
+    }
+}
+
+// Records per second through fram_ring_append_batch() at batch sizes 1, 8
+// and 64, by wall clock and on the simulated bus, for fixed and packed rings
+TEST_CASE("fram_bench_ring_append_batch", "[fram][bench]") {
+    static const uint32_t batch_sizes[] = { 1, 8, 64 };
+    const uint32_t records = 512;
+    uint8_t payload[16];
+    memset(payload, 0x5A, sizeof(payload));
+    fram_ring_rec_t recs[64];
+    for (uint32_t i = 0; i < 64; i++) {
+        recs[i] = (fram_ring_rec_t){ .payload = payload, .len = sizeof(payload) };
+    }
+    fram_hal_mock_config_t bus_cfg = {
+        .clock_hz = BENCH_CLOCK_HZ,
+        .cs_overhead_ns = BENCH_CS_OVERHEAD_NS,
+        .continuous = true,
+    };
+
+    printf("ring append, %u B records:\n", (unsigned)sizeof(payload));
+    for (int packed = 0; packed < 2; packed++) {
+        for (size_t b = 0; b < sizeof(batch_sizes) / sizeof(batch_sizes[0]); b++) {
+            fram_ring_t ring;
+            fram_ring_config_t cfg = {
+                .pm = &s_bench_pm,
+                .partition_name = "bench",
+                .max_payload = sizeof(payload),
+                .packed = packed,
+            };
+            bench_open(&bus_cfg);
+            TEST_ASSERT_EQUAL(ESP_OK, fram_ring_init(&ring, &cfg));
+            bench_bus_take();
+            int64_t start = esp_timer_get_time();
+            for (uint32_t done = 0; done < records; done += batch_sizes[b]) {
+                TEST_ASSERT_EQUAL(ESP_OK, fram_ring_append_batch(&ring, recs, batch_sizes[b]));
+            }
+            int64_t us = esp_timer_get_time() - start;
+            bench_bus_t bus = bench_bus_take();
+            printf("  %-6s batch %2u: %8.0f rec/s wall, %8.0f rec/s bus, %5.2f txns/rec\n",
+                   packed ? "packed" : "fixed", (unsigned)batch_sizes[b],
+                   us > 0 ? records * 1e6 / (double)us : 0.0, records * 1e9 / (double)bus.ns,
+                   (double)bus.txns / records);
+            fram_ring_deinit(&ring);
+            bench_close();
+        }
+    }
+}
+
+static uint64_t s_bench_ring_now_us;
+
+static uint64_t bench_ring_clock(void) {
+    return s_bench_ring_now_us;
+}
+
+static esp_err_t bench_ring_since(uint32_t seq, uint64_t ts_us, const void *payload, size_t len, void *ctx) {
+    (void)seq;
+    (void)payload;
+    (void)len;
+    uint32_t *hits = ctx;
+    if (ts_us >= s_bench_ring_now_us) {
+        (*hits)++;
+    }
+    return ESP_OK;
+}
+
+// "Records from the last 10 %": filtering a full iterate() against
+// iterate_time(), for fixed and packed rings
+TEST_CASE("fram_bench_ring_time_range", "[fram][bench]") {
+    uint8_t payload[16];
+    memset(payload, 0x5A, sizeof(payload));
+    fram_hal_mock_config_t bus_cfg = {
+        .clock_hz = BENCH_CLOCK_HZ,
+        .cs_overhead_ns = BENCH_CS_OVERHEAD_NS,
+        .continuous = true,
+    };
+
+    printf("ring time range, %u B records, newest 10 %%:\n", (unsigned)sizeof(payload));
+    for (int packed = 0; packed < 2; packed++) {
+        fram_ring_t ring;
+        fram_ring_config_t cfg = {
+            .pm = &s_bench_pm,
+            .partition_name = "bench",
+            .max_payload = sizeof(payload),
+            .packed = packed,
+            .clock = bench_ring_clock,
+        };
+        bench_open(&bus_cfg);
+        TEST_ASSERT_EQUAL(ESP_OK, fram_ring_init(&ring, &cfg));
+        for (uint32_t i = 0; i < 512; i++) {
+            s_bench_ring_now_us = i * 1000ULL;
+            TEST_ASSERT_EQUAL(ESP_OK, fram_ring_append(&ring, payload, sizeof(payload)));
+        }
+        uint32_t count = fram_ring_count(&ring);
+        s_bench_ring_now_us = (512 - count / 10) * 1000ULL;
+
+        uint32_t scan_hits = 0;
+        uint32_t range_hits = 0;
+        bench_bus_take();
+        TEST_ASSERT_EQUAL(ESP_OK, fram_ring_iterate(&ring, bench_ring_since, &scan_hits));
+        bench_bus_t scan = bench_bus_take();
+        TEST_ASSERT_EQUAL(ESP_OK, fram_ring_iterate_time(&ring, s_bench_ring_now_us, UINT64_MAX,
+                                                         bench_ring_since, &range_hits));
+        bench_bus_t range = bench_bus_take();
+        printf("  %-6s %3u of %3u: scan %4u txns %8.2f us, range %4u txns %8.2f us\n",
+               packed ? "packed" : "fixed", (unsigned)range_hits, (unsigned)count,
+               (unsigned)scan.txns, (double)scan.ns / 1000.0, (unsigned)range.txns, (double)range.ns / 1000.0);
+        TEST_ASSERT_EQUAL_UINT32(scan_hits, range_hits);
+        TEST_ASSERT_LESS_THAN(scan.ns, range.ns);
+        fram_ring_deinit(&ring);
+        bench_close();
+    }
+}
+
+TEST_CASE("fram_bench_ring_append_latency", "[fram][bench]") {
+    const uint32_t appends = 256;
+    static const char *const op_names[] = { "commit clear", "header", "payload", "commit set" };
+    uint8_t payload[32];
+    memset(payload, 0x5A, sizeof(payload));
+
+    fram_ring_t ring;
+    fram_ring_config_t cfg = {
+        .pm = &s_bench_pm,
+        .partition_name = "bench",
+        .max_payload = sizeof(payload),
+    };
+
+    bench_open_timed(NULL);
+    TEST_ASSERT_EQUAL(ESP_OK, fram_ring_init(&ring, &cfg));
+
+    int64_t total = 0;
+    int64_t op_us[BENCH_TIMED_OPS] = {0};
+    for (uint32_t i = 0; i < appends; i++) {
+        memset(&s_timing, 0, sizeof(s_timing));
+        int64_t start = esp_timer_get_time();
+        TEST_ASSERT_EQUAL(ESP_OK, fram_ring_append(&ring, payload, sizeof(payload)));
+        total += esp_timer_get_time() - start;
+        TEST_ASSERT_EQUAL_UINT32(4, s_timing.ops);
+        for (uint32_t op = 0; op < 4; op++) {
+            op_us[op] += s_timing.us[op];
+        }
+    }
+
+    printf("fram_ring_append(%u B) x%u: %.2f us/append\n",
+           (unsigned)sizeof(payload), (unsigned)appends, (double)total / appends);
+    for (uint32_t op = 0; op < 4; op++) {
+        printf("  %-12s %4u B  %.2f us\n", op_names[op], (unsigned)s_timing.len[op],
+               (double)op_us[op] / appends);
+    }
+
+    fram_ring_deinit(&ring);
+    bench_close();
+}
+
+
+#if CONFIG_FRAM_STAGE_ENABLED
+static fram_stage_t s_bench_stage;
+
+// Producer cost of fram_stage_push() against fram_ring_append(), and the
+// share of a burst dropped when nothing drains during it
+TEST_CASE("fram_bench_stage_burst", "[fram][bench]") {
+    static const uint32_t bursts[] = { 16, 64, 256 };
+    uint8_t payload[16];
+    memset(payload, 0x5A, sizeof(payload));
+
+    fram_ring_t ring;
+    fram_ring_config_t cfg = {
+        .pm = &s_bench_pm,
+        .partition_name = "bench",
+        .max_payload = sizeof(payload),
+    };
+    bench_open(NULL);
+    TEST_ASSERT_EQUAL(ESP_OK, fram_ring_init(&ring, &cfg));
+    fram_stage_config_t stage_cfg = { .ring = &ring };
+    TEST_ASSERT_EQUAL(ESP_OK, fram_stage_init(&s_bench_stage, &stage_cfg));
+
+    const uint32_t appends = 256;
+    int64_t start = esp_timer_get_time();
+    for (uint32_t i = 0; i < appends; i++) {
+        TEST_ASSERT_EQUAL(ESP_OK, fram_ring_append(&ring, payload, sizeof(payload)));
+    }
+    int64_t append_us = esp_timer_get_time() - start;
+    printf("fram_ring_append(%u B): %.2f us\n", (unsigned)sizeof(payload), (double)append_us / appends);
+
+    for (size_t b = 0; b < sizeof(bursts) / sizeof(bursts[0]); b++) {
+        fram_stage_reset_stats(&s_bench_stage);
+        start = esp_timer_get_time();
+        for (uint32_t i = 0; i < bursts[b]; i++) {
+            fram_stage_push(&s_bench_stage, payload, sizeof(payload));
+        }
+        int64_t push_us = esp_timer_get_time() - start;
+        start = esp_timer_get_time();
+        TEST_ASSERT_EQUAL(ESP_OK, fram_stage_drain(&s_bench_stage, 0, NULL));
+        int64_t drain_us = esp_timer_get_time() - start;
+
+        fram_stage_stats_t stats;
+        fram_stage_get_stats(&s_bench_stage, &stats);
+        TEST_ASSERT_EQUAL_UINT32(bursts[b], stats.pushed + stats.dropped);
+        TEST_ASSERT_EQUAL_UINT32(stats.pushed, stats.drained);
+        printf("burst %3u: push %.2f us, drain %.2f us/record, dropped %u (%.0f%%), high water %u/%u B\n",
+               (unsigned)bursts[b], (double)push_us / bursts[b],
+               stats.drained ? (double)drain_us / stats.drained : 0.0, (unsigned)stats.dropped,
+               100.0 * stats.dropped / bursts[b], (unsigned)stats.high_water, (unsigned)FRAM_STAGE_SIZE);
+    }
+
+    fram_stage_deinit(&s_bench_stage);
+    fram_ring_deinit(&ring);
+    bench_close();
+}
+#endif // CONFIG_FRAM_STAGE_ENABLED
+
+#endif